@@ -0,0 +1,447 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include "db/bulk_insert.h"
+#include "db/dbmanager.h"
+#include "db/synthetic_data.h"
+
+/**
+ * etykiety-bench - pomiary typowych ścieżek bazy na danych syntetycznych
+ *
+ * Baza wybierana jak w programie (DB_TYPE, DB_NAME, ... - SecureConfig), więc do
+ * pomiarów należy wskazać osobną bazę, np. DB_NAME=etykiety_bench. Tylko PostgreSQL:
+ * schemat SQLite nie ma części kolumn zamówień, więc program kończy się błędem,
+ * gdy połączenie nie jest QPSQL.
+ *
+ * --populate wypełnia bazę generatorem SyntheticData (tylko pustą, chyba że --append).
+ * Wynik to JSON (jeden obiekt na przebieg), do porównywania czasów między wersjami.
+ */
+
+namespace {
+
+// Jak OrdersTableModel::DEFAULT_PAGE_SIZE - strona listy zamówień w widoku
+constexpr int VIEW_PAGE_SIZE = 200;
+constexpr int SAVED_ORDER_ITEMS = 5;
+
+QTextStream& err() {
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+int fail(const QString& message) {
+    err() << message << "\n";
+    err().flush();
+    return 1;
+}
+
+// Komunikaty qDebug z DbManager zagłuszałyby wynik i same kosztują czas
+QtMessageHandler g_defaultHandler = nullptr;
+void quietHandler(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+    if (type == QtDebugMsg || type == QtInfoMsg) return;
+    g_defaultHandler(type, context, message);
+}
+
+DbManager& dbm() {
+    return DbManager::instance();
+}
+
+// Jeden scenariusz: body zwraca liczbę przetworzonych wierszy, -1 przy błędzie;
+// setup (bez pomiaru czasu) przed pierwszym przebiegiem
+struct Scenario {
+    QString name;
+    QString description;
+    std::function<qint64(int run)> body;
+    std::function<void()> setup;
+};
+
+// Zamówienia zapisane przez order_save - edytowane w order_update i usuwane na końcu
+struct SavedOrders {
+    int clientId = -1;
+    QStringList numbers;
+    QVector<int> ids;
+};
+
+QJsonObject measure(const Scenario& scenario, int iterations) {
+    if (scenario.setup) scenario.setup();
+    QVector<double> times;
+    qint64 rows = 0;
+    for (int run = 0; run < iterations; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        rows = scenario.body(run);
+        times.append(timer.nsecsElapsed() / 1e6);
+        if (rows < 0) break;
+    }
+
+    QJsonObject result;
+    result["name"] = scenario.name;
+    result["description"] = scenario.description;
+    if (rows < 0) {
+        result["error"] = dbm().lastError().text();
+        return result;
+    }
+    // Pierwszy przebieg osobno (puste cache encji i zapytań), statystyki ze wszystkich
+    const double cold = times.first();
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (double t : times) total += t;
+    auto percentile = [&times](double p) {
+        return times.at(qMin(static_cast<int>(times.size()) - 1, static_cast<int>(p * times.size())));
+    };
+    result["rows"] = rows;
+    result["runs"] = static_cast<int>(times.size());
+    result["cold_ms"] = cold;
+    result["min_ms"] = times.first();
+    result["median_ms"] = percentile(0.5);
+    result["mean_ms"] = total / times.size();
+    result["p95_ms"] = percentile(0.95);
+    result["max_ms"] = times.last();
+    return result;
+}
+
+qint64 countRows(const QString& table) {
+    QSqlQuery q(dbm().database());
+    return q.exec(QString("SELECT COUNT(*) FROM %1").arg(table)) && q.next() ? q.value(0).toLongLong() : -1;
+}
+
+// Pliki kopii dla transfer_*: eksport zapisuje, import czyta te same pliki
+struct TransferFiles {
+    QTemporaryDir dir;
+    qint64 orders = 0;
+};
+
+TransferFiles& transferFiles() {
+    static TransferFiles files;
+    return files;
+}
+
+// Zamówienia w kopii - bieżące i z archiwum
+qint64 transferOrderCount() {
+    const qint64 archived = dbm().schema().hasTable("orders_archive") ? countRows("orders_archive") : 0;
+    return countRows("orders") + archived;
+}
+
+bool hasTransferFiles() {
+    return QFile::exists(QDir(transferFiles().dir.path()).filePath("orders.csv"));
+}
+
+QJsonObject datasetSizes() {
+    static const QStringList tables = {"clients", "delivery_addresses", "orders", "order_items", "orders_archive",
+                                       "order_items_archive", "suppliers", "materials_catalog", "materials_orders",
+                                       "materials_order_items"};
+    QJsonObject sizes;
+    for (const QString& table : tables) {
+        if (dbm().schema().hasTable(table)) sizes[table] = countRows(table);
+    }
+    return sizes;
+}
+
+// id zamówień z order_save - dokładnie po numerze (addOrder nie zwraca id)
+void resolveSavedOrders(SavedOrders& saved) {
+    QSqlQuery q(dbm().database());
+    q.prepare("SELECT id FROM orders WHERE order_number = ?");
+    for (const QString& number : saved.numbers) {
+        q.addBindValue(number);
+        if (q.exec() && q.next()) saved.ids.append(q.value(0).toInt());
+    }
+    saved.numbers.clear();
+}
+
+QVector<QMap<QString, QVariant>> savedOrderItems(int run) {
+    QVector<QMap<QString, QVariant>> items;
+    for (int i = 0; i < SAVED_ORDER_ITEMS; ++i) {
+        QMap<QString, QVariant> item;
+        item["width"] = QString::number(50 + 10 * i);
+        item["height"] = QString::number(30 + run % 10);
+        item["material"] = "Termiczny";
+        item["ordered_quantity"] = "10";
+        item["quantity_type"] = "tyś.";
+        item["roll_length"] = "1000";
+        item["core"] = "40";
+        item["price"] = "12.50";
+        item["price_type"] = "za 1 tyś";
+        item["zam_rolki"] = "10";
+        items.append(item);
+    }
+    return items;
+}
+
+// Zapis pozycji na tabeli tymczasowej o kolumnach order_items: wiersz po wierszu
+// albo porcjami wielowierszowego VALUES (BulkInsert). Nie zmienia danych w bazie.
+const QStringList kItemColumns = {"order_id", "width", "height", "material", "ordered_quantity", "quantity_type",
+                                  "roll_length", "core", "price", "price_type", "zam_rolki"};
+
+struct ItemInsertSize {
+    int itemsPerOrder = 30;
+    int orders = 20;
+};
+
+bool createItemInsertTable() {
+    QSqlQuery q(dbm().database());
+    q.exec("DROP TABLE IF EXISTS bench_order_items");
+    if (!q.exec("CREATE TEMP TABLE bench_order_items (order_id INTEGER, width TEXT, height TEXT, material TEXT, "
+                "ordered_quantity TEXT, quantity_type TEXT, roll_length TEXT, core TEXT, price TEXT, "
+                "price_type TEXT, zam_rolki TEXT)")) {
+        err() << "Nie można utworzyć tabeli tymczasowej: " << q.lastError().text() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Każde "zamówienie" w osobnej transakcji, jak w aplikacji; zwraca liczbę pozycji, -1 przy błędzie
+qint64 insertItems(const ItemInsertSize& size, bool bulk) {
+    QSqlDatabase db = dbm().database();
+    QSqlQuery single(db);
+    if (!bulk) single.prepare(BulkInsert::statement("bench_order_items", kItemColumns, 1));
+    const int chunkSize = BulkInsert::rowsPerStatement(kItemColumns.size());
+    for (int order = 1; order <= size.orders; ++order) {
+        QVector<QVariantList> rows;
+        rows.reserve(size.itemsPerOrder);
+        for (int i = 0; i < size.itemsPerOrder; ++i) {
+            rows.append({order, QString::number(50 + i), QString::number(30 + i), "Folia PP",
+                         QString::number(10 * (i + 1)), "tyś.", "1000", "76", "12.50", "za 1 tyś", "2"});
+        }
+        db.transaction();
+        bool ok = true;
+        if (bulk) {
+            for (int first = 0; ok && first < rows.size(); first += chunkSize) {
+                const int count = qMin(chunkSize, static_cast<int>(rows.size()) - first);
+                QSqlQuery q(db);
+                q.prepare(BulkInsert::statement("bench_order_items", kItemColumns, count));
+                BulkInsert::bindRows(q, rows, first, count);
+                ok = q.exec();
+            }
+        } else {
+            for (int i = 0; ok && i < rows.size(); ++i) {
+                BulkInsert::bindRows(single, rows, i, 1);
+                ok = single.exec();
+            }
+        }
+        if (!ok) {
+            db.rollback();
+            return -1;
+        }
+        db.commit();
+    }
+    return static_cast<qint64>(size.orders) * size.itemsPerOrder;
+}
+
+// Scenariusze nie dotykają bazy przy tworzeniu listy (--list działa bez połączenia)
+QVector<Scenario> scenarios(SavedOrders& saved, const ItemInsertSize& insertSize) {
+    const QVector<Order::Status> openStatuses = {Order::Przyjete, Order::Produkcja, Order::Gotowe};
+    const QDate today = QDate::currentDate();
+
+    QVector<Scenario> list;
+    list.append({"get_orders", "DbManager::getOrders - wszystkie zamówienia z klientami",
+                 [](int) { return static_cast<qint64>(dbm().getOrders().size()); }, {}});
+    list.append({"get_clients", "DbManager::getClients",
+                 [](int) { return static_cast<qint64>(dbm().getClients().size()); }, {}});
+    list.append({"orders_view_first_page", "Otwarcie widoku zamówień: pierwsza strona listy",
+                 [](int) {
+                     return static_cast<qint64>(dbm().fetchOrdersPage(OrdersPageCursor(), VIEW_PAGE_SIZE).size());
+                 }, {}});
+    list.append({"orders_view_scroll", "Przewinięcie całej listy zamówień stronami (fetchMore)",
+                 [](int) {
+                     qint64 rows = 0;
+                     OrdersPageCursor cursor;
+                     while (true) {
+                         const QVector<OrderListRow> page = dbm().fetchOrdersPage(cursor, VIEW_PAGE_SIZE);
+                         rows += page.size();
+                         if (page.size() < VIEW_PAGE_SIZE) return rows;
+                         cursor = OrdersPageCursor::after(page.last());
+                     }
+                 }, {}});
+    list.append({"orders_view_search", "Wyszukiwanie w widoku zamówień po nazwie klienta",
+                 [](int) {
+                     return static_cast<qint64>(dbm().fetchOrdersPage(OrdersPageCursor(), VIEW_PAGE_SIZE, "Piekarnia",
+                                                                      OrderSearchField::ClientName).size());
+                 }, {}});
+    list.append({"production_summary", "Podsumowanie produkcji: wszystkie otwarte zamówienia (getProductionGroups)",
+                 [openStatuses](int) {
+                     return static_cast<qint64>(dbm().getProductionGroups(QDate(), QDate(), openStatuses).size());
+                 }, {}});
+    list.append({"production_rollup_week", "Podsumowanie produkcji bieżącego tygodnia (production_rollup)",
+                 [openStatuses, today](int) {
+                     const QDate weekStart = today.addDays(1 - today.dayOfWeek());
+                     return static_cast<qint64>(dbm().getProductionRollup(weekStart, openStatuses).size());
+                 }, {}});
+    list.append({"order_save", "Zapis nowego zamówienia: numer, zamówienie i pozycje",
+                 [&saved, today](int run) -> qint64 {
+                     QMap<QString, QVariant> order;
+                     order["order_number"] = dbm().getNextOrderNumber(today);
+                     order["order_date"] = today;
+                     order["delivery_date"] = today.addDays(14);
+                     order["client_id"] = saved.clientId;
+                     order["payment_term"] = "14 dni";
+                     order["notes"] = "etykiety-bench";
+                     if (!dbm().addOrder(order, savedOrderItems(run))) return -1;
+                     saved.numbers.append(order.value("order_number").toString());
+                     return SAVED_ORDER_ITEMS;
+                 },
+                 [&saved]() { saved.clientId = dbm().getClients().value(0).value("id").toInt(); }});
+    list.append({"order_update", "Edycja zamówienia z order_save: odczyt, zmiana jednej pozycji, zapis",
+                 [&saved](int run) -> qint64 {
+                     if (saved.ids.isEmpty()) return 0;
+                     const int id = saved.ids.at(run % saved.ids.size());
+                     QMap<QString, QVariant> order = dbm().getOrderById(id);
+                     QVector<QMap<QString, QVariant>> items = dbm().getOrderItems(id);
+                     if (items.isEmpty()) return -1;
+                     items[0]["ordered_quantity"] = QString::number(10 + run);
+                     order["notes"] = QString("etykiety-bench %1").arg(run);
+                     return dbm().updateOrder(id, order, items) ? items.size() : -1;
+                 },
+                 [&saved]() { resolveSavedOrders(saved); }});
+    list.append({"item_insert_row_by_row", "Zapis pozycji zamówień: jedno INSERT na pozycję (tabela tymczasowa)",
+                 [insertSize](int) { return insertItems(insertSize, false); },
+                 []() { createItemInsertTable(); }});
+    list.append({"item_insert_bulk", "Zapis pozycji zamówień: porcje wielowierszowego VALUES (BulkInsert)",
+                 [insertSize](int) { return insertItems(insertSize, true); },
+                 []() { createItemInsertTable(); }});
+    // Cel: kopia i odtworzenie 100 tys. zamówień w sekundy (--orders 100000); wiersze = zamówienia
+    list.append({"transfer_export", "Eksport wszystkich tabel kopii do CSV (DbManager::exportAll)",
+                 [](int) { return dbm().exportAll(transferFiles().dir.path(), TransferFormat::Csv) ? transferFiles().orders : -1; },
+                 []() { transferFiles().orders = transferOrderCount(); }});
+    list.append({"transfer_import", "Import kopii CSV z transfer_export - nadpisuje te same wiersze (DbManager::importAll)",
+                 [](int) { return dbm().importAll(transferFiles().dir.path()) ? transferFiles().orders : -1; },
+                 []() {
+                     transferFiles().orders = transferOrderCount();
+                     if (!hasTransferFiles()) dbm().exportAll(transferFiles().dir.path(), TransferFormat::Csv);
+                 }});
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Te same ustawienia co program (cache zapytań, pula połączeń), inna baza przez DB_*
+    QCoreApplication::setOrganizationName("TwojaFirma");
+    QCoreApplication::setApplicationName("EtykietyManager");
+    QCoreApplication::setApplicationVersion("2.0.0");
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Pomiary wydajności bazy Etykiety Manager (wynik JSON).\n"
+        "Tylko PostgreSQL: DB_TYPE=QPSQL, DB_NAME/DB_HOST/... - używaj osobnej bazy do pomiarów.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const SyntheticDataSpec defaults;
+    parser.addOptions({
+        {"populate", "Wypełnij bazę danymi syntetycznymi przed pomiarami."},
+        {"populate-only", "Tylko wypełnij bazę, bez pomiarów."},
+        {"append", "Pozwól wypełniać bazę, w której są już zamówienia."},
+        {"seed", "Ziarno generatora.", "n", QString::number(defaults.seed)},
+        {"scale", "Mnożnik liczby wierszy generatora (np. 5).", "x", "1"},
+        {"clients", "Liczba klientów przy skali 1.", "n", QString::number(defaults.clients)},
+        {"orders", "Liczba zamówień przy skali 1.", "n", QString::number(defaults.orders)},
+        {"months", "Zamówienia z tylu ostatnich miesięcy.", "n", QString::number(defaults.months)},
+        {"iterations", "Przebiegi każdego scenariusza.", "n", "5"},
+        {"insert-items", "item_insert_*: pozycji na zamówienie.", "n", "30"},
+        {"insert-orders", "item_insert_*: zamówień (transakcji) na przebieg.", "n", "20"},
+        {"scenarios", "Tylko te scenariusze (po przecinku).", "lista"},
+        {"list", "Wypisz scenariusze i zakończ."},
+        {"output", "Plik wyniku JSON (domyślnie standardowe wyjście).", "plik"},
+        {"verbose", "Nie wyciszaj komunikatów diagnostycznych."},
+    });
+    parser.process(app);
+
+    if (!parser.isSet("verbose")) g_defaultHandler = qInstallMessageHandler(quietHandler);
+
+    SavedOrders saved;
+    ItemInsertSize insertSize;
+    insertSize.itemsPerOrder = qMax(1, parser.value("insert-items").toInt());
+    insertSize.orders = qMax(1, parser.value("insert-orders").toInt());
+    const QVector<Scenario> all = scenarios(saved, insertSize);
+    if (parser.isSet("list")) {
+        QTextStream out(stdout);
+        for (const Scenario& scenario : all) out << scenario.name << "\t" << scenario.description << "\n";
+        return 0;
+    }
+
+    auto& db = DbManager::instance();
+    if (!db.database().isOpen()) return fail("Brak połączenia z bazą danych");
+    if (db.isOffline()) return fail("Serwer niedostępny - pomiary na kopii lokalnej byłyby mylące");
+    if (db.database().driverName() != QLatin1String("QPSQL")) {
+        return fail("etykiety-bench wymaga bazy PostgreSQL (DB_TYPE=QPSQL, DB_NAME=...)");
+    }
+
+    QJsonObject root;
+    root["tool"] = "etykiety-bench";
+    root["version"] = QCoreApplication::applicationVersion();
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["driver"] = db.database().driverName();
+
+    if (parser.isSet("populate") || parser.isSet("populate-only")) {
+        if (countRows("orders") > 0 && !parser.isSet("append")) {
+            return fail("Baza zawiera już zamówienia - wskaż osobną bazę (DB_NAME) albo użyj --append");
+        }
+        SyntheticDataSpec spec;
+        spec.seed = parser.value("seed").toUInt();
+        spec.clients = parser.value("clients").toInt();
+        spec.orders = parser.value("orders").toInt();
+        spec.months = parser.value("months").toInt();
+        spec = spec.scaled(parser.value("scale").toDouble());
+
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        const bool ok = SyntheticData::populate(db, spec, [](const QString& stage, int done, int total) {
+            err() << "\r" << stage << ": " << done << "/" << total << (done == total ? "\n" : "");
+            err().flush();
+        }, &error);
+        if (!ok) return fail(error);
+
+        QJsonObject populate;
+        populate["seed"] = static_cast<qint64>(spec.seed);
+        populate["clients"] = spec.clients;
+        populate["orders"] = spec.orders;
+        populate["suppliers"] = spec.suppliers;
+        populate["materials_orders"] = spec.materialsOrders;
+        populate["months"] = spec.months;
+        populate["seconds"] = timer.elapsed() / 1000.0;
+        root["populate"] = populate;
+    }
+    root["dataset"] = datasetSizes();
+
+    if (!parser.isSet("populate-only")) {
+        const int iterations = qMax(1, parser.value("iterations").toInt());
+        const QStringList only = parser.value("scenarios").split(',', Qt::SkipEmptyParts);
+        root["iterations"] = iterations;
+        QJsonArray results;
+        for (const Scenario& scenario : all) {
+            if (!only.isEmpty() && !only.contains(scenario.name)) continue;
+            err() << scenario.name << "...\n";
+            err().flush();
+            results.append(measure(scenario, iterations));
+        }
+        root["scenarios"] = results;
+
+        // Zamówienia z order_save nie zostają w bazie
+        resolveSavedOrders(saved);
+        for (int id : saved.ids) db.deleteOrder(id);
+    }
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return fail("Nie można zapisać " + parser.value("output") + ": " + file.errorString());
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
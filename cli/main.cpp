@@ -0,0 +1,305 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDate>
+#include <QDir>
+#include <QTextStream>
+#include <functional>
+#include "db/dbmanager.h"
+#include "db/data_transfer.h"
+#include "utils/python_pdf_generator.h"
+
+/**
+ * etykiety-cli - dostęp do bazy bez okien, do skryptów i zadań cyklicznych
+ *
+ * Korzysta z tych samych ustawień co program (organizacja i nazwa aplikacji),
+ * więc łączy się z tą samą bazą. Wynik list to TSV z nagłówkiem na standardowym
+ * wyjściu, komunikaty błędów - na standardowym wyjściu błędów.
+ */
+
+namespace {
+
+constexpr int PAGE_SIZE = 500;
+
+QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream& err() {
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+int fail(const QString& message) {
+    err() << message << "\n";
+    err().flush();
+    return 1;
+}
+
+QString dbError() {
+    return DbManager::instance().lastError().text();
+}
+
+// Tabulatory i nowe linie w polach psułyby kolumny TSV
+QString tsvField(QString value) {
+    value.replace('\t', ' ');
+    value.replace('\n', ' ');
+    value.remove('\r');
+    return value;
+}
+
+void writeRow(const QStringList& fields) {
+    QStringList cleaned;
+    cleaned.reserve(fields.size());
+    for (const QString& field : fields) cleaned.append(tsvField(field));
+    out() << cleaned.join('\t') << "\n";
+}
+
+// "0,1,2" -> statusy; pusta lista przy błędnej wartości
+QVector<Order::Status> parseStatuses(const QString& value) {
+    QVector<Order::Status> statuses;
+    for (const QString& part : value.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int status = part.trimmed().toInt(&ok);
+        if (!ok || status < Order::Przyjete || status > Order::Zrealizowane) return {};
+        statuses.append(static_cast<Order::Status>(status));
+    }
+    return statuses;
+}
+
+OrderSearchField parseSearchField(const QString& value, bool* ok) {
+    *ok = true;
+    if (value == "order") return OrderSearchField::OrderNumber;
+    if (value == "client-number") return OrderSearchField::ClientNumber;
+    if (value == "client-name") return OrderSearchField::ClientName;
+    *ok = false;
+    return OrderSearchField::OrderNumber;
+}
+
+// Przechodzi listę zamówień stronami (kursor keyset), aż callback zwróci false
+void forEachOrder(const QString& filter, OrderSearchField field, bool includeArchive,
+                  const std::function<bool(const OrderListRow&)>& callback) {
+    OrdersPageCursor cursor;
+    while (true) {
+        const QVector<OrderListRow> page =
+            DbManager::instance().fetchOrdersPage(cursor, PAGE_SIZE, filter, field, includeArchive);
+        for (const OrderListRow& row : page) {
+            if (!callback(row)) return;
+        }
+        if (page.size() < PAGE_SIZE) return;
+        cursor = OrdersPageCursor::after(page.last());
+    }
+}
+
+int listOrders(const QCommandLineParser& parser) {
+    bool ok = false;
+    const OrderSearchField field = parseSearchField(parser.value("field"), &ok);
+    if (!ok) return fail("Nieznane pole wyszukiwania: " + parser.value("field"));
+    const int limit = parser.value("limit").toInt();
+    const QVector<Order::Status> statuses = parser.isSet("status") ? parseStatuses(parser.value("status"))
+                                                                   : QVector<Order::Status>();
+    if (parser.isSet("status") && statuses.isEmpty()) return fail("Nieprawidłowe statusy: " + parser.value("status"));
+
+    writeRow({"id", "order_number", "order_date", "delivery_date", "client_number", "client_name", "status",
+              "production", "archived"});
+    int written = 0;
+    forEachOrder(parser.value("filter"), field, parser.isSet("archive"), [&](const OrderListRow& row) {
+        if (!statuses.isEmpty() && !statuses.contains(row.status)) return true;
+        writeRow({QString::number(row.id), row.orderNumber, row.orderDate.toString(Qt::ISODate),
+                  row.deliveryDate.toString(Qt::ISODate), row.clientNumber, row.clientName,
+                  Order::statusToString(row.status), row.productionSummary, row.archived ? "1" : "0"});
+        return limit <= 0 || ++written < limit;
+    });
+    return 0;
+}
+
+int exportData(const QStringList& args, const QCommandLineParser& parser) {
+    if (args.size() < 2) return fail("Użycie: etykiety-cli export <katalog> [--format csv|ndjson]");
+    const QString format = parser.value("format");
+    if (format != "csv" && format != "ndjson") return fail("Nieznany format: " + format);
+    if (!DbManager::instance().exportAll(args.at(1), format == "csv" ? TransferFormat::Csv : TransferFormat::NdJson)) {
+        return fail("Eksport nieudany: " + dbError());
+    }
+    return 0;
+}
+
+int exportTable(const QStringList& args) {
+    if (args.size() < 3) return fail("Użycie: etykiety-cli export-table <tabela> <plik>");
+    if (!DbManager::instance().exportTable(args.at(1), args.at(2))) return fail("Eksport nieudany: " + dbError());
+    return 0;
+}
+
+int importData(const QStringList& args) {
+    if (args.size() < 2) return fail("Użycie: etykiety-cli import <katalog>");
+    if (!DbManager::instance().importAll(args.at(1))) return fail("Import nieudany: " + dbError());
+    return 0;
+}
+
+// Zamówienia do PDF: podane numery albo (bez numerów) wszystkie o statusach z --status
+QVector<int> ordersForPdf(const QStringList& numbers, const QVector<Order::Status>& statuses, QStringList& missing) {
+    QVector<int> ids;
+    if (numbers.isEmpty()) {
+        forEachOrder(QString(), OrderSearchField::OrderNumber, false, [&](const OrderListRow& row) {
+            if (statuses.contains(row.status)) ids.append(row.id);
+            return true;
+        });
+        return ids;
+    }
+    for (const QString& number : numbers) {
+        int found = -1;
+        forEachOrder(number, OrderSearchField::OrderNumber, false, [&](const OrderListRow& row) {
+            if (row.orderNumber != number) return true;
+            found = row.id;
+            return false;
+        });
+        if (found < 0) missing.append(number);
+        else ids.append(found);
+    }
+    return ids;
+}
+
+int generatePdfs(const QStringList& args, const QCommandLineParser& parser) {
+    if (args.size() < 3 || (args.at(1) != "confirmation" && args.at(1) != "production")) {
+        return fail("Użycie: etykiety-cli pdf confirmation|production <katalog> [numery zamówień...]");
+    }
+    const bool confirmation = args.at(1) == "confirmation";
+    const QString dir = args.at(2);
+    if (!QDir().mkpath(dir)) return fail("Nie można utworzyć katalogu " + dir);
+    const QVector<Order::Status> statuses = parseStatuses(parser.value("status"));
+    if (statuses.isEmpty()) return fail("Nieprawidłowe statusy: " + parser.value("status"));
+
+    QStringList missing;
+    const QVector<int> ids = ordersForPdf(args.mid(3), statuses, missing);
+    for (const QString& number : missing) err() << "Brak zamówienia " << number << "\n";
+
+    auto& dbm = DbManager::instance();
+    PythonPdfGenerator generator;
+    int failed = missing.size();
+    for (int id : ids) {
+        const QMap<QString, QVariant> orderData = dbm.getOrderById(id);
+        if (orderData.isEmpty()) {
+            err() << "Nie można pobrać zamówienia id " << id << "\n";
+            ++failed;
+            continue;
+        }
+        const QMap<QString, QVariant> clientData = dbm.getClientById(orderData.value("client_id").toInt());
+        const QVector<QMap<QString, QVariant>> items = dbm.getOrderItems(id);
+        // Nazwy plików jak w oknie drukowania
+        const QString fileName = QString("%1_%2_%3.pdf")
+            .arg(orderData.value("order_number").toString(),
+                 clientData.value("name").toString().replace(" ", "_"),
+                 confirmation ? "POTWIERDZENIE" : "PRODUKCJA");
+        const QString outputPath = QDir(dir).filePath(fileName);
+        const bool ok = confirmation ? generator.generateOrderConfirmation(orderData, clientData, items, outputPath)
+                                     : generator.generateProductionTicket(orderData, clientData, items, outputPath);
+        if (!ok) {
+            err() << "Zamówienie " << orderData.value("order_number").toString() << ": " << generator.getLastError()
+                  << "\n";
+            ++failed;
+            continue;
+        }
+        out() << outputPath << "\n";
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+int productionSummary(const QCommandLineParser& parser) {
+    const QDate from = QDate::fromString(parser.value("from"), Qt::ISODate);
+    const QDate to = QDate::fromString(parser.value("to"), Qt::ISODate);
+    if (parser.isSet("from") && !from.isValid()) return fail("Nieprawidłowa data: " + parser.value("from"));
+    if (parser.isSet("to") && !to.isValid()) return fail("Nieprawidłowa data: " + parser.value("to"));
+    const QVector<Order::Status> statuses = parseStatuses(parser.value("status"));
+    if (statuses.isEmpty()) return fail("Nieprawidłowe statusy: " + parser.value("status"));
+
+    const QList<ProductionGroup> groups = DbManager::instance().getProductionGroups(from, to, statuses);
+    writeRow({"material", "dimensions", "core", "quantity", "quantity_type", "roll_length", "roll_count",
+              "total_price", "order_count", "orders"});
+    for (const ProductionGroup& group : groups) {
+        writeRow({group.material, group.dimensions, group.core, QString::number(group.quantity, 'f', 2),
+                  group.quantityType, QString::number(group.rollLength), QString::number(group.rollCount),
+                  QString::number(group.totalPrice, 'f', 2), QString::number(group.orderCount),
+                  group.orderNumbers.join(", ")});
+    }
+    return 0;
+}
+
+int archiveOrders(const QCommandLineParser& parser) {
+    const int days = parser.isSet("days") ? parser.value("days").toInt() : -1;
+    const int moved = DbManager::instance().archiveCompletedOrders(days);
+    if (moved < 0) return fail("Archiwizacja nieudana: " + dbError());
+    out() << "Przeniesiono do archiwum: " << moved << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Te same ustawienia (baza, katalogi) co w programie z oknami
+    QCoreApplication::setOrganizationName("TwojaFirma");
+    QCoreApplication::setApplicationName("EtykietyManager");
+    QCoreApplication::setApplicationVersion("2.0.0");
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Etykiety Manager bez okien.\n\n"
+        "Polecenia:\n"
+        "  orders                      lista zamówień (TSV)\n"
+        "  export <katalog>            wszystkie tabele do plików CSV/NDJSON\n"
+        "  export-table <tabela> <plik>\n"
+        "  import <katalog>            pliki tabel z katalogu (nadpisuje wiersze o tym samym id)\n"
+        "  pdf confirmation|production <katalog> [numery zamówień...]\n"
+        "                              PDF potwierdzeń / zleceń produkcyjnych; bez numerów -\n"
+        "                              wszystkie zamówienia o statusach z --status\n"
+        "  production                  podsumowanie produkcji (TSV)\n"
+        "  rebuild-rollup              przelicza tabelę production_rollup od zera\n"
+        "  archive                     przenosi zrealizowane zamówienia do archiwum");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("polecenie", "orders, export, export-table, import, pdf, production, "
+                                              "rebuild-rollup, archive");
+    parser.addOptions({
+        {"filter", "Filtr listy zamówień.", "tekst"},
+        {"field", "Pole filtra: order, client-number, client-name.", "pole", "order"},
+        {"archive", "Lista zamówień także z archiwum."},
+        {"limit", "Najwyżej tyle zamówień na liście.", "n", "0"},
+        {"status", "Statusy zamówień (0 przyjęte, 1 produkcja, 2 gotowe, 3 zrealizowane), np. 0,1,2.",
+         "lista", "0,1,2"},
+        {"from", "Podsumowanie produkcji: dostawa od (RRRR-MM-DD).", "data"},
+        {"to", "Podsumowanie produkcji: dostawa do (RRRR-MM-DD).", "data"},
+        {"format", "Format eksportu: csv albo ndjson.", "format", "csv"},
+        {"days", "Archiwizacja: zamówienia starsze niż tyle dni (domyślnie z ustawień).", "dni"},
+    });
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) parser.showHelp(1);
+    const QString command = args.first();
+
+    if (!DbManager::instance().database().isOpen()) return fail("Brak połączenia z bazą danych");
+    if (DbManager::instance().isOffline()) {
+        err() << "Serwer niedostępny - praca na kopii lokalnej\n";
+    }
+
+    // Postęp importu/eksportu na standardowe wyjście błędów, żeby nie mieszać go z wynikiem
+    QObject::connect(&DbManager::instance(), &DbManager::transferProgress, [](const QString& table, qint64 rows) {
+        err() << table << ": " << rows << "\n";
+        err().flush();
+    });
+
+    int result = 0;
+    if (command == "orders") result = listOrders(parser);
+    else if (command == "export") result = exportData(args, parser);
+    else if (command == "export-table") result = exportTable(args);
+    else if (command == "import") result = importData(args);
+    else if (command == "pdf") result = generatePdfs(args, parser);
+    else if (command == "production") result = productionSummary(parser);
+    else if (command == "rebuild-rollup") {
+        result = DbManager::instance().rebuildProductionRollup() ? 0 : fail("Przeliczenie nieudane: " + dbError());
+    } else if (command == "archive") result = archiveOrders(parser);
+    else result = fail("Nieznane polecenie: " + command);
+
+    out().flush();
+    err().flush();
+    return result;
+}
@@ -0,0 +1,95 @@
+#include "async_db.h"
+
+AsyncDb::AsyncDb(DbManager& manager, int maxThreads)
+    : m_manager(manager) {
+    m_threadPool.setMaxThreadCount(qMax(1, maxThreads));
+    // Wątki żyją dłużej, żeby nie tracić ich połączeń między zadaniami
+    m_threadPool.setExpiryTimeout(5 * 60 * 1000);
+}
+
+AsyncDb::~AsyncDb() {
+    waitForDone();
+}
+
+void AsyncDb::waitForDone() {
+    m_threadPool.waitForDone();
+}
+
+QFuture<QVector<Order>> AsyncDb::fetchOrders() {
+    return run([](DbManager& db) { return db.fetchOrders(); });
+}
+
+QFuture<QVector<Client>> AsyncDb::fetchClients() {
+    return run([](DbManager& db) { return db.fetchClients(); });
+}
+
+QFuture<QVector<OrderItem>> AsyncDb::fetchOrderItems(int orderId) {
+    return run([orderId](DbManager& db) { return db.fetchOrderItems(orderId); });
+}
+
+QFuture<QVector<OrderListRow>> AsyncDb::fetchOrdersPage(const OrdersPageCursor& after, int limit,
+                                                        const QString& filter, OrderSearchField field,
+                                                        bool includeArchive) {
+    return run([after, limit, filter, field, includeArchive](DbManager& db) {
+        return db.fetchOrdersPage(after, limit, filter, field, includeArchive);
+    });
+}
+
+QFuture<std::optional<QVector<OrderListRow>>> AsyncDb::fetchOrderListRows(const QVector<int>& ids, const QString& filter,
+                                                                          OrderSearchField field, bool includeArchive) {
+    return run([ids, filter, field, includeArchive](DbManager& db) {
+        return db.fetchOrderListRows(ids, filter, field, includeArchive);
+    });
+}
+
+QFuture<std::optional<QVector<Order>>> AsyncDb::fetchOrdersByIds(const QVector<int>& ids) {
+    return run([ids](DbManager& db) { return db.fetchOrdersByIds(ids); });
+}
+
+QFuture<QVector<QMap<QString, QVariant>>> AsyncDb::getOrders() {
+    return run([](DbManager& db) { return db.getOrders(); });
+}
+
+QFuture<QVector<QMap<QString, QVariant>>> AsyncDb::getClients() {
+    return run([](DbManager& db) { return db.getClients(); });
+}
+
+QFuture<QVector<QMap<QString, QVariant>>> AsyncDb::getOrderItems(int orderId) {
+    return run([orderId](DbManager& db) { return db.getOrderItems(orderId); });
+}
+
+QFuture<bool> AsyncDb::addOrder(const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
+    return run([orderData, items](DbManager& db) { return db.addOrder(orderData, items); });
+}
+
+QFuture<bool> AsyncDb::updateOrder(int id, const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
+    return run([id, orderData, items](DbManager& db) { return db.updateOrder(id, orderData, items); });
+}
+
+QFuture<bool> AsyncDb::deleteOrder(int id) {
+    return run([id](DbManager& db) { return db.deleteOrder(id); });
+}
+
+QFuture<bool> AsyncDb::updateOrderStatus(int id, Order::Status status) {
+    return run([id, status](DbManager& db) { return db.updateOrderStatus(id, status); });
+}
+
+QFuture<bool> AsyncDb::updateOrderDeliveryDate(int id, const QDate& newDate) {
+    return run([id, newDate](DbManager& db) { return db.updateOrderDeliveryDate(id, newDate); });
+}
+
+QFuture<bool> AsyncDb::deleteClient(int id) {
+    return run([id](DbManager& db) { return db.deleteClient(id); });
+}
+
+QFuture<bool> AsyncDb::exportAll(const QString& directory, TransferFormat format) {
+    return run([directory, format](DbManager& db) { return db.exportAll(directory, format); });
+}
+
+QFuture<bool> AsyncDb::importAll(const QString& directory) {
+    return run([directory](DbManager& db) { return db.importAll(directory); });
+}
+
+QFuture<bool> AsyncDb::rebuildProductionRollup() {
+    return run([](DbManager& db) { return db.rebuildProductionRollup(); });
+}
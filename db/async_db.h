@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QVector>
+#include <QMap>
+#include <QVariant>
+#include <QDate>
+#include <type_traits>
+#include "dbmanager.h"
+
+/**
+ * @brief Asynchroniczna fasada nad DbManager
+ *
+ * Każde zadanie wykonuje się na osobnej puli wątków z własnym połączeniem
+ * wypożyczonym z ConnectionPool, więc wolne zapytania nie blokują wątku GUI.
+ * Wyniki odbiera się przez QFutureWatcher (sygnał finished() przychodzi w
+ * wątku właściciela watchera) albo QFuture::then(context, ...).
+ *
+ * Przykład:
+ *   auto* watcher = new QFutureWatcher<QVector<Order>>(this);
+ *   connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() { ... });
+ *   watcher->setFuture(DbManager::instance().async().fetchOrders());
+ */
+class AsyncDb {
+public:
+    explicit AsyncDb(DbManager& manager, int maxThreads = 2);
+    ~AsyncDb();
+
+    AsyncDb(const AsyncDb&) = delete;
+    AsyncDb& operator=(const AsyncDb&) = delete;
+
+    // Wykonuje dowolną operację DbManager w wątku roboczym
+    template <typename Fn>
+    auto run(Fn fn) -> QFuture<std::invoke_result_t<Fn, DbManager&>>;
+
+    // --- Odczyty ---
+    QFuture<QVector<Order>> fetchOrders();
+    QFuture<QVector<Client>> fetchClients();
+    QFuture<QVector<OrderItem>> fetchOrderItems(int orderId);
+    QFuture<QVector<OrderListRow>> fetchOrdersPage(const OrdersPageCursor& after, int limit,
+                                                   const QString& filter = QString(),
+                                                   OrderSearchField field = OrderSearchField::OrderNumber,
+                                                   bool includeArchive = false);
+    QFuture<std::optional<QVector<OrderListRow>>> fetchOrderListRows(const QVector<int>& ids, const QString& filter = QString(),
+                                                                     OrderSearchField field = OrderSearchField::OrderNumber,
+                                                                     bool includeArchive = false);
+    QFuture<std::optional<QVector<Order>>> fetchOrdersByIds(const QVector<int>& ids);
+    QFuture<QVector<QMap<QString, QVariant>>> getOrders();
+    QFuture<QVector<QMap<QString, QVariant>>> getClients();
+    QFuture<QVector<QMap<QString, QVariant>>> getOrderItems(int orderId);
+
+    // --- Zapisy ---
+    QFuture<bool> addOrder(const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items);
+    QFuture<bool> updateOrder(int id, const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items);
+    QFuture<bool> deleteOrder(int id);
+    QFuture<bool> updateOrderStatus(int id, Order::Status status);
+    QFuture<bool> updateOrderDeliveryDate(int id, const QDate& newDate);
+    QFuture<bool> deleteClient(int id);
+
+    // --- Import/eksport (postęp: DbManager::transferProgress) ---
+    QFuture<bool> exportAll(const QString& directory, TransferFormat format);
+    QFuture<bool> importAll(const QString& directory);
+
+    // --- Utrzymanie ---
+    QFuture<bool> rebuildProductionRollup();
+
+    // Czeka na zakończenie wszystkich zadań (np. przy zamykaniu aplikacji)
+    void waitForDone();
+
+private:
+    DbManager& m_manager;
+    QThreadPool m_threadPool;
+};
+
+template <typename Fn>
+auto AsyncDb::run(Fn fn) -> QFuture<std::invoke_result_t<Fn, DbManager&>> {
+    DbManager* manager = &m_manager;
+    return QtConcurrent::run(&m_threadPool, [manager, fn = std::move(fn)]() {
+        // Połączenie wraca do puli po zakończeniu zadania; jeśli przez
+        // POOLED_CONNECTION_TIMEOUT_MS nie zwolni się żadne, zapytania zwrócą
+        // błąd (lastError) zamiast czekać bez końca albo użyć połączenia GUI
+        ConnectionLease lease = manager->leaseConnection(DbManager::POOLED_CONNECTION_TIMEOUT_MS);
+        DbManager::ThreadConnectionScope scope(lease.database());
+        return fn(*manager);
+    });
+}
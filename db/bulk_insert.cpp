@@ -0,0 +1,25 @@
+#include "bulk_insert.h"
+#include <QSqlQuery>
+
+namespace BulkInsert {
+
+int rowsPerStatement(int columnCount) {
+    if (columnCount <= 0) return 1;
+    return qBound(1, MAX_PARAMETERS / columnCount, MAX_ROWS_PER_STATEMENT);
+}
+
+QString statement(const QString& table, const QStringList& columns, int rowCount) {
+    const QString rowPlaceholders = "(" + QStringList(columns.size(), "?").join(", ") + ")";
+    QStringList values;
+    values.reserve(rowCount);
+    for (int i = 0; i < rowCount; ++i) values << rowPlaceholders;
+    return QString("INSERT INTO %1 (%2) VALUES %3").arg(table, columns.join(", "), values.join(", "));
+}
+
+void bindRows(QSqlQuery& query, const QVector<QVariantList>& rows, int first, int count) {
+    for (int row = first; row < first + count; ++row) {
+        for (const QVariant& value : rows.at(row)) query.addBindValue(value);
+    }
+}
+
+} // namespace BulkInsert
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class QSqlQuery;
+
+/**
+ * @brief Wielowierszowe INSERT ... VALUES (...), (...) dla PostgreSQL i SQLite
+ *
+ * Zamiast jednego zapytania na wiersz wysyłamy porcje wierszy w jednym
+ * zapytaniu. Wielkość porcji ograniczona jest liczbą parametrów - starsze
+ * wersje SQLite przyjmują najwyżej 999 parametrów w zapytaniu.
+ */
+namespace BulkInsert {
+
+constexpr int MAX_PARAMETERS = 999;
+constexpr int MAX_ROWS_PER_STATEMENT = 100;
+
+// Liczba wierszy w jednym zapytaniu dla tabeli o podanej liczbie kolumn
+int rowsPerStatement(int columnCount);
+
+// "INSERT INTO table (a, b) VALUES (?, ?), (?, ?)" dla rowCount wierszy
+QString statement(const QString& table, const QStringList& columns, int rowCount);
+
+// Wiąże wartości wierszy rows[first, first + count) w kolejności placeholderów
+void bindRows(QSqlQuery& query, const QVector<QVariantList>& rows, int first, int count);
+
+} // namespace BulkInsert
@@ -0,0 +1,260 @@
+#include "change_feed.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+// Tabele obserwowane przez feed
+const QStringList kWatchedTables = {"orders", "order_items", "clients", "suppliers", "materials_catalog"};
+// Po tylu odpytaniach change_log usuwamy stare wpisy
+const int kPrunePolls = 100;
+// Ile wpisów change_log zostawiamy za ostatnio odczytanym
+const int kChangeLogRetention = 10000;
+const int kFlushDelayMs = 150;
+}
+
+ChangeFeed::ChangeFeed(QObject* parent) : QObject(parent) {
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &ChangeFeed::flush);
+}
+
+bool ChangeFeed::start(const QSqlDatabase& connection, int pollIntervalMs) {
+    stop();
+    m_connection = connection;
+    if (!m_connection.isOpen()) return false;
+
+    if (m_connection.driverName() == "QPSQL") {
+        if (!installPostgres()) return false;
+        QSqlDriver* driver = m_connection.driver();
+        if (!driver->subscribeToNotification(CHANNEL)) {
+            qWarning() << "[ChangeFeed] Nie można nasłuchiwać kanału" << CHANNEL << ":" << driver->lastError().text();
+            return false;
+        }
+        connect(driver, &QSqlDriver::notification, this, &ChangeFeed::onNotification, Qt::UniqueConnection);
+    } else if (m_connection.driverName() == "QSQLITE") {
+        if (!installSqlite()) return false;
+        QSqlQuery q(m_connection);
+        // Zgłaszamy tylko zmiany nowsze niż start aplikacji
+        if (q.exec("SELECT COALESCE(MAX(seq), 0) FROM change_log") && q.next()) {
+            m_lastSeq = q.value(0).toLongLong();
+        }
+        m_pollTimer = new QTimer(this);
+        m_pollTimer->setInterval(qMax(250, pollIntervalMs));
+        connect(m_pollTimer, &QTimer::timeout, this, &ChangeFeed::poll);
+        m_pollTimer->start();
+    } else {
+        return false;
+    }
+    m_active = true;
+    qDebug() << "[ChangeFeed] Nasłuch zmian aktywny (" << m_connection.driverName() << ")";
+    return true;
+}
+
+void ChangeFeed::stop() {
+    if (!m_active) return;
+    if (m_connection.driverName() == "QPSQL" && m_connection.isOpen()) {
+        m_connection.driver()->unsubscribeFromNotification(CHANNEL);
+        disconnect(m_connection.driver(), &QSqlDriver::notification, this, &ChangeFeed::onNotification);
+    }
+    if (m_pollTimer) {
+        m_pollTimer->stop();
+        m_pollTimer->deleteLater();
+        m_pollTimer = nullptr;
+    }
+    m_active = false;
+}
+
+bool ChangeFeed::installPostgres() {
+    QSqlQuery q(m_connection);
+    // Jedna funkcja dla wszystkich tabel; dla order_items przekazujemy też order_id.
+    // Ładunek: tabela:operacja:id:order_id
+    const QString function = QString(
+        "CREATE OR REPLACE FUNCTION etykiety_notify_change() RETURNS trigger AS $$ "
+        "DECLARE "
+        "    rec RECORD; "
+        "    parent TEXT := ''; "
+        "BEGIN "
+        "    IF TG_OP = 'DELETE' THEN rec := OLD; ELSE rec := NEW; END IF; "
+        "    IF TG_TABLE_NAME = 'order_items' THEN parent := COALESCE(rec.order_id::text, ''); END IF; "
+        "    PERFORM pg_notify('%1', TG_TABLE_NAME || ':' || TG_OP || ':' || rec.id || ':' || parent); "
+        "    RETURN NULL; "
+        "END; "
+        "$$ LANGUAGE plpgsql").arg(CHANNEL);
+    if (!q.exec(function)) {
+        qWarning() << "[ChangeFeed] Nie można utworzyć funkcji powiadomień:" << q.lastError().text();
+        return false;
+    }
+    for (const QString& table : kWatchedTables) {
+        const QString trigger = QString("etykiety_change_%1").arg(table);
+        q.prepare("SELECT 1 FROM pg_trigger WHERE tgname = ?");
+        q.addBindValue(trigger);
+        if (q.exec() && q.next()) continue;
+        if (!q.exec(QString("CREATE TRIGGER %1 AFTER INSERT OR UPDATE OR DELETE ON %2 "
+                            "FOR EACH ROW EXECUTE FUNCTION etykiety_notify_change()").arg(trigger, table))) {
+            qWarning() << "[ChangeFeed] Nie można utworzyć triggera" << trigger << ":" << q.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChangeFeed::installSqlite() {
+    QSqlQuery q(m_connection);
+    if (!q.exec("CREATE TABLE IF NOT EXISTS change_log ("
+                "seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+                "table_name TEXT NOT NULL, "
+                "op TEXT NOT NULL, "
+                "row_id INTEGER, "
+                "order_id INTEGER, "
+                "changed_at DATETIME DEFAULT CURRENT_TIMESTAMP)")) {
+        qWarning() << "[ChangeFeed] Nie można utworzyć tabeli change_log:" << q.lastError().text();
+        return false;
+    }
+    const QList<QPair<QString, QString>> operations = {{"INSERT", "NEW"}, {"UPDATE", "NEW"}, {"DELETE", "OLD"}};
+    for (const QString& table : kWatchedTables) {
+        for (const auto& operation : operations) {
+            const QString& row = operation.second;
+            const QString orderId = table == "order_items" ? row + ".order_id" : "NULL";
+            const QString sql = QString(
+                "CREATE TRIGGER IF NOT EXISTS change_log_%1_%2 AFTER %3 ON %1 BEGIN "
+                "INSERT INTO change_log (table_name, op, row_id, order_id) VALUES ('%1', '%3', %4.id, %5); "
+                "END")
+                .arg(table, operation.first.toLower(), operation.first, row, orderId);
+            if (!q.exec(sql)) {
+                qWarning() << "[ChangeFeed] Nie można utworzyć triggera dla" << table << ":" << q.lastError().text();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ChangeFeed::removeSqlite(const QSqlDatabase& connection, QSqlError* error) {
+    QSqlQuery q(connection);
+    if (!q.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'change_log'")) {
+        if (error) *error = q.lastError();
+        return false;
+    }
+    if (!q.next()) return true;
+    q.finish();
+    for (const QString& table : kWatchedTables) {
+        for (const QString operation : {"insert", "update", "delete"}) {
+            if (!q.exec(QString("DROP TRIGGER IF EXISTS change_log_%1_%2").arg(table, operation))) {
+                qWarning() << "[ChangeFeed] Nie można usunąć triggera dla" << table << ":" << q.lastError().text();
+                if (error) *error = q.lastError();
+                return false;
+            }
+        }
+    }
+    if (!q.exec("DROP TABLE change_log")) {
+        qWarning() << "[ChangeFeed] Nie można usunąć tabeli change_log:" << q.lastError().text();
+        if (error) *error = q.lastError();
+        return false;
+    }
+    return true;
+}
+
+void ChangeFeed::onNotification(const QString& name, QSqlDriver::NotificationSource, const QVariant& payload) {
+    if (name != CHANNEL) return;
+    const QStringList parts = payload.toString().split(':');
+    if (parts.size() < 3) return;
+    RowChange change;
+    change.table = parts.at(0);
+    if (!parseOperation(parts.at(1), change.operation)) return;
+    change.id = parts.at(2).toInt();
+    if (parts.size() > 3 && !parts.at(3).isEmpty()) change.orderId = parts.at(3).toInt();
+    enqueue(change);
+}
+
+void ChangeFeed::poll() {
+    QSqlQuery q(m_connection);
+    q.setForwardOnly(true);
+    q.prepare("SELECT seq, table_name, op, row_id, order_id FROM change_log WHERE seq > ? ORDER BY seq LIMIT 1000");
+    q.addBindValue(m_lastSeq);
+    if (!q.exec()) {
+        qWarning() << "[ChangeFeed] Błąd odczytu change_log:" << q.lastError().text();
+        return;
+    }
+    while (q.next()) {
+        m_lastSeq = q.value(0).toLongLong();
+        RowChange change;
+        change.table = q.value(1).toString();
+        if (!parseOperation(q.value(2).toString(), change.operation)) continue;
+        change.id = q.value(3).toInt();
+        if (!q.value(4).isNull()) change.orderId = q.value(4).toInt();
+        enqueue(change);
+    }
+    q.finish();
+
+    if (++m_pollsSincePrune >= kPrunePolls) {
+        m_pollsSincePrune = 0;
+        QSqlQuery prune(m_connection);
+        prune.prepare("DELETE FROM change_log WHERE seq <= ?");
+        prune.addBindValue(m_lastSeq - kChangeLogRetention);
+        if (!prune.exec()) {
+            qWarning() << "[ChangeFeed] Błąd czyszczenia change_log:" << prune.lastError().text();
+        }
+    }
+}
+
+void ChangeFeed::enqueue(const RowChange& change) {
+    const QString key = change.table + ':' + QString::number(change.id);
+    auto it = m_pendingIndex.constFind(key);
+    if (it == m_pendingIndex.constEnd()) {
+        m_pendingIndex.insert(key, m_pending.size());
+        m_pending.append(change);
+    } else {
+        // Kilka zmian tego samego wiersza w jednej paczce: usunięcie wygrywa,
+        // wstawienie pozostaje wstawieniem mimo późniejszych aktualizacji
+        RowChange& existing = m_pending[it.value()];
+        if (change.operation == RowChange::Delete || existing.operation != RowChange::Insert) {
+            existing.operation = change.operation;
+        }
+        if (change.orderId >= 0) existing.orderId = change.orderId;
+    }
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void ChangeFeed::flush() {
+    if (m_pending.isEmpty()) return;
+    QVector<RowChange> changes;
+    changes.swap(m_pending);
+    m_pendingIndex.clear();
+    emit changed(changes);
+}
+
+bool ChangeFeed::parseOperation(const QString& text, RowChange::Operation& operation) {
+    if (text == "INSERT") operation = RowChange::Insert;
+    else if (text == "UPDATE") operation = RowChange::Update;
+    else if (text == "DELETE") operation = RowChange::Delete;
+    else return false;
+    return true;
+}
+
+QSet<int> ChangeFeed::changedOrderIds(const QVector<RowChange>& changes) {
+    QSet<int> ids;
+    for (const RowChange& change : changes) {
+        if (change.table == "orders") ids.insert(change.id);
+        else if (change.table == "order_items" && change.orderId >= 0) ids.insert(change.orderId);
+    }
+    return ids;
+}
+
+QSet<int> ChangeFeed::deletedOrderIds(const QVector<RowChange>& changes) {
+    QSet<int> ids;
+    for (const RowChange& change : changes) {
+        if (change.table == "orders" && change.operation == RowChange::Delete) ids.insert(change.id);
+    }
+    return ids;
+}
+
+QSet<int> ChangeFeed::changedClientIds(const QVector<RowChange>& changes) {
+    QSet<int> ids;
+    for (const RowChange& change : changes) {
+        if (change.table == "clients") ids.insert(change.id);
+    }
+    return ids;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QString>
+#include <QVector>
+#include <QSet>
+#include <QHash>
+
+class QTimer;
+class QSqlError;
+
+// Zmiana jednego wiersza zgłoszona przez bazę danych
+struct RowChange {
+    enum Operation { Insert, Update, Delete };
+
+    QString table;          // "orders", "order_items", "clients", "suppliers" lub "materials_catalog"
+    Operation operation = Update;
+    int id = -1;
+    int orderId = -1;       // dla order_items: zamówienie, do którego należy pozycja
+};
+
+/**
+ * @brief Powiadomienia o zmianach wierszy zamówień, klientów i słowników
+ *
+ * Zgłasza także zmiany zrobione na innych stanowiskach, więc widoki mogą
+ * aktualizować tylko zmienione wiersze zamiast przeładowywać całe listy.
+ *
+ * - PostgreSQL: triggery wywołują pg_notify() na kanale "etykiety_changes",
+ *   połączenie główne nasłuchuje (LISTEN) przez QSqlDriver::notification.
+ * - SQLite: triggery dopisują zmiany do tabeli change_log, którą feed
+ *   odpytuje co pollIntervalMs. Hook sqlite3_update_hook widziałby tylko
+ *   zmiany z własnego połączenia, a plik bywa współdzielony.
+ *
+ * Zmiany są zbierane przez krótką chwilę i wysyłane paczką (sygnał changed),
+ * powtórzenia tego samego wiersza są łączone.
+ */
+class ChangeFeed : public QObject {
+    Q_OBJECT
+public:
+    static constexpr const char* CHANNEL = "etykiety_changes";
+
+    explicit ChangeFeed(QObject* parent = nullptr);
+
+    // Zakłada triggery (jeśli ich brak) i zaczyna nasłuch na połączeniu,
+    // które musi należeć do bieżącego wątku. False, gdy feed nie działa.
+    bool start(const QSqlDatabase& connection, int pollIntervalMs = 2000);
+    void stop();
+    bool isActive() const { return m_active; }
+
+    // Zamówienia, których dotyczą zmiany (orders oraz pozycje z order_items)
+    static QSet<int> changedOrderIds(const QVector<RowChange>& changes);
+    static QSet<int> deletedOrderIds(const QVector<RowChange>& changes);
+    static QSet<int> changedClientIds(const QVector<RowChange>& changes);
+
+    // Usuwa triggery i tabelę change_log z pliku SQLite, na którym feed nie działa
+    // (kopia lokalna synchronizowana w tle). start() założy je ponownie.
+    static bool removeSqlite(const QSqlDatabase& connection, QSqlError* error = nullptr);
+
+signals:
+    void changed(const QVector<RowChange>& changes);
+
+private slots:
+    void onNotification(const QString& name, QSqlDriver::NotificationSource source, const QVariant& payload);
+    void poll();
+    void flush();
+
+private:
+    bool installPostgres();
+    bool installSqlite();
+    void enqueue(const RowChange& change);
+    static bool parseOperation(const QString& text, RowChange::Operation& operation);
+
+    QSqlDatabase m_connection;
+    QTimer* m_pollTimer = nullptr;
+    QTimer* m_flushTimer = nullptr;
+    QVector<RowChange> m_pending;
+    QHash<QString, int> m_pendingIndex;   // "tabela:id" -> pozycja w m_pending
+    qint64 m_lastSeq = 0;
+    int m_pollsSincePrune = 0;
+    bool m_active = false;
+};
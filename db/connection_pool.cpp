@@ -0,0 +1,245 @@
+#include "connection_pool.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThread>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QDebug>
+
+ConnectionPool::ConnectionPool(const ConnectionSettings& settings, int maxConnections)
+    : m_settings(settings), m_maxConnections(qMax(1, maxConnections)) {
+}
+
+ConnectionPool::~ConnectionPool() {
+    QStringList names;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_threadWatches.begin(); it != m_threadWatches.end(); ++it) {
+            QObject::disconnect(it.value());
+        }
+        m_threadWatches.clear();
+        for (const auto& idle : std::as_const(m_idle)) names << idle;
+        m_idle.clear();
+        if (!m_leased.isEmpty()) {
+            qWarning() << "[ConnectionPool] Niszczenie puli z wypożyczonymi połączeniami:" << m_leased.values();
+        }
+    }
+    for (const QString& name : std::as_const(names)) removeConnection(name);
+}
+
+void ConnectionPool::setMaxConnections(int maxConnections) {
+    QMutexLocker locker(&m_mutex);
+    m_maxConnections = qMax(1, maxConnections);
+    m_released.wakeAll();
+}
+
+int ConnectionPool::maxConnections() const {
+    QMutexLocker locker(&m_mutex);
+    return m_maxConnections;
+}
+
+int ConnectionPool::connectionsInUse() const {
+    QMutexLocker locker(&m_mutex);
+    return m_inUse;
+}
+
+void ConnectionPool::setConnectionInitializer(ConnectionInitializer initializer) {
+    QMutexLocker locker(&m_mutex);
+    m_initializer = std::move(initializer);
+}
+
+void ConnectionPool::setConnectionCloseHandler(ConnectionCloseHandler handler) {
+    QMutexLocker locker(&m_mutex);
+    m_closeHandler = std::move(handler);
+}
+
+void ConnectionPool::setHealthCheckInterval(int msecs) {
+    QMutexLocker locker(&m_mutex);
+    m_healthCheckIntervalMs = msecs;
+}
+
+QSqlDatabase ConnectionPool::acquire(int timeoutMs) {
+    QThread* thread = QThread::currentThread();
+    QString name;
+    bool needsHealthCheck = false;
+    bool watch = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        QDeadlineTimer deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever)
+                                                : QDeadlineTimer(timeoutMs);
+        while (m_inUse >= m_maxConnections) {
+            if (!m_released.wait(&m_mutex, deadline)) {
+                qWarning() << "[ConnectionPool] Brak wolnego połączenia po" << timeoutMs << "ms"
+                           << "(w użyciu:" << m_inUse << "/" << m_maxConnections << ")";
+                return QSqlDatabase();
+            }
+        }
+        ++m_inUse;
+        QStringList& idle = m_idle[thread];
+        if (!idle.isEmpty()) {
+            name = idle.takeLast();
+            const QElapsedTimer& lastUsed = m_lastUsed[name];
+            needsHealthCheck = !lastUsed.isValid() || lastUsed.hasExpired(m_healthCheckIntervalMs);
+        } else {
+            name = QString("pool_%1_%2")
+                       .arg(reinterpret_cast<quintptr>(thread), 0, 16)
+                       .arg(++m_nextSerial);
+        }
+        m_leased.insert(name);
+        m_owner.insert(name, thread);
+        if (!m_threadWatches.contains(thread)) watch = true;
+    }
+
+    if (watch) watchThread(thread);
+
+    QSqlDatabase connection = QSqlDatabase::contains(name) ? QSqlDatabase::database(name, false)
+                                                           : openConnection(name);
+    if (needsHealthCheck && !ensureHealthy(connection, name)) {
+        qWarning() << "[ConnectionPool] Połączenie" << name << "nie odpowiada i nie udało się go odnowić";
+    }
+    if (!connection.isOpen()) {
+        qWarning() << "[ConnectionPool] Nie można otworzyć połączenia" << name << ":" << connection.lastError().text();
+        release(name);
+        return QSqlDatabase();
+    }
+    return connection;
+}
+
+void ConnectionPool::release(const QString& connectionName) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_leased.remove(connectionName)) return;
+    --m_inUse;
+    QThread* owner = m_owner.value(connectionName, QThread::currentThread());
+    // Wątek mógł się już zakończyć - wtedy połączenie nie wraca na listę wolnych
+    if (m_threadWatches.contains(owner)) {
+        m_idle[owner].append(connectionName);
+        m_lastUsed[connectionName].start();
+    }
+    m_released.wakeOne();
+}
+
+void ConnectionPool::closeThreadConnections() {
+    QStringList names;
+    {
+        QMutexLocker locker(&m_mutex);
+        names = m_idle.take(QThread::currentThread());
+        for (const QString& name : std::as_const(names)) {
+            m_lastUsed.remove(name);
+            m_owner.remove(name);
+        }
+    }
+    for (const QString& name : std::as_const(names)) removeConnection(name);
+}
+
+QSqlDatabase ConnectionPool::openConnection(const QString& connectionName) {
+    ConnectionInitializer initializer;
+    {
+        QMutexLocker locker(&m_mutex);
+        initializer = m_initializer;
+    }
+    QSqlDatabase connection = QSqlDatabase::addDatabase(m_settings.driver, connectionName);
+    if (!m_settings.hostName.isEmpty()) connection.setHostName(m_settings.hostName);
+    if (m_settings.port > 0) connection.setPort(m_settings.port);
+    connection.setDatabaseName(m_settings.databaseName);
+    if (!m_settings.userName.isEmpty()) connection.setUserName(m_settings.userName);
+    if (!m_settings.password.isEmpty()) connection.setPassword(m_settings.password);
+    if (!m_settings.connectOptions.isEmpty()) connection.setConnectOptions(m_settings.connectOptions);
+    if (connection.open()) {
+        if (initializer) initializer(connection);
+    }
+    return connection;
+}
+
+bool ConnectionPool::ensureHealthy(QSqlDatabase& connection, const QString& connectionName) {
+    if (connection.isOpen()) {
+        QSqlQuery ping(connection);
+        if (ping.exec("SELECT 1")) return true;
+        qWarning() << "[ConnectionPool] Test połączenia" << connectionName << "nieudany:" << ping.lastError().text();
+    }
+    notifyClosing(connectionName);
+    connection.close();
+    if (!connection.open()) return false;
+    ConnectionInitializer initializer;
+    {
+        QMutexLocker locker(&m_mutex);
+        initializer = m_initializer;
+    }
+    if (initializer) initializer(connection);
+    return true;
+}
+
+void ConnectionPool::watchThread(QThread* thread) {
+    // finished() jest emitowany w kończącym się wątku, więc połączenia
+    // zamykamy tam, gdzie zostały utworzone
+    QMetaObject::Connection watch = QObject::connect(thread, &QThread::finished, [this, thread]() {
+        QStringList names;
+        {
+            QMutexLocker locker(&m_mutex);
+            QObject::disconnect(m_threadWatches.take(thread));
+            names = m_idle.take(thread);
+            for (auto it = m_owner.begin(); it != m_owner.end();) {
+                if (it.value() == thread) {
+                    if (m_leased.contains(it.key())) {
+                        qWarning() << "[ConnectionPool] Wątek zakończył się z wypożyczonym połączeniem" << it.key();
+                    }
+                    m_lastUsed.remove(it.key());
+                    it = m_owner.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (const QString& name : std::as_const(names)) removeConnection(name);
+    });
+    QMutexLocker locker(&m_mutex);
+    m_threadWatches.insert(thread, watch);
+}
+
+void ConnectionPool::notifyClosing(const QString& connectionName) {
+    ConnectionCloseHandler handler;
+    {
+        QMutexLocker locker(&m_mutex);
+        handler = m_closeHandler;
+    }
+    if (handler) handler(connectionName);
+}
+
+void ConnectionPool::removeConnection(const QString& connectionName) {
+    notifyClosing(connectionName);
+    {
+        QSqlDatabase connection = QSqlDatabase::database(connectionName, false);
+        if (connection.isOpen()) connection.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+ConnectionLease::ConnectionLease(ConnectionPool& pool, int timeoutMs)
+    : m_pool(&pool), m_db(pool.acquire(timeoutMs)) {
+}
+
+ConnectionLease::~ConnectionLease() {
+    release();
+}
+
+ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+    : m_pool(other.m_pool), m_db(std::move(other.m_db)) {
+    other.m_db = QSqlDatabase();
+}
+
+ConnectionLease& ConnectionLease::operator=(ConnectionLease&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_db = std::move(other.m_db);
+        other.m_db = QSqlDatabase();
+    }
+    return *this;
+}
+
+void ConnectionLease::release() {
+    if (m_pool && m_db.isValid()) {
+        QString name = m_db.connectionName();
+        m_db = QSqlDatabase();
+        m_pool->release(name);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QObject>
+#include <functional>
+
+class QThread;
+
+// Parametry połączenia wspólne dla wszystkich połączeń w puli
+struct ConnectionSettings {
+    QString driver;          // "QPSQL" lub "QSQLITE"
+    QString hostName;
+    int port = -1;
+    QString databaseName;    // nazwa bazy lub ścieżka pliku SQLite
+    QString userName;
+    QString password;
+    QString connectOptions;
+};
+
+/**
+ * @brief Pula połączeń bezpieczna wątkowo
+ *
+ * QSqlDatabase może być używane wyłącznie w wątku, który je utworzył, dlatego
+ * pula trzyma osobną listę połączeń dla każdego wątku i tworzy je leniwie przy
+ * pierwszym acquire() w danym wątku. Limit maxConnections dotyczy liczby
+ * jednocześnie wypożyczonych połączeń we wszystkich wątkach.
+ */
+class ConnectionPool {
+public:
+    // Wywoływane po otwarciu każdego nowego połączenia (np. ustawienia PRAGMA)
+    using ConnectionInitializer = std::function<void(QSqlDatabase&)>;
+    // Wywoływane w wątku właściciela tuż przed zamknięciem połączenia
+    using ConnectionCloseHandler = std::function<void(const QString& connectionName)>;
+
+    explicit ConnectionPool(const ConnectionSettings& settings, int maxConnections = 4);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    void setMaxConnections(int maxConnections);
+    int maxConnections() const;
+    int connectionsInUse() const;
+
+    void setConnectionInitializer(ConnectionInitializer initializer);
+    void setConnectionCloseHandler(ConnectionCloseHandler handler);
+
+    // Czas bezczynności, po którym połączenie jest sprawdzane przed wydaniem
+    void setHealthCheckInterval(int msecs);
+
+    // Wypożycza połączenie dla bieżącego wątku. timeoutMs < 0 - czeka bez limitu,
+    // 0 - nie czeka wcale. Zwraca nieprawidłowe QSqlDatabase przy przekroczeniu czasu.
+    QSqlDatabase acquire(int timeoutMs = -1);
+    void release(const QString& connectionName);
+
+    // Zamyka i usuwa wszystkie bezczynne połączenia bieżącego wątku
+    void closeThreadConnections();
+
+private:
+    QSqlDatabase openConnection(const QString& connectionName);
+    bool ensureHealthy(QSqlDatabase& connection, const QString& connectionName);
+    void watchThread(QThread* thread);
+    void notifyClosing(const QString& connectionName);
+    void removeConnection(const QString& connectionName);
+
+    ConnectionSettings m_settings;
+    ConnectionInitializer m_initializer;
+    ConnectionCloseHandler m_closeHandler;
+    int m_maxConnections;
+    int m_inUse = 0;
+    int m_healthCheckIntervalMs = 30000;
+    quint64 m_nextSerial = 0;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_released;
+    QHash<QThread*, QStringList> m_idle;              // wolne połączenia per wątek
+    QHash<QString, QElapsedTimer> m_lastUsed;          // nazwa -> czas od ostatniego zwrotu
+    QSet<QString> m_leased;
+    QHash<QString, QThread*> m_owner;                   // nazwa -> wątek właściciela
+    QHash<QThread*, QMetaObject::Connection> m_threadWatches;
+};
+
+// RAII: połączenie wraca do puli przy wyjściu z zakresu
+class ConnectionLease {
+public:
+    explicit ConnectionLease(ConnectionPool& pool, int timeoutMs = -1);
+    ~ConnectionLease();
+
+    ConnectionLease(ConnectionLease&& other) noexcept;
+    ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+    bool isValid() const { return m_db.isValid(); }
+    QSqlDatabase database() const { return m_db; }
+    void release();
+
+private:
+    ConnectionPool* m_pool;
+    QSqlDatabase m_db;
+};
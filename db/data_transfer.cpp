@@ -0,0 +1,533 @@
+#include "data_transfer.h"
+#include "bulk_insert.h"
+#include "models/numeric_value.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QSqlQuery>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+#ifdef ETYKIETY_HAVE_LIBPQ
+#include <QSqlDriver>
+#include <libpq-fe.h>
+#endif
+
+namespace {
+QSqlError transferError(const QString& text) {
+    return QSqlError(QString(), text, QSqlError::UnknownError);
+}
+
+void reportError(const QSqlError& sqlError, QSqlError* error) {
+    if (error) *error = sqlError;
+}
+
+// Kolumny tabeli: id pierwsze, reszta alfabetycznie
+QStringList tableColumns(const SchemaCatalog& schema, const QString& table) {
+    QStringList columns = schema.columns(table);
+    const bool hasId = columns.removeAll("id") > 0;
+    std::sort(columns.begin(), columns.end());
+    if (hasId) columns.prepend("id");
+    return columns;
+}
+
+QString valueText(const QVariant& value) {
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+        return value.toBool() ? "1" : "0";
+    case QMetaType::QDateTime:
+        return value.toDateTime().toString(Qt::ISODateWithMs);
+    default:
+        return value.toString();
+    }
+}
+
+// Pole CSV: NULL - puste pole, pusty tekst - "" (tak samo jak COPY ... CSV)
+QString csvField(const QVariant& value) {
+    if (value.isNull()) return QString();
+    QString text = valueText(value);
+    if (!text.isEmpty() && !text.contains(',') && !text.contains('"') && !text.contains('\n') && !text.contains('\r')) {
+        return text;
+    }
+    text.replace("\"", "\"\"");
+    return "\"" + text + "\"";
+}
+
+QString csvLine(const QVariantList& values) {
+    QStringList fields;
+    fields.reserve(values.size());
+    for (const QVariant& value : values) fields << csvField(value);
+    return fields.join(',') + '\n';
+}
+
+QJsonValue jsonValue(const QVariant& value) {
+    if (value.isNull()) return QJsonValue(QJsonValue::Null);
+    switch (value.typeId()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return QJsonValue(value.toLongLong());
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return QJsonValue(value.toDouble());
+    case QMetaType::Bool:
+        return QJsonValue(value.toBool());
+    default:
+        return QJsonValue(valueText(value));
+    }
+}
+
+// Wartość z pliku w typie kolumny; tekst, którego nie da się odczytać, trafia do bazy bez zmian
+QVariant typedValue(const QString& columnType, const QVariant& value) {
+    if (value.isNull()) return QVariant();
+    const QString type = columnType.toLower();
+    const QString text = value.toString();
+    bool ok = false;
+    if (type.contains("int")) {
+        const qlonglong number = text.toLongLong(&ok);
+        if (ok) return number;
+    } else if (type == QLatin1String("double precision") || type == QLatin1String("real")
+               || type == QLatin1String("numeric")) {
+        const double number = text.toDouble(&ok);
+        if (ok) return number;
+    }
+    return text;
+}
+
+// Wiersze pliku importu w kolejności kolumn nagłówka (CSV) albo kluczy pierwszego obiektu (NDJSON)
+class RowReader {
+public:
+    RowReader(QIODevice& in, TransferFormat format) : m_in(in), m_format(format) {}
+
+    // false przy pustym pliku (error pusty) albo błędzie
+    bool readHeader(QStringList& columns, QString& error) {
+        if (m_format == TransferFormat::Csv) {
+            QVariantList fields;
+            if (!readCsvRecord(fields, error)) return false;
+            for (const QVariant& field : fields) columns << field.toString().trimmed();
+            // BOM z arkusza kalkulacyjnego
+            if (!columns.isEmpty() && columns.first().startsWith(QChar(0xFEFF))) columns.first().remove(0, 1);
+        } else {
+            QJsonObject object;
+            if (!readJsonObject(object, error)) return false;
+            columns = object.keys();
+            m_pending = object;
+            m_hasPending = true;
+        }
+        m_columns = columns;
+        return true;
+    }
+
+    // false na końcu pliku albo przy błędzie (error niepusty)
+    bool next(QVariantList& values, QString& error) {
+        values.clear();
+        if (m_format == TransferFormat::Csv) {
+            if (!readCsvRecord(values, error)) return false;
+            if (values.size() != m_columns.size()) {
+                error = QString("Wiersz %1: %2 pól zamiast %3").arg(m_line).arg(values.size()).arg(m_columns.size());
+                return false;
+            }
+            return true;
+        }
+        QJsonObject object;
+        if (m_hasPending) {
+            object = m_pending;
+            m_hasPending = false;
+        } else if (!readJsonObject(object, error)) {
+            return false;
+        }
+        for (const QString& column : m_columns) values << object.value(column).toVariant();
+        return true;
+    }
+
+private:
+    QIODevice& m_in;
+    TransferFormat m_format;
+    QStringList m_columns;
+    QJsonObject m_pending;
+    bool m_hasPending = false;
+    int m_line = 0;
+
+    // Rekord CSV (RFC 4180), także z podziałami wierszy w polach w cudzysłowie.
+    // Puste pole bez cudzysłowu to NULL. Linia bez żadnego znaku przed końcem
+    // wiersza jest pomijana - poza tabelą z jedną kolumną, gdzie to wiersz z NULL
+    // (tak zapisuje go csvLine i COPY ... CSV).
+    bool readCsvRecord(QVariantList& fields, QString& error) {
+        while (!m_in.atEnd()) {
+            fields.clear();
+            QString field;
+            bool quoted = false;
+            bool inQuotes = false;
+            bool emptyLine = true;
+            do {
+                const QString line = QString::fromUtf8(m_in.readLine());
+                if (emptyLine && line != QLatin1String("\n") && line != QLatin1String("\r\n")) emptyLine = false;
+                ++m_line;
+                for (int i = 0; i < line.size(); ++i) {
+                    const QChar c = line.at(i);
+                    if (inQuotes) {
+                        if (c != '"') {
+                            field += c;
+                        } else if (i + 1 < line.size() && line.at(i + 1) == '"') {
+                            field += c;
+                            ++i;
+                        } else {
+                            inQuotes = false;
+                        }
+                    } else if (c == '"' && field.isEmpty() && !quoted) {
+                        quoted = inQuotes = true;
+                    } else if (c == ',') {
+                        fields << (quoted || !field.isEmpty() ? QVariant(field) : QVariant());
+                        field.clear();
+                        quoted = false;
+                    } else if (c == '\r' || c == '\n') {
+                        break;
+                    } else {
+                        field += c;
+                    }
+                }
+            } while (inQuotes && !m_in.atEnd());
+            if (inQuotes) {
+                error = QString("Wiersz %1: niezamknięty cudzysłów").arg(m_line);
+                return false;
+            }
+            if (emptyLine && m_columns.size() != 1) continue;
+            fields << (quoted || !field.isEmpty() ? QVariant(field) : QVariant());
+            return true;
+        }
+        return false;
+    }
+
+    bool readJsonObject(QJsonObject& object, QString& error) {
+        while (!m_in.atEnd()) {
+            const QByteArray line = m_in.readLine().trimmed();
+            ++m_line;
+            if (line.isEmpty()) continue;
+            QJsonParseError parseError;
+            const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+            if (!document.isObject()) {
+                error = QString("Wiersz %1: %2").arg(m_line).arg(parseError.error == QJsonParseError::NoError
+                                                                     ? QString("oczekiwano obiektu JSON")
+                                                                     : parseError.errorString());
+                return false;
+            }
+            object = document.object();
+            return true;
+        }
+        return false;
+    }
+};
+
+#ifdef ETYKIETY_HAVE_LIBPQ
+// Połączenie libpq pod połączeniem QPSQL; nullptr dla innych sterowników
+PGconn* pgConnection(const QSqlDatabase& connection) {
+    if (connection.driverName() != "QPSQL") return nullptr;
+    const QVariant handle = connection.driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "PGconn*") != 0) return nullptr;
+    return *static_cast<PGconn* const*>(handle.constData());
+}
+
+QSqlError pgError(PGconn* pg) {
+    return QSqlError(QString(), QString::fromUtf8(PQerrorMessage(pg)).trimmed(), QSqlError::StatementError);
+}
+
+// Wynik zakończonego COPY i pozostałe wyniki polecenia
+bool finishCopy(PGconn* pg) {
+    bool ok = true;
+    while (PGresult* result = PQgetResult(pg)) {
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) ok = false;
+        PQclear(result);
+    }
+    return ok;
+}
+
+bool startCopy(PGconn* pg, const QString& sql, ExecStatusType expected) {
+    PGresult* result = PQexec(pg, sql.toUtf8().constData());
+    const bool started = PQresultStatus(result) == expected;
+    PQclear(result);
+    return started;
+}
+#endif
+
+// Porcja wierszy importu: COPY do tabeli tymczasowej (libpq) albo wielowierszowe INSERT
+class BatchWriter {
+public:
+    BatchWriter(const QSqlDatabase& connection, const QString& table, const QStringList& columns)
+        : m_connection(connection), m_table(table), m_columns(columns),
+          m_chunkRows(BulkInsert::rowsPerStatement(columns.size())) {
+        // Wiersz z id istniejącym w tabeli nadpisuje go
+        if (columns.contains("id")) {
+            QStringList assignments;
+            for (const QString& column : columns) {
+                if (column != QLatin1String("id")) assignments << QString("%1 = excluded.%1").arg(column);
+            }
+            m_conflict = assignments.isEmpty() ? " ON CONFLICT (id) DO NOTHING"
+                                               : " ON CONFLICT (id) DO UPDATE SET " + assignments.join(", ");
+        }
+#ifdef ETYKIETY_HAVE_LIBPQ
+        m_pg = pgConnection(connection);
+#endif
+    }
+
+    bool write(const QVector<QVariantList>& rows, QSqlError* error) {
+        if (rows.isEmpty()) return true;
+        m_connection.transaction();
+#ifdef ETYKIETY_HAVE_LIBPQ
+        const bool ok = m_pg ? copyRows(rows, error) : insertRows(rows, error);
+#else
+        const bool ok = insertRows(rows, error);
+#endif
+        if (!ok || !m_connection.commit()) {
+            if (ok) reportError(m_connection.lastError(), error);
+            m_connection.rollback();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QSqlDatabase m_connection;
+    QString m_table;
+    QStringList m_columns;
+    QString m_conflict;
+    int m_chunkRows;
+    // Pełne porcje mają ten sam tekst SQL - przygotowane raz
+    std::unique_ptr<QSqlQuery> m_fullChunk;
+#ifdef ETYKIETY_HAVE_LIBPQ
+    PGconn* m_pg = nullptr;
+
+    bool copyRows(const QVector<QVariantList>& rows, QSqlError* error) {
+        const QString list = m_columns.join(", ");
+        QSqlQuery q(m_connection);
+        if (!q.exec(QString("CREATE TEMP TABLE etykiety_import ON COMMIT DROP AS SELECT %1 FROM %2 WHERE false")
+                        .arg(list, m_table))) {
+            reportError(q.lastError(), error);
+            return false;
+        }
+        if (!startCopy(m_pg, QString("COPY etykiety_import (%1) FROM STDIN WITH (FORMAT csv)").arg(list), PGRES_COPY_IN)) {
+            reportError(pgError(m_pg), error);
+            return false;
+        }
+        for (const QVariantList& row : rows) {
+            const QByteArray line = csvLine(row).toUtf8();
+            if (PQputCopyData(m_pg, line.constData(), line.size()) != 1) {
+                PQputCopyEnd(m_pg, "przerwano");
+                finishCopy(m_pg);
+                reportError(pgError(m_pg), error);
+                return false;
+            }
+        }
+        if (PQputCopyEnd(m_pg, nullptr) != 1 || !finishCopy(m_pg)) {
+            reportError(pgError(m_pg), error);
+            return false;
+        }
+        if (!q.exec(QString("INSERT INTO %1 (%2) SELECT %2 FROM etykiety_import%3").arg(m_table, list, m_conflict))) {
+            reportError(q.lastError(), error);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    bool insertRows(const QVector<QVariantList>& rows, QSqlError* error) {
+        for (int first = 0; first < rows.size(); first += m_chunkRows) {
+            const int count = qMin(m_chunkRows, static_cast<int>(rows.size()) - first);
+            const QString sql = BulkInsert::statement(m_table, m_columns, count) + m_conflict;
+            QSqlQuery partial(m_connection);
+            QSqlQuery* q = &partial;
+            if (count == m_chunkRows) {
+                if (!m_fullChunk) {
+                    m_fullChunk = std::make_unique<QSqlQuery>(m_connection);
+                    m_fullChunk->prepare(sql);
+                }
+                q = m_fullChunk.get();
+            } else {
+                partial.prepare(sql);
+            }
+            BulkInsert::bindRows(*q, rows, first, count);
+            if (!q->exec()) {
+                qWarning() << "[Import] Błąd wstawiania wierszy do" << m_table << ":" << q->lastError().text();
+                reportError(q->lastError(), error);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+}
+
+const QStringList& DataTransfer::tables() {
+    static const QStringList list = {
+        "clients", "delivery_addresses", "suppliers", "materials_catalog",
+        "orders", "order_items", "orders_archive", "order_items_archive",
+        "materials_orders", "materials_order_items",
+    };
+    return list;
+}
+
+TransferFormat DataTransfer::formatForPath(const QString& path) {
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == QLatin1String("ndjson") || suffix == QLatin1String("jsonl") ? TransferFormat::NdJson
+                                                                                  : TransferFormat::Csv;
+}
+
+QString DataTransfer::fileExtension(TransferFormat format) {
+    return format == TransferFormat::NdJson ? "ndjson" : "csv";
+}
+
+bool DataTransfer::exportTable(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& table,
+                               QIODevice& out, TransferFormat format, const Progress& progress, QSqlError* error) {
+    if (!schema.hasTable(table)) {
+        reportError(transferError(QString("Brak tabeli %1").arg(table)), error);
+        return false;
+    }
+    const QStringList columns = tableColumns(schema, table);
+    const QString select = QString("SELECT %1 FROM %2%3")
+                               .arg(columns.join(", "), table, columns.contains("id") ? " ORDER BY id" : "");
+    qint64 rows = 0;
+
+#ifdef ETYKIETY_HAVE_LIBPQ
+    if (PGconn* pg = format == TransferFormat::Csv ? pgConnection(connection) : nullptr) {
+        if (!startCopy(pg, QString("COPY (%1) TO STDOUT WITH (FORMAT csv, HEADER true)").arg(select), PGRES_COPY_OUT)) {
+            reportError(pgError(pg), error);
+            return false;
+        }
+        char* buffer = nullptr;
+        int size = 0;
+        bool written = true;
+        // Jeden wiersz na wywołanie; pierwszy to nagłówek
+        while ((size = PQgetCopyData(pg, &buffer, 0)) > 0) {
+            written = written && out.write(buffer, size) == size;
+            PQfreemem(buffer);
+            if (++rows % PROGRESS_INTERVAL_ROWS == 0 && progress) progress(rows - 1);
+        }
+        if (!finishCopy(pg) || size == -2) {
+            reportError(pgError(pg), error);
+            return false;
+        }
+        if (!written) {
+            reportError(transferError("Błąd zapisu pliku: " + out.errorString()), error);
+            return false;
+        }
+        if (progress) progress(qMax<qint64>(0, rows - 1));
+        return true;
+    }
+#endif
+
+    QSqlQuery q(connection);
+    q.setForwardOnly(true);
+    if (!q.exec(select)) {
+        qWarning() << "[Eksport] Błąd odczytu tabeli" << table << ":" << q.lastError().text();
+        reportError(q.lastError(), error);
+        return false;
+    }
+    if (format == TransferFormat::Csv && out.write(columns.join(',').toUtf8() + '\n') < 0) {
+        reportError(transferError("Błąd zapisu pliku: " + out.errorString()), error);
+        return false;
+    }
+    QVariantList values;
+    while (q.next()) {
+        QByteArray line;
+        if (format == TransferFormat::Csv) {
+            values.clear();
+            for (int i = 0; i < columns.size(); ++i) values << q.value(i);
+            line = csvLine(values).toUtf8();
+        } else {
+            QJsonObject object;
+            for (int i = 0; i < columns.size(); ++i) object.insert(columns.at(i), jsonValue(q.value(i)));
+            line = QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+        }
+        if (out.write(line) != line.size()) {
+            reportError(transferError("Błąd zapisu pliku: " + out.errorString()), error);
+            return false;
+        }
+        if (++rows % PROGRESS_INTERVAL_ROWS == 0 && progress) progress(rows);
+    }
+    if (progress) progress(rows);
+    return true;
+}
+
+qint64 DataTransfer::importTable(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& table,
+                                 QIODevice& in, TransferFormat format, const Progress& progress, QSqlError* error) {
+    if (!schema.hasTable(table)) {
+        reportError(transferError(QString("Brak tabeli %1").arg(table)), error);
+        return -1;
+    }
+    RowReader reader(in, format);
+    QStringList fileColumns;
+    QString message;
+    if (!reader.readHeader(fileColumns, message)) {
+        if (message.isEmpty()) return 0; // pusty plik
+        reportError(transferError(message), error);
+        return -1;
+    }
+
+    // Kolumny pliku, które są w tabeli (indeksy w wierszu pliku)
+    QVector<int> picked;
+    QStringList columns;
+    QStringList types;
+    for (int i = 0; i < fileColumns.size(); ++i) {
+        const QString& column = fileColumns.at(i);
+        if (!schema.hasColumn(table, column) || columns.contains(column)) {
+            qWarning() << "[Import] Kolumna" << column << "pominięta - brak w tabeli" << table;
+            continue;
+        }
+        picked << i;
+        columns << column;
+        types << schema.columnType(table, column);
+    }
+    if (columns.isEmpty()) {
+        reportError(transferError(QString("Plik nie ma żadnej kolumny tabeli %1").arg(table)), error);
+        return -1;
+    }
+    // Pozycje zamówień bez *_value (np. ze starszej kopii) - wartości liczbowe z pól
+    // tekstowych, jak przy zapisie z formularza
+    QVector<int> derivedFrom;
+    if (table == QLatin1String("order_items")) {
+        for (const QString source : {"width", "height", "ordered_quantity", "roll_length", "price"}) {
+            const QString target = source + "_value";
+            if (!columns.contains(source) || columns.contains(target) || !schema.hasColumn(table, target)) continue;
+            derivedFrom << columns.indexOf(source);
+            columns << target;
+        }
+    }
+
+    BatchWriter writer(connection, table, columns);
+    QVector<QVariantList> batch;
+    batch.reserve(IMPORT_BATCH_ROWS);
+    qint64 rows = 0;
+    QVariantList values;
+    while (reader.next(values, message)) {
+        QVariantList row;
+        row.reserve(columns.size());
+        for (int i = 0; i < picked.size(); ++i) row << typedValue(types.at(i), values.at(picked.at(i)));
+        for (int source : derivedFrom) row << numericValue(row.at(source).toString());
+        batch.append(row);
+        if (batch.size() < IMPORT_BATCH_ROWS) continue;
+        if (!writer.write(batch, error)) return -1;
+        rows += batch.size();
+        batch.clear();
+        if (progress) progress(rows);
+    }
+    if (!message.isEmpty()) {
+        qWarning() << "[Import]" << table << ":" << message;
+        reportError(transferError(message), error);
+        return -1;
+    }
+    if (!writer.write(batch, error)) return -1;
+    rows += batch.size();
+    if (progress) progress(rows);
+
+    // Wiersze z jawnym id - sekwencja PostgreSQL za najwyższym id
+    if (connection.driverName() == "QPSQL" && columns.contains("id")) {
+        QSqlQuery q(connection);
+        if (!q.exec(QString("SELECT setval(pg_get_serial_sequence('%1', 'id'), MAX(id)) FROM %1").arg(table))) {
+            qWarning() << "[Import] Nie można przesunąć sekwencji id tabeli" << table << ":" << q.lastError().text();
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QIODevice>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include "schema_catalog.h"
+
+enum class TransferFormat {
+    Csv,    // nagłówek z nazwami kolumn; NULL - puste pole, pusty tekst - ""
+    NdJson  // jeden obiekt JSON w wierszu pliku
+};
+
+/**
+ * @brief Strumieniowy eksport i import tabel w CSV i NDJSON (kopie zapasowe, migracje)
+ *
+ * Wiersze są czytane i zapisywane pojedynczo, więc pamięć nie zależy od
+ * wielkości tabeli:
+ * - eksport: zapytanie forward-only, wiersz po wierszu do pliku,
+ * - import: porcje po IMPORT_BATCH_ROWS wierszy, każda w osobnej transakcji;
+ *   po błędzie wcześniejsze porcje zostają w bazie.
+ *
+ * PostgreSQL z libpq (ETYKIETY_HAVE_LIBPQ) używa COPY: eksport CSV to
+ * COPY ... TO STDOUT prosto do pliku, import - COPY do tabeli tymczasowej
+ * i jedno INSERT ... SELECT na porcję. Bez libpq i na SQLite import wysyła
+ * wielowierszowe INSERT (BulkInsert).
+ *
+ * Wiersze importu z id istniejącym już w tabeli nadpisują go (ON CONFLICT (id)),
+ * więc import kopii zachowuje powiązania zamówień z pozycjami i klientami.
+ * Kolumny pliku nieznane w tabeli są pomijane. Triggery (zestawienie produkcji,
+ * indeks wyszukiwania, ChangeFeed) działają jak przy zwykłych zapisach.
+ */
+class DataTransfer {
+public:
+    static constexpr int IMPORT_BATCH_ROWS = 5000;
+    static constexpr int PROGRESS_INTERVAL_ROWS = 1000;
+    // Liczba wierszy dotąd: eksport co PROGRESS_INTERVAL_ROWS wierszy, import po każdej porcji;
+    // zawsze także na końcu tabeli
+    using Progress = std::function<void(qint64 rows)>;
+
+    // Tabele kopii zapasowej, rodzice przed dziećmi (kolejność importu)
+    static const QStringList& tables();
+    // .ndjson / .jsonl - NDJSON, pozostałe - CSV
+    static TransferFormat formatForPath(const QString& path);
+    static QString fileExtension(TransferFormat format);
+
+    static bool exportTable(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& table,
+                            QIODevice& out, TransferFormat format, const Progress& progress = {},
+                            QSqlError* error = nullptr);
+    // Zwraca liczbę zaimportowanych wierszy, -1 przy błędzie
+    static qint64 importTable(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& table,
+                              QIODevice& in, TransferFormat format, const Progress& progress = {},
+                              QSqlError* error = nullptr);
+};
@@ -1,6 +1,13 @@
 #include "dbmanager.h"
-#include "views/client_full_dialog.h"
+#include "async_db.h"
+#include "bulk_insert.h"
+#include "models/numeric_value.h"
+#include "change_feed.h"
+#include "local_replica.h"
+#include "order_archive.h"
+#include "row_diff.h"
 #include "../utils/secure_config.h"
+#include "../utils/settings_manager.h"
 #include <QSqlError>
 #include <QDebug>
 #include <QSqlRecord>
@@ -13,25 +20,138 @@
 #include <QRegularExpression>
 #include <QDate>
 #include <QUuid>
+#include <QSet>
+#include <QTimer>
+#include <QThread>
+#include <QFile>
+#include <QDir>
+#include <QLoggingCategory>
+
+// Podsumowania synchronizacji kopii lokalnej (co replica/sync_interval_ms) - tylko na
+// żądanie: logging/level = Debug albo QT_LOGGING_RULES="etykiety.replica.debug=true"
+Q_LOGGING_CATEGORY(lcReplica, "etykiety.replica", QtInfoMsg)
+// Liczba wierszy zmienionych przy każdym zapisie pozycji zamówienia: "etykiety.edits.debug=true"
+Q_LOGGING_CATEGORY(lcEdits, "etykiety.edits", QtInfoMsg)
+
+namespace {
+// Połączenie przypięte przez ThreadConnectionScope (wątki robocze AsyncDb)
+thread_local QSqlDatabase t_boundConnection;
+thread_local bool t_hasBoundConnection = false;
+
+// Dopisuje pozycję zamówienia do podsumowań listy zamówień. Kolumny pozycji
+// zaczynają się od firstColumn: price, price_type, material, width, height,
+// ordered_quantity, quantity_type.
+void appendItemSummary(const QSqlQuery& q, int firstColumn, QStringList& prodList, QStringList& priceList) {
+    // LEFT JOIN: zamówienie bez pozycji daje jeden wiersz z NULL-ami
+    if (q.isNull(firstColumn + 3)) return;
+    QString w = q.value(firstColumn + 3).toString().trimmed();
+    QString h = q.value(firstColumn + 4).toString().trimmed();
+    QString mat = q.value(firstColumn + 2).toString().trimmed();
+    QString qty = q.value(firstColumn + 5).toString().trimmed();
+    bool ok = false;
+    int qtyInt = qty.toInt(&ok);
+    // Tylko pozycje z wypełnionymi wymiarami, materiałem i dodatnią ilością
+    if (w.isEmpty() || h.isEmpty() || mat.isEmpty() || !ok || qtyInt <= 0) return;
+    prodList << QString("%1 %2x%3 %4 %5").arg(mat, w, h, qty, q.value(firstColumn + 6).toString());
+    QString priceSuffix = q.value(firstColumn + 1).toString().trimmed().toLower().contains("rolk") ? "zł/rolkę" : "zł/tyś.";
+    priceList << QString("%1 %2").arg(q.value(firstColumn).toString(), priceSuffix);
+}
+
+// Zamówienia bez daty sortują się na końcu listy (data zastępcza w kluczu keyset)
+const QDate kMissingOrderDate(1, 1, 1);
+
+// Klucz sortowania listy zamówień. Indeks idx_orders_sort_date_id ma dokładnie
+// to wyrażenie - inaczej planista nie użyje go do ORDER BY ani warunku keyset.
+QString orderSortDateExpression(bool isPostgres, const QString& column) {
+    return QString(isPostgres ? "COALESCE(%1, DATE '0001-01-01')" : "COALESCE(%1, '0001-01-01')").arg(column);
+}
+
+// Indeksy pomocnicze. Nowe indeksy dopisujemy z kolejnym numerem wersji -
+// wersja trafia do schema_migrations jako "indexes_vN", gdy wszystkie jej indeksy istnieją.
+struct IndexDefinition {
+    int version;
+    const char* name;
+    const char* table;
+    QStringList columns;     // kolumny, które muszą istnieć (i klucz indeksu, jeśli nie ma sortDateKey)
+    bool sortDateKey = false; // klucz: (orderSortDateExpression(order_date), id)
+};
+
+const QVector<IndexDefinition>& indexDefinitions() {
+    static const QVector<IndexDefinition> definitions = {
+        {1, "idx_order_items_order_id", "order_items", {"order_id"}},
+        {1, "idx_orders_status", "orders", {"status"}},
+        {1, "idx_orders_delivery_date", "orders", {"delivery_date"}},
+        {1, "idx_orders_order_date_id", "orders", {"order_date", "id"}},
+        {1, "idx_clients_nip", "clients", {"nip"}},
+        {1, "idx_clients_client_number", "clients", {"client_number"}},
+        {1, "idx_delivery_addresses_client_id", "delivery_addresses", {"client_id"}},
+        {1, "idx_materials_order_items_order_id", "materials_order_items", {"order_id"}},
+        {2, "idx_orders_sort_date_id", "orders", {"order_date", "id"}, true},
+    };
+    return definitions;
+}
+
+// Wpisuje wartości w miejsca kolejnych "?" (do EXPLAIN, patrz PlannedStatement)
+QString inlineParameters(QString sql, const QStringList& literals) {
+    int from = 0;
+    for (const QString& literal : literals) {
+        const int pos = sql.indexOf('?', from);
+        if (pos < 0) break;
+        sql.replace(pos, 1, literal);
+        from = pos + literal.size();
+    }
+    return sql;
+}
+
+// Zapytanie, którego plan trafia do raportu queryPlanReport(). Wartości są
+// wpisane w tekst - PostgreSQL nie przygotowuje (PREPARE) instrukcji EXPLAIN.
+struct PlannedStatement {
+    QString label;
+    QString sql;
+};
+}
 
 DbManager& DbManager::instance() {
     static DbManager instance;
     return instance;
 }
 
+DbManager::~DbManager() {
+    // AsyncDb czeka na zakończenie zadań, zanim zniknie pula połączeń
+    m_async.reset();
+    StatementCacheStats stats = statementCacheStats();
+    qDebug() << "[DbManager] Cache zapytań: trafienia" << stats.hits << "chybienia" << stats.misses
+             << "w cache" << stats.cachedStatements << "połączeń" << stats.connections;
+}
+
+DbManager::ThreadConnectionScope::ThreadConnectionScope(const QSqlDatabase& connection)
+    : m_previous(t_boundConnection), m_hadPrevious(t_hasBoundConnection) {
+    t_boundConnection = connection;
+    t_hasBoundConnection = true;
+}
+
+DbManager::ThreadConnectionScope::~ThreadConnectionScope() {
+    t_boundConnection = m_previous;
+    t_hasBoundConnection = m_hadPrevious;
+}
+
 DbManager::DbManager(QObject *parent) : QObject(parent) {
+    m_changeFeed = new ChangeFeed(this);
+    // Zmiany słowników (także z innych stanowisk) unieważniają cache encji
+    connect(m_changeFeed, &ChangeFeed::changed, this, [this](const QVector<RowChange>& changes) {
+        EntityCache::Table table;
+        for (const RowChange& change : changes) {
+            if (EntityCache::tableFor(change.table, table)) m_entityCache.invalidate(table);
+        }
+    });
+
     // Force clean slate - remove any existing connections
     if (QSqlDatabase::contains("main_conn")) {
         QSqlDatabase::removeDatabase("main_conn");
     }
     
-    // Usunięcie istniejących połączeń z puli
-    for (int i = 0; i < POOL_SIZE; i++) {
-        QString connName = QString("pool_conn_%1").arg(i);
-        if (QSqlDatabase::contains(connName)) {
-            QSqlDatabase::removeDatabase(connName);
-        }
-    }
+    m_statementCacheSize = SettingsManager::instance().getValue("database/statement_cache_size", DEFAULT_STATEMENT_CACHE_SIZE).toInt();
+    m_numbering.setBlockSize(SettingsManager::instance().getValue("numbering/block_size", 1).toInt());
     
     // Pobierz bezpieczną konfigurację
     SecureConfig& config = SecureConfig::instance();
@@ -50,6 +170,7 @@ DbManager::DbManager(QObject *parent) : QObject(parent) {
         if (password.isEmpty()) {
             qCritical() << "Database password not configured! Set DB_PASSWORD environment variable.";
             emit dbConnectionError("Database password not configured");
+            createConnectionPool();
             return;
         }
         db.setPassword(password);
@@ -66,102 +187,365 @@ DbManager::DbManager(QObject *parent) : QObject(parent) {
     // Fallback do SQLite
     if (!usePostgreSQL) {
         db = QSqlDatabase::addDatabase("QSQLITE", "main_conn");
-        db.setDatabaseName("etykiety_db.sqlite");
+        // Bez serwera - kopia lokalna danych z PostgreSQL, jeśli była już pobrana
+        if (config.getDatabaseType() == "QPSQL" && replicaEnabled() && QFile::exists(replicaPath())) {
+            db.setDatabaseName(replicaPath());
+            m_offline = db.open() && LocalReplica::isInitialized(db);
+            if (m_offline) qWarning() << "[Replika] Brak połączenia z PostgreSQL - praca na kopii lokalnej" << replicaPath();
+            else db.close();
+        }
+        if (!m_offline) db.setDatabaseName("etykiety_db.sqlite");
         
-        if (db.open()) {
+        if (db.isOpen() || db.open()) {
             qDebug() << "Connected to SQLite database";
+            m_sqliteProfile = SqliteProfile::fromSettings();
+            m_sqliteProfile.apply(db);
+            startSqliteMaintenance();
             initializeTables();
         } else {
             qCritical() << "Failed to open SQLite database:" << db.lastError().text();
             emit dbConnectionError("Nie można otworzyć bazy danych SQLite");
+            createConnectionPool();
             return;
         }
     }
     
-    // Inicjalizacja connection pool
-    connectionAvailable.resize(POOL_SIZE);
-    connectionPool.resize(POOL_SIZE);
-    
-    for (int i = 0; i < POOL_SIZE; i++) {
-        QString connName = QString("pool_conn_%1").arg(i);
-        
-        if (usePostgreSQL) {
-            connectionPool[i] = QSqlDatabase::addDatabase("QPSQL", connName);
-            connectionPool[i].setHostName(config.getDatabaseHost());
-            connectionPool[i].setPort(config.getDatabasePort());
-            connectionPool[i].setDatabaseName(config.getDatabaseName());
-            connectionPool[i].setUserName(config.getDatabaseUser());
-            connectionPool[i].setPassword(config.getDatabasePassword());
-        } else {
-            connectionPool[i] = QSqlDatabase::addDatabase("QSQLITE", connName);
-            connectionPool[i].setDatabaseName("etykiety_db.sqlite");
-        }
-        
-        if (!connectionPool[i].open()) {
-            qWarning() << "Failed to open pooled connection" << i << ":" << connectionPool[i].lastError().text();
-            emit dbConnectionError(QString("Nie można otworzyć połączenia %1 w puli").arg(i));
-        }
-        
-        connectionAvailable[i] = true;
+    // Pula połączeń dla zapytań spoza głównego połączenia (np. z wątków roboczych)
+    createConnectionPool();
+    runMigrations();
+    if (m_offline) {
+        // Zestawienie produkcji nie jest kopiowane z serwera
+        rebuildProductionRollup();
+        QSqlError replicaError;
+        if (!LocalReplica::beginOffline(db, &replicaError)) setLastError(replicaError);
     }
+    startChangeFeed();
     
     // --- Dodaj kolumnę 'done' do materials_orders jeśli nie istnieje ---
-    QSqlQuery alterQ(db);
-    alterQ.exec("PRAGMA table_info(materials_orders)");
-    bool hasDone = false;
-    while (alterQ.next()) {
-        if (alterQ.value(1).toString() == "done") {
-            hasDone = true;
-            break;
-        }
-    }
-    if (!hasDone) {
+    if (m_schema.hasTable("materials_orders") && !m_schema.hasColumn("materials_orders", "done")) {
         QSqlQuery alterAdd(db);
-        alterAdd.exec("ALTER TABLE materials_orders ADD COLUMN done INTEGER DEFAULT 0");
+        if (alterAdd.exec("ALTER TABLE materials_orders ADD COLUMN done INTEGER DEFAULT 0")) refreshSchema();
     }
 }
 
 QSqlDatabase DbManager::database() {
-    return db;
+    return connection();
+}
+
+QSqlDatabase DbManager::connection() const {
+    return t_hasBoundConnection ? t_boundConnection : db;
+}
+
+AsyncDb& DbManager::async() {
+    std::call_once(m_asyncOnce, [this]() {
+        int threads = SettingsManager::instance().getValue("database/async_threads", DEFAULT_ASYNC_THREADS).toInt();
+        m_async = std::make_unique<AsyncDb>(*this, threads);
+    });
+    return *m_async;
+}
+
+ChangeFeed& DbManager::changeFeed() {
+    return *m_changeFeed;
+}
+
+void DbManager::startChangeFeed() {
+    auto& settings = SettingsManager::instance();
+    if (!settings.getValue("changefeed/enabled", true).toBool()) return;
+    int pollIntervalMs = settings.getValue("changefeed/poll_interval_ms", 2000).toInt();
+    if (!m_changeFeed->start(db, pollIntervalMs)) {
+        qWarning() << "[DbManager] Powiadomienia o zmianach niedostępne - widoki odświeżają się po własnych zapisach";
+    }
+}
+
+void DbManager::startBackgroundMaintenance() {
+    if (!db.isOpen()) return;
+    // Zaległe archiwum może obejmować tysiące zamówień - przenosi je wątek roboczy
+    // na połączeniu z puli, okno główne nie czeka
+    async().run([](DbManager& manager) { return manager.archiveCompletedOrders(); });
+    startReplicaSync();
+}
+
+bool DbManager::replicaEnabled() {
+    return SettingsManager::instance().getValue("replica/enabled", true).toBool();
+}
+
+QString DbManager::replicaPath() {
+    return SettingsManager::instance().getValue("replica/path", "etykiety_replica.sqlite").toString();
+}
+
+bool DbManager::isOffline() const {
+    return m_offline;
+}
+
+QSqlDatabase DbManager::openReplica(const QString& connectionName) {
+    QSqlDatabase replica = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    replica.setDatabaseName(replicaPath());
+    if (!replica.open()) {
+        qWarning() << "[Replika] Nie można otworzyć pliku kopii" << replicaPath() << ":" << replica.lastError().text();
+        return replica;
+    }
+    SqliteProfile::fromSettings().apply(replica);
+    return replica;
+}
+
+void DbManager::startReplicaSync() {
+    if (m_offline || db.driverName() != "QPSQL" || !replicaEnabled()) return;
+    scheduleReplicaSync();
+    int intervalMs = SettingsManager::instance().getValue("replica/sync_interval_ms", DEFAULT_REPLICA_SYNC_INTERVAL_MS).toInt();
+    if (intervalMs <= 0) return;
+    m_replicaSyncTimer = new QTimer(this);
+    m_replicaSyncTimer->setInterval(intervalMs);
+    // Timer tylko zleca synchronizację - wysyłka i pobieranie idą w wątku AsyncDb
+    connect(m_replicaSyncTimer, &QTimer::timeout, this, [this]() { scheduleReplicaSync(); });
+    m_replicaSyncTimer->start();
+}
+
+void DbManager::scheduleReplicaSync() {
+    // Poprzednia synchronizacja jeszcze trwa (np. pierwsze pobranie całej kopii)
+    if (m_replicaSyncRunning.exchange(true)) return;
+    async().run([](DbManager& manager) {
+        const bool ok = manager.syncReplica();
+        manager.m_replicaSyncRunning = false;
+        return ok;
+    });
+}
+
+bool DbManager::syncReplica() {
+    QSqlDatabase server = connection();
+    if (m_offline || server.driverName() != "QPSQL") return false;
+    // Połączenie SQLite wolno używać tylko w wątku, który je otworzył -
+    // każda synchronizacja otwiera kopię pod własną nazwą i zamyka po sobie
+    const QString name = QString("%1_%2").arg(LocalReplica::CONNECTION_NAME)
+                             .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    bool ok = false;
+    {
+        QSqlDatabase replica = openReplica(name);
+        if (replica.isOpen()) ok = syncReplica(replica, server);
+        replica.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    return ok;
+}
+
+bool DbManager::syncReplica(const QSqlDatabase& replica, const QSqlDatabase& server) {
+    ReplicaSyncStats stats;
+    QSqlError error;
+    if (!LocalReplica::replay(replica, server, m_schema, stats, &error)) {
+        setLastError(error);
+        return false;
+    }
+    // Triggery change_log z pracy bez serwera dopisywałyby każde pobranie,
+    // a online nikt tej tabeli nie czyta
+    if (!ChangeFeed::removeSqlite(replica, &error)) {
+        setLastError(error);
+        return false;
+    }
+    // Numery nadane bez serwera (zamówienia, klienci) - ciągi za nimi
+    if (stats.replayed > 0) migrateNumberSequences();
+    if (!LocalReplica::pull(replica, server, m_schema, stats, &error)) {
+        qWarning() << "[Replika] Pobieranie zmian nie powiodło się:" << error.text();
+        setLastError(error);
+        return false;
+    }
+    if (stats.replayed > 0 || stats.conflicts > 0) {
+        qCDebug(lcReplica) << "[Replika] Wysłano zapisów:" << stats.replayed << "konfliktów:" << stats.conflicts
+                           << "nowych numerów:" << stats.renumbered;
+    }
+    if (stats.pulled > 0 || stats.removed > 0) {
+        qCDebug(lcReplica) << "[Replika] Pobrano wierszy:" << stats.pulled << "usunięto:" << stats.removed;
+    }
+    return true;
+}
+
+void DbManager::createConnectionPool() {
+    // Połączenia w puli używają tych samych parametrów co połączenie główne
+    ConnectionSettings settings;
+    settings.driver = db.driverName();
+    settings.hostName = db.hostName();
+    settings.port = db.port();
+    settings.databaseName = db.databaseName();
+    settings.userName = db.userName();
+    settings.password = db.password();
+    int poolSize = SettingsManager::instance().getValue("database/pool_size", DEFAULT_POOL_SIZE).toInt();
+    m_pool = std::make_unique<ConnectionPool>(settings, poolSize);
+    // Przygotowane zapytania tracą ważność razem z połączeniem
+    m_pool->setConnectionCloseHandler([this](const QString& connectionName) {
+        dropStatementCache(connectionName);
+    });
+    if (settings.driver == "QSQLITE") {
+        SqliteProfile profile = m_sqliteProfile;
+        m_pool->setConnectionInitializer([profile](QSqlDatabase& connection) {
+            profile.apply(connection);
+        });
+    }
+}
+
+void DbManager::startSqliteMaintenance() {
+    if (m_sqliteProfile.maintenanceIntervalMs <= 0) return;
+    m_sqliteMaintenanceTimer = new QTimer(this);
+    m_sqliteMaintenanceTimer->setInterval(m_sqliteProfile.maintenanceIntervalMs);
+    // Timer działa w wątku DbManager, więc używa połączenia głównego
+    connect(m_sqliteMaintenanceTimer, &QTimer::timeout, this, [this]() {
+        SqliteProfile::runMaintenance(db);
+    });
+    m_sqliteMaintenanceTimer->start();
+}
+
+std::shared_ptr<QSqlQuery> DbManager::prepared(const QString& sql) const {
+    QSqlDatabase conn = connection();
+    if (!conn.isValid()) {
+        // Brak połączenia (np. wyczerpana pula) - exec() zwróci błąd
+        auto query = std::make_shared<QSqlQuery>(conn);
+        query->prepare(sql);
+        return query;
+    }
+    std::shared_ptr<PreparedStatementCache> cache;
+    {
+        QMutexLocker locker(&m_statementCacheMutex);
+        auto& slot = m_statementCaches[conn.connectionName()];
+        if (!slot) slot = std::make_shared<PreparedStatementCache>(conn, m_statementCacheSize);
+        cache = slot;
+    }
+    return cache->acquire(sql);
+}
+
+void DbManager::dropStatementCache(const QString& connectionName) {
+    std::shared_ptr<PreparedStatementCache> cache;
+    {
+        QMutexLocker locker(&m_statementCacheMutex);
+        cache = m_statementCaches.take(connectionName);
+    }
+    // Zapytania usuwane poza blokadą, w wątku zamykającym połączenie
+    cache.reset();
+}
+
+StatementCacheStats DbManager::statementCacheStats() const {
+    StatementCacheStats stats;
+    QMutexLocker locker(&m_statementCacheMutex);
+    for (const auto& cache : std::as_const(m_statementCaches)) {
+        stats.hits += cache->hits();
+        stats.misses += cache->misses();
+        stats.cachedStatements += cache->size();
+    }
+    stats.connections = m_statementCaches.size();
+    return stats;
+}
+
+ConnectionPool& DbManager::connectionPool() {
+    return *m_pool;
+}
+
+ConnectionLease DbManager::leaseConnection(int timeoutMs) {
+    ConnectionLease lease(*m_pool, timeoutMs);
+    if (!lease.isValid()) {
+        qWarning() << "[DbManager] Pula połączeń wyczerpana - brak połączenia do wydania";
+        setLastError(QSqlError(QString(), "Brak wolnego połączenia w puli", QSqlError::ConnectionError));
+    }
+    return lease;
 }
 
 bool DbManager::isOpen() {
     return QSqlDatabase::contains("main_conn") && QSqlDatabase::database("main_conn").isOpen();
 }
 
+QVector<Client> DbManager::fetchClients() {
+    auto clients = cachedClients();
+    return clients ? clients->rows : QVector<Client>();
+}
+
+QVector<Client> DbManager::searchClients(const QString& text, ClientSearchField field, int limit) {
+    QVector<Client> result;
+    QSqlError error;
+    const QVector<int> ids = m_search.searchClients(connection(), text, field, limit, &error);
+    if (error.isValid()) {
+        setLastError(error);
+        return result;
+    }
+    // Baza zwraca tylko id w kolejności trafności - dane klientów z cache
+    auto clients = cachedClients();
+    if (!clients) return result;
+    result.reserve(ids.size());
+    for (int id : ids) {
+        if (const Client* client = clients->find(id)) result.append(*client);
+    }
+    return result;
+}
+
+std::shared_ptr<const ClientIndex> DbManager::cachedClients() {
+    if (auto cached = m_entityCache.clients()) return cached;
+    const quint64 generation = m_entityCache.generation(EntityCache::Clients);
+    QVector<Client> rows;
+    if (!loadClients(rows)) return nullptr;
+    auto index = std::make_shared<const ClientIndex>(std::move(rows));
+    m_entityCache.store(index, generation);
+    return index;
+}
+
+bool DbManager::loadClients(QVector<Client>& result) {
+    auto q = prepared("SELECT id, client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip FROM clients ORDER BY name");
+    if (!q->exec()) {
+        qWarning() << "Błąd pobierania klientów:" << q->lastError().text();
+        setLastError(q->lastError());
+        return false;
+    }
+    if (q->size() > 0) result.reserve(q->size());
+    while (q->next()) {
+        Client c;
+        c.id = q->value(0).toInt();
+        c.clientNumber = q->value(1).toString();
+        c.name = q->value(2).toString();
+        c.shortName = q->value(3).toString();
+        c.contactPerson = q->value(4).toString();
+        c.phone = q->value(5).toString();
+        c.email = q->value(6).toString();
+        c.street = q->value(7).toString();
+        c.postalCode = q->value(8).toString();
+        c.city = q->value(9).toString();
+        c.nip = q->value(10).toString();
+        result.append(std::move(c));
+    }
+    return true;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const Client& c) {
+    QMap<QString, QVariant> row;
+    row["id"] = c.id;
+    row["client_number"] = c.clientNumber;
+    row["name"] = c.name;
+    row["short_name"] = c.shortName;
+    row["contact_person"] = c.contactPerson;
+    row["phone"] = c.phone;
+    row["email"] = c.email;
+    row["street"] = c.street;
+    row["postal_code"] = c.postalCode;
+    row["city"] = c.city;
+    row["nip"] = c.nip;
+    return row;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getClients() {
-    qDebug() << "[DbManager::getClients] Pobieram klientów z bazy...";
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.exec("SELECT id, client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip FROM clients ORDER BY name");
-    while (q.next()) {
-        QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        row["client_number"] = q.value(1);
-        row["name"] = q.value(2);
-        row["short_name"] = q.value(3);
-        row["contact_person"] = q.value(4);
-        row["phone"] = q.value(5);
-        row["email"] = q.value(6);
-        row["street"] = q.value(7);
-        row["postal_code"] = q.value(8);
-        row["city"] = q.value(9);
-        row["nip"] = q.value(10);
-        result.append(row);
-    }
+    const QVector<Client> clients = fetchClients();
+    result.reserve(clients.size());
+    for (const auto& c : clients) result.append(toVariantMap(c));
     qDebug() << "[DbManager::getClients] Liczba klientów w bazie:" << result.size();
     return result;
 }
 
+QMap<QString, QVariant> DbManager::getClientById(int clientId) {
+    auto clients = cachedClients();
+    const Client* client = clients ? clients->find(clientId) : nullptr;
+    return client ? toVariantMap(*client) : QMap<QString, QVariant>();
+}
+
 int DbManager::findClientByNip(const QString& nip) {
     // ZAWSZE oczyszczaj NIP do cyfr przed porównaniem
-    QString cleanNip = ClientFullDialog::cleanNip(nip);
-    QSqlQuery q(db);
-    q.prepare("SELECT id, name FROM clients WHERE nip = ?");
-    q.addBindValue(cleanNip);
-    if (q.exec() && q.next()) {
-        int clientId = q.value(0).toInt();
-        QString clientName = q.value(1).toString();
+    QString cleanNip = Client::cleanNip(nip);
+    auto q = prepared("SELECT id, name FROM clients WHERE nip = ?");
+    q->addBindValue(cleanNip);
+    if (q->exec() && q->next()) {
+        int clientId = q->value(0).toInt();
+        QString clientName = q->value(1).toString();
         qDebug() << "Znaleziono istniejącego klienta z NIP" << cleanNip << "- ID:" << clientId << "Nazwa:" << clientName;
         return clientId;
     }
@@ -174,130 +558,469 @@ int DbManager::findClientByNumber(const QString &clientNumber) {
     QString formatted = clientNumber;
     if (formatted.length() < 6)
         formatted = formatted.rightJustified(6, '0');
-    QSqlQuery q(db);
-    q.prepare("SELECT id FROM clients WHERE client_number = ?");
-    q.addBindValue(formatted);
-    if (q.exec() && q.next()) {
-        return q.value(0).toInt();
+    auto q = prepared("SELECT id FROM clients WHERE client_number = ?");
+    q->addBindValue(formatted);
+    if (q->exec() && q->next()) {
+        return q->value(0).toInt();
     }
     return -1;
 }
 
 bool DbManager::addClient(const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO clients (client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(data.value("client_number"));
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("short_name"));
-    q.addBindValue(data.value("contact_person"));
-    q.addBindValue(data.value("phone"));
-    q.addBindValue(data.value("email"));
-    q.addBindValue(data.value("street"));
-    q.addBindValue(data.value("postal_code"));
-    q.addBindValue(data.value("city"));
-    q.addBindValue(data.value("nip"));
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("INSERT INTO clients (client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    q->addBindValue(data.value("client_number"));
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("short_name"));
+    q->addBindValue(data.value("contact_person"));
+    q->addBindValue(data.value("phone"));
+    q->addBindValue(data.value("email"));
+    q->addBindValue(data.value("street"));
+    q->addBindValue(data.value("postal_code"));
+    q->addBindValue(data.value("city"));
+    q->addBindValue(data.value("nip"));
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Clients);
     return ok;
 }
 
 bool DbManager::updateClient(int id, const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("UPDATE clients SET client_number=?, name=?, short_name=?, contact_person=?, phone=?, email=?, street=?, postal_code=?, city=?, nip=? WHERE id=?");
-    q.addBindValue(data.value("client_number"));
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("short_name"));
-    q.addBindValue(data.value("contact_person"));
-    q.addBindValue(data.value("phone"));
-    q.addBindValue(data.value("email"));
-    q.addBindValue(data.value("street"));
-    q.addBindValue(data.value("postal_code"));
-    q.addBindValue(data.value("city"));
-    q.addBindValue(data.value("nip"));
-    q.addBindValue(id);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("UPDATE clients SET client_number=?, name=?, short_name=?, contact_person=?, phone=?, email=?, street=?, postal_code=?, city=?, nip=? WHERE id=?");
+    q->addBindValue(data.value("client_number"));
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("short_name"));
+    q->addBindValue(data.value("contact_person"));
+    q->addBindValue(data.value("phone"));
+    q->addBindValue(data.value("email"));
+    q->addBindValue(data.value("street"));
+    q->addBindValue(data.value("postal_code"));
+    q->addBindValue(data.value("city"));
+    q->addBindValue(data.value("nip"));
+    q->addBindValue(id);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Clients);
     return ok;
 }
 
+QVector<Order> DbManager::fetchOrders() {
+    return queryOrders(QString());
+}
+
+QVector<Order> DbManager::fetchOpenOrders() {
+    return queryOrders(QString("WHERE status <> %1 ").arg(static_cast<int>(Order::Zrealizowane)));
+}
+
+QVector<Order> DbManager::queryOrders(const QString& where) {
+    QVector<Order> result;
+    auto q = prepared("SELECT id, order_number, order_date, delivery_date, client_id, notes, payment_term, status, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone FROM orders "
+                      + where + "ORDER BY order_date DESC");
+    if (!q->exec()) {
+        qWarning() << "Błąd pobierania zamówień:" << q->lastError().text();
+        setLastError(q->lastError());
+        return result;
+    }
+    if (q->size() > 0) result.reserve(q->size());
+    while (q->next()) {
+        Order o;
+        o.id = q->value(0).toInt();
+        o.orderNumber = q->value(1).toString();
+        o.orderDate = q->value(2).toDate();
+        o.deliveryDate = q->value(3).toDate();
+        o.clientId = q->value(4).toInt();
+        o.notes = q->value(5).toString();
+        o.paymentTerm = q->value(6).toString();
+        o.status = static_cast<Order::Status>(q->value(7).toInt());
+        o.deliveryCompany = q->value(8).toString();
+        o.deliveryStreet = q->value(9).toString();
+        o.deliveryPostalCode = q->value(10).toString();
+        o.deliveryCity = q->value(11).toString();
+        o.deliveryContactPerson = q->value(12).toString();
+        o.deliveryPhone = q->value(13).toString();
+        result.append(std::move(o));
+    }
+    return result;
+}
+
+std::optional<QVector<Order>> DbManager::fetchOrdersByIds(const QVector<int>& ids) {
+    QVector<Order> result;
+    result.reserve(ids.size());
+    for (int first = 0; first < ids.size(); first += ORDER_IDS_PER_QUERY) {
+        const QVector<int> chunk = ids.mid(first, ORDER_IDS_PER_QUERY);
+        auto q = prepared(QString("SELECT o.id, o.order_number, o.order_date, o.delivery_date, o.client_id, o.notes, o.payment_term, o.status, "
+                                  "o.delivery_company, o.delivery_street, o.delivery_postal_code, o.delivery_city, o.delivery_contact_person, o.delivery_phone, "
+                                  "c.name, c.short_name "
+                                  "FROM orders o LEFT JOIN clients c ON c.id = o.client_id "
+                                  "WHERE o.id IN (%1)").arg(QStringList(chunk.size(), "?").join(", ")));
+        for (int id : chunk) q->addBindValue(id);
+        if (!q->exec()) {
+            qWarning() << "Błąd pobierania zamówień po ID:" << q->lastError().text();
+            setLastError(q->lastError());
+            return std::nullopt;
+        }
+        while (q->next()) {
+            Order o;
+            o.id = q->value(0).toInt();
+            o.orderNumber = q->value(1).toString();
+            o.orderDate = q->value(2).toDate();
+            o.deliveryDate = q->value(3).toDate();
+            o.clientId = q->value(4).toInt();
+            o.notes = q->value(5).toString();
+            o.paymentTerm = q->value(6).toString();
+            o.status = static_cast<Order::Status>(q->value(7).toInt());
+            o.deliveryCompany = q->value(8).toString();
+            o.deliveryStreet = q->value(9).toString();
+            o.deliveryPostalCode = q->value(10).toString();
+            o.deliveryCity = q->value(11).toString();
+            o.deliveryContactPerson = q->value(12).toString();
+            o.deliveryPhone = q->value(13).toString();
+            o.client.id = o.clientId;
+            o.client.name = q->value(14).toString();
+            o.client.shortName = q->value(15).toString();
+            result.append(std::move(o));
+        }
+    }
+    return result;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const Order& o) {
+    QMap<QString, QVariant> row;
+    row["id"] = o.id;
+    row["order_number"] = o.orderNumber;
+    row["order_date"] = o.orderDate;
+    row["delivery_date"] = o.deliveryDate;
+    row["client_id"] = o.clientId;
+    row["notes"] = o.notes;
+    row["payment_term"] = o.paymentTerm;
+    row["status"] = static_cast<int>(o.status);
+    row["delivery_company"] = o.deliveryCompany;
+    row["delivery_street"] = o.deliveryStreet;
+    row["delivery_postal_code"] = o.deliveryPostalCode;
+    row["delivery_city"] = o.deliveryCity;
+    row["delivery_contact_person"] = o.deliveryContactPerson;
+    row["delivery_phone"] = o.deliveryPhone;
+    return row;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const OrderListRow& r) {
+    QMap<QString, QVariant> row;
+    row["id"] = r.id;
+    row["order_number"] = r.orderNumber;
+    row["order_date"] = r.orderDate;
+    row["delivery_date"] = r.deliveryDate;
+    row["client_id"] = r.clientId;
+    row["notes"] = r.notes;
+    row["payment_term"] = r.paymentTerm;
+    row["status"] = static_cast<int>(r.status);
+    row["delivery_company"] = r.deliveryCompany;
+    row["delivery_street"] = r.deliveryStreet;
+    row["delivery_postal_code"] = r.deliveryPostalCode;
+    row["delivery_city"] = r.deliveryCity;
+    row["delivery_contact_person"] = r.deliveryContactPerson;
+    row["delivery_phone"] = r.deliveryPhone;
+    row["client_number"] = r.clientNumber;
+    row["client_name"] = r.clientName;
+    row["price_summary"] = r.priceSummary;
+    row["production_summary"] = r.productionSummary;
+    row["archived"] = r.archived;
+    return row;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getOrders() {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.exec("SELECT id, order_number, order_date, delivery_date, client_id, notes, payment_term, status, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone FROM orders ORDER BY order_date DESC");
-    while (q.next()) {
-        QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        QString orderNumber = q.value(1).toString();
-        QRegularExpression re("^ZAM-\\d{4}-\\d{3}$");
-        if (!re.match(orderNumber).hasMatch()) {
-            // Automatyczna poprawa: nadaj nowy numer w formacie ZAM-YYYY-NNN
-            QDate date = q.value(2).toDate();
-            int id = q.value(0).toInt();
-            QString newOrderNumber = QString("ZAM-%1-%2").arg(date.year()).arg(id, 3, 10, QChar('0'));
-            row["order_number"] = newOrderNumber;
-            // Zapisz poprawiony numer do bazy
-            QSqlQuery qupdate(db);
-            qupdate.prepare("UPDATE orders SET order_number=? WHERE id=?");
-            qupdate.addBindValue(newOrderNumber);
-            qupdate.addBindValue(id);
-            qupdate.exec();
-        } else {
-            row["order_number"] = orderNumber;
-        }
-        row["order_date"] = q.value(2);
-        row["delivery_date"] = q.value(3);
-        row["client_id"] = q.value(4);
-        row["notes"] = q.value(5);
-        row["payment_term"] = q.value(6);
-        row["status"] = q.value(7);
-        // Nowe pola adresu dostawy:
-        row["delivery_company"] = q.value(8);
-        row["delivery_street"] = q.value(9);
-        row["delivery_postal_code"] = q.value(10);
-        row["delivery_city"] = q.value(11);
-        row["delivery_contact_person"] = q.value(12);
-        row["delivery_phone"] = q.value(13);
-        result.append(row);
+    const QVector<Order> orders = fetchOrders();
+    result.reserve(orders.size());
+    for (const auto& o : orders) result.append(toVariantMap(o));
+    return result;
+}
+
+int DbManager::archiveCompletedOrders(int olderThanDays) {
+    if (olderThanDays < 0) {
+        olderThanDays = SettingsManager::instance().getValue("archive/completed_after_days", DEFAULT_ARCHIVE_AFTER_DAYS).toInt();
+    }
+    // 0 - archiwizacja wyłączona; w kopii lokalnej przeniesienia trafiłyby do kolejki jako usunięcia
+    if (olderThanDays <= 0 || m_offline || !m_schema.hasTable(OrderArchive::ORDERS)) return 0;
+    const QDate before = QDate::currentDate().addDays(-olderThanDays);
+    int total = 0;
+    // Partiami, każda w osobnej transakcji - krótkie blokady przy dużym zaległym archiwum
+    while (true) {
+        int moved = 0;
+        bool ok = executeTransaction([&]() {
+            QSqlError error;
+            moved = OrderArchive::archiveBatch(connection(), m_schema, before, MIGRATION_BATCH_SIZE, &error);
+            if (moved < 0) setLastError(error);
+            return moved >= 0;
+        });
+        if (!ok) {
+            qWarning() << "[Archiwum] Przerwano archiwizację po" << total << "zamówieniach";
+            return -1;
+        }
+        total += moved;
+        if (moved < MIGRATION_BATCH_SIZE) break;
+    }
+    if (total > 0) qDebug() << "[Archiwum] Przeniesiono do archiwum zamówień:" << total;
+    return total;
+}
+
+bool DbManager::restoreArchivedOrder(int orderId) {
+    return executeTransaction([&]() {
+        QSqlError error;
+        if (!OrderArchive::restore(connection(), m_schema, orderId, &error)) {
+            setLastError(error);
+            return false;
+        }
+        return true;
+    });
+}
+
+bool DbManager::exportTable(const QString& table, const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "[Eksport] Nie można utworzyć pliku" << path << ":" << file.errorString();
+        setLastError(QSqlError(QString(), "Nie można utworzyć pliku " + path, QSqlError::UnknownError));
+        return false;
+    }
+    QSqlError error;
+    const bool ok = DataTransfer::exportTable(connection(), m_schema, table, file, DataTransfer::formatForPath(path),
+                                              [this, table](qint64 rows) { emit transferProgress(table, rows); }, &error);
+    if (!ok) setLastError(error);
+    return ok;
+}
+
+qint64 DbManager::importTable(const QString& table, const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[Import] Nie można otworzyć pliku" << path << ":" << file.errorString();
+        setLastError(QSqlError(QString(), "Nie można otworzyć pliku " + path, QSqlError::UnknownError));
+        return -1;
+    }
+    QSqlError error;
+    const qint64 rows = DataTransfer::importTable(connection(), m_schema, table, file, DataTransfer::formatForPath(path),
+                                                  [this, table](qint64 done) { emit transferProgress(table, done); }, &error);
+    if (rows < 0) setLastError(error);
+    // Zaimportowane wiersze mogły trafić do bazy także przy błędzie (wcześniejsze porcje)
+    EntityCache::Table cached;
+    if (EntityCache::tableFor(table, cached)) m_entityCache.invalidate(cached);
+    if (rows > 0 && (table == "orders" || table == OrderArchive::ORDERS || table == "materials_orders" || table == "clients")) {
+        // Numery z pliku - ciągi numeracji za nimi
+        migrateNumberSequences();
+    }
+    return rows;
+}
+
+bool DbManager::exportAll(const QString& directory, TransferFormat format) {
+    const QDir dir(directory);
+    for (const QString& table : DataTransfer::tables()) {
+        if (!m_schema.hasTable(table)) continue;
+        if (!exportTable(table, dir.filePath(table + "." + DataTransfer::fileExtension(format)))) return false;
+    }
+    return true;
+}
+
+bool DbManager::importAll(const QString& directory) {
+    const QDir dir(directory);
+    for (const QString& table : DataTransfer::tables()) {
+        for (TransferFormat format : {TransferFormat::Csv, TransferFormat::NdJson}) {
+            const QString path = dir.filePath(table + "." + DataTransfer::fileExtension(format));
+            if (!QFile::exists(path)) continue;
+            if (importTable(table, path) < 0) return false;
+            qDebug() << "[Import] Zaimportowano" << path;
+            break;
+        }
+    }
+    return true;
+}
+
+QVector<OrderItem> DbManager::fetchOrderItems(int orderId) {
+    QVector<OrderItem> result;
+    auto q = prepared("SELECT id, order_id, width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki, "
+              "width_value, height_value, ordered_quantity_value, roll_length_value, price_value "
+              "FROM order_items WHERE order_id = ? ORDER BY id");
+    q->addBindValue(orderId);
+    if (!q->exec()) {
+        qWarning() << "Błąd podczas pobierania pozycji zamówienia:" << q->lastError().text();
+        setLastError(q->lastError());
+        return result;
+    }
+    while (q->next()) {
+        OrderItem item;
+        item.id = q->value(0).toInt();
+        item.orderId = q->value(1).toInt();
+        item.width = q->value(2).toString();
+        item.height = q->value(3).toString();
+        item.material = q->value(4).toString();
+        item.orderedQuantity = q->value(5).toString();
+        item.quantityType = q->value(6).toString();
+        item.rollLength = q->value(7).toString();
+        item.core = q->value(8).toString();
+        item.price = q->value(9).toString();
+        item.priceType = q->value(10).toString();
+        item.zamRolki = q->value(11).toString();
+        item.widthValue = q->value(12).toDouble();
+        item.heightValue = q->value(13).toDouble();
+        item.orderedQuantityValue = q->value(14).toDouble();
+        item.rollLengthValue = q->value(15).toDouble();
+        item.priceValue = q->value(16).toDouble();
+        result.append(std::move(item));
     }
     return result;
 }
 
+QVector<OrderListRow> DbManager::fetchOrdersPage(const OrdersPageCursor& after, int limit,
+                                                 const QString& filter, OrderSearchField field, bool includeArchive) {
+    QStringList conditions;
+    QVariantList bindValues;
+    if (!after.atStart()) {
+        conditions << orderKeysetCondition();
+        bindValues << (after.orderDate.isValid() ? after.orderDate : kMissingOrderDate) << after.id;
+    }
+    appendOrderSearchCondition(filter, field, conditions, bindValues, includeArchive);
+    return queryOrderList(conditions, bindValues, limit, includeArchive);
+}
+
+std::optional<QVector<OrderListRow>> DbManager::fetchOrderListRows(const QVector<int>& ids, const QString& filter,
+                                                                   OrderSearchField field, bool includeArchive) {
+    QVector<OrderListRow> result;
+    for (int first = 0; first < ids.size(); first += ORDER_IDS_PER_QUERY) {
+        const QVector<int> chunk = ids.mid(first, ORDER_IDS_PER_QUERY);
+        QStringList conditions;
+        QVariantList bindValues;
+        conditions << QString("o.id IN (%1)").arg(QStringList(chunk.size(), "?").join(", "));
+        for (int id : chunk) bindValues << id;
+        appendOrderSearchCondition(filter, field, conditions, bindValues, includeArchive);
+        bool ok = false;
+        result += queryOrderList(conditions, bindValues, chunk.size(), includeArchive, &ok);
+        if (!ok) return std::nullopt;
+    }
+    return result;
+}
+
+QString DbManager::orderKeysetCondition() const {
+    return QString("(%1, o.id) < (?, ?)").arg(orderListSortDate());
+}
+
+QString DbManager::orderListSortDate() const {
+    // Klucz sortowania bez NULL-i, żeby porównanie krotek działało dla każdego wiersza;
+    // to samo wyrażenie co w idx_orders_sort_date_id
+    return orderSortDateExpression(connection().driverName() == "QPSQL", "o.order_date");
+}
+
+void DbManager::appendOrderSearchCondition(const QString& filter, OrderSearchField field,
+                                           QStringList& conditions, QVariantList& bindValues, bool includeArchive) const {
+    // Bez polskich znaków, w postaci zgodnej z indeksem wyszukiwania
+    const QString condition = m_search.orderCondition(filter, field, bindValues, includeArchive);
+    if (!condition.isEmpty()) conditions << condition;
+}
+
+QString DbManager::orderListSql(const QStringList& conditions, bool includeArchive) const {
+    // Z archiwum: te same kolumny z tabel bieżących i archiwalnych (id są
+    // wspólne, bo archiwizacja je zachowuje) oraz znacznik archived
+    const QString orderColumns = "id, order_number, order_date, delivery_date, client_id, notes, payment_term, status, "
+                                 "delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone";
+    const QString itemColumns = "id, order_id, price, price_type, material, width, height, ordered_quantity, quantity_type";
+    const QString orders = includeArchive
+        ? QString("(SELECT %1, 0 AS archived FROM orders UNION ALL SELECT %1, 1 FROM %2)").arg(orderColumns, OrderArchive::ORDERS)
+        : QString("orders");
+    const QString items = includeArchive
+        ? QString("(SELECT %1 FROM order_items UNION ALL SELECT %1 FROM %2)").arg(itemColumns, OrderArchive::ORDER_ITEMS)
+        : QString("order_items");
+    // Najpierw wybieramy stronę zamówień (LIMIT w podzapytaniu), dopiero potem
+    // dołączamy pozycje - inaczej LIMIT liczyłby wiersze pozycji, nie zamówień.
+    // Tekst SQL zależy tylko od rodzaju warunków, więc trafia do cache zapytań.
+    return QString(
+        "SELECT p.id, p.order_number, p.order_date, p.delivery_date, p.client_id, p.notes, p.payment_term, p.status, "
+        "p.delivery_company, p.delivery_street, p.delivery_postal_code, p.delivery_city, p.delivery_contact_person, p.delivery_phone, "
+        "p.client_number, p.client_name, "
+        "oi.price, oi.price_type, oi.material, oi.width, oi.height, oi.ordered_quantity, oi.quantity_type, p.archived "
+        "FROM (SELECT o.id, o.order_number, o.order_date, o.delivery_date, o.client_id, o.notes, o.payment_term, o.status, "
+        "o.delivery_company, o.delivery_street, o.delivery_postal_code, o.delivery_city, o.delivery_contact_person, o.delivery_phone, "
+        "c.client_number, c.name AS client_name, %1 AS sort_date, %3 AS archived "
+        "FROM %4 o "
+        "LEFT JOIN clients c ON c.id = o.client_id "
+        "%2"
+        "ORDER BY sort_date DESC, o.id DESC LIMIT ?) p "
+        "LEFT JOIN %5 oi ON oi.order_id = p.id "
+        "ORDER BY p.sort_date DESC, p.id DESC, oi.id")
+        .arg(orderListSortDate(), conditions.isEmpty() ? QString() : "WHERE " + conditions.join(" AND ") + " ",
+             includeArchive ? "o.archived" : "0", orders, items);
+}
+
+QVector<OrderListRow> DbManager::queryOrderList(const QStringList& conditions, const QVariantList& bindValues, int limit,
+                                               bool includeArchive, bool* ok) {
+    QVector<OrderListRow> result;
+    const QString sql = orderListSql(conditions, includeArchive);
+    auto q = prepared(sql);
+    for (const QVariant& value : bindValues) q->addBindValue(value);
+    q->addBindValue(qMax(1, limit));
+    if (ok) *ok = false;
+    if (!q->exec()) {
+        qWarning() << "Błąd pobierania listy zamówień:" << q->lastError().text();
+        setLastError(q->lastError());
+        return result;
+    }
+    if (ok) *ok = true;
+    result.reserve(qMax(1, limit));
+    int currentId = -1;
+    QStringList prodList;
+    QStringList priceList;
+    auto flush = [&]() {
+        if (result.isEmpty()) return;
+        result.last().productionSummary = prodList.join("\n");
+        result.last().priceSummary = priceList.join("\n");
+        prodList.clear();
+        priceList.clear();
+    };
+    while (q->next()) {
+        int id = q->value(0).toInt();
+        if (id != currentId) {
+            flush();
+            currentId = id;
+            OrderListRow row;
+            row.id = id;
+            row.orderNumber = q->value(1).toString();
+            row.orderDate = q->value(2).toDate();
+            row.deliveryDate = q->value(3).toDate();
+            row.clientId = q->value(4).isNull() ? -1 : q->value(4).toInt();
+            row.notes = q->value(5).toString();
+            row.paymentTerm = q->value(6).toString();
+            row.status = static_cast<Order::Status>(q->value(7).toInt());
+            row.deliveryCompany = q->value(8).toString();
+            row.deliveryStreet = q->value(9).toString();
+            row.deliveryPostalCode = q->value(10).toString();
+            row.deliveryCity = q->value(11).toString();
+            row.deliveryContactPerson = q->value(12).toString();
+            row.deliveryPhone = q->value(13).toString();
+            row.clientNumber = q->value(14).toString();
+            row.clientName = q->value(15).toString();
+            row.archived = q->value(23).toInt() != 0;
+            result.append(row);
+        }
+        appendItemSummary(*q, 16, prodList, priceList);
+    }
+    flush();
+    return result;
+}
+
 bool DbManager::addOrder(const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
-    db.transaction();
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO orders (order_number, order_date, delivery_date, client_id, notes, payment_term, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone, status) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(orderData.value("order_number"));
-    q.addBindValue(orderData.value("order_date"));
-    q.addBindValue(orderData.value("delivery_date"));
-    q.addBindValue(orderData.value("client_id"));
-    q.addBindValue(orderData.value("notes"));
-    q.addBindValue(orderData.value("payment_term"));
-    q.addBindValue(orderData.value("delivery_company"));
-    q.addBindValue(orderData.value("delivery_street"));
-    q.addBindValue(orderData.value("delivery_postal_code"));
-    q.addBindValue(orderData.value("delivery_city"));
-    q.addBindValue(orderData.value("delivery_contact_person"));
-    q.addBindValue(orderData.value("delivery_phone"));
-    q.addBindValue(orderData.contains("status") ? orderData.value("status").toInt() : 0); // Domyślny status: 0 = Przyjęte do realizacji
-    if (!q.exec()) { db.rollback(); return false; }
-    int orderId = q.lastInsertId().toInt();
-    for (const auto &item : items) {
-        QSqlQuery q2(db);
-        q2.prepare("INSERT INTO order_items (order_id, width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-        q2.addBindValue(orderId);
-        q2.addBindValue(item.value("width"));
-        q2.addBindValue(item.value("height"));
-        q2.addBindValue(item.value("material"));
-        q2.addBindValue(item.value("ordered_quantity"));
-        q2.addBindValue(item.value("quantity_type"));
-        q2.addBindValue(item.value("roll_length"));
-        q2.addBindValue(item.value("core"));
-        q2.addBindValue(item.value("price"));
-        q2.addBindValue(item.value("price_type"));
-        q2.addBindValue(item.value("zam_rolki"));
-        if (!q2.exec()) { db.rollback(); return false; }
-    }
-    db.commit();
+    connection().transaction();
+    auto q = prepared("INSERT INTO orders (order_number, order_date, delivery_date, client_id, notes, payment_term, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone, status) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    q->addBindValue(orderData.value("order_number"));
+    q->addBindValue(orderData.value("order_date"));
+    q->addBindValue(orderData.value("delivery_date"));
+    q->addBindValue(orderData.value("client_id"));
+    q->addBindValue(orderData.value("notes"));
+    q->addBindValue(orderData.value("payment_term"));
+    q->addBindValue(orderData.value("delivery_company"));
+    q->addBindValue(orderData.value("delivery_street"));
+    q->addBindValue(orderData.value("delivery_postal_code"));
+    q->addBindValue(orderData.value("delivery_city"));
+    q->addBindValue(orderData.value("delivery_contact_person"));
+    q->addBindValue(orderData.value("delivery_phone"));
+    q->addBindValue(orderData.contains("status") ? orderData.value("status").toInt() : 0); // Domyślny status: 0 = Przyjęte do realizacji
+    if (!q->exec()) { connection().rollback(); return false; }
+    int orderId = q->lastInsertId().toInt();
+    if (!insertOrderItems(orderId, items)) { connection().rollback(); return false; }
+    connection().commit();
     
     // Emituj sygnał o dodaniu nowego zamówienia
     qDebug() << "=== DbManager: Emituję sygnał orderAdded po zapisaniu zamówienia ===";
@@ -307,165 +1030,243 @@ bool DbManager::addOrder(const QMap<QString, QVariant>& orderData, const QVector
     return true;
 }
 
+bool DbManager::bulkInsert(const QString& table, const QStringList& columns, const QVector<QVariantList>& rows) {
+    const int chunkSize = BulkInsert::rowsPerStatement(columns.size());
+    for (int first = 0; first < rows.size(); first += chunkSize) {
+        const int count = qMin(chunkSize, static_cast<int>(rows.size()) - first);
+        // Pełne porcje mają ten sam tekst SQL, więc trafiają do cache zapytań
+        auto q = prepared(BulkInsert::statement(table, columns, count));
+        BulkInsert::bindRows(*q, rows, first, count);
+        if (!q->exec()) {
+            qWarning() << "Błąd wstawiania wierszy do" << table << ":" << q->lastError().text();
+            setLastError(q->lastError());
+            return false;
+        }
+    }
+    return true;
+}
+
+const QStringList& DbManager::orderItemColumns() {
+    static const QStringList columns = {"width", "height", "material", "ordered_quantity", "quantity_type",
+                                        "roll_length", "core", "price", "price_type", "zam_rolki",
+                                        "width_value", "height_value", "ordered_quantity_value", "roll_length_value", "price_value"};
+    return columns;
+}
+
+QVariantList DbManager::orderItemValues(const QMap<QString, QVariant>& item) {
+    return {item.value("width"), item.value("height"), item.value("material"),
+            item.value("ordered_quantity"), item.value("quantity_type"), item.value("roll_length"),
+            item.value("core"), item.value("price"), item.value("price_type"), item.value("zam_rolki"),
+            numericValue(item.value("width").toString()), numericValue(item.value("height").toString()),
+            numericValue(item.value("ordered_quantity").toString()), numericValue(item.value("roll_length").toString()),
+            numericValue(item.value("price").toString())};
+}
+
+bool DbManager::insertOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items) {
+    QVector<QVariantList> rows;
+    rows.reserve(items.size());
+    for (const auto& item : items) rows.append(QVariantList{orderId} + orderItemValues(item));
+    return bulkInsert("order_items", QStringList{"order_id"} + orderItemColumns(), rows);
+}
+
+bool DbManager::syncChildRows(const QString& table, const QString& parentColumn, int parentId,
+                              const QStringList& columns, const QVector<QPair<int, QVariantList>>& rows) {
+    QHash<int, QVariantList> existing;
+    auto qselect = prepared(QString("SELECT id, %1 FROM %2 WHERE %3 = ?").arg(columns.join(", "), table, parentColumn));
+    qselect->addBindValue(parentId);
+    if (!qselect->exec()) {
+        qWarning() << "Błąd odczytu" << table << ":" << qselect->lastError().text();
+        setLastError(qselect->lastError());
+        return false;
+    }
+    while (qselect->next()) {
+        QVariantList values;
+        values.reserve(columns.size());
+        for (int i = 0; i < columns.size(); ++i) values.append(qselect->value(i + 1));
+        existing.insert(qselect->value(0).toInt(), values);
+    }
+
+    const RowDiffPlan plan = RowDiff::plan(existing, rows);
+    if (!plan.deletes.isEmpty()) {
+        auto qdelete = prepared(QString("DELETE FROM %1 WHERE %2 = ? AND id IN (%3)")
+                                    .arg(table, parentColumn, QStringList(plan.deletes.size(), "?").join(", ")));
+        qdelete->addBindValue(parentId);
+        for (int id : plan.deletes) qdelete->addBindValue(id);
+        if (!qdelete->exec()) {
+            qWarning() << "Błąd usuwania z" << table << ":" << qdelete->lastError().text();
+            setLastError(qdelete->lastError());
+            return false;
+        }
+    }
+    if (!plan.updates.isEmpty()) {
+        QStringList assignments;
+        for (const QString& column : columns) assignments << column + " = ?";
+        auto qupdate = prepared(QString("UPDATE %1 SET %2 WHERE id = ?").arg(table, assignments.join(", ")));
+        for (const auto& update : plan.updates) {
+            for (const QVariant& value : update.second) qupdate->addBindValue(value);
+            qupdate->addBindValue(update.first);
+            if (!qupdate->exec()) {
+                qWarning() << "Błąd aktualizacji" << table << ":" << qupdate->lastError().text();
+                setLastError(qupdate->lastError());
+                return false;
+            }
+        }
+    }
+    if (!plan.inserts.isEmpty()) {
+        QVector<QVariantList> inserts;
+        inserts.reserve(plan.inserts.size());
+        for (const QVariantList& values : plan.inserts) inserts.append(QVariantList{parentId} + values);
+        if (!bulkInsert(table, QStringList{parentColumn} + columns, inserts)) return false;
+    }
+    if (!plan.isEmpty()) {
+        qCDebug(lcEdits) << "[Edycja]" << table << "- wstawione:" << plan.inserts.size()
+                         << "zmienione:" << plan.updates.size() << "usunięte:" << plan.deletes.size();
+    }
+    return true;
+}
+
+bool DbManager::syncOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items) {
+    QVector<QPair<int, QVariantList>> rows;
+    rows.reserve(items.size());
+    for (const auto& item : items) {
+        rows.append({item.value("id", -1).toInt(), orderItemValues(item)});
+    }
+    return syncChildRows("order_items", "order_id", orderId, orderItemColumns(), rows);
+}
+
+bool DbManager::syncDeliveryAddresses(int clientId, const QList<QMap<QString, QVariant>>& addresses) {
+    static const QStringList columns = {"name", "company", "street", "postal_code", "city", "contact_person", "phone"};
+    QVector<QPair<int, QVariantList>> rows;
+    rows.reserve(addresses.size());
+    for (const auto& addr : addresses) {
+        QVariantList values;
+        for (const QString& column : columns) values.append(addr.value(column));
+        rows.append({addr.value("id", -1).toInt(), values});
+    }
+    return syncChildRows("delivery_addresses", "client_id", clientId, columns, rows);
+}
+
+bool DbManager::insertMaterialsOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items) {
+    static const QStringList columns = {"order_id", "material_id", "material_name", "width", "length", "quantity", "quantity_value"};
+    QVector<QVariantList> rows;
+    rows.reserve(items.size());
+    for (const auto& item : items) {
+        rows.append({orderId, item.value("material_id"), item.value("material_name"),
+                     item.value("width"), item.value("length"), item.value("quantity"),
+                     numericValue(item.value("quantity").toString())});
+    }
+    return bulkInsert("materials_order_items", columns, rows);
+}
+
 bool DbManager::addMaterialsOrder(const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
-    QSqlQuery q(db);
-    QSqlDatabase::database().transaction();
+    connection().transaction();
     // Dodaj zamówienie do materials_orders
-    q.prepare("INSERT INTO materials_orders (order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(orderData.value("order_number"));
-    q.addBindValue(orderData.value("order_date"));
-    q.addBindValue(orderData.value("delivery_date"));
-    q.addBindValue(orderData.value("notes"));
-    q.addBindValue(orderData.value("supplier_id"));
-    q.addBindValue(orderData.value("delivery_company"));
-    q.addBindValue(orderData.value("delivery_street"));
-    q.addBindValue(orderData.value("delivery_postal_code"));
-    q.addBindValue(orderData.value("delivery_city"));
-    q.addBindValue(orderData.value("delivery_country"));
-    q.addBindValue(orderData.contains("done") ? orderData.value("done").toInt() : 0);
-    if (!q.exec()) {
-        m_lastError = q.lastError();
-        QSqlDatabase::database().rollback();
+    auto q = prepared("INSERT INTO materials_orders (order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    q->addBindValue(orderData.value("order_number"));
+    q->addBindValue(orderData.value("order_date"));
+    q->addBindValue(orderData.value("delivery_date"));
+    q->addBindValue(orderData.value("notes"));
+    q->addBindValue(orderData.value("supplier_id"));
+    q->addBindValue(orderData.value("delivery_company"));
+    q->addBindValue(orderData.value("delivery_street"));
+    q->addBindValue(orderData.value("delivery_postal_code"));
+    q->addBindValue(orderData.value("delivery_city"));
+    q->addBindValue(orderData.value("delivery_country"));
+    q->addBindValue(orderData.contains("done") ? orderData.value("done").toInt() : 0);
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        connection().rollback();
         return false;
     }
-    int orderId = q.lastInsertId().toInt();
+    int orderId = q->lastInsertId().toInt();
     // Dodaj pozycje zamówienia do materials_order_items
-    QSqlQuery q2(db);
-    for (const auto& item : items) {
-        q2.prepare("INSERT INTO materials_order_items (order_id, material_id, material_name, width, length, quantity) VALUES (?, ?, ?, ?, ?, ?)");
-        q2.addBindValue(orderId);
-        q2.addBindValue(item.value("material_id"));
-        q2.addBindValue(item.value("material_name"));
-        q2.addBindValue(item.value("width"));
-        q2.addBindValue(item.value("length"));
-        q2.addBindValue(item.value("quantity"));
-        if (!q2.exec()) {
-            m_lastError = q2.lastError();
-            QSqlDatabase::database().rollback();
-            return false;
-        }
+    if (!insertMaterialsOrderItems(orderId, items)) {
+        connection().rollback();
+        return false;
     }
-    QSqlDatabase::database().commit();
+    connection().commit();
     emit orderAdded();
     return true;
 }
 
 bool DbManager::updateOrder(int id, const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
     return executeTransaction([&]() {
-        QSqlQuery q(db);
-        q.prepare("UPDATE orders SET order_number=?, order_date=?, delivery_date=?, client_id=?, notes=?, payment_term=?, delivery_company=?, delivery_street=?, delivery_postal_code=?, delivery_city=?, delivery_contact_person=?, delivery_phone=? WHERE id=?");
-        q.addBindValue(orderData.value("order_number"));
-        q.addBindValue(orderData.value("order_date"));
-        q.addBindValue(orderData.value("delivery_date"));
-        q.addBindValue(orderData.value("client_id"));
-        q.addBindValue(orderData.value("notes"));
-        q.addBindValue(orderData.value("payment_term"));
-        q.addBindValue(orderData.value("delivery_company"));
-        q.addBindValue(orderData.value("delivery_street"));
-        q.addBindValue(orderData.value("delivery_postal_code"));
-        q.addBindValue(orderData.value("delivery_city"));
-        q.addBindValue(orderData.value("delivery_contact_person"));
-        q.addBindValue(orderData.value("delivery_phone"));
-        q.addBindValue(id);
-        
-        if (!q.exec()) {
-            qWarning() << "Błąd aktualizacji zamówienia:" << q.lastError().text();
-            m_lastError = q.lastError(); // Ustawienie m_lastError
+        auto q = prepared("UPDATE orders SET order_number=?, order_date=?, delivery_date=?, client_id=?, notes=?, payment_term=?, delivery_company=?, delivery_street=?, delivery_postal_code=?, delivery_city=?, delivery_contact_person=?, delivery_phone=? WHERE id=?");
+        q->addBindValue(orderData.value("order_number"));
+        q->addBindValue(orderData.value("order_date"));
+        q->addBindValue(orderData.value("delivery_date"));
+        q->addBindValue(orderData.value("client_id"));
+        q->addBindValue(orderData.value("notes"));
+        q->addBindValue(orderData.value("payment_term"));
+        q->addBindValue(orderData.value("delivery_company"));
+        q->addBindValue(orderData.value("delivery_street"));
+        q->addBindValue(orderData.value("delivery_postal_code"));
+        q->addBindValue(orderData.value("delivery_city"));
+        q->addBindValue(orderData.value("delivery_contact_person"));
+        q->addBindValue(orderData.value("delivery_phone"));
+        q->addBindValue(id);
+        
+        if (!q->exec()) {
+            qWarning() << "Błąd aktualizacji zamówienia:" << q->lastError().text();
+            setLastError(q->lastError()); // Ustawienie m_lastError
             return false;
         }
         
-        // Usuń stare pozycje
-        QSqlQuery qdel(db);
-        qdel.prepare("DELETE FROM order_items WHERE order_id=?");
-        qdel.addBindValue(id);
-        
-        if (!qdel.exec()) {
-            qWarning() << "Błąd usuwania pozycji zamówienia:" << qdel.lastError().text();
-            m_lastError = qdel.lastError(); // Ustawienie m_lastError
-            return false;
-        }
-        
-        // Dodaj nowe pozycje
-        for (const auto &item : items) {
-            QSqlQuery q2(db);
-            q2.prepare("INSERT INTO order_items (order_id, width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-            q2.addBindValue(id);
-            q2.addBindValue(item.value("width"));
-            q2.addBindValue(item.value("height"));
-            q2.addBindValue(item.value("material"));
-            q2.addBindValue(item.value("ordered_quantity"));
-            q2.addBindValue(item.value("quantity_type"));
-            q2.addBindValue(item.value("roll_length"));
-            q2.addBindValue(item.value("core"));
-            q2.addBindValue(item.value("price"));
-            q2.addBindValue(item.value("price_type"));
-            q2.addBindValue(item.value("zam_rolki"));
-            
-            if (!q2.exec()) {
-                qWarning() << "Błąd dodawania pozycji zamówienia:" << q2.lastError().text();
-                m_lastError = q2.lastError(); // Ustawienie m_lastError
-                return false;
-            }
-        }
-        
-        return true;
+        // Tylko zmienione pozycje - dopasowanie po "id"
+        return syncOrderItems(id, items);
     });
 }
 
 bool DbManager::deleteClient(int id) {
     // Najpierw usuń powiązane adresy dostawy
-    QSqlQuery qdel(db);
     qDebug() << "[DEBUG] Usuwanie adresów dostawy klienta id:" << id;
-    qdel.prepare("DELETE FROM delivery_addresses WHERE client_id=?");
-    qdel.addBindValue(id);
-    if (!qdel.exec()) {
-        qDebug() << "[DEBUG] Błąd SQL (delete adresy):" << qdel.lastError().text();
-        m_lastError = qdel.lastError(); // Ustawienie m_lastError
+    auto qdel = prepared("DELETE FROM delivery_addresses WHERE client_id=?");
+    qdel->addBindValue(id);
+    if (!qdel->exec()) {
+        qDebug() << "[DEBUG] Błąd SQL (delete adresy):" << qdel->lastError().text();
+        setLastError(qdel->lastError()); // Ustawienie m_lastError
         return false;
     }
     // Usuń powiązane zamówienia (i pozycje zamówień)
-    QSqlQuery qOrders(db);
-    qOrders.prepare("SELECT id FROM orders WHERE client_id=?");
-    qOrders.addBindValue(id);
-    if (qOrders.exec()) {
-        while (qOrders.next()) {
-            int orderId = qOrders.value(0).toInt();
+    auto qOrders = prepared("SELECT id FROM orders WHERE client_id=?");
+    qOrders->addBindValue(id);
+    if (qOrders->exec()) {
+        while (qOrders->next()) {
+            int orderId = qOrders->value(0).toInt();
             deleteOrder(orderId);
         }
     }
     // Usuń klienta
-    QSqlQuery q(db);
-    q.prepare("DELETE FROM clients WHERE id=?");
-    q.addBindValue(id);
-    if (!q.exec()) {
-        qDebug() << "[DEBUG] Błąd SQL (delete klient):" << q.lastError().text();
-        m_lastError = q.lastError(); // Ustawienie m_lastError
+    auto q = prepared("DELETE FROM clients WHERE id=?");
+    q->addBindValue(id);
+    if (!q->exec()) {
+        qDebug() << "[DEBUG] Błąd SQL (delete klient):" << q->lastError().text();
+        setLastError(q->lastError()); // Ustawienie m_lastError
         return false;
     }
+    m_entityCache.invalidate(EntityCache::Clients);
     return true;
 }
 
 bool DbManager::deleteOrder(int id) {
     return executeTransaction([&]() {
         // Usuń elementy zamówienia
-        QSqlQuery q1(db);
-        q1.prepare("DELETE FROM order_items WHERE order_id=?");
-        q1.addBindValue(id);
+        auto q1 = prepared("DELETE FROM order_items WHERE order_id=?");
+        q1->addBindValue(id);
         
-        if (!q1.exec()) {
-            qWarning() << "Błąd usuwania pozycji zamówienia:" << q1.lastError().text();
-            m_lastError = q1.lastError(); // Ustawienie m_lastError
+        if (!q1->exec()) {
+            qWarning() << "Błąd usuwania pozycji zamówienia:" << q1->lastError().text();
+            setLastError(q1->lastError()); // Ustawienie m_lastError
             return false;
         }
         
         // Usuń zamówienie
-        QSqlQuery q2(db);
-        q2.prepare("DELETE FROM orders WHERE id=?");
-        q2.addBindValue(id);
+        auto q2 = prepared("DELETE FROM orders WHERE id=?");
+        q2->addBindValue(id);
         
-        if (!q2.exec()) {
-            qWarning() << "Błąd usuwania zamówienia:" << q2.lastError().text();
-            m_lastError = q2.lastError(); // Ustawienie m_lastError
+        if (!q2->exec()) {
+            qWarning() << "Błąd usuwania zamówienia:" << q2->lastError().text();
+            setLastError(q2->lastError()); // Ustawienie m_lastError
             return false;
         }
         
@@ -476,34 +1277,16 @@ bool DbManager::deleteOrder(int id) {
 
 
 bool DbManager::addDeliveryAddress(const QMap<QString, QVariant>& data) {
-    if (!db.isOpen()) {
+    if (!connection().isOpen()) {
         qWarning() << "Błąd: Brak połączenia z bazą danych";
         return false;
     }
     
     // Sprawdź, czy kolumny istnieją w tabeli
-    bool hasCountry = false;
-    bool hasNip = false;
-    
-    if (db.driverName() == "QPSQL") {
-        QSqlQuery checkQuery(db);
-        if (checkQuery.exec("SELECT column_name FROM information_schema.columns WHERE table_name = 'delivery_addresses'")) {
-            while (checkQuery.next()) {
-                QString columnName = checkQuery.value(0).toString();
-                if (columnName == "country") hasCountry = true;
-                if (columnName == "nip") hasNip = true;
-            }
-        }
-    } else {
-        // Dla SQLite
-        QSqlRecord record = db.record("delivery_addresses");
-        hasCountry = record.contains("country");
-        hasNip = record.contains("nip");
-    }
+    bool hasCountry = checkColumnExistence("delivery_addresses", "country");
+    bool hasNip = checkColumnExistence("delivery_addresses", "nip");
     
     return executeTransaction([&]() {
-        QSqlQuery q(db);
-        
         // Buduj dynamicznie zapytanie w zależności od dostępnych kolumn
         QStringList columns = {"client_id", "name", "company", "street", "postal_code", 
                               "city", "contact_person", "phone"};
@@ -523,33 +1306,30 @@ bool DbManager::addDeliveryAddress(const QMap<QString, QVariant>& data) {
         
         qDebug() << "Zapytanie dodawania adresu dostawy:" << queryStr;
         
-        if (!q.prepare(queryStr)) {
-            m_lastError = q.lastError();
-            qWarning() << "Błąd przygotowania zapytania dodawania adresu dostawy:" << q.lastError().text();
-            return false;
-        }
+        // Błąd prepare() zgłosi exec() poniżej
+        auto q = prepared(queryStr);
         
         // Dodaj wartości w odpowiedniej kolejności
-        q.addBindValue(data.value("client_id", QVariant(-1)));
-        q.addBindValue(data.value("name"));
-        q.addBindValue(data.value("company"));
-        q.addBindValue(data.value("street"));
-        q.addBindValue(data.value("postal_code"));
-        q.addBindValue(data.value("city"));
-        q.addBindValue(data.value("contact_person"));
-        q.addBindValue(data.value("phone"));
+        q->addBindValue(data.value("client_id", QVariant(-1)));
+        q->addBindValue(data.value("name"));
+        q->addBindValue(data.value("company"));
+        q->addBindValue(data.value("street"));
+        q->addBindValue(data.value("postal_code"));
+        q->addBindValue(data.value("city"));
+        q->addBindValue(data.value("contact_person"));
+        q->addBindValue(data.value("phone"));
         
         if (hasCountry) {
-            q.addBindValue(data.value("country", ""));
+            q->addBindValue(data.value("country", ""));
         }
         
         if (hasNip) {
-            q.addBindValue(data.value("nip", ""));
+            q->addBindValue(data.value("nip", ""));
         }
         
-        if (!q.exec()) {
-            m_lastError = q.lastError();
-            qWarning() << "Błąd dodawania adresu dostawy:" << q.lastError().text();
+        if (!q->exec()) {
+            setLastError(q->lastError());
+            qWarning() << "Błąd dodawania adresu dostawy:" << q->lastError().text();
             return false;
         }
         
@@ -559,7 +1339,7 @@ bool DbManager::addDeliveryAddress(const QMap<QString, QVariant>& data) {
 }
 
 bool DbManager::updateDeliveryAddress(const QMap<QString, QVariant>& data) {
-    if (!db.isOpen()) {
+    if (!connection().isOpen()) {
         qWarning() << "Błąd: Brak połączenia z bazą danych";
         return false;
     }
@@ -571,21 +1351,13 @@ bool DbManager::updateDeliveryAddress(const QMap<QString, QVariant>& data) {
     
     int id = data["id"].toInt();
     
-    // Sprawdź, czy kolumny istnieją w tabeli - ulepszona wersja
+    // Sprawdź, czy kolumny istnieją w tabeli
     bool hasCountry = checkColumnExistence("delivery_addresses", "country");
     bool hasNip = checkColumnExistence("delivery_addresses", "nip");
     
-    // Wymuszamy wykrycie kolumn, jeśli wiemy, że istnieją (zgodnie z informacjami użytkownika)
-    if (!hasCountry || !hasNip) {
-        qDebug() << "Uwaga: Wymuszam wykrycie kolumn 'country' i 'nip' (znane problemy z wykrywaniem)";
-        hasCountry = hasNip = true;
-    }
-    
     qDebug() << "Aktualizacja adresu dostawy ID:" << id << "- wykryte kolumny: country:" << hasCountry << "nip:" << hasNip;
     
     return executeTransaction([&]() {
-        QSqlQuery q(db);
-        
         // Buduj dynamicznie zapytanie w zależności od dostępnych kolumn
         QStringList setClauses = {
             "name = ?", 
@@ -606,32 +1378,29 @@ bool DbManager::updateDeliveryAddress(const QMap<QString, QVariant>& data) {
         
         qDebug() << "Zapytanie aktualizacji adresu dostawy:" << queryStr;
         
-        if (!q.prepare(queryStr)) {
-            m_lastError = q.lastError();
-            qWarning() << "Błąd przygotowania zapytania aktualizacji adresu dostawy:" << q.lastError().text();
-            return false;
-        }
+        // Błąd prepare() zgłosi exec() poniżej
+        auto q = prepared(queryStr);
         
         // Dodaj wartości w odpowiedniej kolejności (zgodnie z kolejnością w setClauses)
-        q.addBindValue(data.value("name"));
-        q.addBindValue(data.value("company"));
-        q.addBindValue(data.value("street"));
-        q.addBindValue(data.value("postal_code"));
-        q.addBindValue(data.value("city"));
-        q.addBindValue(data.value("contact_person"));
-        q.addBindValue(data.value("phone"));
+        q->addBindValue(data.value("name"));
+        q->addBindValue(data.value("company"));
+        q->addBindValue(data.value("street"));
+        q->addBindValue(data.value("postal_code"));
+        q->addBindValue(data.value("city"));
+        q->addBindValue(data.value("contact_person"));
+        q->addBindValue(data.value("phone"));
         
         // Dodaj opcjonalne wartości, jeśli kolumny istnieją
         if (hasCountry) {
-            q.addBindValue(data.value("country", ""));
+            q->addBindValue(data.value("country", ""));
         }
         
         if (hasNip) {
-            q.addBindValue(data.value("nip", ""));
+            q->addBindValue(data.value("nip", ""));
         }
         
         // Dodaj ID warunku WHERE
-        q.addBindValue(id);
+        q->addBindValue(id);
         
         qDebug() << "Wartości do aktualizacji:" 
                  << "name:" << data.value("name").toString()
@@ -645,16 +1414,16 @@ bool DbManager::updateDeliveryAddress(const QMap<QString, QVariant>& data) {
                  << "nip:" << (hasNip ? data.value("nip", "").toString() : "[niedostępne]")
                  << "id:" << id;
         
-        if (!q.exec()) {
-            m_lastError = q.lastError();
-            qWarning() << "Błąd wykonania zapytania aktualizacji adresu dostawy:" << q.lastError().text();
-            qWarning() << "Szczegóły błędu:" << q.lastError().databaseText();
+        if (!q->exec()) {
+            setLastError(q->lastError());
+            qWarning() << "Błąd wykonania zapytania aktualizacji adresu dostawy:" << q->lastError().text();
+            qWarning() << "Szczegóły błędu:" << q->lastError().databaseText();
             qWarning() << "ID adresu dostawy:" << id;
             qWarning() << "Dane do aktualizacji:" << data;
             return false;
         }
         
-        int rowsAffected = q.numRowsAffected();
+        int rowsAffected = q->numRowsAffected();
         if (rowsAffected == 0) {
             qWarning() << "Nie znaleziono adresu dostawy o ID:" << id << "do aktualizacji";
             return false;
@@ -666,90 +1435,476 @@ bool DbManager::updateDeliveryAddress(const QMap<QString, QVariant>& data) {
 }
 
 bool DbManager::migrateDeliveryAddresses() {
-    if (!db.isOpen()) {
+    if (!connection().isOpen()) {
         qWarning() << "Błąd: Brak połączenia z bazą danych";
         return false;
     }
     
     return executeTransaction([&]() {
-        QSqlQuery q(db);
+        QSqlQuery q(connection());
         
         // Sprawdź czy kolumny istnieją
-        bool hasCountry = false;
-        bool hasNip = false;
+        bool hasCountry = checkColumnExistence("delivery_addresses", "country");
+        bool hasNip = checkColumnExistence("delivery_addresses", "nip");
         
-        if (db.driverName() == "QPSQL") {
-            QSqlQuery checkColQuery(db);
-            if (checkColQuery.exec("SELECT column_name FROM information_schema.columns WHERE table_name = 'delivery_addresses' AND column_name = 'country'")) {
-                hasCountry = checkColQuery.next();
+        if (!hasCountry || !hasNip) {
+            qWarning() << "Błąd: Brak wymaganych kolumn w tabeli delivery_addresses";
+            return false;
+        }
+        
+        // Aktualizuj puste wartości dla istniejących rekordów
+        if (!q.exec("UPDATE delivery_addresses SET country = 'Polska' WHERE country IS NULL OR country = ''")) {
+            qWarning() << "Błąd aktualizacji pustych wartości country:" << q.lastError().text();
+            return false;
+        }
+        
+        // Dla NIP ustawiamy pusty string zamiast NULL, jeśli jest NULL
+        if (!q.exec("UPDATE delivery_addresses SET nip = '' WHERE nip IS NULL")) {
+            qWarning() << "Błąd aktualizacji pustych wartości nip:" << q.lastError().text();
+            return false;
+        }
+        
+        qDebug() << "Pomyślnie zaktualizowano dane w tabeli delivery_addresses";
+        return true;
+    });
+}
+
+void DbManager::runMigrations() {
+    QSqlQuery q(db);
+    if (!q.exec("CREATE TABLE IF NOT EXISTS schema_migrations ("
+                "name TEXT PRIMARY KEY, "
+                "applied_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)")) {
+        qWarning() << "Nie można utworzyć tabeli schema_migrations:" << q.lastError().text();
+        return;
+    }
+    refreshSchema();
+    ensureIndexes();
+    m_search.install(connection());
+    // Diagnostyka: plany kluczowych zapytań w logu (domyślnie wyłączone)
+    if (SettingsManager::instance().getValue("database/log_query_plans", false).toBool()) {
+        qDebug().noquote() << queryPlanReport();
+    }
+    if (!isMigrationApplied("order_numbers_zam_format")) {
+        bool ok = migrateOrderNumbers([](int done, int total) {
+            qDebug() << "[Migracja] Numery zamówień:" << done << "/" << total;
+        });
+        if (ok) markMigrationApplied("order_numbers_zam_format");
+        else qWarning() << "[Migracja] Numery zamówień nie zostały poprawione - ponowna próba przy następnym uruchomieniu";
+    }
+    if (!isMigrationApplied("numeric_item_values")) {
+        bool ok = migrateNumericItemValues([](int done, int total) {
+            qDebug() << "[Migracja] Wartości liczbowe pozycji:" << done << "/" << total;
+        });
+        if (ok) markMigrationApplied("numeric_item_values");
+        else qWarning() << "[Migracja] Wartości liczbowe pozycji nie zostały uzupełnione - ponowna próba przy następnym uruchomieniu";
+    }
+    if (!isMigrationApplied("number_sequences")) {
+        if (migrateNumberSequences()) markMigrationApplied("number_sequences");
+        else qWarning() << "[Migracja] Ciągi numeracji nie zostały utworzone - ponowna próba przy następnym uruchomieniu";
+    }
+    if (installProductionRollup() && !isMigrationApplied("production_rollup")) {
+        if (rebuildProductionRollup()) markMigrationApplied("production_rollup");
+    }
+    // Migracje mogły dodać tabele i kolumny
+    refreshSchema();
+    // updated_at i usunięte wiersze dla kopii lokalnych stanowisk
+    if (connection().driverName() == "QPSQL" && replicaEnabled()) {
+        QSqlError replicaError;
+        if (LocalReplica::installServer(connection(), m_schema, &replicaError)) refreshSchema();
+        else setLastError(replicaError);
+    }
+    // Archiwum na końcu - dopisuje kolumny dodane przez migracje powyżej
+    QSqlError archiveError;
+    if (OrderArchive::install(connection(), m_schema, &archiveError)) refreshSchema();
+    else setLastError(archiveError);
+}
+
+bool DbManager::isMigrationApplied(const QString& name) {
+    auto q = prepared("SELECT 1 FROM schema_migrations WHERE name = ?");
+    q->addBindValue(name);
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        return false;
+    }
+    return q->next();
+}
+
+bool DbManager::markMigrationApplied(const QString& name) {
+    auto q = prepared("INSERT INTO schema_migrations (name) VALUES (?)");
+    q->addBindValue(name);
+    if (!q->exec()) {
+        qWarning() << "Błąd zapisu migracji" << name << ":" << q->lastError().text();
+        setLastError(q->lastError());
+        return false;
+    }
+    return true;
+}
+
+QStringList DbManager::missingIndexes() {
+    QStringList missing;
+    QSqlQuery q(connection());
+    bool ok = connection().driverName() == "QPSQL"
+        ? q.exec("SELECT indexname FROM pg_indexes WHERE schemaname = current_schema()")
+        : q.exec("SELECT name FROM sqlite_master WHERE type = 'index'");
+    if (!ok) {
+        qWarning() << "Błąd odczytu listy indeksów:" << q.lastError().text();
+        setLastError(q.lastError());
+        for (const auto& index : indexDefinitions()) missing << index.name;
+        return missing;
+    }
+    QSet<QString> existing;
+    while (q.next()) existing.insert(q.value(0).toString());
+    for (const auto& index : indexDefinitions()) {
+        if (!existing.contains(index.name)) missing << index.name;
+    }
+    return missing;
+}
+
+bool DbManager::ensureIndexes() {
+    const QStringList missing = missingIndexes();
+    QSet<int> failedVersions;
+    QSqlQuery q(connection());
+    for (const auto& index : indexDefinitions()) {
+        if (!missing.contains(index.name)) continue;
+        // Starsze bazy SQLite nie mają wszystkich kolumn - taki indeks pomijamy
+        bool hasColumns = m_schema.hasTable(index.table);
+        for (const QString& column : index.columns) hasColumns = hasColumns && m_schema.hasColumn(index.table, column);
+        if (!hasColumns) {
+            qWarning() << "[Indeksy] Pominięto" << index.name << "- brak tabeli lub kolumn" << index.table << index.columns;
+            failedVersions.insert(index.version);
+            continue;
+        }
+        const QString key = index.sortDateKey
+            ? QString("(%1), id").arg(orderSortDateExpression(connection().driverName() == "QPSQL", "order_date"))
+            : index.columns.join(", ");
+        QString sql = QString("CREATE INDEX IF NOT EXISTS %1 ON %2 (%3)").arg(index.name, index.table, key);
+        if (!q.exec(sql)) {
+            qWarning() << "[Indeksy] Błąd tworzenia" << index.name << ":" << q.lastError().text();
+            setLastError(q.lastError());
+            failedVersions.insert(index.version);
+            continue;
+        }
+        qDebug() << "[Indeksy] Utworzono" << index.name;
+    }
+    // Wersja jest zapisywana raz, gdy wszystkie jej indeksy istnieją
+    QSet<int> versions;
+    for (const auto& index : indexDefinitions()) versions.insert(index.version);
+    for (int version : std::as_const(versions)) {
+        if (failedVersions.contains(version)) continue;
+        QString migration = QString("indexes_v%1").arg(version);
+        if (!isMigrationApplied(migration)) markMigrationApplied(migration);
+    }
+    return failedVersions.isEmpty();
+}
+
+QString DbManager::queryPlanReport() {
+    const bool isPostgres = connection().driverName() == "QPSQL";
+    const QString today = QDate::currentDate().toString(Qt::ISODate);
+    const QString nextWeek = QDate::currentDate().addDays(7).toString(Qt::ISODate);
+    const QVector<PlannedStatement> statements = {
+        {"Pozycje zamówienia", "SELECT * FROM order_items WHERE order_id = 1"},
+        {"Zamówienia wg statusu", "SELECT id FROM orders WHERE status = '0'"},
+        {"Zamówienia wg daty dostawy", QString("SELECT id FROM orders WHERE delivery_date BETWEEN '%1' AND '%2'").arg(today, nextWeek)},
+        // To samo zapytanie co fetchOrdersPage: pierwsza strona i strona za kursorem
+        {"Strona listy zamówień", inlineParameters(orderListSql({}, false), {"200"})},
+        {"Kolejna strona listy zamówień",
+         inlineParameters(orderListSql({orderKeysetCondition()}, false), {QString("'%1'").arg(today), "2147483647", "200"})},
+        {"Klient wg NIP", "SELECT id FROM clients WHERE nip = '0000000000'"},
+        {"Klient wg numeru", "SELECT id FROM clients WHERE client_number = '1'"},
+        {"Adresy dostawy klienta", "SELECT * FROM delivery_addresses WHERE client_id = 1"},
+        {"Pozycje zamówienia materiałów", "SELECT * FROM materials_order_items WHERE order_id = 1"},
+    };
+    QString report;
+    report += QString("Plany zapytań (%1)\n").arg(connection().driverName());
+    const QStringList missing = missingIndexes();
+    report += missing.isEmpty() ? QString("Wszystkie indeksy istnieją\n")
+                                : QString("Brakujące indeksy: %1\n").arg(missing.join(", "));
+    for (const auto& statement : statements) {
+        report += QString("\n-- %1\n%2\n").arg(statement.label, statement.sql);
+        QSqlQuery q(connection());
+        if (!q.exec(QString(isPostgres ? "EXPLAIN %1" : "EXPLAIN QUERY PLAN %1").arg(statement.sql))) {
+            report += QString("  błąd: %1\n").arg(q.lastError().text());
+            continue;
+        }
+        // PostgreSQL: jedna kolumna z linią planu; SQLite: (id, parent, notused, detail)
+        const int detailColumn = isPostgres ? 0 : 3;
+        while (q.next()) report += "  " + q.value(detailColumn).toString() + "\n";
+    }
+    return report;
+}
+
+bool DbManager::migrateOrderNumbers(const std::function<void(int done, int total)>& progress) {
+    int total = 0;
+    {
+        auto qcount = prepared("SELECT COUNT(*) FROM orders");
+        if (!qcount->exec() || !qcount->next()) {
+            qWarning() << "Błąd liczenia zamówień:" << qcount->lastError().text();
+            setLastError(qcount->lastError());
+            return false;
+        }
+        total = qcount->value(0).toInt();
+    }
+
+    int done = 0;
+    int repaired = 0;
+    int lastId = 0;
+    while (true) {
+        // Partia po kluczu (id > ostatnie id) - bez OFFSET, który skanowałby od początku
+        QVector<QPair<int, QString>> fixes;
+        int batchRows = 0;
+        {
+            auto q = prepared("SELECT id, order_number, order_date FROM orders WHERE id > ? ORDER BY id LIMIT ?");
+            q->addBindValue(lastId);
+            q->addBindValue(MIGRATION_BATCH_SIZE);
+            if (!q->exec()) {
+                qWarning() << "Błąd pobierania numerów zamówień:" << q->lastError().text();
+                setLastError(q->lastError());
+                return false;
             }
-            if (checkColQuery.exec("SELECT column_name FROM information_schema.columns WHERE table_name = 'delivery_addresses' AND column_name = 'nip'")) {
-                hasNip = checkColQuery.next();
+            while (q->next()) {
+                ++batchRows;
+                lastId = q->value(0).toInt();
+                if (Order::isValidOrderNumber(q->value(1).toString())) continue;
+                QDate orderDate = q->value(2).toDate();
+                int year = orderDate.isValid() ? orderDate.year() : QDate::currentDate().year();
+                fixes.append({lastId, QString("ZAM-%1-%2").arg(year).arg(lastId, 3, 10, QChar('0'))});
             }
-        } else {
-            QSqlRecord record = db.record("delivery_addresses");
-            hasCountry = record.contains("country");
-            hasNip = record.contains("nip");
         }
-        
-        if (!hasCountry || !hasNip) {
-            qWarning() << "Błąd: Brak wymaganych kolumn w tabeli delivery_addresses";
+        if (batchRows == 0) break;
+
+        if (!fixes.isEmpty()) {
+            bool ok = executeTransaction([&]() {
+                auto qupdate = prepared("UPDATE orders SET order_number=? WHERE id=?");
+                for (const auto& fix : fixes) {
+                    qupdate->addBindValue(fix.second);
+                    qupdate->addBindValue(fix.first);
+                    if (!qupdate->exec()) {
+                        qWarning() << "Błąd poprawiania numeru zamówienia ID:" << fix.first << qupdate->lastError().text();
+                        setLastError(qupdate->lastError());
+                        return false;
+                    }
+                }
+                return true;
+            });
+            if (!ok) return false;
+            repaired += fixes.size();
+        }
+        done += batchRows;
+        if (progress) progress(qMin(done, total), total);
+        if (batchRows < MIGRATION_BATCH_SIZE) break;
+    }
+    qDebug() << "[Migracja] Poprawiono numery zamówień:" << repaired << "z" << done;
+    return true;
+}
+
+bool DbManager::migrateNumericItemValues(const std::function<void(int done, int total)>& progress) {
+    const QString numericType = connection().driverName() == "QPSQL" ? "DOUBLE PRECISION" : "REAL";
+    const QList<QPair<QString, QStringList>> tables = {
+        {"order_items", {"width", "height", "ordered_quantity", "roll_length", "price"}},
+        {"materials_order_items", {"quantity"}}};
+
+    int total = 0;
+    for (const auto& table : tables) {
+        for (const QString& column : table.second) {
+            const QString valueColumn = column + "_value";
+            if (checkColumnExistence(table.first, valueColumn)) continue;
+            QSqlQuery alter(connection());
+            if (!alter.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table.first, valueColumn, numericType))) {
+                qWarning() << "Nie udało się dodać kolumny" << valueColumn << "do tabeli" << table.first << ":" << alter.lastError().text();
+                setLastError(alter.lastError());
+                return false;
+            }
+        }
+        auto qcount = prepared(QString("SELECT COUNT(*) FROM %1").arg(table.first));
+        if (!qcount->exec() || !qcount->next()) {
+            qWarning() << "Błąd liczenia pozycji" << table.first << ":" << qcount->lastError().text();
+            setLastError(qcount->lastError());
+            return false;
+        }
+        total += qcount->value(0).toInt();
+    }
+
+    int done = 0;
+    for (const auto& table : tables) {
+        const QStringList& columns = table.second;
+        QStringList assignments;
+        for (const QString& column : columns) assignments << column + "_value=?";
+        const QString selectSql = QString("SELECT id, %1 FROM %2 WHERE id > ? ORDER BY id LIMIT ?").arg(columns.join(", "), table.first);
+        const QString updateSql = QString("UPDATE %1 SET %2 WHERE id=?").arg(table.first, assignments.join(", "));
+        int invalid = 0;
+        int lastId = 0;
+        while (true) {
+            // Partie po kluczu jak w migrateOrderNumbers
+            QVector<QVariantList> updates;
+            {
+                auto q = prepared(selectSql);
+                q->addBindValue(lastId);
+                q->addBindValue(MIGRATION_BATCH_SIZE);
+                if (!q->exec()) {
+                    qWarning() << "Błąd pobierania pozycji" << table.first << ":" << q->lastError().text();
+                    setLastError(q->lastError());
+                    return false;
+                }
+                while (q->next()) {
+                    lastId = q->value(0).toInt();
+                    QVariantList values;
+                    for (int i = 0; i < columns.size(); ++i) {
+                        const QString text = q->value(i + 1).toString();
+                        const QVariant value = numericValue(text);
+                        if (value.isNull() && !text.trimmed().isEmpty()) ++invalid;
+                        values << value;
+                    }
+                    values << lastId;
+                    updates.append(values);
+                }
+            }
+            if (updates.isEmpty()) break;
+
+            bool ok = executeTransaction([&]() {
+                auto qupdate = prepared(updateSql);
+                for (const QVariantList& values : updates) {
+                    for (const QVariant& value : values) qupdate->addBindValue(value);
+                    if (!qupdate->exec()) {
+                        qWarning() << "Błąd zapisu wartości liczbowych" << table.first << "ID:" << values.last() << qupdate->lastError().text();
+                        setLastError(qupdate->lastError());
+                        return false;
+                    }
+                }
+                return true;
+            });
+            if (!ok) return false;
+            done += updates.size();
+            if (progress) progress(qMin(done, total), total);
+            if (updates.size() < MIGRATION_BATCH_SIZE) break;
+        }
+        // Tekst zostaje bez zmian; kolumna *_value jest wtedy NULL
+        if (invalid > 0) qWarning() << "[Migracja]" << table.first << "- wartości, które nie są liczbą:" << invalid;
+    }
+    return true;
+}
+
+bool DbManager::migrateNumberSequences() {
+    QSqlError error;
+    if (!NumberingService::createTable(connection(), &error)) {
+        setLastError(error);
+        return false;
+    }
+    const QStringList tables = connection().tables();
+    const int currentYear = QDate::currentDate().year();
+
+    // Najwyższy numer w każdym roku, z numerów już zapisanych w tabeli
+    auto maxPerYear = [this](const QString& sql, const QRegularExpression& re, QHash<int, qint64>& result) {
+        QSqlQuery q(connection());
+        q.setForwardOnly(true);
+        if (!q.exec(sql)) {
+            setLastError(q.lastError());
             return false;
         }
-        
-        // Aktualizuj puste wartości dla istniejących rekordów
-        if (!q.exec("UPDATE delivery_addresses SET country = 'Polska' WHERE country IS NULL OR country = ''")) {
-            qWarning() << "Błąd aktualizacji pustych wartości country:" << q.lastError().text();
+        while (q.next()) {
+            const auto match = re.match(q.value(0).toString());
+            if (!match.hasMatch()) continue;
+            const int year = match.captured(1).toInt();
+            result[year] = qMax(result.value(year), match.captured(2).toLongLong());
+        }
+        return true;
+    };
+
+    QHash<int, qint64> orders;
+    if (!maxPerYear("SELECT order_number FROM orders WHERE order_number LIKE 'ZAM-%'",
+                    QRegularExpression("^ZAM-(\\d{4})-(\\d+)$"), orders)) return false;
+    // Numery zamówień przeniesionych do archiwum też są wydane (np. po imporcie kopii)
+    if (tables.contains(OrderArchive::ORDERS)
+        && !maxPerYear(QString("SELECT order_number FROM %1 WHERE order_number LIKE 'ZAM-%'").arg(OrderArchive::ORDERS),
+                       QRegularExpression("^ZAM-(\\d{4})-(\\d+)$"), orders)) return false;
+    if (tables.contains("order_sequence")) {
+        // Dotychczasowy licznik (bez podziału na lata) zaczynał od 751
+        QSqlQuery q(connection());
+        if (q.exec("SELECT last_number FROM order_sequence WHERE id=1") && q.next()) {
+            orders[currentYear] = qMax(orders.value(currentYear), qMax<qint64>(q.value(0).toLongLong(), 750));
+        }
+    }
+    QHash<int, qint64> materialsOrders;
+    if (!maxPerYear("SELECT order_number FROM materials_orders WHERE order_number LIKE 'MO-%'",
+                    QRegularExpression("^MO-(\\d{4})-(\\d+)$"), materialsOrders)) return false;
+
+    qint64 lastClient = 0;
+    {
+        QSqlQuery q(connection());
+        q.setForwardOnly(true);
+        if (!q.exec("SELECT client_number FROM clients")) {
+            setLastError(q.lastError());
             return false;
         }
-        
-        // Dla NIP ustawiamy pusty string zamiast NULL, jeśli jest NULL
-        if (!q.exec("UPDATE delivery_addresses SET nip = '' WHERE nip IS NULL")) {
-            qWarning() << "Błąd aktualizacji pustych wartości nip:" << q.lastError().text();
+        while (q.next()) lastClient = qMax(lastClient, q.value(0).toString().toLongLong());
+    }
+    if (tables.contains("used_client_numbers")) {
+        QSqlQuery q(connection());
+        if (q.exec("SELECT MAX(client_number) FROM used_client_numbers") && q.next()) {
+            lastClient = qMax(lastClient, q.value(0).toLongLong());
+        }
+    }
+
+    return executeTransaction([&]() {
+        for (auto it = orders.constBegin(); it != orders.constEnd(); ++it) {
+            if (!NumberingService::advanceTo(connection(), NumberingService::ORDERS, it.key(), it.value(), &error)) {
+                setLastError(error);
+                return false;
+            }
+        }
+        for (auto it = materialsOrders.constBegin(); it != materialsOrders.constEnd(); ++it) {
+            if (!NumberingService::advanceTo(connection(), NumberingService::MATERIALS_ORDERS, it.key(), it.value(), &error)) {
+                setLastError(error);
+                return false;
+            }
+        }
+        if (!NumberingService::advanceTo(connection(), NumberingService::CLIENTS, 0, lastClient, &error)) {
+            setLastError(error);
             return false;
         }
-        
-        qDebug() << "Pomyślnie zaktualizowano dane w tabeli delivery_addresses";
+        qDebug() << "[Migracja] Ciągi numeracji: zamówienia" << orders << "materiały" << materialsOrders << "klienci" << lastClient;
         return true;
     });
 }
 
 int DbManager::getMaxClientNumber() {
-    QSqlQuery q(db);
-    q.exec("SELECT MAX(client_number::integer) FROM clients");
-    if (q.next()) {
-        return q.value(0).toInt();
+    auto q = prepared("SELECT MAX(client_number::integer) FROM clients");
+    q->exec();
+    if (q->next()) {
+        return q->value(0).toInt();
     }
     return 0;
 }
 
 bool DbManager::addClientWithAddresses(const QMap<QString, QVariant>& data, const QList<QMap<QString, QVariant>>& addresses) {
     QMap<QString, QVariant> cleanData = data;
-    cleanData["nip"] = ClientFullDialog::cleanNip(data.value("nip").toString());
-    QSqlQuery q(db);
-    db.transaction();
+    cleanData["nip"] = Client::cleanNip(data.value("nip").toString());
+    connection().transaction();
     qDebug() << "[DEBUG] Dodawanie klienta:" << cleanData;
-    q.prepare("INSERT INTO clients (client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(cleanData.value("client_number"));
-    q.addBindValue(cleanData.value("name"));
-    q.addBindValue(cleanData.value("short_name"));
-    q.addBindValue(cleanData.value("contact_person"));
-    q.addBindValue(cleanData.value("phone"));
-    q.addBindValue(cleanData.value("email"));
-    q.addBindValue(cleanData.value("street"));
-    q.addBindValue(cleanData.value("postal_code"));
-    q.addBindValue(cleanData.value("city"));
-    q.addBindValue(cleanData.value("nip"));
-    if (!q.exec()) {
-        qDebug() << "[DEBUG] Błąd SQL (klient):" << q.lastError().text();
-        m_lastError = q.lastError(); // Ustawienie m_lastError
-        db.rollback();
+    auto q = prepared("INSERT INTO clients (client_number, name, short_name, contact_person, phone, email, street, postal_code, city, nip) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    q->addBindValue(cleanData.value("client_number"));
+    q->addBindValue(cleanData.value("name"));
+    q->addBindValue(cleanData.value("short_name"));
+    q->addBindValue(cleanData.value("contact_person"));
+    q->addBindValue(cleanData.value("phone"));
+    q->addBindValue(cleanData.value("email"));
+    q->addBindValue(cleanData.value("street"));
+    q->addBindValue(cleanData.value("postal_code"));
+    q->addBindValue(cleanData.value("city"));
+    q->addBindValue(cleanData.value("nip"));
+    if (!q->exec()) {
+        qDebug() << "[DEBUG] Błąd SQL (klient):" << q->lastError().text();
+        setLastError(q->lastError()); // Ustawienie m_lastError
+        connection().rollback();
+        return false;
+    }
+    // lastInsertId działa na PostgreSQL i na SQLite (także w kopii lokalnej bez serwera)
+    const int clientId = q->lastInsertId().toInt();
+    if (clientId <= 0) {
+        qWarning() << "Nie otrzymano id nowego klienta - adresy dostawy nie zostaną zapisane";
+        setLastError(QSqlError(QString(), "Nie otrzymano id nowego klienta", QSqlError::StatementError));
+        connection().rollback();
         return false;
     }
-    int clientId = 0;
-    QSqlQuery qid(db);
-    qid.exec("SELECT currval(pg_get_serial_sequence('clients','id'))");
-    if (qid.next()) clientId = qid.value(0).toInt();
     QList<QMap<QString, QVariant>> addressesToAdd = addresses;
     // Dodaj domyślny adres jeśli nie ma żadnego adresu z company == short_name
     bool hasDefault = false;
@@ -770,148 +1925,117 @@ bool DbManager::addClientWithAddresses(const QMap<QString, QVariant>& data, cons
         addressesToAdd.append(defaultAddr);
     }
     for (const auto& addr : addressesToAdd) {
-        QSqlQuery qa(db);
-        qa.prepare("INSERT INTO delivery_addresses (client_id, company, street, postal_code, city, contact_person, phone) VALUES (?, ?, ?, ?, ?, ?, ?)");
-        qa.addBindValue(clientId);
-        qa.addBindValue(addr.value("company"));
-        qa.addBindValue(addr.value("street"));
-        qa.addBindValue(addr.value("postal_code"));
-        qa.addBindValue(addr.value("city"));
-        qa.addBindValue(addr.value("contact_person"));
-        qa.addBindValue(addr.value("phone"));
-        if (!qa.exec()) {
-            qDebug() << "[DEBUG] Błąd SQL (adres dostawy):" << qa.lastError().text();
-            m_lastError = qa.lastError();
-            db.rollback();
+        auto qa = prepared("INSERT INTO delivery_addresses (client_id, company, street, postal_code, city, contact_person, phone) VALUES (?, ?, ?, ?, ?, ?, ?)");
+        qa->addBindValue(clientId);
+        qa->addBindValue(addr.value("company"));
+        qa->addBindValue(addr.value("street"));
+        qa->addBindValue(addr.value("postal_code"));
+        qa->addBindValue(addr.value("city"));
+        qa->addBindValue(addr.value("contact_person"));
+        qa->addBindValue(addr.value("phone"));
+        if (!qa->exec()) {
+            qDebug() << "[DEBUG] Błąd SQL (adres dostawy):" << qa->lastError().text();
+            setLastError(qa->lastError());
+            connection().rollback();
             return false;
         }
     }
-    if (!db.commit()) {
-        qDebug() << "[DEBUG] Błąd przy commitowaniu transakcji po dodaniu klienta:" << db.lastError().text();
-        db.rollback();
+    if (!connection().commit()) {
+        qDebug() << "[DEBUG] Błąd przy commitowaniu transakcji po dodaniu klienta:" << connection().lastError().text();
+        connection().rollback();
         return false;
     }
+    m_entityCache.invalidate(EntityCache::Clients);
     return true;
 }
 
 int DbManager::getNextUniqueClientNumber() {
-    QSqlQuery q(db);
-    int nextNr = 0;
-    qDebug() << "[DEBUG] Szukam największego numeru klienta w used_client_numbers i clients";
-    q.exec("SELECT GREATEST(COALESCE((SELECT MAX(client_number) FROM used_client_numbers),0), COALESCE((SELECT MAX(client_number::integer) FROM clients),0))");
-    if (q.next()) {
-        nextNr = q.value(0).toInt();
-    }
-    qDebug() << "[DEBUG] Największy numer klienta:" << nextNr;
-    // Szukaj kolejnego wolnego numeru, który nie istnieje w clients
-    while (true) {
-        ++nextNr;
-        QString candidate = QString::number(nextNr).rightJustified(6, '0');
-        QSqlQuery check(db);
-        check.prepare("SELECT COUNT(*) FROM clients WHERE client_number=?");
-        check.addBindValue(candidate);
-        check.exec();
-        check.next();
-        int existsInClients = check.value(0).toInt();
-        // Sprawdź, czy numer jest w used_client_numbers, ale tylko jeśli istnieje w clients
-        if (existsInClients == 0) {
-            break;
-        }
+    qint64 nextNr = 0;
+    if (!m_numbering.next(connection(), NumberingService::CLIENTS, 0, 1, nextNr)) {
+        setLastError(m_numbering.lastError());
+        return 0;
     }
     qDebug() << "[DEBUG] Nowy numer klienta do przydzielenia:" << nextNr;
-    return nextNr;
+    return static_cast<int>(nextNr);
 }
 
-void DbManager::markClientNumberUsed(int clientNumber) {
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO used_client_numbers (client_number) VALUES (?) ON CONFLICT DO NOTHING");
-    q.addBindValue(clientNumber);
-    q.exec();
+bool DbManager::markClientNumberUsed(int clientNumber) {
+    // Zapis numeru i przesunięcie ciągu razem - inaczej ciąg mógłby rozjechać się z used_client_numbers
+    return executeTransaction([&]() {
+        auto q = prepared("INSERT INTO used_client_numbers (client_number) VALUES (?) ON CONFLICT DO NOTHING");
+        q->addBindValue(clientNumber);
+        if (!q->exec()) {
+            qWarning() << "Błąd zapisu użytego numeru klienta" << clientNumber << ":" << q->lastError().text();
+            setLastError(q->lastError());
+            return false;
+        }
+        // Numer wpisany ręcznie ponad ciąg - kolejne przydziały zaczną się za nim
+        QSqlError error;
+        if (!NumberingService::advanceTo(connection(), NumberingService::CLIENTS, 0, clientNumber, &error)) {
+            qWarning() << "Błąd przesunięcia ciągu numerów klientów:" << error.text();
+            setLastError(error);
+            return false;
+        }
+        return true;
+    });
 }
 
 bool DbManager::updateClientWithAddresses(int id, const QMap<QString, QVariant>& data, const QList<QMap<QString, QVariant>>& addresses) {
     QMap<QString, QVariant> cleanData = data;
-    cleanData["nip"] = ClientFullDialog::cleanNip(data.value("nip").toString());
-    db.transaction();
-    QSqlQuery q(db);
+    cleanData["nip"] = Client::cleanNip(data.value("nip").toString());
+    connection().transaction();
     qDebug() << "[DEBUG] Aktualizacja klienta id:" << id << cleanData;
-    q.prepare("UPDATE clients SET client_number=?, name=?, short_name=?, contact_person=?, phone=?, email=?, street=?, postal_code=?, city=?, nip=? WHERE id=?");
-    q.addBindValue(cleanData.value("client_number"));
-    q.addBindValue(cleanData.value("name"));
-    q.addBindValue(cleanData.value("short_name"));
-    q.addBindValue(cleanData.value("contact_person"));
-    q.addBindValue(cleanData.value("phone"));
-    q.addBindValue(cleanData.value("email"));
-    q.addBindValue(cleanData.value("street"));
-    q.addBindValue(cleanData.value("postal_code"));
-    q.addBindValue(cleanData.value("city"));
-    q.addBindValue(cleanData.value("nip"));
-    q.addBindValue(id);
-    if (!q.exec()) { qDebug() << "[DEBUG] Błąd SQL (update klient):" << q.lastError().text(); db.rollback(); return false; }
-    // Usuń stare adresy
-    QSqlQuery qdel(db);
-    qDebug() << "[DEBUG] Usuwanie starych adresów klienta id:" << id;
-    qdel.prepare("DELETE FROM delivery_addresses WHERE client_id=?");
-    qdel.addBindValue(id);
-    if (!qdel.exec()) { qDebug() << "[DEBUG] Błąd SQL (delete adresy):" << qdel.lastError().text(); db.rollback(); return false; }
-    // Dodaj nowe adresy (z polem name)
-    for (const auto& addr : addresses) {
-        QSqlQuery qa(db);
-        qDebug() << "[DEBUG] Dodawanie adresu dostawy (edycja):" << addr;
-        qa.prepare("INSERT INTO delivery_addresses (client_id, name, company, street, postal_code, city, contact_person, phone) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
-        qa.addBindValue(id);
-        qa.addBindValue(addr.value("name"));
-        qa.addBindValue(addr.value("company"));
-        qa.addBindValue(addr.value("street"));
-        qa.addBindValue(addr.value("postal_code"));
-        qa.addBindValue(addr.value("city"));
-        qa.addBindValue(addr.value("contact_person"));
-        qa.addBindValue(addr.value("phone"));
-        if (!qa.exec()) { qDebug() << "[DEBUG] Błąd SQL (adres - edycja):" << qa.lastError().text(); db.rollback(); return false; }
-    }
-    db.commit();
+    auto q = prepared("UPDATE clients SET client_number=?, name=?, short_name=?, contact_person=?, phone=?, email=?, street=?, postal_code=?, city=?, nip=? WHERE id=?");
+    q->addBindValue(cleanData.value("client_number"));
+    q->addBindValue(cleanData.value("name"));
+    q->addBindValue(cleanData.value("short_name"));
+    q->addBindValue(cleanData.value("contact_person"));
+    q->addBindValue(cleanData.value("phone"));
+    q->addBindValue(cleanData.value("email"));
+    q->addBindValue(cleanData.value("street"));
+    q->addBindValue(cleanData.value("postal_code"));
+    q->addBindValue(cleanData.value("city"));
+    q->addBindValue(cleanData.value("nip"));
+    q->addBindValue(id);
+    if (!q->exec()) { qDebug() << "[DEBUG] Błąd SQL (update klient):" << q->lastError().text(); connection().rollback(); return false; }
+    // Adresy dopasowane po "id" - zmienione UPDATE, nowe INSERT, usunięte DELETE
+    if (!syncDeliveryAddresses(id, addresses)) { connection().rollback(); return false; }
+    connection().commit();
+    m_entityCache.invalidate(EntityCache::Clients);
     return true;
 }
 
 bool DbManager::updateOrderDeliveryDate(int id, const QDate& newDate) {
-    QSqlQuery q(db);
-    q.prepare("UPDATE orders SET delivery_date=? WHERE id=?");
-    q.addBindValue(newDate);
-    q.addBindValue(id);
-    return q.exec();
+    auto q = prepared("UPDATE orders SET delivery_date=? WHERE id=?");
+    q->addBindValue(newDate);
+    q->addBindValue(id);
+    return q->exec();
+}
+
+bool DbManager::updateOrderStatus(int id, Order::Status status) {
+    auto q = prepared("UPDATE orders SET status=? WHERE id=?");
+    q->addBindValue(static_cast<int>(status));
+    q->addBindValue(id);
+    if (!q->exec()) {
+        qWarning() << "Błąd aktualizacji statusu zamówienia:" << q->lastError().text();
+        setLastError(q->lastError());
+        return false;
+    }
+    return true;
 }
 
 QVector<QMap<QString, QVariant>> DbManager::getDeliveryAddresses(int clientId) {
     QVector<QMap<QString, QVariant>> result;
     
-    if (!db.isOpen()) {
+    if (!connection().isOpen()) {
         qWarning() << "Błąd: Brak połączenia z bazą danych";
         return result;
     }
     
-    // Sprawdź, czy kolumny istnieją w tabeli
-    bool hasCountry = false;
-    bool hasNip = false;
-    
-    if (db.driverName() == "QPSQL") {
-        QSqlQuery checkQuery(db);
-        if (checkQuery.exec("SELECT column_name FROM information_schema.columns WHERE table_name = 'delivery_addresses'")) {
-            while (checkQuery.next()) {
-                QString columnName = checkQuery.value(0).toString();
-                if (columnName == "country") hasCountry = true;
-                if (columnName == "nip") hasNip = true;
-            }
-        } else {
-            qWarning() << "Błąd sprawdzania kolumn w getDeliveryAddresses:" << checkQuery.lastError().text();
-        }
-    } else {
-        // Dla SQLite
-        QSqlRecord record = db.record("delivery_addresses");
-        hasCountry = record.contains("country");
-        hasNip = record.contains("nip");
-    }
+    // Sprawdź, czy kolumny istnieją w tabeli (katalog schematu - bez dodatkowego zapytania)
+    bool hasCountry = checkColumnExistence("delivery_addresses", "country");
+    bool hasNip = checkColumnExistence("delivery_addresses", "nip");
     
-    QSqlQuery query(db);
     QString queryStr = "SELECT id, name, company, street, postal_code, city, contact_person, phone";
     
     // Dodaj tylko istniejące kolumny do zapytania
@@ -926,40 +2050,38 @@ QVector<QMap<QString, QVariant>> DbManager::getDeliveryAddresses(int clientId) {
     
     queryStr += " ORDER BY name, company";
     
-    if (!query.prepare(queryStr)) {
-        qWarning() << "Błąd przygotowania zapytania w getDeliveryAddresses:" << query.lastError().text();
-        return result;
-    }
+    // Błąd prepare() zgłosi exec() poniżej
+    auto query = prepared(queryStr);
     
     if (clientId > 0) {
-        query.addBindValue(clientId);
+        query->addBindValue(clientId);
     }
     
-    if (!query.exec()) {
-        qWarning() << "Błąd wykonania zapytania w getDeliveryAddresses:" << query.lastError().text();
+    if (!query->exec()) {
+        qWarning() << "Błąd wykonania zapytania w getDeliveryAddresses:" << query->lastError().text();
         return result;
     }
     
-    while (query.next()) {
+    while (query->next()) {
         QMap<QString, QVariant> address;
-        address["id"] = query.value("id");
-        address["name"] = query.value("name");
-        address["company"] = query.value("company");
-        address["street"] = query.value("street");
-        address["postal_code"] = query.value("postal_code");
-        address["city"] = query.value("city");
-        address["contact_person"] = query.value("contact_person");
-        address["phone"] = query.value("phone");
+        address["id"] = query->value("id");
+        address["name"] = query->value("name");
+        address["company"] = query->value("company");
+        address["street"] = query->value("street");
+        address["postal_code"] = query->value("postal_code");
+        address["city"] = query->value("city");
+        address["contact_person"] = query->value("contact_person");
+        address["phone"] = query->value("phone");
         
         // Dodaj tylko istniejące kolumny
         if (hasCountry) {
-            address["country"] = query.value("country");
+            address["country"] = query->value("country");
         } else {
             address["country"] = "";
         }
         
         if (hasNip) {
-            address["nip"] = query.value("nip");
+            address["nip"] = query->value("nip");
         } else {
             address["nip"] = "";
         }
@@ -976,39 +2098,38 @@ QVector<QMap<QString, QVariant>> DbManager::getDeliveryAddresses(int clientId) {
 QVector<QMap<QString, QVariant>> DbManager::getOrderItems(int orderId) {
     QVector<QMap<QString, QVariant>> items;
     
-    QSqlQuery query(db);
-    query.prepare("SELECT id, order_id, product_name, quantity, unit, price, vat_rate, notes, "
+    auto query = prepared("SELECT id, order_id, product_name, quantity, unit, price, vat_rate, notes, "
                  "width, height, material, ordered_quantity, quantity_type, roll_length, "
                  "core, price_type, zam_rolki "
                  "FROM order_items WHERE order_id = ? ORDER BY id");
-    query.addBindValue(orderId);
+    query->addBindValue(orderId);
     
-    if (!query.exec()) {
-        qWarning() << "Błąd podczas pobierania pozycji zamówienia:" << query.lastError().text();
+    if (!query->exec()) {
+        qWarning() << "Błąd podczas pobierania pozycji zamówienia:" << query->lastError().text();
         return items;
     }
     
-    while (query.next()) {
+    while (query->next()) {
         QMap<QString, QVariant> item;
-        item["id"] = query.value(0);
-        item["order_id"] = query.value(1);
-        item["product_name"] = query.value(2);
-        item["quantity"] = query.value(3);
-        item["unit"] = query.value(4);
-        item["price"] = query.value(5);
-        item["vat_rate"] = query.value(6);
-        item["notes"] = query.value(7);
+        item["id"] = query->value(0);
+        item["order_id"] = query->value(1);
+        item["product_name"] = query->value(2);
+        item["quantity"] = query->value(3);
+        item["unit"] = query->value(4);
+        item["price"] = query->value(5);
+        item["vat_rate"] = query->value(6);
+        item["notes"] = query->value(7);
         
         // Dodaj szczegółowe pola dla PDF
-        item["width"] = query.value(8);
-        item["height"] = query.value(9);
-        item["material"] = query.value(10);
-        item["ordered_quantity"] = query.value(11);
-        item["quantity_type"] = query.value(12);
-        item["roll_length"] = query.value(13);
-        item["core"] = query.value(14);
-        item["price_type"] = query.value(15);
-        item["zam_rolki"] = query.value(16);
+        item["width"] = query->value(8);
+        item["height"] = query->value(9);
+        item["material"] = query->value(10);
+        item["ordered_quantity"] = query->value(11);
+        item["quantity_type"] = query->value(12);
+        item["roll_length"] = query->value(13);
+        item["core"] = query->value(14);
+        item["price_type"] = query->value(15);
+        item["zam_rolki"] = query->value(16);
         
         // Oblicz wartość netto i brutto
         double quantity = item["quantity"].toDouble();
@@ -1030,39 +2151,37 @@ QVector<QMap<QString, QVariant>> DbManager::getOrderItems(int orderId) {
 
 QMap<QString, QVariant> DbManager::getOrderById(int orderId) {
     QMap<QString, QVariant> result;
-    QSqlQuery q(db);
-    q.prepare("SELECT id, order_number, order_date, delivery_date, client_id, notes, payment_term, "
+    auto q = prepared("SELECT id, order_number, order_date, delivery_date, client_id, notes, payment_term, "
               "delivery_company, delivery_street, delivery_postal_code, delivery_city, "
               "delivery_contact_person, delivery_phone, status FROM orders WHERE id = ?");
-    q.addBindValue(orderId);
-    
-    if (q.exec() && q.next()) {
-        result["id"] = q.value(0);
-        result["order_number"] = q.value(1);
-        result["order_date"] = q.value(2).toDate();
-        result["delivery_date"] = q.value(3).toDate();
-        result["client_id"] = q.value(4);
-        result["notes"] = q.value(5);
-        result["payment_term"] = q.value(6);
-        result["delivery_company"] = q.value(7);
-        result["delivery_street"] = q.value(8);
-        result["delivery_postal_code"] = q.value(9);
-        result["delivery_city"] = q.value(10);
-        result["delivery_contact_person"] = q.value(11);
-        result["delivery_phone"] = q.value(12);
-        result["status"] = q.value(13);
+    q->addBindValue(orderId);
+    
+    if (q->exec() && q->next()) {
+        result["id"] = q->value(0);
+        result["order_number"] = q->value(1);
+        result["order_date"] = q->value(2).toDate();
+        result["delivery_date"] = q->value(3).toDate();
+        result["client_id"] = q->value(4);
+        result["notes"] = q->value(5);
+        result["payment_term"] = q->value(6);
+        result["delivery_company"] = q->value(7);
+        result["delivery_street"] = q->value(8);
+        result["delivery_postal_code"] = q->value(9);
+        result["delivery_city"] = q->value(10);
+        result["delivery_contact_person"] = q->value(11);
+        result["delivery_phone"] = q->value(12);
+        result["status"] = q->value(13);
         
         // Dodaj dane klienta
-        int clientId = q.value(4).toInt();
-        QSqlQuery clientQuery(db);
-        clientQuery.prepare("SELECT name, short_name, email, phone FROM clients WHERE id = ?");
-        clientQuery.addBindValue(clientId);
-        
-        if (clientQuery.exec() && clientQuery.next()) {
-            result["client_name"] = clientQuery.value(0);
-            result["client_short_name"] = clientQuery.value(1);
-            result["client_email"] = clientQuery.value(2);
-            result["client_phone"] = clientQuery.value(3);
+        int clientId = q->value(4).toInt();
+        auto clientQuery = prepared("SELECT name, short_name, email, phone FROM clients WHERE id = ?");
+        clientQuery->addBindValue(clientId);
+        
+        if (clientQuery->exec() && clientQuery->next()) {
+            result["client_name"] = clientQuery->value(0);
+            result["client_short_name"] = clientQuery->value(1);
+            result["client_email"] = clientQuery->value(2);
+            result["client_phone"] = clientQuery->value(3);
         }
         
         // Dodaj pozycje zamówienia
@@ -1078,9 +2197,9 @@ QMap<QString, QVariant> DbManager::getOrderById(int orderId) {
 }
 
 void DbManager::initializeTables() {
-    if (!db.isOpen()) return;
+    if (!connection().isOpen()) return;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
     // Create basic clients table
     QString createClients = R"(
@@ -1143,7 +2262,7 @@ void DbManager::initializeTables() {
         "roll_length", "core", "price_type", "zam_rolki"
     };
 
-    QSqlRecord orderItemsRecord = db.record("order_items");
+    QSqlRecord orderItemsRecord = connection().record("order_items");
     for (const QString& column : requiredColumns) {
         if (!orderItemsRecord.contains(column)) {
             QString alterQuery = QString("ALTER TABLE order_items ADD COLUMN %1 TEXT").arg(column);
@@ -1227,7 +2346,7 @@ void DbManager::initializeTables() {
     }
     
     // Sprawdź i zaktualizuj strukturę tabeli delivery_addresses, jeśli jest już utworzona
-    if (db.tables().contains("delivery_addresses")) {
+    if (connection().tables().contains("delivery_addresses")) {
         // Sprawdź, czy kolumna 'country' istnieje
         bool hasCountry = false;
         bool hasNip = false;
@@ -1236,11 +2355,11 @@ void DbManager::initializeTables() {
         QSqlRecord record;
         
         // Sprawdź typ bazy danych
-        bool isPostgreSQL = db.driverName() == "QPSQL";
+        bool isPostgreSQL = connection().driverName() == "QPSQL";
         
         if (isPostgreSQL) {
             // Dla PostgreSQL używamy zapytania informacyjnego
-            QSqlQuery checkColQuery(db);
+            QSqlQuery checkColQuery(connection());
             
             // Sprawdź czy kolumna 'country' istnieje
             if (checkColQuery.exec("SELECT column_name FROM information_schema.columns WHERE table_name = 'delivery_addresses' AND column_name = 'country'")) {
@@ -1259,7 +2378,7 @@ void DbManager::initializeTables() {
             }
             
             // Dodatkowe debugowanie - wyświetl wszystkie kolumny w tabeli
-            QSqlQuery debugQuery(db);
+            QSqlQuery debugQuery(connection());
             if (debugQuery.exec("SELECT column_name, data_type FROM information_schema.columns WHERE table_name = 'delivery_addresses'")) {
                 qDebug() << "Kolumny w tabeli delivery_addresses:";
                 while (debugQuery.next()) {
@@ -1270,7 +2389,7 @@ void DbManager::initializeTables() {
             }
         } else {
             // Dla SQLite używamy standardowego podejścia
-            record = db.record("delivery_addresses");
+            record = connection().record("delivery_addresses");
             hasCountry = record.contains("country");
             hasNip = record.contains("nip");
             
@@ -1352,6 +2471,7 @@ void DbManager::initializeTables() {
             qDebug() << "Failed to create delivery_addresses table:" << query.lastError().text();
         } else {
             qDebug() << "Created delivery_addresses table with all required columns";
+            refreshSchema();
             
             // Po utworzeniu nowej tabeli, ustaw domyślne wartości dla istniejących rekordów
             if (migrateDeliveryAddresses()) {
@@ -1365,114 +2485,59 @@ void DbManager::initializeTables() {
     qDebug() << "Database tables initialized successfully";
 }
 
-int DbManager::getAvailableConnection() {
-    for (int i = 0; i < POOL_SIZE; i++) {
-        if (connectionAvailable[i]) {
-            connectionAvailable[i] = false;
-            return i;
-        }
+QSqlDatabase DbManager::getPooledConnection() {
+    // Zgodność wsteczna - nowy kod powinien używać leaseConnection()
+    QSqlDatabase connection = m_pool->acquire(POOLED_CONNECTION_TIMEOUT_MS);
+    if (!connection.isValid()) {
+        qWarning() << "[DbManager] Pula połączeń wyczerpana - brak połączenia do wydania";
     }
-    return -1; // Brak dostępnych połączeń
+    return connection;
 }
 
-void DbManager::releaseConnection(int connectionId) {
-    if (connectionId >= 0 && connectionId < POOL_SIZE) {
-        connectionAvailable[connectionId] = true;
+bool DbManager::checkColumnExistence(const QString& tableName, const QString& columnName) const {
+    if (!m_schema.isLoaded()) {
+        qWarning() << "Katalog schematu nie jest wczytany - brak danych o kolumnie" << columnName << "w tabeli" << tableName;
+        return false;
     }
+    return m_schema.hasColumn(tableName, columnName);
 }
 
-QSqlDatabase DbManager::getPooledConnection() {
-    int connId = getAvailableConnection();
-    if (connId >= 0) {
-        return connectionPool[connId];
-    }
-    
-    // Jeśli brak dostępnych połączeń, zwracamy główne połączenie
-    return db;
+const SchemaCatalog& DbManager::schema() const {
+    return m_schema;
 }
 
-bool DbManager::checkColumnExistence(const QString& tableName, const QString& columnName) const {
-    if (!db.isOpen()) {
-        qWarning() << "Błąd: Brak połączenia z bazą danych";
-        return false;
-    }
-    
-    // Metoda 1: Sprawdź przez QSqlRecord
-    QSqlRecord record = db.record(tableName);
-    if (record.contains(columnName)) {
-        qDebug() << "Kolumna" << columnName << "znaleziona w tabeli" << tableName << "poprzez QSqlRecord";
-        return true;
-    }
-    
-    // Metoda 2: Sprawdź przez information_schema (dla PostgreSQL)
-    if (db.driverName() == "QPSQL") {
-        QSqlQuery query(db);
-        QString queryStr = QString(
-            "SELECT EXISTS ("
-            "   SELECT 1 FROM information_schema.columns "
-            "   WHERE table_name = :tableName AND column_name = :columnName"
-            ")"
-        );
-        
-        query.prepare(queryStr);
-        query.bindValue(":tableName", tableName);
-        query.bindValue(":columnName", columnName);
-        
-        if (query.exec() && query.next()) {
-            bool exists = query.value(0).toBool();
-            qDebug() << "Sprawdzenie kolumny" << columnName << "w tabeli" << tableName 
-                     << "przez information_schema:" << (exists ? "istnieje" : "nie istnieje");
-            return exists;
-        } else {
-            qWarning() << "Błąd podczas sprawdzania kolumny" << columnName 
-                      << "w tabeli" << tableName << ":" << query.lastError().text();
-        }
-    }
-    
-    // Metoda 3: Sprawdź przez wykonanie próbnego zapytania (ostateczność)
-    QSqlQuery testQuery(db);
-    QString testQueryStr = QString("SELECT %1 FROM %2 LIMIT 1").arg(columnName, tableName);
-    
-    if (testQuery.exec(testQueryStr)) {
-        qDebug() << "Kolumna" << columnName << "istnieje w tabeli" << tableName 
-                 << "(sprawdzenie przez testowe zapytanie)";
-        return true;
-    } else if (testQuery.lastError().isValid()) {
-        qDebug() << "Kolumna" << columnName << "prawdopodobnie nie istnieje w tabeli" 
-                 << tableName << ":" << testQuery.lastError().text();
+void DbManager::refreshSchema() {
+    if (!m_schema.load(connection())) {
+        qWarning() << "Nie udało się wczytać katalogu schematu bazy danych";
     }
-    
-    qWarning() << "Nie udało się potwierdzić istnienia kolumny" << columnName 
-               << "w tabeli" << tableName;
-    return false;
 }
 
 void DbManager::returnPooledConnection(QSqlDatabase& connection) {
+    if (!connection.isValid()) return;
     QString connectionName = connection.connectionName();
-    if (connectionName.startsWith("pool_conn_")) {
-        int connId = connectionName.mid(10).toInt();
-        releaseConnection(connId);
-    }
+    connection = QSqlDatabase();
+    m_pool->release(connectionName);
 }
 
 bool DbManager::executeTransaction(const std::function<bool()>& operation) {
-    db.transaction();
+    QSqlDatabase conn = connection();
+    conn.transaction();
     
     bool success = false;
     try {
         success = operation();
         
         if (success) {
-            db.commit();
+            conn.commit();
         } else {
-            db.rollback();
+            conn.rollback();
         }
     } catch (const std::exception& e) {
-        db.rollback();
+        conn.rollback();
         qWarning() << "Transaction error:" << e.what();
         success = false;
     } catch (...) {
-        db.rollback();
+        conn.rollback();
         qWarning() << "Unknown transaction error";
         success = false;
     }
@@ -1482,8 +2547,8 @@ bool DbManager::executeTransaction(const std::function<bool()>& operation) {
 
 bool DbManager::clearAllOrders() {
     qDebug() << "=== Rozpoczynanie czyszczenia bazy danych ===";
-    qDebug() << "Typ bazy danych:" << db.driverName();
-    qDebug() << "Nazwa bazy:" << db.databaseName();
+    qDebug() << "Typ bazy danych:" << connection().driverName();
+    qDebug() << "Nazwa bazy:" << connection().databaseName();
     
     // Sprawdź liczbę zamówień przed usunięciem
     int countBefore = getOrdersCount();
@@ -1491,44 +2556,44 @@ bool DbManager::clearAllOrders() {
     
     bool success = executeTransaction([this]() -> bool {
         // Najpierw usuń wszystkie pozycje zamówień
-        QSqlQuery q1(db);
+        QSqlQuery q1(connection());
         qDebug() << "Usuwanie pozycji zamówień...";
         if (!q1.exec("DELETE FROM order_items")) {
             qWarning() << "Błąd usuwania pozycji zamówień:" << q1.lastError().text();
-            m_lastError = q1.lastError(); // Ustawienie m_lastError
+            setLastError(q1.lastError()); // Ustawienie m_lastError
             return false;
         }
         int deletedItems = q1.numRowsAffected();
         qDebug() << "Usunięto" << deletedItems << "pozycji zamówień";
         
         // Następnie usuń wszystkie zamówienia
-        QSqlQuery q2(db);
+        QSqlQuery q2(connection());
         qDebug() << "Usuwanie zamówień...";
         if (!q2.exec("DELETE FROM orders")) {
             qWarning() << "Błąd usuwania zamówień:" << q2.lastError().text();
-            m_lastError = q2.lastError(); // Ustawienie m_lastError
+            setLastError(q2.lastError()); // Ustawienie m_lastError
             return false;
         }
         int deletedOrders = q2.numRowsAffected();
         qDebug() << "Usunięto" << deletedOrders << "zamówień";
         
         // Zresetuj licznik autoincrement dla ID (tylko dla SQLite)
-        if (db.driverName() == "QSQLITE") {
-            QSqlQuery q3(db);
+        if (connection().driverName() == "QSQLITE") {
+            QSqlQuery q3(connection());
             if (!q3.exec("DELETE FROM sqlite_sequence WHERE name='orders'")) {
                 qDebug() << "Informacja: nie można zresetować licznika ID dla zamówień";
             }
             
-            QSqlQuery q4(db);
+            QSqlQuery q4(connection());
             if (!q4.exec("DELETE FROM sqlite_sequence WHERE name='order_items'")) {
                 qDebug() << "Informacja: nie można zresetować licznika ID dla pozycji zamówień";
             }
-        } else if (db.driverName() == "QPSQL") {
+        } else if (connection().driverName() == "QPSQL") {
             // Dla PostgreSQL można zresetować sekwencje
-            QSqlQuery q3(db);
+            QSqlQuery q3(connection());
             q3.exec("ALTER SEQUENCE orders_id_seq RESTART WITH 1");
             
-            QSqlQuery q4(db);
+            QSqlQuery q4(connection());
             q4.exec("ALTER SEQUENCE order_items_id_seq RESTART WITH 1");
         }
         
@@ -1551,233 +2616,339 @@ bool DbManager::clearAllOrders() {
 }
 
 int DbManager::getOrdersCount() {
-    QSqlQuery q(db);
-    if (q.exec("SELECT COUNT(*) FROM orders")) {
-        if (q.next()) {
-            int count = q.value(0).toInt();
+    auto q = prepared("SELECT COUNT(*) FROM orders");
+    if (q->exec()) {
+        if (q->next()) {
+            int count = q->value(0).toInt();
             qDebug() << "Liczba zamówień w bazie danych:" << count;
             return count;
         }
     } else {
-        qWarning() << "Błąd podczas sprawdzania liczby zamówień:" << q.lastError().text();
+        qWarning() << "Błąd podczas sprawdzania liczby zamówień:" << q->lastError().text();
     }
     return -1; // Błąd
 }
 
 QSqlError DbManager::lastError() const {
+    QMutexLocker locker(&m_lastErrorMutex);
     return m_lastError;
 }
 
+void DbManager::setLastError(const QSqlError& error) {
+    QMutexLocker locker(&m_lastErrorMutex);
+    m_lastError = error;
+}
+
 QString DbManager::getClientNameById(int clientId) const {
-    QSqlQuery q(db);
-    q.prepare("SELECT name FROM clients WHERE id = ?");
-    q.addBindValue(clientId);
-    if (q.exec() && q.next()) {
-        return q.value(0).toString();
+    // Z cache, jeśli klienci są już wczytani (metoda const - nie ładuje cache)
+    if (auto clients = m_entityCache.clients()) {
+        if (const Client* client = clients->find(clientId)) return client->name;
+    }
+    auto q = prepared("SELECT name FROM clients WHERE id = ?");
+    q->addBindValue(clientId);
+    if (q->exec() && q->next()) {
+        return q->value(0).toString();
     }
     return QString();
 }
 
 // --- CRUD dla dostawców (suppliers) ---
+QVector<Supplier> DbManager::fetchSuppliers() {
+    auto suppliers = cachedSuppliers();
+    return suppliers ? suppliers->rows : QVector<Supplier>();
+}
+
+std::shared_ptr<const SupplierIndex> DbManager::cachedSuppliers() {
+    if (auto cached = m_entityCache.suppliers()) return cached;
+    const quint64 generation = m_entityCache.generation(EntityCache::Suppliers);
+    QVector<Supplier> rows;
+    if (!loadSuppliers(rows)) return nullptr;
+    auto index = std::make_shared<const SupplierIndex>(std::move(rows));
+    m_entityCache.store(index, generation);
+    return index;
+}
+
+bool DbManager::loadSuppliers(QVector<Supplier>& result) {
+    auto q = prepared("SELECT id, name, street, city, postal_code, country, contact_person, phone, email FROM suppliers ORDER BY name");
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        return false;
+    }
+    while (q->next()) {
+        Supplier s;
+        s.id = q->value(0).toInt();
+        s.name = q->value(1).toString();
+        s.street = q->value(2).toString();
+        s.city = q->value(3).toString();
+        s.postalCode = q->value(4).toString();
+        s.country = q->value(5).toString();
+        s.contactPerson = q->value(6).toString();
+        s.phone = q->value(7).toString();
+        s.email = q->value(8).toString();
+        result.append(std::move(s));
+    }
+    return true;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const Supplier& s) {
+    QMap<QString, QVariant> row;
+    row["id"] = s.id;
+    row["name"] = s.name;
+    row["street"] = s.street;
+    row["city"] = s.city;
+    row["postal_code"] = s.postalCode;
+    row["country"] = s.country;
+    row["contact_person"] = s.contactPerson;
+    row["phone"] = s.phone;
+    row["email"] = s.email;
+    return row;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getSuppliers() {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.exec("SELECT id, name, street, city, postal_code, country, contact_person, phone, email FROM suppliers ORDER BY name");
-    while (q.next()) {
-        QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        row["name"] = q.value(1);
-        row["street"] = q.value(2);
-        row["city"] = q.value(3);
-        row["postal_code"] = q.value(4);
-        row["country"] = q.value(5);
-        row["contact_person"] = q.value(6);
-        row["phone"] = q.value(7);
-        row["email"] = q.value(8);
-        result.append(row);
-    }
+    const QVector<Supplier> suppliers = fetchSuppliers();
+    result.reserve(suppliers.size());
+    for (const auto& s : suppliers) result.append(toVariantMap(s));
     return result;
 }
 
 QMap<QString, QVariant> DbManager::getSupplierById(int supplierId) {
-    QMap<QString, QVariant> row;
-    QSqlQuery q(db);
-    q.prepare("SELECT id, name, street, city, postal_code, country, contact_person, phone, email FROM suppliers WHERE id = ?");
-    q.addBindValue(supplierId);
-    if (q.exec() && q.next()) {
-        row["id"] = q.value(0);
-        row["name"] = q.value(1);
-        row["street"] = q.value(2);
-        row["city"] = q.value(3);
-        row["postal_code"] = q.value(4);
-        row["country"] = q.value(5);
-        row["contact_person"] = q.value(6);
-        row["phone"] = q.value(7);
-        row["email"] = q.value(8);
-    }
-    return row;
+    auto suppliers = cachedSuppliers();
+    const Supplier* supplier = suppliers ? suppliers->find(supplierId) : nullptr;
+    return supplier ? toVariantMap(*supplier) : QMap<QString, QVariant>();
 }
 
 bool DbManager::addSupplier(const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO suppliers (name, street, city, postal_code, country, contact_person, phone, email) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("street"));
-    q.addBindValue(data.value("city"));
-    q.addBindValue(data.value("postal_code"));
-    q.addBindValue(data.value("country"));
-    q.addBindValue(data.value("contact_person"));
-    q.addBindValue(data.value("phone"));
-    q.addBindValue(data.value("email"));
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("INSERT INTO suppliers (name, street, city, postal_code, country, contact_person, phone, email) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("street"));
+    q->addBindValue(data.value("city"));
+    q->addBindValue(data.value("postal_code"));
+    q->addBindValue(data.value("country"));
+    q->addBindValue(data.value("contact_person"));
+    q->addBindValue(data.value("phone"));
+    q->addBindValue(data.value("email"));
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Suppliers);
     return ok;
 }
 
 bool DbManager::updateSupplier(int id, const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("UPDATE suppliers SET name=?, street=?, city=?, postal_code=?, country=?, contact_person=?, phone=?, email=? WHERE id=?");
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("street"));
-    q.addBindValue(data.value("city"));
-    q.addBindValue(data.value("postal_code"));
-    q.addBindValue(data.value("country"));
-    q.addBindValue(data.value("contact_person"));
-    q.addBindValue(data.value("phone"));
-    q.addBindValue(data.value("email"));
-    q.addBindValue(id);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("UPDATE suppliers SET name=?, street=?, city=?, postal_code=?, country=?, contact_person=?, phone=?, email=? WHERE id=?");
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("street"));
+    q->addBindValue(data.value("city"));
+    q->addBindValue(data.value("postal_code"));
+    q->addBindValue(data.value("country"));
+    q->addBindValue(data.value("contact_person"));
+    q->addBindValue(data.value("phone"));
+    q->addBindValue(data.value("email"));
+    q->addBindValue(id);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Suppliers);
     return ok;
 }
 
 bool DbManager::deleteSupplier(int id) {
-    QSqlQuery q(db);
-    q.prepare("DELETE FROM suppliers WHERE id=?");
-    q.addBindValue(id);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("DELETE FROM suppliers WHERE id=?");
+    q->addBindValue(id);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Suppliers);
     return ok;
 }
 
 // --- CRUD dla katalogu materiałów (materials_catalog) ---
+QVector<Material> DbManager::fetchMaterialsCatalog() {
+    auto materials = cachedMaterials();
+    return materials ? materials->rows : QVector<Material>();
+}
+
+std::shared_ptr<const MaterialIndex> DbManager::cachedMaterials() {
+    if (auto cached = m_entityCache.materials()) return cached;
+    const quint64 generation = m_entityCache.generation(EntityCache::Materials);
+    QVector<Material> rows;
+    if (!loadMaterialsCatalog(rows)) return nullptr;
+    auto index = std::make_shared<const MaterialIndex>(std::move(rows));
+    m_entityCache.store(index, generation);
+    return index;
+}
+
+bool DbManager::loadMaterialsCatalog(QVector<Material>& result) {
+    auto q = prepared("SELECT id, name, width, length, unit FROM materials_catalog ORDER BY name");
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        return false;
+    }
+    while (q->next()) {
+        Material m;
+        m.id = q->value(0).toInt();
+        m.name = q->value(1).toString();
+        m.width = q->value(2).toString();
+        m.length = q->value(3).toString();
+        m.unit = q->value(4).toString();
+        result.append(std::move(m));
+    }
+    return true;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const Material& m) {
+    QMap<QString, QVariant> row;
+    row["id"] = m.id;
+    row["name"] = m.name;
+    row["width"] = m.width;
+    row["length"] = m.length;
+    row["unit"] = m.unit;
+    return row;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getMaterialsCatalog() {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.exec("SELECT id, name, width, length, unit FROM materials_catalog ORDER BY name");
-    while (q.next()) {
-        QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        row["name"] = q.value(1);
-        row["width"] = q.value(2);
-        row["length"] = q.value(3);
-        row["unit"] = q.value(4);
-        result.append(row);
-    }
+    const QVector<Material> materials = fetchMaterialsCatalog();
+    result.reserve(materials.size());
+    for (const auto& m : materials) result.append(toVariantMap(m));
     return result;
 }
 
 QMap<QString, QVariant> DbManager::getMaterialById(int materialId) {
-    QMap<QString, QVariant> row;
-    QSqlQuery q(db);
-    q.prepare("SELECT id, name, width, length, unit FROM materials_catalog WHERE id = ?");
-    q.addBindValue(materialId);
-    if (q.exec() && q.next()) {
-        row["id"] = q.value(0);
-        row["name"] = q.value(1);
-        row["width"] = q.value(2);
-        row["length"] = q.value(3);
-        row["unit"] = q.value(4);
-    }
-    return row;
+    auto materials = cachedMaterials();
+    const Material* material = materials ? materials->find(materialId) : nullptr;
+    return material ? toVariantMap(*material) : QMap<QString, QVariant>();
+}
+
+int DbManager::findMaterialIdByName(const QString& name) {
+    auto materials = cachedMaterials();
+    const Material* material = materials ? materials->findByName(name) : nullptr;
+    return material ? material->id : -1;
 }
 
 bool DbManager::addMaterial(const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO materials_catalog (name, width, length, unit) VALUES (?, ?, ?, ?)");
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("width"));
-    q.addBindValue(data.value("length"));
-    q.addBindValue(data.value("unit"));
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("INSERT INTO materials_catalog (name, width, length, unit) VALUES (?, ?, ?, ?)");
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("width"));
+    q->addBindValue(data.value("length"));
+    q->addBindValue(data.value("unit"));
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Materials);
     return ok;
 }
 
 bool DbManager::updateMaterial(int id, const QMap<QString, QVariant>& data) {
-    QSqlQuery q(db);
-    q.prepare("UPDATE materials_catalog SET name=?, width=?, length=?, unit=? WHERE id=?");
-    q.addBindValue(data.value("name"));
-    q.addBindValue(data.value("width"));
-    q.addBindValue(data.value("length"));
-    q.addBindValue(data.value("unit"));
-    q.addBindValue(id);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("UPDATE materials_catalog SET name=?, width=?, length=?, unit=? WHERE id=?");
+    q->addBindValue(data.value("name"));
+    q->addBindValue(data.value("width"));
+    q->addBindValue(data.value("length"));
+    q->addBindValue(data.value("unit"));
+    q->addBindValue(id);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Materials);
     return ok;
 }
 
 bool DbManager::deleteMaterial(int id) {
-    QSqlQuery q(db);
-    q.prepare("DELETE FROM materials_catalog WHERE id=?");
-    q.addBindValue(id);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("DELETE FROM materials_catalog WHERE id=?");
+    q->addBindValue(id);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
+    else m_entityCache.invalidate(EntityCache::Materials);
     return ok;
 }
 
 // --- CRUD dla zamówień materiałów (materials_orders) ---
+QVector<MaterialsOrder> DbManager::fetchMaterialsOrders() {
+    QVector<MaterialsOrder> result;
+    auto q = prepared("SELECT id, order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done FROM materials_orders ORDER BY order_date DESC");
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        return result;
+    }
+    while (q->next()) {
+        MaterialsOrder o;
+        o.id = q->value(0).toInt();
+        o.orderNumber = q->value(1).toString();
+        o.orderDate = q->value(2).toDate();
+        o.deliveryDate = q->value(3).toDate();
+        o.notes = q->value(4).toString();
+        o.supplierId = q->value(5).isNull() ? -1 : q->value(5).toInt();
+        o.deliveryCompany = q->value(6).toString();
+        o.deliveryStreet = q->value(7).toString();
+        o.deliveryPostalCode = q->value(8).toString();
+        o.deliveryCity = q->value(9).toString();
+        o.deliveryCountry = q->value(10).toString();
+        o.done = q->value(11).toInt() != 0;
+        result.append(std::move(o));
+    }
+    return result;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const MaterialsOrder& o) {
+    QMap<QString, QVariant> row;
+    row["id"] = o.id;
+    row["order_number"] = o.orderNumber;
+    row["order_date"] = o.orderDate;
+    row["delivery_date"] = o.deliveryDate;
+    row["notes"] = o.notes;
+    row["supplier_id"] = o.supplierId >= 0 ? QVariant(o.supplierId) : QVariant();
+    row["delivery_company"] = o.deliveryCompany;
+    row["delivery_street"] = o.deliveryStreet;
+    row["delivery_postal_code"] = o.deliveryPostalCode;
+    row["delivery_city"] = o.deliveryCity;
+    row["delivery_country"] = o.deliveryCountry;
+    row["done"] = o.done ? 1 : 0;
+    return row;
+}
+
+QMap<QString, QVariant> DbManager::toVariantMap(const MaterialsOrderItem& it) {
+    QMap<QString, QVariant> row;
+    row["id"] = it.id;
+    row["order_id"] = it.orderId;
+    row["material_id"] = it.materialId >= 0 ? QVariant(it.materialId) : QVariant();
+    row["material_name"] = it.materialName;
+    row["width"] = it.width;
+    row["length"] = it.length;
+    row["quantity"] = it.quantity;
+    row["quantity_value"] = it.quantityValue;
+    return row;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getMaterialsOrders() {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.exec("SELECT id, order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done FROM materials_orders ORDER BY order_date DESC");
-    while (q.next()) {
-        QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        row["order_number"] = q.value(1);
-        row["order_date"] = q.value(2);
-        row["delivery_date"] = q.value(3);
-        row["notes"] = q.value(4);
-        row["supplier_id"] = q.value(5);
-        row["delivery_company"] = q.value(6);
-        row["delivery_street"] = q.value(7);
-        row["delivery_postal_code"] = q.value(8);
-        row["delivery_city"] = q.value(9);
-        row["delivery_country"] = q.value(10);
-        row["done"] = q.value(11);
-        result.append(row);
-    }
+    const QVector<MaterialsOrder> orders = fetchMaterialsOrders();
+    result.reserve(orders.size());
+    for (const auto& o : orders) result.append(toVariantMap(o));
     return result;
 }
 
 bool DbManager::setMaterialsOrderDone(int orderId, bool done) {
-    QSqlQuery q(db);
-    q.prepare("UPDATE materials_orders SET done=? WHERE id=?");
-    q.addBindValue(done ? 1 : 0);
-    q.addBindValue(orderId);
-    bool ok = q.exec();
-    if (!ok) m_lastError = q.lastError();
+    auto q = prepared("UPDATE materials_orders SET done=? WHERE id=?");
+    q->addBindValue(done ? 1 : 0);
+    q->addBindValue(orderId);
+    bool ok = q->exec();
+    if (!ok) setLastError(q->lastError());
     return ok;
 }
 
 QMap<QString, QVariant> DbManager::getMaterialsOrderById(int orderId) {
     QMap<QString, QVariant> row;
-    QSqlQuery q(db);
-    q.prepare("SELECT id, order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done FROM materials_orders WHERE id = ?");
-    q.addBindValue(orderId);
-    if (q.exec() && q.next()) {
-        row["id"] = q.value(0);
-        row["order_number"] = q.value(1);
-        row["order_date"] = q.value(2);
-        row["delivery_date"] = q.value(3);
-        row["notes"] = q.value(4);
-        row["supplier_id"] = q.value(5);
-        row["delivery_company"] = q.value(6);
-        row["delivery_street"] = q.value(7);
-        row["delivery_postal_code"] = q.value(8);
-        row["delivery_city"] = q.value(9);
-        row["delivery_country"] = q.value(10);
-        row["done"] = q.value(11);
+    auto q = prepared("SELECT id, order_number, order_date, delivery_date, notes, supplier_id, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_country, done FROM materials_orders WHERE id = ?");
+    q->addBindValue(orderId);
+    if (q->exec() && q->next()) {
+        row["id"] = q->value(0);
+        row["order_number"] = q->value(1);
+        row["order_date"] = q->value(2);
+        row["delivery_date"] = q->value(3);
+        row["notes"] = q->value(4);
+        row["supplier_id"] = q->value(5);
+        row["delivery_company"] = q->value(6);
+        row["delivery_street"] = q->value(7);
+        row["delivery_postal_code"] = q->value(8);
+        row["delivery_city"] = q->value(9);
+        row["delivery_country"] = q->value(10);
+        row["done"] = q->value(11);
     }
     return row;
 }
@@ -1785,148 +2956,145 @@ QMap<QString, QVariant> DbManager::getMaterialsOrderById(int orderId) {
 // --- PODPOWIEDZI (QCompleter) dla materiałów ---
 QVector<QVariant> DbManager::getUniqueMaterialWidths() {
     QVector<QVariant> result;
-    QSqlQuery q(db);
-    q.exec("SELECT DISTINCT width FROM materials_catalog WHERE width IS NOT NULL ORDER BY width");
-    while (q.next()) {
-        result.append(q.value(0));
+    auto q = prepared("SELECT DISTINCT width FROM materials_catalog WHERE width IS NOT NULL ORDER BY width");
+    q->exec();
+    while (q->next()) {
+        result.append(q->value(0));
     }
     return result;
 }
 
 QVector<QVariant> DbManager::getUniqueMaterialLengths() {
     QVector<QVariant> result;
-    QSqlQuery q(db);
-    q.exec("SELECT DISTINCT length FROM materials_catalog WHERE length IS NOT NULL ORDER BY length");
-    while (q.next()) {
-        result.append(q.value(0));
+    auto q = prepared("SELECT DISTINCT length FROM materials_catalog WHERE length IS NOT NULL ORDER BY length");
+    q->exec();
+    while (q->next()) {
+        result.append(q->value(0));
     }
     return result;
 }
 
 QVector<QVariant> DbManager::getUniqueMaterialRolls() {
     QVector<QVariant> result;
-    QSqlQuery q(db);
-    q.exec("SELECT DISTINCT quantity FROM materials_order_items WHERE quantity IS NOT NULL ORDER BY quantity");
-    while (q.next()) {
-        result.append(q.value(0));
+    auto q = prepared("SELECT DISTINCT quantity FROM materials_order_items WHERE quantity IS NOT NULL ORDER BY quantity");
+    q->exec();
+    while (q->next()) {
+        result.append(q->value(0));
     }
     return result;
 }
 
 // --- Automatyczne ładowanie pozycji zamówienia materiałów ---
+QVector<MaterialsOrderItem> DbManager::fetchMaterialsOrderItems(int orderId) {
+    QVector<MaterialsOrderItem> result;
+    auto q = prepared("SELECT id, order_id, material_id, material_name, width, length, quantity, quantity_value "
+                      "FROM materials_order_items WHERE order_id=?");
+    q->addBindValue(orderId);
+    if (!q->exec()) {
+        qWarning() << "Błąd podczas pobierania pozycji zamówienia materiałów:" << q->lastError().text();
+        setLastError(q->lastError());
+        return result;
+    }
+    while (q->next()) {
+        MaterialsOrderItem item;
+        item.id = q->value(0).toInt();
+        item.orderId = q->value(1).toInt();
+        item.materialId = q->value(2).isNull() ? -1 : q->value(2).toInt();
+        item.materialName = q->value(3).toString();
+        item.width = q->value(4).toString();
+        item.length = q->value(5).toString();
+        item.quantity = q->value(6).toString();
+        item.quantityValue = q->value(7).toDouble();
+        result.append(std::move(item));
+    }
+    return result;
+}
+
 QVector<QMap<QString, QVariant>> DbManager::getMaterialsOrderItemsForOrder(int orderId) {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    q.prepare("SELECT id, order_id, material_id, material_name, width, length, quantity FROM materials_order_items WHERE order_id=?");
-    q.addBindValue(orderId);
-    if (q.exec()) {
-        while (q.next()) {
-            QMap<QString, QVariant> row;
-            row["id"] = q.value(0);
-            row["order_id"] = q.value(1);
-            row["material_id"] = q.value(2);
-            row["material_name"] = q.value(3);
-            row["width"] = q.value(4);
-            row["length"] = q.value(5);
-            row["quantity"] = q.value(6);
-            result.append(row);
-        }
-    }
+    const QVector<MaterialsOrderItem> items = fetchMaterialsOrderItems(orderId);
+    result.reserve(items.size());
+    for (const auto& item : items) result.append(toVariantMap(item));
     return result;
 }
 
-// --- Numeracja zamówień materiałów ---
+// --- Numeracja zamówień ---
+QString DbManager::getNextOrderNumber(const QDate& date) {
+    const int year = date.isValid() ? date.year() : QDate::currentDate().year();
+    qint64 n = 0;
+    if (!m_numbering.next(connection(), NumberingService::ORDERS, year, 1, n)) {
+        setLastError(m_numbering.lastError());
+        return QString();
+    }
+    return QString("ZAM-%1-%2").arg(year).arg(n, 3, 10, QChar('0'));
+}
+
 QString DbManager::getNextMaterialsOrderNumber() {
     // Format: MO-YYYY-NNNN
-    int year = QDate::currentDate().year();
-    QString prefix = QString("MO-%1-").arg(year);
-    QSqlQuery q(db);
-    // Szukamy największego numeru z bieżącego roku
-    q.prepare("SELECT order_number FROM materials_orders WHERE order_number LIKE ? ORDER BY order_number DESC LIMIT 1");
-    q.addBindValue(prefix + "%");
-    if (q.exec() && q.next()) {
-        QString lastNumber = q.value(0).toString();
-        QRegularExpression re(QString("MO-%1-(\\d{4})").arg(year));
-        auto match = re.match(lastNumber);
-        if (match.hasMatch()) {
-            int n = match.captured(1).toInt();
-            return prefix + QString::number(n + 1).rightJustified(4, '0');
-        }
+    const int year = QDate::currentDate().year();
+    qint64 n = 0;
+    if (!m_numbering.next(connection(), NumberingService::MATERIALS_ORDERS, year, 1, n)) {
+        setLastError(m_numbering.lastError());
+        return QString();
     }
-    // Jeśli nie znaleziono żadnego numeru z tego roku, zaczynamy od 0001
-    return prefix + "0001";
+    return QString("MO-%1-%2").arg(year).arg(n, 4, 10, QChar('0'));
 }
 
 bool DbManager::deleteMaterialsOrder(int id) {
-    QSqlDatabase::database().transaction();
-    QSqlQuery q1(db);
-    q1.prepare("DELETE FROM materials_order_items WHERE order_id=?");
-    q1.addBindValue(id);
-    if (!q1.exec()) {
-        m_lastError = q1.lastError();
-        QSqlDatabase::database().rollback();
+    connection().transaction();
+    auto q1 = prepared("DELETE FROM materials_order_items WHERE order_id=?");
+    q1->addBindValue(id);
+    if (!q1->exec()) {
+        setLastError(q1->lastError());
+        connection().rollback();
         return false;
     }
-    QSqlQuery q2(db);
-    q2.prepare("DELETE FROM materials_orders WHERE id=?");
-    q2.addBindValue(id);
-    if (!q2.exec()) {
-        m_lastError = q2.lastError();
-        QSqlDatabase::database().rollback();
+    auto q2 = prepared("DELETE FROM materials_orders WHERE id=?");
+    q2->addBindValue(id);
+    if (!q2->exec()) {
+        setLastError(q2->lastError());
+        connection().rollback();
         return false;
     }
-    QSqlDatabase::database().commit();
+    connection().commit();
     return true;
 }
 
 bool DbManager::updateMaterialsOrder(int id, const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items) {
-    QSqlDatabase::database().transaction();
-    QSqlQuery q(db);
+    connection().transaction();
     // Aktualizuj zamówienie w materials_orders
-    q.prepare("UPDATE materials_orders SET order_number=?, order_date=?, delivery_date=?, notes=?, supplier_id=?, delivery_company=?, delivery_street=?, delivery_postal_code=?, delivery_city=?, delivery_country=?, done=? WHERE id=?");
-    q.addBindValue(orderData.value("order_number"));
-    q.addBindValue(orderData.value("order_date"));
-    q.addBindValue(orderData.value("delivery_date"));
-    q.addBindValue(orderData.value("notes"));
-    q.addBindValue(orderData.value("supplier_id"));
-    q.addBindValue(orderData.value("delivery_company"));
-    q.addBindValue(orderData.value("delivery_street"));
-    q.addBindValue(orderData.value("delivery_postal_code"));
-    q.addBindValue(orderData.value("delivery_city"));
-    q.addBindValue(orderData.value("delivery_country"));
-    q.addBindValue(orderData.contains("done") ? orderData.value("done").toInt() : 0);
-    q.addBindValue(id);
-    if (!q.exec()) {
-        m_lastError = q.lastError();
-        QSqlDatabase::database().rollback();
+    auto q = prepared("UPDATE materials_orders SET order_number=?, order_date=?, delivery_date=?, notes=?, supplier_id=?, delivery_company=?, delivery_street=?, delivery_postal_code=?, delivery_city=?, delivery_country=?, done=? WHERE id=?");
+    q->addBindValue(orderData.value("order_number"));
+    q->addBindValue(orderData.value("order_date"));
+    q->addBindValue(orderData.value("delivery_date"));
+    q->addBindValue(orderData.value("notes"));
+    q->addBindValue(orderData.value("supplier_id"));
+    q->addBindValue(orderData.value("delivery_company"));
+    q->addBindValue(orderData.value("delivery_street"));
+    q->addBindValue(orderData.value("delivery_postal_code"));
+    q->addBindValue(orderData.value("delivery_city"));
+    q->addBindValue(orderData.value("delivery_country"));
+    q->addBindValue(orderData.contains("done") ? orderData.value("done").toInt() : 0);
+    q->addBindValue(id);
+    if (!q->exec()) {
+        setLastError(q->lastError());
+        connection().rollback();
         return false;
     }
     // Usuń stare pozycje zamówienia
-    QSqlQuery qdel(db);
-    qdel.prepare("DELETE FROM materials_order_items WHERE order_id=?");
-    qdel.addBindValue(id);
-    if (!qdel.exec()) {
-        m_lastError = qdel.lastError();
-        QSqlDatabase::database().rollback();
+    auto qdel = prepared("DELETE FROM materials_order_items WHERE order_id=?");
+    qdel->addBindValue(id);
+    if (!qdel->exec()) {
+        setLastError(qdel->lastError());
+        connection().rollback();
         return false;
     }
     // Dodaj nowe pozycje
-    QSqlQuery q2(db);
-    for (const auto& item : items) {
-        q2.prepare("INSERT INTO materials_order_items (order_id, material_id, material_name, width, length, quantity) VALUES (?, ?, ?, ?, ?, ?)");
-        q2.addBindValue(id);
-        q2.addBindValue(item.value("material_id"));
-        q2.addBindValue(item.value("material_name"));
-        q2.addBindValue(item.value("width"));
-        q2.addBindValue(item.value("length"));
-        q2.addBindValue(item.value("quantity"));
-        if (!q2.exec()) {
-            m_lastError = q2.lastError();
-            QSqlDatabase::database().rollback();
-            return false;
-        }
+    if (!insertMaterialsOrderItems(id, items)) {
+        connection().rollback();
+        return false;
     }
-    QSqlDatabase::database().commit();
+    connection().commit();
     emit orderAdded();
     return true;
 }
@@ -1934,54 +3102,367 @@ bool DbManager::updateMaterialsOrder(int id, const QMap<QString, QVariant>& orde
 // --- Wydajne pobieranie zamówień materiałów z nazwą dostawcy i materiałami (JOIN) ---
 QVector<QMap<QString, QVariant>> DbManager::getMaterialsOrdersWithDetails() {
     QVector<QMap<QString, QVariant>> result;
-    QSqlQuery q(db);
-    if (!q.exec(R"(
+    auto q = prepared(R"(
         SELECT mo.id, mo.order_number, mo.order_date, mo.delivery_date, mo.notes, mo.supplier_id,
                mo.delivery_company, mo.delivery_street, mo.delivery_postal_code, mo.delivery_city, mo.delivery_country, mo.done,
                s.name AS supplier_name
         FROM materials_orders mo
         LEFT JOIN suppliers s ON mo.supplier_id = s.id
         ORDER BY mo.order_date DESC
-    )")) {
-        qDebug() << "Błąd SQL (zamówienia z JOIN):" << q.lastError().text();
+    )");
+    if (!q->exec()) {
+        qDebug() << "Błąd SQL (zamówienia z JOIN):" << q->lastError().text();
         return result;
     }
     QMap<int, QStringList> orderIdToMaterials;
-    QSqlQuery q2(db);
-    if (!q2.exec(R"(
+    auto q2 = prepared(R"(
         SELECT order_id, material_name, width, length, quantity
         FROM materials_order_items
-    )")) {
-        qDebug() << "Błąd SQL (pozycje materiałowe):" << q2.lastError().text();
-    }
-    while (q2.next()) {
-        int orderId = q2.value(0).toInt();
-        QString mat = q2.value(1).toString();
-        QString width = q2.value(2).toString();
-        QString length = q2.value(3).toString();
-        QString qty = q2.value(4).toString();
+    )");
+    if (!q2->exec()) {
+        qDebug() << "Błąd SQL (pozycje materiałowe):" << q2->lastError().text();
+    }
+    while (q2->next()) {
+        int orderId = q2->value(0).toInt();
+        QString mat = q2->value(1).toString();
+        QString width = q2->value(2).toString();
+        QString length = q2->value(3).toString();
+        QString qty = q2->value(4).toString();
         if (!mat.isEmpty())
             orderIdToMaterials[orderId] << QString("%1 %2x%3 %4").arg(mat, width, length, qty);
     }
-    while (q.next()) {
+    while (q->next()) {
         QMap<QString, QVariant> row;
-        row["id"] = q.value(0);
-        row["order_number"] = q.value(1);
-        row["order_date"] = q.value(2);
-        row["delivery_date"] = q.value(3);
-        row["notes"] = q.value(4);
-        row["supplier_id"] = q.value(5);
-        row["delivery_company"] = q.value(6);
-        row["delivery_street"] = q.value(7);
-        row["delivery_postal_code"] = q.value(8);
-        row["delivery_city"] = q.value(9);
-        row["delivery_country"] = q.value(10);
-        row["done"] = q.value(11);
-        row["supplier_name"] = q.value(12);
+        row["id"] = q->value(0);
+        row["order_number"] = q->value(1);
+        row["order_date"] = q->value(2);
+        row["delivery_date"] = q->value(3);
+        row["notes"] = q->value(4);
+        row["supplier_id"] = q->value(5);
+        row["delivery_company"] = q->value(6);
+        row["delivery_street"] = q->value(7);
+        row["delivery_postal_code"] = q->value(8);
+        row["delivery_city"] = q->value(9);
+        row["delivery_country"] = q->value(10);
+        row["done"] = q->value(11);
+        row["supplier_name"] = q->value(12);
         // Agregacja materiałów jako string
-        int orderId = q.value(0).toInt();
+        int orderId = q->value(0).toInt();
         row["materials_summary"] = orderIdToMaterials.value(orderId).join(", ");
         result.append(row);
     }
     return result;
 }
+
+// --- Podsumowanie produkcji ---
+QString DbManager::productionWeekStartSql(const QString& dateColumn) const {
+    // Poniedziałek tygodnia ISO; w SQLite: 6 dni wstecz, potem najbliższy poniedziałek
+    return connection().driverName() == "QPSQL"
+        ? QString("CAST(date_trunc('week', %1) AS DATE)").arg(dateColumn)
+        : QString("date(%1, '-6 days', 'weekday 1')").arg(dateColumn);
+}
+
+QString DbManager::productionGroupsSql(const QString& where, bool perWeek) const {
+    const bool postgres = connection().driverName() == "QPSQL";
+    const QString lowerType = "LOWER(REPLACE(COALESCE(%1, ''), 'Ś', 'ś'))";
+
+    // Podzapytanie normalizuje każdą pozycję: liczby z kolumn *_value, jednostka ilości
+    // (k - tysiące, r - rolki, p - sztuki) i rodzaj ceny (1 - za rolkę,
+    // 2 - za tysiąc, 3 - za sztukę, 0 - nieznany). Zewnętrzne zapytanie
+    // przelicza ilości na tysiące, wartości na PLN i grupuje.
+    // Składane bez arg() - "%10" we wzorcu '%1000%' byłby znacznikiem argumentu
+    const QString priceType = lowerType.arg("oi.price_type");
+    const QString priceKind = "CASE WHEN " + priceType + " LIKE '%rolk%' THEN 1 "
+                              "WHEN " + priceType + " LIKE '%tys%' OR " + priceType + " LIKE '%tyś%' OR "
+                              + priceType + " LIKE '%1000%' THEN 2 "
+                              "WHEN " + priceType + " LIKE '%szt%' THEN 3 ELSE 0 END";
+
+    const QString normalized = QString(
+        "SELECT o.order_number, %1 AS week_start, o.status, "
+        "COALESCE(oi.material, '') AS material, COALESCE(oi.width, '') AS width, "
+        "COALESCE(oi.height, '') AS height, COALESCE(oi.core, '') AS core, "
+        "CASE WHEN oi.ordered_quantity_value > 0 THEN oi.ordered_quantity_value END AS qty, "
+        "CASE WHEN oi.price_value > 0 THEN oi.price_value END AS price, "
+        "COALESCE(oi.roll_length_value, 0) AS roll_length, "
+        "CASE WHEN %2 LIKE '%tys%' OR %2 LIKE '%tyś%' THEN 'k' "
+        "     WHEN %2 LIKE '%rol%' THEN 'r' ELSE 'p' END AS unit, "
+        "%3 AS price_kind "
+        "FROM order_items oi JOIN orders o ON oi.order_id = o.id "
+        "WHERE %4 AND TRIM(COALESCE(oi.material, '')) <> '' AND TRIM(COALESCE(oi.width, '')) <> ''")
+        .arg(productionWeekStartSql("o.delivery_date"),
+             lowerType.arg("oi.quantity_type"),
+             priceKind,
+             where);
+
+    const QString keys = perWeek ? "n.week_start, n.status, n.material, n.width, n.height, n.core"
+                                 : "n.material, n.width, n.height, n.core";
+    const QString priced = "n.qty IS NOT NULL AND n.price IS NOT NULL AND n.price_kind > 0";
+    const QString pricedOrder = QString("CASE WHEN %1 THEN n.order_number END").arg(priced);
+    return QString(
+        "SELECT %1, "
+        "SUM(CASE WHEN n.qty IS NULL THEN 0 "
+        "         WHEN n.unit = 'k' THEN n.qty "
+        "         WHEN n.unit = 'r' THEN CASE WHEN n.roll_length > 0 THEN n.qty * n.roll_length / 1000.0 ELSE 0 END "
+        "         ELSE n.qty / 1000.0 END), "
+        "SUM(CASE WHEN n.qty IS NOT NULL AND n.unit = 'r' AND n.roll_length > 0 THEN %2 ELSE 0 END), "
+        "SUM(CASE WHEN NOT (%3) THEN 0 "
+        "         WHEN n.price_kind IN (1, 3) THEN n.qty * n.price "
+        "         WHEN n.unit = 'k' THEN n.qty * n.price "
+        "         WHEN n.unit = 'r' THEN n.qty * n.roll_length / 1000.0 * n.price "
+        "         ELSE n.qty / 1000.0 * n.price END), "
+        "COUNT(DISTINCT %4), "
+        "%5 "
+        "FROM (%6) n "
+        "GROUP BY %1 "
+        "ORDER BY %1")
+        .arg(keys,
+             postgres ? "CAST(TRUNC(n.qty) AS INTEGER)" : "CAST(n.qty AS INTEGER)",
+             priced,
+             pricedOrder,
+             postgres ? QString("STRING_AGG(DISTINCT %1, ',')").arg(pricedOrder)
+                      : QString("GROUP_CONCAT(DISTINCT %1)").arg(pricedOrder),
+             normalized);
+}
+
+QList<ProductionGroup> DbManager::readProductionGroups(QSqlQuery& q) {
+    QList<ProductionGroup> result;
+    while (q.next()) {
+        ProductionGroup group;
+        group.material = q.value(0).toString();
+        group.width = q.value(1).toString();
+        group.height = q.value(2).toString();
+        group.dimensions = QString("%1 x %2").arg(group.width, group.height);
+        group.core = q.value(3).toString();
+        group.quantity = q.value(4).toDouble();
+        group.rollCount = q.value(5).toInt();
+        group.totalPrice = q.value(6).toDouble();
+        group.orderCount = q.value(7).toInt();
+        const QString orderNumbers = q.value(8).toString();
+        if (!orderNumbers.isEmpty()) group.orderNumbers = orderNumbers.split(',');
+        result.append(group);
+    }
+    return result;
+}
+
+QList<ProductionGroup> DbManager::getProductionGroups(const QDate& from, const QDate& to,
+                                                      const QVector<Order::Status>& statuses) {
+    if (statuses.isEmpty()) return {};
+    QStringList conditions;
+    QVariantList bindValues;
+    conditions << QString("o.status IN (%1)").arg(QStringList(statuses.size(), "?").join(", "));
+    for (Order::Status status : statuses) bindValues << static_cast<int>(status);
+    if (from.isValid() && to.isValid()) {
+        conditions << "o.delivery_date BETWEEN ? AND ?";
+        bindValues << from << to;
+    }
+
+    auto q = prepared(productionGroupsSql(conditions.join(" AND "), false));
+    for (const QVariant& value : bindValues) q->addBindValue(value);
+    if (!q->exec()) {
+        qWarning() << "Błąd pobierania danych produkcji:" << q->lastError().text();
+        setLastError(q->lastError());
+        return {};
+    }
+    return readProductionGroups(*q);
+}
+
+bool DbManager::installProductionRollup() {
+    QSqlQuery q(connection());
+    if (!q.exec("CREATE TABLE IF NOT EXISTS production_rollup ("
+                "week_start DATE NOT NULL, "
+                "status INTEGER NOT NULL, "
+                "material TEXT NOT NULL, "
+                "width TEXT NOT NULL, "
+                "height TEXT NOT NULL, "
+                "core TEXT NOT NULL, "
+                "quantity DOUBLE PRECISION NOT NULL DEFAULT 0, "
+                "roll_count INTEGER NOT NULL DEFAULT 0, "
+                "value DOUBLE PRECISION NOT NULL DEFAULT 0, "
+                "order_count INTEGER NOT NULL DEFAULT 0, "
+                "order_numbers TEXT, "
+                "PRIMARY KEY (week_start, status, material, width, height, core))")
+        || !q.exec("CREATE TABLE IF NOT EXISTS production_rollup_dirty (week_start DATE PRIMARY KEY)")) {
+        qWarning() << "Nie można utworzyć tabel zestawienia produkcji:" << q.lastError().text();
+        setLastError(q.lastError());
+        return false;
+    }
+    const bool postgres = connection().driverName() == "QPSQL";
+    // Chwila ostatniego zaznaczenia tygodnia - przeliczenie usuwa tylko tę wersję znacznika,
+    // którą przeczytało, więc zmiana zatwierdzona w trakcie przeliczenia nie ginie
+    const QString now = postgres ? "clock_timestamp()" : "strftime('%Y-%m-%d %H:%M:%f', 'now')";
+    if (!connection().record("production_rollup_dirty").contains("marked_at")
+        && (!q.exec(QString("ALTER TABLE production_rollup_dirty ADD COLUMN marked_at %1")
+                        .arg(postgres ? "TIMESTAMPTZ" : "TEXT"))
+            || !q.exec(QString("UPDATE production_rollup_dirty SET marked_at = %1").arg(now)))) {
+        qWarning() << "Nie można dodać kolumny marked_at do production_rollup_dirty:" << q.lastError().text();
+        setLastError(q.lastError());
+        return false;
+    }
+
+    // Triggery zaznaczają tylko tygodnie do przeliczenia - samo przeliczenie robi
+    // refreshProductionRollup() przy odczycie, jedno zapytanie na tydzień
+    const QString stamp = " ON CONFLICT (week_start) DO UPDATE SET marked_at = excluded.marked_at; ";
+    if (postgres) {
+        const QString week = "CAST(date_trunc('week', %1) AS DATE)";
+        const QString markOrder = "INSERT INTO production_rollup_dirty (week_start, marked_at) VALUES (" + week + ", "
+                                  + now + ")" + stamp;
+        const QString markItem = "INSERT INTO production_rollup_dirty (week_start, marked_at) SELECT "
+                                 + week.arg("o.delivery_date") + ", " + now
+                                 + " FROM orders o WHERE o.id = %1 AND o.delivery_date IS NOT NULL" + stamp;
+        const QString function = QString(
+            "CREATE OR REPLACE FUNCTION etykiety_rollup_dirty() RETURNS trigger AS $$ "
+            "BEGIN "
+            "    IF TG_TABLE_NAME = 'orders' THEN "
+            "        IF TG_OP <> 'INSERT' AND OLD.delivery_date IS NOT NULL THEN %1END IF; "
+            "        IF TG_OP <> 'DELETE' AND NEW.delivery_date IS NOT NULL THEN %2END IF; "
+            "    ELSE "
+            "        IF TG_OP <> 'INSERT' THEN %3END IF; "
+            "        IF TG_OP <> 'DELETE' THEN %4END IF; "
+            "    END IF; "
+            "    RETURN NULL; "
+            "END; "
+            "$$ LANGUAGE plpgsql")
+            .arg(markOrder.arg("OLD.delivery_date"), markOrder.arg("NEW.delivery_date"),
+                 markItem.arg("OLD.order_id"), markItem.arg("NEW.order_id"));
+        if (!q.exec(function)) {
+            qWarning() << "Nie można utworzyć funkcji etykiety_rollup_dirty:" << q.lastError().text();
+            setLastError(q.lastError());
+            return false;
+        }
+        for (const QString table : {"orders", "order_items"}) {
+            const QString trigger = QString("etykiety_rollup_%1").arg(table);
+            q.prepare("SELECT 1 FROM pg_trigger WHERE tgname = ?");
+            q.addBindValue(trigger);
+            if (q.exec() && q.next()) continue;
+            if (!q.exec(QString("CREATE TRIGGER %1 AFTER INSERT OR UPDATE OR DELETE ON %2 "
+                                "FOR EACH ROW EXECUTE FUNCTION etykiety_rollup_dirty()").arg(trigger, table))) {
+                qWarning() << "Nie można utworzyć triggera" << trigger << ":" << q.lastError().text();
+                setLastError(q.lastError());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const QString markOrder = "INSERT INTO production_rollup_dirty (week_start, marked_at) SELECT "
+                              + productionWeekStartSql("%1.delivery_date") + ", " + now
+                              + " WHERE %1.delivery_date IS NOT NULL" + stamp;
+    const QString markItem = "INSERT INTO production_rollup_dirty (week_start, marked_at) SELECT "
+                             + productionWeekStartSql("o.delivery_date") + ", " + now
+                             + " FROM orders o WHERE o.id = %1.order_id AND o.delivery_date IS NOT NULL" + stamp;
+    const QList<QPair<QString, QString>> operations = {{"INSERT", "NEW"}, {"UPDATE", "OLD NEW"}, {"DELETE", "OLD"}};
+    for (const QString table : {"orders", "order_items"}) {
+        const QString& mark = table == QLatin1String("orders") ? markOrder : markItem;
+        for (const auto& operation : operations) {
+            QString body;
+            for (const QString& row : operation.second.split(' ')) body += mark.arg(row);
+            // Odtwarzany przy każdym starcie - wcześniejsze wersje nie stemplowały marked_at
+            const QString name = QString("production_rollup_%1_%2").arg(table, operation.first.toLower());
+            const QString sql = QString("CREATE TRIGGER %1 AFTER %2 ON %3 BEGIN %4END")
+                                    .arg(name, operation.first, table, body);
+            if (!q.exec("DROP TRIGGER IF EXISTS " + name) || !q.exec(sql)) {
+                qWarning() << "Nie można utworzyć triggera zestawienia dla" << table << ":" << q.lastError().text();
+                setLastError(q.lastError());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DbManager::refreshProductionRollup() {
+    QVector<QDate> weeks;
+    {
+        auto q = prepared("SELECT week_start FROM production_rollup_dirty ORDER BY week_start");
+        if (!q->exec()) {
+            qWarning() << "Błąd odczytu production_rollup_dirty:" << q->lastError().text();
+            setLastError(q->lastError());
+            return false;
+        }
+        while (q->next()) weeks.append(q->value(0).toDate());
+    }
+    const bool postgres = connection().driverName() == "QPSQL";
+    // PostgreSQL: tydzień przelicza jedno stanowisko naraz; znacznik zablokowany przez
+    // inne stanowisko albo niezatwierdzony zapis jest pomijany - wróci przy kolejnym odczycie
+    const QString claimSql = postgres
+        ? "SELECT CAST(marked_at AS TEXT) FROM production_rollup_dirty WHERE week_start = ? FOR UPDATE SKIP LOCKED"
+        : "SELECT marked_at FROM production_rollup_dirty WHERE week_start = ?";
+    const QString cleanSql = postgres
+        ? "DELETE FROM production_rollup_dirty WHERE week_start = ? AND marked_at = CAST(? AS TIMESTAMPTZ)"
+        : "DELETE FROM production_rollup_dirty WHERE week_start = ? AND marked_at = ?";
+    const QString insertSql = "INSERT INTO production_rollup (week_start, status, material, width, height, core, "
+                              "quantity, roll_count, value, order_count, order_numbers) "
+                              + productionGroupsSql("o.delivery_date BETWEEN ? AND ?", true);
+    for (const QDate& week : weeks) {
+        bool ok = executeTransaction([&]() {
+            auto qclaim = prepared(claimSql);
+            qclaim->addBindValue(week);
+            if (!qclaim->exec()) {
+                qWarning() << "Błąd odczytu znacznika zestawienia za tydzień" << week << ":" << qclaim->lastError().text();
+                setLastError(qclaim->lastError());
+                return false;
+            }
+            if (!qclaim->next()) return true;
+            const QVariant markedAt = qclaim->value(0);
+            auto qclean = prepared(cleanSql);
+            qclean->addBindValue(week);
+            qclean->addBindValue(markedAt);
+            auto qdelete = prepared("DELETE FROM production_rollup WHERE week_start = ?");
+            qdelete->addBindValue(week);
+            auto qinsert = prepared(insertSql);
+            qinsert->addBindValue(week);
+            qinsert->addBindValue(week.addDays(6));
+            for (const auto& q : {qclean, qdelete, qinsert}) {
+                if (!q->exec()) {
+                    qWarning() << "Błąd przeliczania zestawienia produkcji za tydzień" << week << ":" << q->lastError().text();
+                    setLastError(q->lastError());
+                    return false;
+                }
+            }
+            return true;
+        });
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool DbManager::rebuildProductionRollup() {
+    return executeTransaction([&]() {
+        QSqlQuery q(connection());
+        if (!q.exec("DELETE FROM production_rollup_dirty") || !q.exec("DELETE FROM production_rollup")
+            || !q.exec("INSERT INTO production_rollup (week_start, status, material, width, height, core, "
+                       "quantity, roll_count, value, order_count, order_numbers) "
+                       + productionGroupsSql("o.delivery_date IS NOT NULL", true))) {
+            qWarning() << "Błąd przebudowy zestawienia produkcji:" << q.lastError().text();
+            setLastError(q.lastError());
+            return false;
+        }
+        qDebug() << "[Zestawienie] Przebudowano production_rollup";
+        return true;
+    });
+}
+
+QList<ProductionGroup> DbManager::getProductionRollup(const QDate& weekStart, const QVector<Order::Status>& statuses) {
+    if (statuses.isEmpty() || !weekStart.isValid()) return {};
+    // Najpierw tygodnie zmienione od ostatniego odczytu (zwykle żaden). Błąd przeliczenia
+    // nie czyści widoku - zostaje poprzednie zestawienie, błąd w lastError()
+    if (!refreshProductionRollup()) {
+        qWarning() << "[Zestawienie] Nie przeliczono zmienionych tygodni - zestawienie może być nieaktualne";
+    }
+    const bool postgres = connection().driverName() == "QPSQL";
+    auto q = prepared(QString(
+        "SELECT material, width, height, core, SUM(quantity), SUM(roll_count), SUM(value), SUM(order_count), %1 "
+        "FROM production_rollup WHERE week_start = ? AND status IN (%2) "
+        "GROUP BY material, width, height, core "
+        "ORDER BY material, width, height, core")
+        .arg(postgres ? "STRING_AGG(order_numbers, ',')" : "GROUP_CONCAT(order_numbers)",
+             QStringList(statuses.size(), "?").join(", ")));
+    q->addBindValue(weekStart);
+    for (Order::Status status : statuses) q->addBindValue(static_cast<int>(status));
+    if (!q->exec()) {
+        qWarning() << "Błąd odczytu zestawienia produkcji:" << q->lastError().text();
+        setLastError(q->lastError());
+        return {};
+    }
+    return readProductionGroups(*q);
+}
@@ -2,22 +2,130 @@
 
 #include <QSqlDatabase>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QObject>
 #include <QDate>
 #include <QSqlError>
+#include <QMutex>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include "connection_pool.h"
+#include "prepared_statement_cache.h"
+#include "sqlite_profile.h"
+#include "entity_cache.h"
+#include "numbering_service.h"
+#include "schema_catalog.h"
+#include "search_index.h"
+#include "data_transfer.h"
+#include "models/order.h"
+#include "models/order_list_row.h"
+#include "models/production_group.h"
+#include "models/client.h"
+#include "models/supplier.h"
+#include "models/material.h"
+#include "models/materials_order.h"
+
+class AsyncDb;
+class ChangeFeed;
+class QTimer;
 
 class DbManager : public QObject {
     Q_OBJECT
 public:
     static DbManager& instance(); // singleton
-    QSqlDatabase database(); // Główne połączenie
-    QSqlDatabase getPooledConnection(); // Połączenie z puli
+    ~DbManager();
+    QSqlDatabase database(); // Połączenie bieżącego wątku (w wątku GUI - główne połączenie)
+    // Asynchroniczne wywołania na puli wątków roboczych (wyniki jako QFuture)
+    AsyncDb& async();
+    // Powiadomienia o zmianach zamówień i klientów (także z innych stanowisk)
+    ChangeFeed& changeFeed();
+
+    // Przypina połączenie do bieżącego wątku na czas życia obiektu - metody
+    // DbManager wywołane w tym wątku używają go zamiast połączenia głównego
+    class ThreadConnectionScope {
+    public:
+        explicit ThreadConnectionScope(const QSqlDatabase& connection);
+        ~ThreadConnectionScope();
+        ThreadConnectionScope(const ThreadConnectionScope&) = delete;
+        ThreadConnectionScope& operator=(const ThreadConnectionScope&) = delete;
+    private:
+        QSqlDatabase m_previous;
+        bool m_hadPrevious;
+    };
+    // Pula połączeń (bezpieczna wątkowo, połączenia tworzone leniwie per wątek)
+    ConnectionPool& connectionPool();
+    // Czas oczekiwania na wolne połączenie z puli; po nim lease jest nieprawidłowy
+    static const int POOLED_CONNECTION_TIMEOUT_MS = 5000;
+    // Nieprawidłowy lease (pula wyczerpana) ustawia lastError - zapytania na nim zwracają błąd
+    ConnectionLease leaseConnection(int timeoutMs = POOLED_CONNECTION_TIMEOUT_MS);
+    // Starsze API puli - zwraca nieprawidłowe połączenie, gdy pula jest wyczerpana
+    QSqlDatabase getPooledConnection();
     void returnPooledConnection(QSqlDatabase& connection);
     static bool isOpen();
+
+    // --- Typowane API (wiersze jako struktury z models/, bez QMap/QVariant) ---
+    // Wersje QMap poniżej są cienkimi adapterami nad tymi metodami.
+    QVector<Client> fetchClients();
+    // Klienci pasujący do frazy (bez polskich znaków, indeks trigramowy / FTS5), najtrafniejsi pierwsi
+    QVector<Client> searchClients(const QString& text, ClientSearchField field = ClientSearchField::All, int limit = 200);
+    QVector<Order> fetchOrders();
+    // Zamówienia bez statusu Zrealizowane (dashboard)
+    QVector<Order> fetchOpenOrders();
+    QVector<OrderItem> fetchOrderItems(int orderId);
+    QVector<MaterialsOrderItem> fetchMaterialsOrderItems(int orderId);
+    QVector<Supplier> fetchSuppliers();
+    QVector<Material> fetchMaterialsCatalog();
+    QVector<MaterialsOrder> fetchMaterialsOrders();
+    // Strona listy zamówień (najnowsze pierwsze) zaczynająca się za kursorem
+    // "after"; pusty filtr zwraca wszystkie zamówienia. Bez archiwum strona to
+    // odczyt indeksu idx_orders_sort_date_id, więc koszt zależy od rozmiaru
+    // strony, nie od liczby zamówień w bazie. includeArchive - także zamówienia
+    // z orders_archive (UNION bez tego indeksu; bez indeksu wyszukiwania numerów w SQLite).
+    QVector<OrderListRow> fetchOrdersPage(const OrdersPageCursor& after, int limit,
+                                          const QString& filter = QString(),
+                                          OrderSearchField field = OrderSearchField::OrderNumber,
+                                          bool includeArchive = false);
+    // Wiersze listy dla podanych zamówień (np. po powiadomieniu o zmianie);
+    // zamówienia niepasujące do filtra są pomijane. id wysyłane porcjami
+    // ORDER_IDS_PER_QUERY; nullopt przy błędzie zapytania (lastError)
+    std::optional<QVector<OrderListRow>> fetchOrderListRows(const QVector<int>& ids, const QString& filter = QString(),
+                                                            OrderSearchField field = OrderSearchField::OrderNumber,
+                                                            bool includeArchive = false);
+    // Zamówienia z nazwą klienta (client.name, client.shortName), bez pozycji;
+    // porcjami jak fetchOrderListRows, nullopt przy błędzie
+    std::optional<QVector<Order>> fetchOrdersByIds(const QVector<int>& ids);
+    // Najwięcej id w jednym "IN (?, ...)" - daleko poniżej limitu parametrów sterowników
+    static const int ORDER_IDS_PER_QUERY = 500;
+    // Podsumowanie produkcji zgrupowane w bazie po materiale, wymiarach i rdzeniu:
+    // ilości w tysiącach, liczba rolek, wartość i numery zamówień z ceną.
+    // Nieprawidłowe from/to - bez filtra daty wysyłki.
+    QList<ProductionGroup> getProductionGroups(const QDate& from, const QDate& to,
+                                               const QVector<Order::Status>& statuses);
+    // To samo zestawienie dla jednego tygodnia (poniedziałek weekStart) z tabeli
+    // production_rollup. Tygodnie oznaczone przez triggery jako zmienione są
+    // przeliczane przed odczytem.
+    QList<ProductionGroup> getProductionRollup(const QDate& weekStart, const QVector<Order::Status>& statuses);
+    bool refreshProductionRollup();
+    // Przelicza production_rollup od zera (np. po imporcie danych z pominięciem triggerów)
+    bool rebuildProductionRollup();
+
+    static QMap<QString, QVariant> toVariantMap(const Client& client);
+    static QMap<QString, QVariant> toVariantMap(const Order& order);
+    static QMap<QString, QVariant> toVariantMap(const OrderListRow& row);
+    static QMap<QString, QVariant> toVariantMap(const Supplier& supplier);
+    static QMap<QString, QVariant> toVariantMap(const Material& material);
+    static QMap<QString, QVariant> toVariantMap(const MaterialsOrder& order);
+    static QMap<QString, QVariant> toVariantMap(const MaterialsOrderItem& item);
+
     // Klienci
     QVector<QMap<QString, QVariant>> getClients();
+    QMap<QString, QVariant> getClientById(int clientId); // pusta mapa, gdy brak klienta
     bool addClient(const QMap<QString, QVariant>& data);
     bool updateClient(int id, const QMap<QString, QVariant>& data);
     bool deleteClient(int id);
@@ -26,8 +134,8 @@ public:
     int findClientByNumber(const QString &clientNumber);
     int getMaxClientNumber();
     bool addClientWithAddresses(const QMap<QString, QVariant>& data, const QList<QMap<QString, QVariant>>& addresses);
-    int getNextUniqueClientNumber(); // Zwraca unikatowy numer klienta, nigdy nieużyty
-    void markClientNumberUsed(int clientNumber); // Zapisuje numer jako użyty
+    int getNextUniqueClientNumber(); // Przydziela numer klienta z ciągu (number_sequences); 0 przy błędzie
+    bool markClientNumberUsed(int clientNumber); // Zapisuje numer jako użyty i przesuwa ciąg; false przy błędzie
     bool updateClientWithAddresses(int id, const QMap<QString, QVariant>& data, const QList<QMap<QString, QVariant>>& addresses);
     // Zamówienia
     QVector<QMap<QString, QVariant>> getOrders();
@@ -35,13 +143,56 @@ public:
     bool addOrder(const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items);
     bool updateOrder(int id, const QMap<QString, QVariant>& orderData, const QVector<QMap<QString, QVariant>>& items);
     bool deleteOrder(int id);
+    // --- Archiwum zamówień (OrderArchive) ---
+    // Przenosi zrealizowane zamówienia starsze niż olderThanDays dni do archiwum;
+    // -1 - wiek z ustawienia archive/completed_after_days (0 wyłącza archiwizację).
+    // Zwraca liczbę przeniesionych zamówień, -1 przy błędzie.
+    int archiveCompletedOrders(int olderThanDays = -1);
+    // Zadania utrzymaniowe w tle (AsyncDb): archiwizacja zrealizowanych zamówień
+    // i synchronizacja kopii lokalnej co replica/sync_interval_ms.
+    // Uruchamia je program z GUI po otwarciu okna głównego; CLI i etykiety-bench nie.
+    void startBackgroundMaintenance();
+    // Przywraca zamówienie z archiwum do tabel bieżących (np. przed edycją)
+    bool restoreArchivedOrder(int orderId);
+    // Wstawia pozycje porcjami (wielowierszowe VALUES, jedno zapytanie na porcję).
+    // Nie otwiera transakcji - wywołujący odpowiada za commit/rollback.
+    bool insertOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items);
+    // Doprowadza pozycje zamówienia do stanu z items (RowDiff): pozycje z "id" są
+    // aktualizowane tylko przy zmianie, bez "id" - wstawiane, brakujące - usuwane.
+    // Nie otwiera transakcji.
+    bool syncOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items);
+    bool insertMaterialsOrderItems(int orderId, const QVector<QMap<QString, QVariant>>& items);
+    // Jak syncOrderItems, dla adresów dostawy klienta
+    bool syncDeliveryAddresses(int clientId, const QList<QMap<QString, QVariant>>& addresses);
     // --- CRUD dla adresów dostawy ---
     QVector<QMap<QString, QVariant>> getDeliveryAddresses(int clientId = -1);
     bool addDeliveryAddress(const QMap<QString, QVariant>& data);
     bool updateDeliveryAddress(const QMap<QString, QVariant>& data);
     bool migrateDeliveryAddresses(); // Migracja istniejących danych adresów dostawy
+    // --- Migracje jednorazowe (zapisywane w tabeli schema_migrations) ---
+    bool isMigrationApplied(const QString& name);
+    bool markMigrationApplied(const QString& name);
+    // Nadaje numery ZAM-YYYY-NNN zamówieniom z numerem w innym formacie.
+    // Działa partiami, każda partia w osobnej transakcji; progress(przetworzone, wszystkie)
+    // wywoływany jest po każdej partii.
+    bool migrateOrderNumbers(const std::function<void(int done, int total)>& progress = {});
+    // Tworzy number_sequences i ustawia ciągi za najwyższymi numerami już zapisanymi
+    // w orders, materials_orders, clients (oraz order_sequence / used_client_numbers)
+    bool migrateNumberSequences();
+    // Dodaje kolumny *_value (DOUBLE PRECISION / REAL) obok tekstowych wymiarów, ilości i cen
+    // pozycji i wypełnia je partiami; wartości, których nie da się odczytać, zostają NULL.
+    bool migrateNumericItemValues(const std::function<void(int done, int total)>& progress = {});
+    // --- Indeksy (wersjonowane, zakładane przy starcie) ---
+    // Tworzy brakujące indeksy i zapisuje wersje "indexes_vN"; false, jeśli któregoś nie udało się utworzyć
+    bool ensureIndexes();
+    // Indeksy z listy, których nie ma w bazie (pg_indexes / sqlite_master)
+    QStringList missingIndexes();
+    // Plany wykonania kluczowych zapytań (EXPLAIN / EXPLAIN QUERY PLAN) do diagnostyki
+    QString queryPlanReport();
     // Aktualizuje tylko datę dostawy zamówienia
     bool updateOrderDeliveryDate(int id, const QDate& newDate);
+    // Aktualizuje tylko status zamówienia
+    bool updateOrderStatus(int id, Order::Status status);
     QVector<QMap<QString, QVariant>> getOrderItems(int orderId);
     
     // Wyczyszczenie wszystkich zamówień z bazy danych
@@ -55,9 +206,16 @@ public:
     
     // Pobranie ostatniego błędu bazy danych
     QSqlError lastError() const;
+
+    // Liczniki cache przygotowanych zapytań (trafienia/chybienia ze wszystkich połączeń)
+    StatementCacheStats statementCacheStats() const;
     
-    // Pomocnicza funkcja do sprawdzania istnienia kolumny w tabeli
+    // Pomocnicza funkcja do sprawdzania istnienia kolumny w tabeli (z katalogu schematu)
     bool checkColumnExistence(const QString& tableName, const QString& columnName) const;
+    // Kolumny tabel wczytane po połączeniu i po migracjach
+    const SchemaCatalog& schema() const;
+    // Wczytuje katalog ponownie - po każdej zmianie struktury tabel (ALTER/CREATE)
+    void refreshSchema();
     QString getClientNameById(int clientId) const;
 
     // --- CRUD dla dostawców (suppliers) ---
@@ -70,6 +228,7 @@ public:
     // --- CRUD dla katalogu materiałów (materials_catalog) ---
     QVector<QMap<QString, QVariant>> getMaterialsCatalog();
     QMap<QString, QVariant> getMaterialById(int materialId);
+    int findMaterialIdByName(const QString& name); // -1, gdy brak w katalogu
     bool addMaterial(const QMap<QString, QVariant>& data);
     bool updateMaterial(int id, const QMap<QString, QVariant>& data);
     bool deleteMaterial(int id);
@@ -84,8 +243,10 @@ public:
     // Nowa metoda do obsługi checkboxa "Zrealizowane"
     bool setMaterialsOrderDone(int orderId, bool done);
 
-    // --- Numeracja zamówień materiałów ---
-    QString getNextMaterialsOrderNumber();
+    // --- Numeracja zamówień (NumberingService, tabela number_sequences) ---
+    // Każde wywołanie przydziela nowy numer - pusty tekst przy błędzie
+    QString getNextOrderNumber(const QDate& date = QDate::currentDate()); // ZAM-YYYY-NNN
+    QString getNextMaterialsOrderNumber(); // MO-YYYY-NNNN
 
     // --- PODPOWIEDZI (QCompleter) dla materiałów ---
     QVector<QVariant> getUniqueMaterialWidths();
@@ -94,9 +255,32 @@ public:
     // --- Automatyczne ładowanie pozycji zamówienia materiałów ---
     QVector<QMap<QString, QVariant>> getMaterialsOrderItemsForOrder(int orderId);
 
+    // --- Import/eksport danych (DataTransfer) ---
+    // Tabela do pliku CSV albo NDJSON (według rozszerzenia), strumieniowo - pamięć
+    // nie zależy od liczby wierszy. Postęp sygnałem transferProgress; przez async()
+    // bez blokowania GUI.
+    bool exportTable(const QString& table, const QString& path);
+    // Wiersze z id istniejącym w tabeli są nadpisywane; porcje w osobnych transakcjach.
+    // Zwraca liczbę zaimportowanych wierszy, -1 przy błędzie.
+    qint64 importTable(const QString& table, const QString& path);
+    // Wszystkie tabele DataTransfer::tables() jako pliki <tabela>.csv / <tabela>.ndjson w katalogu
+    bool exportAll(const QString& directory, TransferFormat format);
+    // Pliki tabel z katalogu w kolejności DataTransfer::tables(); tabele bez pliku są pomijane
+    bool importAll(const QString& directory);
+
+    // --- Kopia lokalna do pracy bez serwera (LocalReplica, plik replica/path) ---
+    // true - PostgreSQL był niedostępny i program pracuje na kopii lokalnej;
+    // zapisy czekają w kolejce do następnego uruchomienia z serwerem
+    bool isOffline() const;
+    // Wysyła kolejkę zapisów z kopii na serwer i pobiera zmiany (tylko z połączeniem do PostgreSQL).
+    // Blokuje do końca synchronizacji - z GUI przez startBackgroundMaintenance().
+    bool syncReplica();
+
 signals:
     void dbConnectionError(const QString &errorMsg);
     void orderAdded(); // Sygnał emitowany po dodaniu nowego zamówienia
+    // Postęp importu/eksportu (emitowany także z wątku roboczego AsyncDb)
+    void transferProgress(const QString& table, qint64 rows);
 
 private:
     DbManager(QObject *parent = nullptr); // prywatny konstruktor
@@ -106,16 +290,102 @@ private:
     // Główne połączenie do bazy danych
     QSqlDatabase db;
     
+    // Cache przygotowanych zapytań, osobny dla każdego połączenia (klucz: nazwa
+    // połączenia). Zadeklarowany przed pulą, bo pula zgłasza zamykanie połączeń
+    // także w swoim destruktorze.
+    static const int DEFAULT_STATEMENT_CACHE_SIZE = 64;
+    int m_statementCacheSize = DEFAULT_STATEMENT_CACHE_SIZE;
+    mutable QMutex m_statementCacheMutex;
+    mutable QHash<QString, std::shared_ptr<PreparedStatementCache>> m_statementCaches;
+    // Przygotowane zapytanie z cache połączenia bieżącego wątku
+    std::shared_ptr<QSqlQuery> prepared(const QString& sql) const;
+    void dropStatementCache(const QString& connectionName);
+    bool bulkInsert(const QString& table, const QStringList& columns, const QVector<QVariantList>& rows);
+    // Wspólne zapytanie listy zamówień (fetchOrdersPage, fetchOrderListRows)
+    QVector<OrderListRow> queryOrderList(const QStringList& conditions, const QVariantList& bindValues, int limit,
+                                         bool includeArchive, bool* ok = nullptr);
+    QVector<Order> queryOrders(const QString& where);
+    // Kolumny pozycji zamówienia (bez order_id) i ich wartości z mapy pozycji
+    static const QStringList& orderItemColumns();
+    static QVariantList orderItemValues(const QMap<QString, QVariant>& item);
+    // Wspólna część syncOrderItems / syncDeliveryAddresses: rows - (id lub -1, wartości columns)
+    bool syncChildRows(const QString& table, const QString& parentColumn, int parentId,
+                       const QStringList& columns, const QVector<QPair<int, QVariantList>>& rows);
+    QString orderListSortDate() const;
+    // Warunek keyset "za kursorem" - wiązane: data zastępcza lub order_date, id
+    QString orderKeysetCondition() const;
+    // Tekst zapytania listy (strona zamówień z pozycjami); parametry: bindValues
+    // warunków, na końcu LIMIT. Wspólny dla queryOrderList i queryPlanReport.
+    QString orderListSql(const QStringList& conditions, bool includeArchive) const;
+    // Zestawienie produkcji: zapytanie grupujące (perWeek - także po tygodniu i statusie)
+    QString productionGroupsSql(const QString& where, bool perWeek) const;
+    QString productionWeekStartSql(const QString& dateColumn) const;
+    static QList<ProductionGroup> readProductionGroups(QSqlQuery& q);
+    bool installProductionRollup();
+    void appendOrderSearchCondition(const QString& filter, OrderSearchField field,
+                                    QStringList& conditions, QVariantList& bindValues, bool includeArchive) const;
+    
     // Connection pool
-    static const int POOL_SIZE = 3;
-    QVector<QSqlDatabase> connectionPool;
-    QVector<bool> connectionAvailable;
-    int getAvailableConnection();
-    void releaseConnection(int connectionId);
+    static const int DEFAULT_POOL_SIZE = 4;
+    std::unique_ptr<ConnectionPool> m_pool;
+    void createConnectionPool();
+
+    // Ustawienia PRAGMA dla trybu SQLite (połączenie główne i połączenia z puli)
+    SqliteProfile m_sqliteProfile;
+    QTimer* m_sqliteMaintenanceTimer = nullptr;
+    void startSqliteMaintenance();
+
+    // Klienci, dostawcy i katalog materiałów w pamięci. fetchClients(),
+    // fetchSuppliers() i fetchMaterialsCatalog() (oraz ich wersje QMap)
+    // czytają z cache; zapisy tych tabel i ChangeFeed go unieważniają.
+    EntityCache m_entityCache;
+    std::shared_ptr<const ClientIndex> cachedClients();
+    std::shared_ptr<const SupplierIndex> cachedSuppliers();
+    std::shared_ptr<const MaterialIndex> cachedMaterials();
+    bool loadClients(QVector<Client>& result);
+    bool loadSuppliers(QVector<Supplier>& result);
+    bool loadMaterialsCatalog(QVector<Material>& result);
+
+    SchemaCatalog m_schema;
+    // Indeksy wyszukiwania klientów i zamówień (zakładane w runMigrations)
+    SearchIndex m_search;
+
+    // Numeracja zamówień i klientów; numery pobierane blokami numbering/block_size
+    NumberingService m_numbering;
+
+    // Nasłuch zmian na połączeniu głównym (po migracjach)
+    ChangeFeed* m_changeFeed = nullptr;
+    void startChangeFeed();
+
+    // Wątki robocze dla AsyncDb (tworzone przy pierwszym użyciu)
+    static const int DEFAULT_ASYNC_THREADS = 2;
+    std::unique_ptr<AsyncDb> m_async;
+    std::once_flag m_asyncOnce;
+
+    // Kopia lokalna: synchronizacja co replica/sync_interval_ms przy połączeniu z PostgreSQL,
+    // w wątku AsyncDb; kolejna nie startuje, dopóki trwa poprzednia
+    static const int DEFAULT_REPLICA_SYNC_INTERVAL_MS = 60000;
+    bool m_offline = false;
+    QTimer* m_replicaSyncTimer = nullptr;
+    std::atomic_bool m_replicaSyncRunning{false};
+    static bool replicaEnabled();
+    static QString replicaPath();
+    static QSqlDatabase openReplica(const QString& connectionName);
+    void startReplicaSync();
+    void scheduleReplicaSync();
+    bool syncReplica(const QSqlDatabase& replica, const QSqlDatabase& server);
+
+    // Połączenie przypięte do bieżącego wątku lub połączenie główne
+    QSqlDatabase connection() const;
     
     // Helper methods
     void initializeTables(); // Create basic tables for SQLite
+    void runMigrations(); // Migracje danych wykonywane raz na bazę
+    static const int MIGRATION_BATCH_SIZE = 500;
+    static const int DEFAULT_ARCHIVE_AFTER_DAYS = 180;
     bool executeTransaction(const std::function<bool()>& operation); // Zunifikowana obsługa transakcji
 
     QSqlError m_lastError; // Dodano pole do przechowywania ostatniego błędu SQL
+    mutable QMutex m_lastErrorMutex; // m_lastError ustawiany także z wątków roboczych
+    void setLastError(const QSqlError& error);
 };
@@ -0,0 +1,83 @@
+#include "entity_cache.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+ClientIndex::ClientIndex(QVector<Client> sortedRows) : EntityIndex<Client>(std::move(sortedRows)) {
+    byNip.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        const Client& c = rows.at(i);
+        if (!c.clientNumber.isEmpty()) byClientNumber.insert(c.clientNumber, i);
+        if (!c.nip.isEmpty()) byNip.insert(c.nip, i);
+    }
+}
+
+MaterialIndex::MaterialIndex(QVector<Material> sortedRows) : EntityIndex<Material>(std::move(sortedRows)) {
+    byName.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        // Przy powtórzonej nazwie wygrywa pierwszy wiersz (jak dotychczasowe wyszukiwanie w pętli)
+        if (!byName.contains(rows.at(i).name)) byName.insert(rows.at(i).name, i);
+    }
+}
+
+const Material* MaterialIndex::findByName(const QString& name) const {
+    auto it = byName.constFind(name);
+    return it == byName.constEnd() ? nullptr : &rows.at(it.value());
+}
+
+std::shared_ptr<const ClientIndex> EntityCache::clients() const {
+    QReadLocker locker(&m_lock);
+    return m_clients;
+}
+
+std::shared_ptr<const SupplierIndex> EntityCache::suppliers() const {
+    QReadLocker locker(&m_lock);
+    return m_suppliers;
+}
+
+std::shared_ptr<const MaterialIndex> EntityCache::materials() const {
+    QReadLocker locker(&m_lock);
+    return m_materials;
+}
+
+quint64 EntityCache::generation(Table table) const {
+    QReadLocker locker(&m_lock);
+    return m_generations[table];
+}
+
+void EntityCache::store(std::shared_ptr<const ClientIndex> index, quint64 generation) {
+    QWriteLocker locker(&m_lock);
+    if (m_generations[Clients] == generation) m_clients = std::move(index);
+}
+
+void EntityCache::store(std::shared_ptr<const SupplierIndex> index, quint64 generation) {
+    QWriteLocker locker(&m_lock);
+    if (m_generations[Suppliers] == generation) m_suppliers = std::move(index);
+}
+
+void EntityCache::store(std::shared_ptr<const MaterialIndex> index, quint64 generation) {
+    QWriteLocker locker(&m_lock);
+    if (m_generations[Materials] == generation) m_materials = std::move(index);
+}
+
+void EntityCache::invalidate(Table table) {
+    QWriteLocker locker(&m_lock);
+    ++m_generations[table];
+    switch (table) {
+    case Clients: m_clients.reset(); break;
+    case Suppliers: m_suppliers.reset(); break;
+    case Materials: m_materials.reset(); break;
+    case TableCount: break;
+    }
+}
+
+void EntityCache::invalidateAll() {
+    for (int table = 0; table < TableCount; ++table) invalidate(static_cast<Table>(table));
+}
+
+bool EntityCache::tableFor(const QString& tableName, Table& table) {
+    if (tableName == "clients") table = Clients;
+    else if (tableName == "suppliers") table = Suppliers;
+    else if (tableName == "materials_catalog") table = Materials;
+    else return false;
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "models/client.h"
+#include "models/supplier.h"
+#include "models/material.h"
+
+// Wiersze jednej tabeli słownikowej z indeksem po id. Kolejność wierszy jak
+// w zapytaniu źródłowym (ORDER BY name).
+template <typename T>
+class EntityIndex {
+public:
+    QVector<T> rows;
+    QHash<int, int> byId; // id -> pozycja w rows
+
+    explicit EntityIndex(QVector<T> sortedRows) : rows(std::move(sortedRows)) {
+        byId.reserve(rows.size());
+        for (int i = 0; i < rows.size(); ++i) byId.insert(rows.at(i).id, i);
+    }
+    const T* find(int id) const {
+        auto it = byId.constFind(id);
+        return it == byId.constEnd() ? nullptr : &rows.at(it.value());
+    }
+};
+
+class ClientIndex : public EntityIndex<Client> {
+public:
+    QMap<QString, int> byClientNumber; // posortowane po numerze klienta
+    QHash<QString, int> byNip;
+
+    explicit ClientIndex(QVector<Client> sortedRows);
+};
+
+class MaterialIndex : public EntityIndex<Material> {
+public:
+    QHash<QString, int> byName;
+
+    explicit MaterialIndex(QVector<Material> sortedRows);
+    const Material* findByName(const QString& name) const;
+};
+
+using SupplierIndex = EntityIndex<Supplier>;
+
+/**
+ * @brief Wspólny dla całego procesu cache klientów, dostawców i katalogu materiałów
+ *
+ * Trzyma niezmienne migawki (shared_ptr do const) - czytelnik dostaje migawkę
+ * pod krótką blokadą i dalej korzysta z niej bez blokowania, także w wątkach
+ * roboczych AsyncDb. Zapisy w DbManager i powiadomienia ChangeFeed unieważniają
+ * tabelę; kolejny odczyt ładuje ją ponownie z bazy.
+ *
+ * Każde unieważnienie zwiększa generację tabeli. Wynik zapytania jest
+ * zapamiętywany tylko wtedy, gdy generacja nie zmieniła się od rozpoczęcia
+ * ładowania - dane pobrane przed równoległym zapisem nie trafiają do cache.
+ */
+class EntityCache {
+public:
+    enum Table { Clients, Suppliers, Materials, TableCount };
+
+    std::shared_ptr<const ClientIndex> clients() const;
+    std::shared_ptr<const SupplierIndex> suppliers() const;
+    std::shared_ptr<const MaterialIndex> materials() const;
+
+    quint64 generation(Table table) const;
+    void store(std::shared_ptr<const ClientIndex> index, quint64 generation);
+    void store(std::shared_ptr<const SupplierIndex> index, quint64 generation);
+    void store(std::shared_ptr<const MaterialIndex> index, quint64 generation);
+
+    void invalidate(Table table);
+    void invalidateAll();
+    // Tabela bazy danych -> tabela cache (false dla tabel spoza cache)
+    static bool tableFor(const QString& tableName, Table& table);
+
+private:
+    mutable QReadWriteLock m_lock;
+    std::shared_ptr<const ClientIndex> m_clients;
+    std::shared_ptr<const SupplierIndex> m_suppliers;
+    std::shared_ptr<const MaterialIndex> m_materials;
+    quint64 m_generations[TableCount] = {0, 0, 0};
+};
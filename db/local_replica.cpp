@@ -0,0 +1,745 @@
+#include "local_replica.h"
+#include <QDate>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSqlQuery>
+#include <QVariantMap>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#include "numbering_service.h"
+
+namespace {
+// Klucz znacznika usunięć w replica_state
+const char* TOMBSTONES = "replica_tombstones";
+
+struct ForeignKey {
+    const char* table;
+    const char* column;
+    const char* parent;
+};
+
+// Klucze obce przepisywane przy wysyłaniu wierszy dodanych bez serwera
+const ForeignKey FOREIGN_KEYS[] = {
+    {"delivery_addresses", "client_id", "clients"},
+    {"orders", "client_id", "clients"},
+    {"order_items", "order_id", "orders"},
+    {"materials_orders", "supplier_id", "suppliers"},
+    {"materials_order_items", "order_id", "materials_orders"},
+    {"materials_order_items", "material_id", "materials_catalog"},
+};
+
+// Numery nadawane z NumberingService; format jak w DbManager::getNextOrderNumber,
+// getNextMaterialsOrderNumber i w oknie klienta
+struct NumberColumn {
+    const char* table;
+    const char* column;
+    const char* sequence;
+    const char* prefix; // nullptr - numer bez roku (klienci)
+    int width;
+};
+
+const NumberColumn NUMBER_COLUMNS[] = {
+    {"orders", "order_number", NumberingService::ORDERS, "ZAM", 3},
+    {"materials_orders", "order_number", NumberingService::MATERIALS_ORDERS, "MO", 4},
+    {"clients", "client_number", NumberingService::CLIENTS, nullptr, 6},
+};
+
+// Wiersz z kolejki: operacja i updated_at z pierwszej zmiany od przejścia w tryb
+// bez serwera, kolejność wysyłania według ostatniej zmiany (lastSeq)
+struct PendingWrite {
+    QString table;
+    QString operation; // I, U, D
+    int rowId = -1;
+    QString baseUpdatedAt;
+    qint64 lastSeq = 0;
+};
+
+void reportError(const QSqlQuery& q, QSqlError* error) {
+    if (error) *error = q.lastError();
+}
+
+QString placeholders(int count) {
+    return QStringList(count, "?").join(", ");
+}
+
+QString localType(const QString& serverType) {
+    const QString type = serverType.toLower();
+    if (type.contains("int") || type == QLatin1String("boolean")) return "INTEGER";
+    if (type == QLatin1String("double precision") || type == QLatin1String("real") || type == QLatin1String("numeric")) return "REAL";
+    if (type == QLatin1String("date")) return "DATE";
+    if (type.startsWith("timestamp")) return "TIMESTAMP";
+    return "TEXT";
+}
+
+// Kolumny tabeli serwera: id pierwsze, reszta alfabetycznie
+QStringList serverColumns(const SchemaCatalog& schema, const QString& table) {
+    QStringList columns = schema.columns(table);
+    columns.removeAll("id");
+    std::sort(columns.begin(), columns.end());
+    columns.prepend("id");
+    return columns;
+}
+
+// Kolumny wysyłane na serwer: wspólne dla kopii i serwera, bez id i updated_at
+QStringList writableColumns(const SchemaCatalog& local, const SchemaCatalog& server, const QString& table) {
+    QStringList columns;
+    for (const QString& column : server.columns(table)) {
+        if (column == QLatin1String("id") || column == QLatin1String("updated_at")) continue;
+        if (local.hasColumn(table, column)) columns << column;
+    }
+    std::sort(columns.begin(), columns.end());
+    return columns;
+}
+
+bool setWatermark(const QSqlDatabase& replica, const QString& table, const QString& value, QSqlError* error) {
+    QSqlQuery q(replica);
+    q.prepare("INSERT INTO replica_state (table_name, watermark) VALUES (?, ?) "
+              "ON CONFLICT (table_name) DO UPDATE SET watermark = excluded.watermark");
+    q.addBindValue(table);
+    q.addBindValue(value);
+    if (!q.exec()) {
+        qWarning() << "[Replika] Nie można zapisać znacznika" << table << ":" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    return true;
+}
+
+// Numer nadany bez serwera mógł zostać w tym czasie wydany na serwerze -
+// wiersz dostaje wtedy kolejny numer z ciągu serwera
+bool ensureFreeNumbers(const QSqlDatabase& server, const QString& table, QVariantMap& row,
+                       ReplicaSyncStats& stats, QSqlError* error) {
+    for (const NumberColumn& number : NUMBER_COLUMNS) {
+        if (table != QLatin1String(number.table) || row.value(number.column).isNull()) continue;
+        const QVariant original = row.value(number.column);
+        int year = 0;
+        if (number.prefix) {
+            const auto match = QRegularExpression(QString("^%1-(\\d{4})-").arg(number.prefix)).match(original.toString());
+            year = match.hasMatch() ? match.captured(1).toInt() : QDate::currentDate().year();
+        }
+        QSqlQuery sq(server);
+        while (true) {
+            sq.prepare(QString("SELECT 1 FROM %1 WHERE %2 = ?").arg(table, number.column));
+            sq.addBindValue(row.value(number.column));
+            if (!sq.exec()) {
+                reportError(sq, error);
+                return false;
+            }
+            if (!sq.next()) break;
+            NumberBlock block;
+            if (!NumberingService::allocate(server, number.sequence, year, 1, 1, block, error)) return false;
+            const QString digits = QString::number(block.first).rightJustified(number.width, '0');
+            if (number.prefix) {
+                row.insert(number.column, QString("%1-%2-%3").arg(number.prefix).arg(year).arg(digits));
+            } else {
+                row.insert(number.column, original.typeId() == QMetaType::QString ? QVariant(digits) : QVariant(block.first));
+            }
+        }
+        if (row.value(number.column) != original) {
+            qWarning() << "[Replika] Numer" << original.toString() << "zajęty na serwerze -" << table
+                       << "wysłany z numerem" << row.value(number.column).toString();
+            ++stats.renumbered;
+        }
+    }
+    return true;
+}
+
+bool recordConflict(const QSqlDatabase& replica, const PendingWrite& write, const QVariantMap& row,
+                    const QString& message, QSqlError* error) {
+    qWarning() << "[Replika] Konflikt" << write.table << write.rowId << write.operation << ":" << message;
+    QSqlQuery q(replica);
+    q.prepare("INSERT INTO replica_conflicts (table_name, row_id, operation, message, local_row) VALUES (?, ?, ?, ?, ?)");
+    q.addBindValue(write.table);
+    q.addBindValue(write.rowId);
+    q.addBindValue(write.operation);
+    q.addBindValue(message);
+    q.addBindValue(row.isEmpty() ? QVariant() : QString::fromUtf8(QJsonDocument(QJsonObject::fromVariantMap(row)).toJson(QJsonDocument::Compact)));
+    if (!q.exec()) {
+        qWarning() << "[Replika] Nie można zapisać konfliktu:" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    return true;
+}
+}
+
+const QStringList& LocalReplica::tables() {
+    static const QStringList list = {
+        "clients", "delivery_addresses", "orders", "order_items",
+        "suppliers", "materials_catalog", "materials_orders", "materials_order_items",
+    };
+    return list;
+}
+
+bool LocalReplica::installServer(const QSqlDatabase& server, const SchemaCatalog& serverSchema, QSqlError* error) {
+    QSqlQuery q(server);
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS replica_tombstones ("
+        "table_name TEXT NOT NULL, "
+        "row_id INTEGER NOT NULL, "
+        "deleted_at TIMESTAMPTZ NOT NULL DEFAULT now(), "
+        "PRIMARY KEY (table_name, row_id))",
+        "CREATE INDEX IF NOT EXISTS idx_replica_tombstones_deleted_at ON replica_tombstones (deleted_at)",
+        // updated_at zawsze z zegara serwera; wiersz wstawiony ponownie (przywrócony
+        // z archiwum) przestaje być usunięty
+        "CREATE OR REPLACE FUNCTION etykiety_replica_touch() RETURNS trigger AS $$ "
+        "BEGIN "
+        "    NEW.updated_at := now(); "
+        "    IF TG_OP = 'INSERT' THEN "
+        "        DELETE FROM replica_tombstones WHERE table_name = TG_TABLE_NAME AND row_id = NEW.id; "
+        "    END IF; "
+        "    RETURN NEW; "
+        "END; "
+        "$$ LANGUAGE plpgsql",
+        "CREATE OR REPLACE FUNCTION etykiety_replica_tombstone() RETURNS trigger AS $$ "
+        "BEGIN "
+        "    INSERT INTO replica_tombstones (table_name, row_id) VALUES (TG_TABLE_NAME, OLD.id) "
+        "    ON CONFLICT (table_name, row_id) DO UPDATE SET deleted_at = now(); "
+        "    RETURN NULL; "
+        "END; "
+        "$$ LANGUAGE plpgsql",
+        QString("DELETE FROM replica_tombstones WHERE deleted_at < now() - INTERVAL '%1 days'")
+            .arg(TOMBSTONE_RETENTION_DAYS),
+    };
+    for (const QString& sql : statements) {
+        if (!q.exec(sql)) {
+            qWarning() << "[Replika] Nie można przygotować serwera:" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+    }
+
+    for (const QString& table : tables()) {
+        if (!serverSchema.hasTable(table)) continue;
+        if (!serverSchema.hasColumn(table, "updated_at")
+            && !q.exec(QString("ALTER TABLE %1 ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now()").arg(table))) {
+            qWarning() << "[Replika] Nie można dodać kolumny updated_at do" << table << ":" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+        if (!q.exec(QString("CREATE INDEX IF NOT EXISTS idx_%1_updated_at ON %1 (updated_at)").arg(table))) {
+            qWarning() << "[Replika] Nie można utworzyć indeksu updated_at dla" << table << ":" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+        const QList<QPair<QString, QString>> triggers = {
+            {QString("etykiety_replica_touch_%1").arg(table),
+             QString("BEFORE INSERT OR UPDATE ON %1 FOR EACH ROW EXECUTE FUNCTION etykiety_replica_touch()").arg(table)},
+            {QString("etykiety_replica_tombstone_%1").arg(table),
+             QString("AFTER DELETE ON %1 FOR EACH ROW EXECUTE FUNCTION etykiety_replica_tombstone()").arg(table)},
+        };
+        for (const auto& trigger : triggers) {
+            q.prepare("SELECT 1 FROM pg_trigger WHERE tgname = ?");
+            q.addBindValue(trigger.first);
+            if (q.exec() && q.next()) continue;
+            if (!q.exec(QString("CREATE TRIGGER %1 %2").arg(trigger.first, trigger.second))) {
+                qWarning() << "[Replika] Nie można utworzyć triggera" << trigger.first << ":" << q.lastError().text();
+                reportError(q, error);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::prepare(const QSqlDatabase& replica, const SchemaCatalog& serverSchema, QSqlError* error) {
+    QSqlQuery q(replica);
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS replica_state (table_name TEXT PRIMARY KEY, watermark TEXT)",
+        "CREATE TABLE IF NOT EXISTS pending_writes ("
+        "seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "table_name TEXT NOT NULL, "
+        "operation TEXT NOT NULL, "
+        "row_id INTEGER NOT NULL, "
+        "base_updated_at TEXT, "
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)",
+        "CREATE TABLE IF NOT EXISTS replica_id_map ("
+        "table_name TEXT NOT NULL, "
+        "local_id INTEGER NOT NULL, "
+        "server_id INTEGER NOT NULL, "
+        "PRIMARY KEY (table_name, local_id))",
+        "CREATE TABLE IF NOT EXISTS replica_conflicts ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "table_name TEXT NOT NULL, "
+        "row_id INTEGER NOT NULL, "
+        "operation TEXT NOT NULL, "
+        "message TEXT, "
+        "local_row TEXT, "
+        "detected_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)",
+        "CREATE TABLE IF NOT EXISTS schema_migrations ("
+        "name TEXT PRIMARY KEY, "
+        "applied_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)",
+    };
+    for (const QString& sql : statements) {
+        if (!q.exec(sql)) {
+            qWarning() << "[Replika] Nie można utworzyć tabel kopii:" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+    }
+    if (!NumberingService::createTable(replica, error)) return false;
+
+    SchemaCatalog local;
+    local.load(replica);
+    for (const QString& table : tables()) {
+        if (!serverSchema.hasTable(table)) continue;
+        QStringList sql;
+        if (!local.hasTable(table)) {
+            // AUTOINCREMENT - id wierszy usuniętych bez serwera nie wracają
+            QStringList definitions = {"id INTEGER PRIMARY KEY AUTOINCREMENT"};
+            for (const QString& column : serverColumns(serverSchema, table).mid(1)) {
+                definitions << column + " " + localType(serverSchema.columnType(table, column));
+            }
+            sql << QString("CREATE TABLE %1 (%2)").arg(table, definitions.join(", "));
+        } else {
+            for (const QString& column : serverColumns(serverSchema, table).mid(1)) {
+                if (local.hasColumn(table, column)) continue;
+                sql << QString("ALTER TABLE %1 ADD COLUMN %2 %3")
+                           .arg(table, column, localType(serverSchema.columnType(table, column)));
+            }
+        }
+        for (const QString& statement : sql) {
+            if (!q.exec(statement)) {
+                qWarning() << "[Replika] Nie można przygotować tabeli" << table << ":" << q.lastError().text();
+                reportError(q, error);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::isInitialized(const QSqlDatabase& replica) {
+    QSqlQuery q(replica);
+    return q.exec(QString("SELECT 1 FROM replica_state WHERE table_name = '%1'").arg(TOMBSTONES)) && q.next();
+}
+
+int LocalReplica::pendingCount(const QSqlDatabase& replica) {
+    QSqlQuery q(replica);
+    if (!q.exec("SELECT COUNT(*) FROM pending_writes") || !q.next()) return 0;
+    return q.value(0).toInt();
+}
+
+QString LocalReplica::watermark(const QSqlDatabase& replica, const QString& table) {
+    QSqlQuery q(replica);
+    q.prepare("SELECT watermark FROM replica_state WHERE table_name = ?");
+    q.addBindValue(table);
+    if (!q.exec() || !q.next()) return QString();
+    return q.value(0).toString();
+}
+
+bool LocalReplica::beginOffline(const QSqlDatabase& replica, QSqlError* error) {
+    QSqlQuery q(replica);
+    const QList<QPair<QString, QString>> operations = {
+        {"INSERT", "'I', NEW.id, NULL"},
+        {"UPDATE", "'U', OLD.id, OLD.updated_at"},
+        {"DELETE", "'D', OLD.id, OLD.updated_at"},
+    };
+    for (const QString& table : tables()) {
+        for (const auto& operation : operations) {
+            const QString sql = QString("CREATE TRIGGER IF NOT EXISTS replica_pending_%1_%2 AFTER %3 ON %1 BEGIN "
+                                        "INSERT INTO pending_writes (table_name, operation, row_id, base_updated_at) "
+                                        "VALUES ('%1', %4); END")
+                                    .arg(table, operation.first.toLower(), operation.first, operation.second);
+            if (!q.exec(sql)) {
+                qWarning() << "[Replika] Nie można utworzyć triggera kolejki dla" << table << ":" << q.lastError().text();
+                reportError(q, error);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::dropPendingTriggers(const QSqlDatabase& replica, QSqlError* error) {
+    QSqlQuery q(replica);
+    for (const QString& table : tables()) {
+        for (const QString operation : {"insert", "update", "delete"}) {
+            if (!q.exec(QString("DROP TRIGGER IF EXISTS replica_pending_%1_%2").arg(table, operation))) {
+                reportError(q, error);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::replay(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                          ReplicaSyncStats& stats, QSqlError* error) {
+    SchemaCatalog local;
+    local.load(replica);
+    if (!local.hasTable("pending_writes")) return true;
+
+    // Kolejne zmiany tego samego wiersza wysyłamy raz - jego bieżący stan, w miejscu ostatniej zmiany
+    QVector<PendingWrite> writes;
+    {
+        QSqlQuery q(replica);
+        q.setForwardOnly(true);
+        if (!q.exec("SELECT table_name, operation, row_id, base_updated_at, seq FROM pending_writes ORDER BY seq")) {
+            qWarning() << "[Replika] Błąd odczytu kolejki zapisów:" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+        QHash<QString, int> seen;
+        while (q.next()) {
+            PendingWrite write;
+            write.table = q.value(0).toString();
+            write.operation = q.value(1).toString();
+            write.rowId = q.value(2).toInt();
+            write.baseUpdatedAt = q.value(3).toString();
+            write.lastSeq = q.value(4).toLongLong();
+            const QString key = write.table + '/' + QString::number(write.rowId);
+            if (seen.contains(key)) {
+                writes[seen.value(key)].lastSeq = write.lastSeq;
+                continue;
+            }
+            seen.insert(key, writes.size());
+            writes.append(write);
+        }
+    }
+    std::stable_sort(writes.begin(), writes.end(), [](const PendingWrite& a, const PendingWrite& b) {
+        return a.lastSeq < b.lastSeq;
+    });
+
+    // Wiersze dodane bez serwera; klucz obcy wskazujący na taki wiersz czeka, aż rodzic dostanie id z serwera
+    QHash<QString, QHash<int, int>> pendingInserts;
+    for (int i = 0; i < writes.size(); ++i) {
+        if (writes.at(i).operation == QLatin1String("I")) pendingInserts[writes.at(i).table].insert(writes.at(i).rowId, i);
+    }
+
+    // id wierszy dodanych bez serwera -> id nadane przez serwer (także z przerwanej wcześniej wysyłki)
+    QHash<QString, QHash<int, int>> serverIds;
+    {
+        QSqlQuery q(replica);
+        if (q.exec("SELECT table_name, local_id, server_id FROM replica_id_map")) {
+            while (q.next()) serverIds[q.value(0).toString()].insert(q.value(1).toInt(), q.value(2).toInt());
+        }
+    }
+
+    auto removeFromQueue = [&](const PendingWrite& write) {
+        QSqlQuery lq(replica);
+        lq.prepare("DELETE FROM pending_writes WHERE table_name = ? AND row_id = ?");
+        lq.addBindValue(write.table);
+        lq.addBindValue(write.rowId);
+        if (!lq.exec()) {
+            qWarning() << "[Replika] Nie można usunąć zapisu z kolejki:" << lq.lastError().text();
+            reportError(lq, error);
+            return false;
+        }
+        return true;
+    };
+    // Wersja z serwera zastąpi całą kopię przy najbliższym pobraniu
+    auto reject = [&](const PendingWrite& write, const QVariantMap& row, const QString& message) {
+        // Bez zapisanego konfliktu lokalna wersja przepadłaby bez śladu - zapis zostaje w kolejce
+        if (!recordConflict(replica, write, row, message, error)) return false;
+        ++stats.conflicts;
+        QSqlQuery lq(replica);
+        if (!lq.exec("DELETE FROM replica_state")) {
+            qWarning() << "[Replika] Nie można wyczyścić znaczników pobierania:" << lq.lastError().text();
+            reportError(lq, error);
+            return false;
+        }
+        return removeFromQueue(write);
+    };
+
+    enum State { Waiting, Sending, Sent, Rejected };
+    QVector<State> states(writes.size(), Waiting);
+    // false - błąd połączenia albo kopii, niewysłana reszta kolejki zostaje
+    std::function<bool(int)> send = [&](int index) -> bool {
+        const PendingWrite& write = writes.at(index);
+        states[index] = Sending;
+        const QStringList columns = writableColumns(local, serverSchema, write.table);
+        QVariantMap row;
+        if (columns.isEmpty()) {
+            states[index] = Rejected;
+            return reject(write, row, "Brak tabeli na serwerze");
+        }
+        QSqlQuery lq(replica);
+        lq.prepare(QString("SELECT %1 FROM %2 WHERE id = ?").arg(columns.join(", "), write.table));
+        lq.addBindValue(write.rowId);
+        if (!lq.exec()) {
+            qWarning() << "[Replika] Błąd odczytu wiersza" << write.table << write.rowId << ":" << lq.lastError().text();
+            reportError(lq, error);
+            return false;
+        }
+        const bool exists = lq.next();
+        if (exists) {
+            for (int i = 0; i < columns.size(); ++i) row.insert(columns.at(i), lq.value(i));
+            for (const ForeignKey& key : FOREIGN_KEYS) {
+                if (write.table != QLatin1String(key.table) || row.value(key.column).isNull()) continue;
+                const int parentId = row.value(key.column).toInt();
+                // Rodzic dodany bez serwera wysyłany jest przed wierszem, który na niego wskazuje
+                const int parent = pendingInserts.value(key.parent).value(parentId, -1);
+                if (parent >= 0 && states.at(parent) == Waiting && !send(parent)) return false;
+                if (serverIds.value(key.parent).contains(parentId)) {
+                    row.insert(key.column, serverIds.value(key.parent).value(parentId));
+                } else if (parent >= 0) {
+                    // Bez id z serwera wiersz trafiłby do innego rodzica albo naruszył klucz obcy
+                    states[index] = Rejected;
+                    return reject(write, row, QString("Wiersz nadrzędny %1 %2 nie został zapisany na serwerze")
+                                                  .arg(key.parent).arg(parentId));
+                }
+            }
+        }
+
+        QSqlQuery sq(server);
+        bool ok = true;
+        QString conflict;
+        if (write.operation == QLatin1String("I")) {
+            // Wiersz dodany i usunięty bez serwera - nie ma czego wysyłać
+            if (exists) {
+                if (!ensureFreeNumbers(server, write.table, row, stats, error)) return false;
+                sq.prepare(QString("INSERT INTO %1 (%2) VALUES (%3) RETURNING id")
+                               .arg(write.table, columns.join(", "), placeholders(columns.size())));
+                for (const QString& column : columns) sq.addBindValue(row.value(column));
+                ok = sq.exec() && sq.next();
+                if (ok) {
+                    const int serverId = sq.value(0).toInt();
+                    serverIds[write.table].insert(write.rowId, serverId);
+                    lq.prepare("INSERT OR REPLACE INTO replica_id_map (table_name, local_id, server_id) VALUES (?, ?, ?)");
+                    lq.addBindValue(write.table);
+                    lq.addBindValue(write.rowId);
+                    lq.addBindValue(serverId);
+                    if (!lq.exec()) {
+                        qWarning() << "[Replika] Nie można zapisać id z serwera dla" << write.table << write.rowId << ":"
+                                   << lq.lastError().text();
+                        reportError(lq, error);
+                        return false;
+                    }
+                }
+            }
+        } else if (exists) {
+            QStringList assignments;
+            for (const QString& column : columns) assignments << column + " = ?";
+            sq.prepare(QString("UPDATE %1 SET %2 WHERE id = ? AND updated_at = CAST(? AS TIMESTAMPTZ)")
+                           .arg(write.table, assignments.join(", ")));
+            for (const QString& column : columns) sq.addBindValue(row.value(column));
+            sq.addBindValue(write.rowId);
+            sq.addBindValue(write.baseUpdatedAt);
+            ok = sq.exec();
+            if (ok && sq.numRowsAffected() == 0) conflict = "Wiersz zmieniony lub usunięty na serwerze";
+        } else {
+            sq.prepare(QString("DELETE FROM %1 WHERE id = ? AND updated_at = CAST(? AS TIMESTAMPTZ)").arg(write.table));
+            sq.addBindValue(write.rowId);
+            sq.addBindValue(write.baseUpdatedAt);
+            ok = sq.exec();
+            if (ok && sq.numRowsAffected() == 0) {
+                // Usunięty także na serwerze - to nie konflikt
+                sq.prepare(QString("SELECT 1 FROM %1 WHERE id = ?").arg(write.table));
+                sq.addBindValue(write.rowId);
+                ok = sq.exec();
+                if (ok && sq.next()) conflict = "Wiersz zmieniony na serwerze";
+            }
+        }
+        if (!ok) {
+            if (sq.lastError().type() == QSqlError::ConnectionError) {
+                qWarning() << "[Replika] Utracono połączenie z serwerem podczas wysyłania kolejki:" << sq.lastError().text();
+                reportError(sq, error);
+                return false;
+            }
+            conflict = sq.lastError().text();
+        }
+        if (!conflict.isEmpty()) {
+            states[index] = Rejected;
+            return reject(write, row, conflict);
+        }
+        states[index] = Sent;
+        ++stats.replayed;
+        return removeFromQueue(write);
+    };
+    for (int i = 0; i < writes.size(); ++i) {
+        if (states.at(i) == Waiting && !send(i)) return false;
+    }
+
+    // Kolejka pusta: bez triggerów kolejki usuwamy wiersze dodane bez serwera -
+    // wrócą z id (i ewentualnie nowym numerem) serwera przy pobraniu
+    if (!dropPendingTriggers(replica, error)) return false;
+    QSqlQuery lq(replica);
+    for (auto it = serverIds.constBegin(); it != serverIds.constEnd(); ++it) {
+        for (int localId : it.value().keys()) {
+            lq.prepare(QString("DELETE FROM %1 WHERE id = ?").arg(it.key()));
+            lq.addBindValue(localId);
+            if (!lq.exec()) {
+                qWarning() << "[Replika] Nie można usunąć lokalnego wiersza" << it.key() << localId << ":" << lq.lastError().text();
+                reportError(lq, error);
+                return false;
+            }
+        }
+    }
+    if (!lq.exec("DELETE FROM replica_id_map")) {
+        reportError(lq, error);
+        return false;
+    }
+    return true;
+}
+
+bool LocalReplica::pull(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                        ReplicaSyncStats& stats, QSqlError* error) {
+    if (!prepare(replica, serverSchema, error)) return false;
+    if (pendingCount(replica) > 0) {
+        qWarning() << "[Replika] Kolejka zapisów nie jest pusta - pobieranie wstrzymane";
+        return true;
+    }
+
+    QSqlQuery sq(server);
+    if (!sq.exec("SELECT CAST(now() AS TEXT)") || !sq.next()) {
+        reportError(sq, error);
+        return false;
+    }
+    const QString startedAt = sq.value(0).toString();
+
+    // Kopia starsza niż przechowywane usunięcia nie wie, co zniknęło - od nowa
+    QString since = watermark(replica, TOMBSTONES);
+    if (!since.isEmpty()) {
+        sq.prepare(QString("SELECT CAST(? AS TIMESTAMPTZ) < now() - INTERVAL '%1 days'").arg(TOMBSTONE_RETENTION_DAYS));
+        sq.addBindValue(since);
+        if (!sq.exec() || !sq.next()) {
+            reportError(sq, error);
+            return false;
+        }
+        if (sq.value(0).toBool()) since.clear();
+    }
+    QSqlQuery lq(replica);
+    if (since.isEmpty() && !lq.exec("DELETE FROM replica_state")) {
+        reportError(lq, error);
+        return false;
+    }
+
+    for (const QString& table : tables()) {
+        if (!serverSchema.hasTable(table)) continue;
+        if (!serverSchema.hasColumn(table, "updated_at")) {
+            qWarning() << "[Replika] Tabela" << table << "na serwerze nie ma kolumny updated_at - pominięta";
+            continue;
+        }
+        if (!pullTable(replica, server, serverSchema, table, watermark(replica, table), startedAt, stats, error)) {
+            return false;
+        }
+    }
+    for (const QString table : {"schema_migrations", "number_sequences"}) {
+        if (serverSchema.hasTable(table) && !copyTable(replica, server, serverSchema, table, error)) return false;
+    }
+    if (!since.isEmpty() && !pullTombstones(replica, server, since, stats, error)) return false;
+    return setWatermark(replica, TOMBSTONES, startedAt, error);
+}
+
+bool LocalReplica::pullTable(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                             const QString& table, const QString& since, const QString& startedAt,
+                             ReplicaSyncStats& stats, QSqlError* error) {
+    const QStringList columns = serverColumns(serverSchema, table);
+    QStringList select;
+    QStringList assignments;
+    for (const QString& column : columns) {
+        // Tekst z przesunięciem strefy - bez utraty mikrosekund przy porównaniu w replay()
+        select << (column == QLatin1String("updated_at") ? "CAST(updated_at AS TEXT)" : column);
+        if (column != QLatin1String("id")) assignments << QString("%1 = excluded.%1").arg(column);
+    }
+    QString sql = QString("SELECT %1 FROM %2").arg(select.join(", "), table);
+    if (!since.isEmpty()) {
+        sql += QString(" WHERE updated_at > CAST(? AS TIMESTAMPTZ) - INTERVAL '%1 seconds'").arg(OVERLAP_SECONDS);
+    }
+    QSqlQuery sq(server);
+    sq.setForwardOnly(true);
+    sq.prepare(sql);
+    if (!since.isEmpty()) sq.addBindValue(since);
+    if (!sq.exec()) {
+        qWarning() << "[Replika] Błąd pobierania tabeli" << table << ":" << sq.lastError().text();
+        reportError(sq, error);
+        return false;
+    }
+
+    QSqlDatabase connection = replica;
+    connection.transaction();
+    QSqlQuery lq(connection);
+    if (since.isEmpty() && !lq.exec(QString("DELETE FROM %1").arg(table))) {
+        reportError(lq, error);
+        connection.rollback();
+        return false;
+    }
+    lq.prepare(QString("INSERT INTO %1 (%2) VALUES (%3) ON CONFLICT (id) DO UPDATE SET %4")
+                   .arg(table, columns.join(", "), placeholders(columns.size()), assignments.join(", ")));
+    while (sq.next()) {
+        for (int i = 0; i < columns.size(); ++i) lq.addBindValue(sq.value(i));
+        if (!lq.exec()) {
+            qWarning() << "[Replika] Błąd zapisu wiersza" << table << sq.value(0) << ":" << lq.lastError().text();
+            reportError(lq, error);
+            connection.rollback();
+            return false;
+        }
+        ++stats.pulled;
+    }
+    if (!setWatermark(connection, table, startedAt, error) || !connection.commit()) {
+        connection.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool LocalReplica::pullTombstones(const QSqlDatabase& replica, const QSqlDatabase& server, const QString& since,
+                                  ReplicaSyncStats& stats, QSqlError* error) {
+    QSqlQuery sq(server);
+    sq.setForwardOnly(true);
+    sq.prepare(QString("SELECT table_name, row_id FROM replica_tombstones "
+                       "WHERE deleted_at > CAST(? AS TIMESTAMPTZ) - INTERVAL '%1 seconds'").arg(OVERLAP_SECONDS));
+    sq.addBindValue(since);
+    if (!sq.exec()) {
+        qWarning() << "[Replika] Błąd pobierania usuniętych wierszy:" << sq.lastError().text();
+        reportError(sq, error);
+        return false;
+    }
+    QSqlDatabase connection = replica;
+    connection.transaction();
+    QSqlQuery lq(connection);
+    while (sq.next()) {
+        const QString table = sq.value(0).toString();
+        if (!tables().contains(table)) continue;
+        lq.prepare(QString("DELETE FROM %1 WHERE id = ?").arg(table));
+        lq.addBindValue(sq.value(1).toInt());
+        if (!lq.exec()) {
+            reportError(lq, error);
+            connection.rollback();
+            return false;
+        }
+        stats.removed += lq.numRowsAffected();
+    }
+    return connection.commit();
+}
+
+bool LocalReplica::copyTable(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                             const QString& table, QSqlError* error) {
+    SchemaCatalog local;
+    local.load(replica);
+    QStringList columns;
+    for (const QString& column : serverSchema.columns(table)) {
+        if (local.hasColumn(table, column)) columns << column;
+    }
+    if (columns.isEmpty()) return true;
+
+    QSqlQuery sq(server);
+    sq.setForwardOnly(true);
+    if (!sq.exec(QString("SELECT %1 FROM %2").arg(columns.join(", "), table))) {
+        reportError(sq, error);
+        return false;
+    }
+    QSqlDatabase connection = replica;
+    connection.transaction();
+    QSqlQuery lq(connection);
+    if (!lq.exec(QString("DELETE FROM %1").arg(table))) {
+        reportError(lq, error);
+        connection.rollback();
+        return false;
+    }
+    lq.prepare(QString("INSERT INTO %1 (%2) VALUES (%3)").arg(table, columns.join(", "), placeholders(columns.size())));
+    while (sq.next()) {
+        for (int i = 0; i < columns.size(); ++i) lq.addBindValue(sq.value(i));
+        if (!lq.exec()) {
+            qWarning() << "[Replika] Błąd kopiowania tabeli" << table << ":" << lq.lastError().text();
+            reportError(lq, error);
+            connection.rollback();
+            return false;
+        }
+    }
+    return connection.commit();
+}
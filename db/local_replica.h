@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+#include "schema_catalog.h"
+
+// Liczniki jednej synchronizacji kopii lokalnej
+struct ReplicaSyncStats {
+    int replayed = 0;  // zapisy z kolejki przyjęte przez serwer
+    int conflicts = 0; // zapisy odrzucone - wiersz zmieniony na serwerze, błąd serwera albo rodzic niewysłany
+    int renumbered = 0; // wiersze dodane bez serwera, których numer był już zajęty na serwerze
+    int pulled = 0;    // wiersze pobrane z serwera
+    int removed = 0;   // wiersze usunięte w kopii, bo zniknęły z serwera
+};
+
+/**
+ * @brief Kopia lokalna (plik SQLite) zbioru roboczego bazy PostgreSQL do pracy bez serwera
+ *
+ * Zbiór roboczy to tabele z tables(): zamówienia bez archiwum, klienci z adresami
+ * dostawy, dostawcy, katalog materiałów i zamówienia materiałów. Kopia ma te same
+ * nazwy tabel i kolumn co serwer, więc DbManager bez serwera otwiera ją jako
+ * zwykłą bazę SQLite i wszystkie odczyty działają lokalnie.
+ *
+ * Pobieranie (pull) jest przyrostowe:
+ * - serwer ustawia updated_at przy każdym INSERT/UPDATE (trigger, czas serwera),
+ *   a usunięcia zapisuje w replica_tombstones,
+ * - kopia pamięta w replica_state czas serwera z początku ostatniego pobrania
+ *   i czyta tylko wiersze nowsze od niego (z zakładką OVERLAP_SECONDS na
+ *   transakcje zatwierdzone po odczycie),
+ * - kopia starsza niż przechowywane usunięcia jest pobierana od nowa.
+ *
+ * Praca bez serwera (beginOffline) włącza w kopii triggery, które zapisują każdą
+ * zmianę w kolejce pending_writes. Po powrocie serwera replay() wysyła bieżący
+ * stan każdego zmienionego wiersza w kolejności jego ostatniej zmiany:
+ * - nowe wiersze dostają id z serwera, a klucze obce kolejnych wierszy są
+ *   przepisywane na te id (replica_id_map); rodzic dodany bez serwera jest
+ *   wysyłany przed wierszem, który na niego wskazuje, a wiersz, którego rodzic
+ *   nie trafił na serwer, jest odrzucany zamiast podpiąć się pod obcy wiersz,
+ * - numer zamówienia lub klienta nadany bez serwera (z kopii number_sequences),
+ *   który serwer w tym czasie wydał komuś innemu, jest zastępowany kolejnym
+ *   numerem z ciągu serwera,
+ * - UPDATE/DELETE trafia na serwer tylko wtedy, gdy updated_at wiersza na
+ *   serwerze jest taki sam jak w chwili pobrania do kopii; inaczej to konflikt -
+ *   wygrywa serwer, a wersja lokalna zostaje w replica_conflicts (tak samo
+ *   wiersze odrzucone z innych powodów).
+ * Dopiero po opróżnieniu kolejki kopia znów pobiera dane z serwera.
+ *
+ * Metody nie otwierają transakcji na serwerze - replay() wysyła każdy wiersz osobno.
+ */
+class LocalReplica {
+public:
+    static constexpr const char* CONNECTION_NAME = "replica_conn";
+    static constexpr int OVERLAP_SECONDS = 300;
+    static constexpr int TOMBSTONE_RETENTION_DAYS = 30;
+
+    // Tabele kopii (z kolumną id), w kolejności rodzic przed dzieckiem
+    static const QStringList& tables();
+
+    // PostgreSQL: kolumny updated_at, triggery i tabela replica_tombstones.
+    // Po wywołaniu katalog schematu trzeba wczytać ponownie.
+    static bool installServer(const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                              QSqlError* error = nullptr);
+
+    // Czy kopia ma już dane z serwera (można na niej pracować bez połączenia)
+    static bool isInitialized(const QSqlDatabase& replica);
+    // Od tej chwili zmiany w kopii trafiają do kolejki pending_writes
+    static bool beginOffline(const QSqlDatabase& replica, QSqlError* error = nullptr);
+    static int pendingCount(const QSqlDatabase& replica);
+
+    // Wysyła kolejkę na serwer. false - błąd połączenia, niewysłana reszta kolejki zostaje.
+    static bool replay(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                       ReplicaSyncStats& stats, QSqlError* error = nullptr);
+    // Pobiera zmiany od ostatniego pobrania; nic nie robi, dopóki kolejka nie jest pusta
+    static bool pull(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                     ReplicaSyncStats& stats, QSqlError* error = nullptr);
+
+private:
+    // Tabele pomocnicze kopii oraz brakujące tabele i kolumny zbioru roboczego
+    static bool prepare(const QSqlDatabase& replica, const SchemaCatalog& serverSchema, QSqlError* error);
+    static bool pullTable(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                          const QString& table, const QString& since, const QString& startedAt,
+                          ReplicaSyncStats& stats, QSqlError* error);
+    static bool pullTombstones(const QSqlDatabase& replica, const QSqlDatabase& server, const QString& since,
+                               ReplicaSyncStats& stats, QSqlError* error);
+    // Tabele kopiowane w całości (bez updated_at): schema_migrations, number_sequences
+    static bool copyTable(const QSqlDatabase& replica, const QSqlDatabase& server, const SchemaCatalog& serverSchema,
+                          const QString& table, QSqlError* error);
+    static bool dropPendingTriggers(const QSqlDatabase& replica, QSqlError* error);
+    static QString watermark(const QSqlDatabase& replica, const QString& table);
+};
@@ -0,0 +1,110 @@
+#include "numbering_service.h"
+#include <QMutexLocker>
+#include <QSqlQuery>
+#include <QDebug>
+
+namespace {
+QString blockKey(const QString& name, int year) {
+    return name + '/' + QString::number(year);
+}
+
+void reportError(const QSqlQuery& q, QSqlError* error) {
+    if (error) *error = q.lastError();
+}
+}
+
+bool NumberingService::createTable(const QSqlDatabase& connection, QSqlError* error) {
+    QSqlQuery q(connection);
+    if (!q.exec("CREATE TABLE IF NOT EXISTS number_sequences ("
+                "name TEXT NOT NULL, "
+                "year INTEGER NOT NULL DEFAULT 0, "
+                "last_value BIGINT NOT NULL DEFAULT 0, "
+                "PRIMARY KEY (name, year))")) {
+        qWarning() << "Nie można utworzyć tabeli number_sequences:" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    return true;
+}
+
+bool NumberingService::allocate(const QSqlDatabase& connection, const QString& name, int year, int count,
+                                qint64 startValue, NumberBlock& block, QSqlError* error) {
+    if (count < 1) count = 1;
+    // Jedno zapytanie: nowy ciąg od razu z zarezerwowanym blokiem, istniejący przesunięty o count
+    QSqlQuery q(connection);
+    q.prepare("INSERT INTO number_sequences (name, year, last_value) VALUES (?, ?, ?) "
+              "ON CONFLICT (name, year) DO UPDATE SET last_value = number_sequences.last_value + ? "
+              "RETURNING last_value");
+    q.addBindValue(name);
+    q.addBindValue(year);
+    q.addBindValue(startValue - 1 + count);
+    q.addBindValue(count);
+    if (!q.exec() || !q.next()) {
+        qWarning() << "Nie można przydzielić numeru z ciągu" << name << year << ":" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    block.last = q.value(0).toLongLong();
+    block.first = block.last - count + 1;
+    return true;
+}
+
+bool NumberingService::advanceTo(const QSqlDatabase& connection, const QString& name, int year, qint64 value,
+                                 QSqlError* error) {
+    QSqlQuery q(connection);
+    q.prepare("INSERT INTO number_sequences (name, year, last_value) VALUES (?, ?, ?) "
+              "ON CONFLICT (name, year) DO UPDATE SET last_value = ? WHERE number_sequences.last_value < ?");
+    q.addBindValue(name);
+    q.addBindValue(year);
+    q.addBindValue(value);
+    q.addBindValue(value);
+    q.addBindValue(value);
+    if (!q.exec()) {
+        qWarning() << "Nie można przesunąć ciągu" << name << year << ":" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    return true;
+}
+
+qint64 NumberingService::lastValue(const QSqlDatabase& connection, const QString& name, int year) {
+    QSqlQuery q(connection);
+    q.prepare("SELECT last_value FROM number_sequences WHERE name = ? AND year = ?");
+    q.addBindValue(name);
+    q.addBindValue(year);
+    if (q.exec() && q.next()) return q.value(0).toLongLong();
+    return 0;
+}
+
+bool NumberingService::next(const QSqlDatabase& connection, const QString& name, int year, qint64 startValue,
+                            qint64& value) {
+    QMutexLocker locker(&m_mutex);
+    NumberBlock& block = m_blocks[blockKey(name, year)];
+    if (block.isEmpty()) {
+        NumberBlock allocated;
+        if (!allocate(connection, name, year, m_blockSize, startValue, allocated, &m_lastError)) return false;
+        block = allocated;
+    }
+    value = block.first++;
+    return true;
+}
+
+void NumberingService::setBlockSize(int blockSize) {
+    QMutexLocker locker(&m_mutex);
+    m_blockSize = qMax(1, blockSize);
+}
+
+int NumberingService::blockSize() const {
+    QMutexLocker locker(&m_mutex);
+    return m_blockSize;
+}
+
+void NumberingService::discardBlocks() {
+    QMutexLocker locker(&m_mutex);
+    m_blocks.clear();
+}
+
+QSqlError NumberingService::lastError() const {
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
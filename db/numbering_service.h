@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+
+// Przedział numerów [first, last] przydzielony jednym zapytaniem
+struct NumberBlock {
+    qint64 first = 0;
+    qint64 last = -1;
+
+    bool isEmpty() const { return first > last; }
+};
+
+/**
+ * @brief Numeracja zamówień, zamówień materiałów i klientów (tabela number_sequences)
+ *
+ * Każdy ciąg to wiersz (name, year, last_value). Numer przydziela jedno
+ * zapytanie INSERT ... ON CONFLICT DO UPDATE ... RETURNING - tak samo na
+ * PostgreSQL i SQLite (3.35+), bez SELECT ... FOR UPDATE i bez szukania
+ * wolnego numeru w pętli. Dwa stanowiska nigdy nie dostaną tego samego numeru.
+ *
+ * Ciągi z rokiem w prefiksie (ZAM-YYYY-, MO-YYYY-) mają osobny wiersz na każdy
+ * rok; numeracja klientów jest wspólna (year = 0).
+ *
+ * Przy blockSize > 1 stanowisko pobiera od razu blok numerów i wydaje je
+ * z pamięci. Numery niewykorzystane do zamknięcia programu przepadają,
+ * a kolejność numerów między stanowiskami przestaje być ściśle rosnąca.
+ *
+ * Numer przydzielony w otwartej transakcji blokuje wiersz ciągu (PostgreSQL)
+ * do jej zakończenia - dlatego numer warto pobrać przed transakcją zapisu.
+ */
+class NumberingService {
+public:
+    static constexpr const char* ORDERS = "orders";
+    static constexpr const char* MATERIALS_ORDERS = "materials_orders";
+    static constexpr const char* CLIENTS = "clients";
+
+    static bool createTable(const QSqlDatabase& connection, QSqlError* error = nullptr);
+
+    // Rezerwuje count kolejnych numerów. Ciąg, którego jeszcze nie ma, zaczyna się od startValue.
+    static bool allocate(const QSqlDatabase& connection, const QString& name, int year, int count,
+                         qint64 startValue, NumberBlock& block, QSqlError* error = nullptr);
+    // Przesuwa ciąg tak, by kolejny numer był większy niż value (numery nadane ręcznie, dane sprzed migracji)
+    static bool advanceTo(const QSqlDatabase& connection, const QString& name, int year, qint64 value,
+                          QSqlError* error = nullptr);
+    // Ostatnio przydzielony numer (0, gdy ciąg nie istnieje)
+    static qint64 lastValue(const QSqlDatabase& connection, const QString& name, int year);
+
+    // Kolejny numer z bloku stanowiska; gdy blok się skończy, pobiera następny
+    bool next(const QSqlDatabase& connection, const QString& name, int year, qint64 startValue, qint64& value);
+    void setBlockSize(int blockSize);
+    int blockSize() const;
+    // Porzuca bloki w pamięci (np. po zmianie bazy danych)
+    void discardBlocks();
+    QSqlError lastError() const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, NumberBlock> m_blocks; // klucz: name/year
+    int m_blockSize = 1;
+    QSqlError m_lastError;
+};
@@ -0,0 +1,133 @@
+#include "order_archive.h"
+#include <QSqlQuery>
+#include <QDebug>
+#include <algorithm>
+#include "models/order.h"
+
+namespace {
+void reportError(const QSqlQuery& q, QSqlError* error) {
+    if (error) *error = q.lastError();
+}
+
+QString placeholders(int count) {
+    return QStringList(count, "?").join(", ");
+}
+}
+
+bool OrderArchive::install(const QSqlDatabase& connection, const SchemaCatalog& schema, QSqlError* error) {
+    QSqlQuery q(connection);
+    const QList<QPair<QString, QString>> tables = {{"orders", ORDERS}, {"order_items", ORDER_ITEMS}};
+    for (const auto& table : tables) {
+        if (!schema.hasTable(table.second)) {
+            // Pusta kopia struktury; archived_at tylko w archiwum zamówień
+            if (!q.exec(QString("CREATE TABLE %1 AS SELECT * FROM %2 WHERE 1 = 0").arg(table.second, table.first))
+                || (table.second == QLatin1String(ORDERS)
+                    && !q.exec(QString("ALTER TABLE %1 ADD COLUMN archived_at TIMESTAMP").arg(table.second)))) {
+                qWarning() << "[Archiwum] Nie można utworzyć tabeli" << table.second << ":" << q.lastError().text();
+                reportError(q, error);
+                return false;
+            }
+            continue;
+        }
+        for (const QString& column : schema.columns(table.first)) {
+            if (schema.hasColumn(table.second, column)) continue;
+            QString type = schema.columnType(table.first, column);
+            if (type.isEmpty()) type = "TEXT";
+            if (!q.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table.second, column, type))) {
+                qWarning() << "[Archiwum] Nie można dodać kolumny" << column << "do" << table.second << ":" << q.lastError().text();
+                reportError(q, error);
+                return false;
+            }
+        }
+    }
+    const QStringList indexes = {
+        QString("CREATE UNIQUE INDEX IF NOT EXISTS idx_orders_archive_id ON %1 (id)").arg(ORDERS),
+        QString("CREATE INDEX IF NOT EXISTS idx_orders_archive_order_number ON %1 (order_number)").arg(ORDERS),
+        QString("CREATE INDEX IF NOT EXISTS idx_order_items_archive_order_id ON %1 (order_id)").arg(ORDER_ITEMS),
+    };
+    for (const QString& sql : indexes) {
+        if (!q.exec(sql)) {
+            qWarning() << "[Archiwum] Nie można utworzyć indeksu:" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+    }
+    return true;
+}
+
+QStringList OrderArchive::sharedColumns(const SchemaCatalog& schema, const QString& from, const QString& to) {
+    QStringList columns;
+    for (const QString& column : schema.columns(from)) {
+        if (schema.hasColumn(to, column)) columns << column;
+    }
+    std::sort(columns.begin(), columns.end());
+    return columns;
+}
+
+bool OrderArchive::move(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& from,
+                        const QString& to, const QString& idColumn, const QVector<int>& ids, QSqlError* error) {
+    const QStringList columns = sharedColumns(schema, from, to);
+    if (columns.isEmpty()) {
+        qWarning() << "[Archiwum] Brak wspólnych kolumn tabel" << from << "i" << to;
+        return false;
+    }
+    const QString list = columns.join(", ");
+    QString insert = QString("INSERT INTO %1 (%2) SELECT %2 FROM %3 WHERE %4 IN (%5)")
+                         .arg(to, list, from, idColumn, placeholders(ids.size()));
+    if (to == QLatin1String(ORDERS)) {
+        insert = QString("INSERT INTO %1 (%2, archived_at) SELECT %2, CURRENT_TIMESTAMP FROM %3 WHERE %4 IN (%5)")
+                     .arg(to, list, from, idColumn, placeholders(ids.size()));
+    }
+    const QString remove = QString("DELETE FROM %1 WHERE %2 IN (%3)").arg(from, idColumn, placeholders(ids.size()));
+
+    QSqlQuery q(connection);
+    for (const QString& sql : {insert, remove}) {
+        q.prepare(sql);
+        for (int id : ids) q.addBindValue(id);
+        if (!q.exec()) {
+            qWarning() << "[Archiwum] Błąd przenoszenia z" << from << "do" << to << ":" << q.lastError().text();
+            reportError(q, error);
+            return false;
+        }
+    }
+    return true;
+}
+
+int OrderArchive::archiveBatch(const QSqlDatabase& connection, const SchemaCatalog& schema, const QDate& before,
+                               int limit, QSqlError* error) {
+    QSqlQuery q(connection);
+    q.prepare("SELECT id FROM orders WHERE status = ? AND COALESCE(delivery_date, order_date) < ? ORDER BY id LIMIT ?");
+    q.addBindValue(static_cast<int>(Order::Zrealizowane));
+    q.addBindValue(before);
+    q.addBindValue(qMax(1, limit));
+    if (!q.exec()) {
+        qWarning() << "[Archiwum] Błąd wyboru zamówień do archiwum:" << q.lastError().text();
+        reportError(q, error);
+        return -1;
+    }
+    QVector<int> ids;
+    while (q.next()) ids.append(q.value(0).toInt());
+    if (ids.isEmpty()) return 0;
+
+    // Najpierw pozycje - klucz obcy order_items.order_id wskazuje na orders
+    if (!move(connection, schema, "order_items", ORDER_ITEMS, "order_id", ids, error)
+        || !move(connection, schema, "orders", ORDERS, "id", ids, error)) {
+        return -1;
+    }
+    return ids.size();
+}
+
+bool OrderArchive::restore(const QSqlDatabase& connection, const SchemaCatalog& schema, int orderId,
+                           QSqlError* error) {
+    QSqlQuery q(connection);
+    q.prepare(QString("SELECT 1 FROM %1 WHERE id = ?").arg(ORDERS));
+    q.addBindValue(orderId);
+    if (!q.exec() || !q.next()) {
+        qWarning() << "[Archiwum] Brak zamówienia" << orderId << "w archiwum" << q.lastError().text();
+        reportError(q, error);
+        return false;
+    }
+    const QVector<int> ids = {orderId};
+    return move(connection, schema, ORDERS, "orders", "id", ids, error)
+        && move(connection, schema, ORDER_ITEMS, "order_items", "order_id", ids, error);
+}
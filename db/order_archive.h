@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QDate>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "schema_catalog.h"
+
+/**
+ * @brief Archiwum zrealizowanych zamówień (tabele orders_archive, order_items_archive)
+ *
+ * Zamówienia o statusie Zrealizowane starsze niż ustawiony wiek są przenoszone
+ * z orders/order_items do tabel archiwum - z tymi samymi id, więc numery,
+ * powiązania pozycji i ChangeFeed działają bez zmian. Listy, dashboard
+ * i zestawienia czytają tylko tabele bieżące; archiwum przeszukuje się
+ * jawnie (OrdersDbView - "Uwzględnij archiwum").
+ *
+ * Tabele archiwum mają kolumny tabel źródłowych (CREATE TABLE ... AS SELECT),
+ * a kolumny dodane później do orders/order_items są dopisywane przy starcie.
+ * Przenoszone są tylko kolumny wspólne obu tabel (według SchemaCatalog).
+ *
+ * Metody nie otwierają transakcji - wywołujący odpowiada za commit/rollback.
+ */
+class OrderArchive {
+public:
+    static constexpr const char* ORDERS = "orders_archive";
+    static constexpr const char* ORDER_ITEMS = "order_items_archive";
+
+    // Tworzy brakujące tabele archiwum i indeksy oraz dopisuje brakujące kolumny.
+    // Po wywołaniu katalog schematu trzeba wczytać ponownie.
+    static bool install(const QSqlDatabase& connection, const SchemaCatalog& schema, QSqlError* error = nullptr);
+
+    // Przenosi do limit zrealizowanych zamówień z datą dostawy (bez niej - datą
+    // zamówienia) wcześniejszą niż before. Zwraca liczbę przeniesionych zamówień, -1 przy błędzie.
+    static int archiveBatch(const QSqlDatabase& connection, const SchemaCatalog& schema, const QDate& before,
+                            int limit, QSqlError* error = nullptr);
+    // Przenosi zamówienie z pozycjami z powrotem do orders/order_items
+    static bool restore(const QSqlDatabase& connection, const SchemaCatalog& schema, int orderId,
+                        QSqlError* error = nullptr);
+
+private:
+    // Kolumny tabeli źródłowej, które są też w tabeli docelowej
+    static QStringList sharedColumns(const SchemaCatalog& schema, const QString& from, const QString& to);
+    static bool move(const QSqlDatabase& connection, const SchemaCatalog& schema, const QString& from,
+                     const QString& to, const QString& idColumn, const QVector<int>& ids, QSqlError* error);
+};
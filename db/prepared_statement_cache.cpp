@@ -0,0 +1,46 @@
+#include "prepared_statement_cache.h"
+#include <QSqlError>
+#include <QDebug>
+
+PreparedStatementCache::PreparedStatementCache(const QSqlDatabase& connection, int maxStatements)
+    : m_connection(connection), m_cache(qMax(1, maxStatements)) {
+}
+
+std::shared_ptr<QSqlQuery> PreparedStatementCache::acquire(const QString& sql) {
+    std::shared_ptr<Entry> entry;
+    if (std::shared_ptr<Entry>* cached = m_cache.object(sql)) {
+        entry = *cached;
+    }
+
+    if (entry && !entry->inUse) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        auto fresh = std::make_shared<Entry>(m_connection);
+        fresh->query.setForwardOnly(true);
+        bool prepared = fresh->query.prepare(sql);
+        if (!prepared) {
+            qWarning() << "[PreparedStatementCache] Błąd przygotowania zapytania:" << fresh->query.lastError().text();
+        }
+        // To samo zapytanie jest już w użyciu (np. zagnieżdżone wywołanie) albo
+        // prepare() się nie udał - zwracamy zapytanie spoza cache
+        if (entry || !prepared) {
+            return std::shared_ptr<QSqlQuery>(fresh, &fresh->query);
+        }
+        entry = fresh;
+        m_cache.insert(sql, new std::shared_ptr<Entry>(entry));
+        m_size.store(m_cache.size(), std::memory_order_relaxed);
+    }
+
+    entry->inUse = true;
+    // Uchwyt trzyma wpis przy życiu także po wyrzuceniu go z LRU
+    return std::shared_ptr<QSqlQuery>(&entry->query, [entry](QSqlQuery* query) {
+        query->finish();
+        entry->inUse = false;
+    });
+}
+
+void PreparedStatementCache::clear() {
+    m_cache.clear();
+    m_size.store(0, std::memory_order_relaxed);
+}
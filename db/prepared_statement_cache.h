@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QCache>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+// Liczniki cache zapytań (sumowane po wszystkich połączeniach w DbManager)
+struct StatementCacheStats {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    int cachedStatements = 0;
+    int connections = 0;
+};
+
+/**
+ * @brief Cache przygotowanych zapytań dla jednego połączenia
+ *
+ * Kluczem jest tekst SQL, rozmiar ograniczony jest przez LRU (QCache). Obiekt
+ * musi być używany wyłącznie w wątku, do którego należy połączenie; liczniki
+ * można odczytywać z dowolnego wątku.
+ *
+ * acquire() zwraca uchwyt do przygotowanego zapytania. Po zwolnieniu uchwytu
+ * zapytanie jest kończone (finish()), żeby nie trzymać otwartego kursora -
+ * w SQLite niezakończony SELECT blokuje zapisy z innych połączeń.
+ */
+class PreparedStatementCache {
+public:
+    explicit PreparedStatementCache(const QSqlDatabase& connection, int maxStatements = 64);
+
+    PreparedStatementCache(const PreparedStatementCache&) = delete;
+    PreparedStatementCache& operator=(const PreparedStatementCache&) = delete;
+
+    std::shared_ptr<QSqlQuery> acquire(const QString& sql);
+    void clear();
+
+    quint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    quint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+    int size() const { return m_size.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        QSqlQuery query;
+        bool inUse = false;
+        explicit Entry(const QSqlDatabase& db) : query(db) {}
+    };
+
+    QSqlDatabase m_connection;
+    QCache<QString, std::shared_ptr<Entry>> m_cache;
+    std::atomic<quint64> m_hits{0};
+    std::atomic<quint64> m_misses{0};
+    std::atomic<int> m_size{0};
+};
@@ -0,0 +1,63 @@
+#include "row_diff.h"
+#include <QSet>
+#include <QtMath>
+#include <algorithm>
+
+namespace RowDiff {
+
+namespace {
+bool isNumeric(const QVariant& value) {
+    switch (value.typeId()) {
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::Int:
+    case QMetaType::LongLong:
+    case QMetaType::UInt:
+    case QMetaType::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool sameRow(const QVariantList& stored, const QVariantList& values) {
+    if (stored.size() != values.size()) return false;
+    for (int i = 0; i < values.size(); ++i) {
+        if (!sameValue(stored.at(i), values.at(i))) return false;
+    }
+    return true;
+}
+}
+
+bool sameValue(const QVariant& stored, const QVariant& value) {
+    const bool storedEmpty = stored.isNull() || (stored.typeId() == QMetaType::QString && stored.toString().isEmpty());
+    const bool valueEmpty = value.isNull() || (value.typeId() == QMetaType::QString && value.toString().isEmpty());
+    if (storedEmpty || valueEmpty) return storedEmpty == valueEmpty;
+    if (isNumeric(stored) && isNumeric(value)) {
+        // Kolumny *_value: REAL / DOUBLE PRECISION po drodze przez bazę
+        return qFuzzyCompare(stored.toDouble() + 1.0, value.toDouble() + 1.0);
+    }
+    return stored.toString() == value.toString();
+}
+
+RowDiffPlan plan(const QHash<int, QVariantList>& existing, const QVector<QPair<int, QVariantList>>& desired) {
+    RowDiffPlan result;
+    QSet<int> kept;
+    for (const auto& row : desired) {
+        auto it = existing.constFind(row.first);
+        // Nowy wiersz, wiersz usunięty w międzyczasie albo to samo id drugi raz
+        if (row.first < 0 || it == existing.constEnd() || kept.contains(row.first)) {
+            result.inserts.append(row.second);
+            continue;
+        }
+        kept.insert(row.first);
+        if (!sameRow(it.value(), row.second)) result.updates.append(row);
+    }
+    for (auto it = existing.constBegin(); it != existing.constEnd(); ++it) {
+        if (!kept.contains(it.key())) result.deletes.append(it.key());
+    }
+    std::sort(result.deletes.begin(), result.deletes.end());
+    return result;
+}
+
+} // namespace RowDiff
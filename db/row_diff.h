@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Różnica między wierszami podrzędnymi w bazie a stanem z formularza
+ *
+ * Edycja zamówienia (pozycje) i klienta (adresy dostawy) nie usuwa już
+ * wszystkich wierszy, żeby wstawić je od nowa. Wiersze z formularza są
+ * dopasowywane po id do wierszy w bazie:
+ * - id znane i wartości bez zmian - nic,
+ * - id znane, inne wartości - UPDATE tego wiersza,
+ * - brak id (lub id, którego już nie ma w bazie) - INSERT,
+ * - wiersz z bazy, którego nie ma w formularzu - DELETE.
+ *
+ * Wiersze zachowują id między edycjami, a zapis jednej zmienionej wartości
+ * to jedno zapytanie.
+ */
+struct RowDiffPlan {
+    QVector<QVariantList> inserts;              // wartości kolumn nowych wierszy
+    QVector<QPair<int, QVariantList>> updates;  // id -> nowe wartości zmienionych wierszy
+    QVector<int> deletes;
+
+    bool isEmpty() const { return inserts.isEmpty() && updates.isEmpty() && deletes.isEmpty(); }
+};
+
+namespace RowDiff {
+
+// existing: id -> wartości kolumn w bazie; desired: (id lub -1 dla nowego wiersza, wartości)
+// w tej samej kolejności kolumn
+RowDiffPlan plan(const QHash<int, QVariantList>& existing, const QVector<QPair<int, QVariantList>>& desired);
+
+// NULL i pusty tekst są równe; liczby porównywane jako liczby, reszta jako tekst
+bool sameValue(const QVariant& stored, const QVariant& value);
+
+} // namespace RowDiff
@@ -0,0 +1,61 @@
+#include "schema_catalog.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+bool SchemaCatalog::load(const QSqlDatabase& connection) {
+    if (!connection.isOpen()) return false;
+    QHash<QString, QHash<QString, QString>> tables;
+    QSqlQuery q(connection);
+    q.setForwardOnly(true);
+    if (connection.driverName() == "QPSQL") {
+        if (!q.exec("SELECT table_name, column_name, data_type FROM information_schema.columns "
+                    "WHERE table_schema = ANY (current_schemas(false))")) {
+            qWarning() << "[SchemaCatalog] Nie można odczytać kolumn:" << q.lastError().text();
+            return false;
+        }
+        while (q.next()) tables[q.value(0).toString()].insert(q.value(1).toString(), q.value(2).toString());
+    } else {
+        for (const QString& table : connection.tables()) {
+            if (!q.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+                qWarning() << "[SchemaCatalog] Nie można odczytać kolumn tabeli" << table << ":" << q.lastError().text();
+                return false;
+            }
+            QHash<QString, QString>& columns = tables[table];
+            while (q.next()) columns.insert(q.value(1).toString(), q.value(2).toString());
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    m_tables = std::move(tables);
+    m_loaded = true;
+    return true;
+}
+
+bool SchemaCatalog::isLoaded() const {
+    QReadLocker locker(&m_lock);
+    return m_loaded;
+}
+
+bool SchemaCatalog::hasTable(const QString& table) const {
+    QReadLocker locker(&m_lock);
+    return m_tables.contains(table);
+}
+
+bool SchemaCatalog::hasColumn(const QString& table, const QString& column) const {
+    QReadLocker locker(&m_lock);
+    auto it = m_tables.constFind(table);
+    return it != m_tables.constEnd() && it->contains(column);
+}
+
+QStringList SchemaCatalog::columns(const QString& table) const {
+    QReadLocker locker(&m_lock);
+    return m_tables.value(table).keys();
+}
+
+QString SchemaCatalog::columnType(const QString& table, const QString& column) const {
+    QReadLocker locker(&m_lock);
+    return m_tables.value(table).value(column);
+}
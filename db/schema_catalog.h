@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Kolumny i typy tabel bazy danych, wczytane raz zamiast sprawdzania przy każdym zapytaniu
+ *
+ * DbManager wczytuje katalog po połączeniu i ponownie po migracjach (oraz po
+ * własnych ALTER TABLE). Metody, które budują zapytania zależnie od tego,
+ * jakie kolumny istnieją (np. adresy dostaw), pytają katalog zamiast
+ * information_schema.
+ *
+ * - PostgreSQL: jedno zapytanie do information_schema.columns (schematy z search_path)
+ * - SQLite: PRAGMA table_info dla każdej tabeli
+ */
+class SchemaCatalog {
+public:
+    bool load(const QSqlDatabase& connection);
+    bool isLoaded() const;
+
+    bool hasTable(const QString& table) const;
+    bool hasColumn(const QString& table, const QString& column) const;
+    QStringList columns(const QString& table) const;
+    // Typ kolumny tak, jak podaje go baza (np. "text", "integer", "REAL"); pusty, gdy kolumny brak
+    QString columnType(const QString& table, const QString& column) const;
+
+private:
+    mutable QReadWriteLock m_lock;
+    QHash<QString, QHash<QString, QString>> m_tables; // tabela -> kolumna -> typ
+    bool m_loaded = false;
+};
@@ -0,0 +1,250 @@
+#include "search_index.h"
+#include <QSqlQuery>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+const QString kPolishLetters = QString::fromUtf8("ąćęłńóśźżĄĆĘŁŃÓŚŹŻ");
+const QString kAsciiLetters = "acelnoszzacelnoszz";
+// Trigram nie indeksuje krótszych fraz - dla nich zostaje LIKE
+const int kMinIndexedLength = 3;
+
+struct SearchColumn {
+    QString name;       // kolumna w tabeli FTS i nazwa indeksu
+    QString expression; // kolumna tabeli źródłowej
+};
+
+const QVector<SearchColumn>& clientColumns() {
+    static const QVector<SearchColumn> columns = {
+        {"name", "name"},
+        {"short_name", "short_name"},
+        {"city", "city"},
+        {"nip", "nip"},
+        {"client_number", "CAST(client_number AS TEXT)"},
+    };
+    return columns;
+}
+
+// Kolumny dla pola wyszukiwania (All - wszystkie)
+QVector<SearchColumn> columnsFor(ClientSearchField field) {
+    const QVector<SearchColumn>& all = clientColumns();
+    switch (field) {
+    case ClientSearchField::All: return all;
+    case ClientSearchField::Name: return {all.at(0)};
+    case ClientSearchField::ShortName: return {all.at(1)};
+    case ClientSearchField::City: return {all.at(2)};
+    case ClientSearchField::Nip: return {all.at(3)};
+    case ClientSearchField::ClientNumber: return {all.at(4)};
+    }
+    return all;
+}
+
+QString qualified(const QString& expression, const QString& prefix) {
+    // "CAST(client_number AS TEXT)" -> "CAST(NEW.client_number AS TEXT)"
+    if (expression.startsWith("CAST(")) return QString(expression).insert(5, prefix);
+    return prefix + expression;
+}
+}
+
+QString SearchIndex::fold(const QString& text) {
+    QString folded = text.trimmed().toLower();
+    for (QChar& ch : folded) {
+        const int index = kPolishLetters.indexOf(ch);
+        if (index >= 0) ch = kAsciiLetters.at(index);
+    }
+    return folded;
+}
+
+QString SearchIndex::foldSql(const QString& expression, bool postgres) {
+    const QString value = QString("COALESCE(%1, '')").arg(expression);
+    if (postgres) {
+        return QString("translate(lower(%1), '%2', '%3')").arg(value, kPolishLetters, kAsciiLetters);
+    }
+    // lower() w SQLite zmienia tylko litery ASCII, więc polskie znaki (obie wielkości) zamieniamy wprost
+    QString sql = value;
+    for (int i = 0; i < kPolishLetters.size(); ++i) {
+        sql = QString("replace(%1, '%2', '%3')").arg(sql, QString(kPolishLetters.at(i)), QString(kAsciiLetters.at(i)));
+    }
+    return QString("lower(%1)").arg(sql);
+}
+
+QString SearchIndex::likePattern(const QString& folded) {
+    QString pattern = folded;
+    pattern.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+    return "%" + pattern + "%";
+}
+
+QString SearchIndex::ftsPhrase(const QString& folded) {
+    return '"' + QString(folded).replace('"', "\"\"") + '"';
+}
+
+bool SearchIndex::install(const QSqlDatabase& connection) {
+    m_postgres = connection.driverName() == "QPSQL";
+    m_trigram = false;
+    m_fts = false;
+    if (!connection.isOpen()) return false;
+    return m_postgres ? installPostgres(connection) : installSqlite(connection);
+}
+
+bool SearchIndex::installPostgres(const QSqlDatabase& connection) {
+    QSqlQuery q(connection);
+    if (!q.exec("CREATE EXTENSION IF NOT EXISTS pg_trgm")) {
+        qWarning() << "[Wyszukiwanie] Brak rozszerzenia pg_trgm - wyszukiwanie bez indeksu:" << q.lastError().text();
+        return false;
+    }
+    QVector<QPair<QString, SearchColumn>> indexed;
+    for (const SearchColumn& column : clientColumns()) indexed.append({"clients", column});
+    indexed.append({"orders", {"order_number", "order_number"}});
+    for (const auto& index : indexed) {
+        const QString sql = QString("CREATE INDEX IF NOT EXISTS idx_%1_%2_trgm ON %1 USING gin ((%3) gin_trgm_ops)")
+                                .arg(index.first, index.second.name, foldSql(index.second.expression, true));
+        if (!q.exec(sql)) {
+            qWarning() << "[Wyszukiwanie] Nie można utworzyć indeksu" << index.first << index.second.name << ":" << q.lastError().text();
+            return false;
+        }
+    }
+    m_trigram = true;
+    return true;
+}
+
+bool SearchIndex::installSqlite(const QSqlDatabase& connection) {
+    QSqlQuery q(connection);
+    struct FtsTable {
+        QString name;
+        QString source;
+        QVector<SearchColumn> columns;
+    };
+    const QVector<FtsTable> tables = {
+        {"clients_search", "clients", clientColumns()},
+        {"orders_search", "orders", {{"order_number", "order_number"}}},
+    };
+    for (const FtsTable& table : tables) {
+        q.prepare("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?");
+        q.addBindValue(table.name);
+        const bool exists = q.exec() && q.next();
+
+        QStringList names;
+        QStringList newValues;
+        QStringList sourceValues;
+        for (const SearchColumn& column : table.columns) {
+            names << column.name;
+            newValues << foldSql(qualified(column.expression, "NEW."), false);
+            sourceValues << foldSql(column.expression, false);
+        }
+        if (!exists) {
+            if (!q.exec(QString("CREATE VIRTUAL TABLE %1 USING fts5(%2, tokenize='trigram')").arg(table.name, names.join(", ")))) {
+                qWarning() << "[Wyszukiwanie] FTS5 (trigram) niedostępne - wyszukiwanie bez indeksu:" << q.lastError().text();
+                return false;
+            }
+            // Pierwsze wypełnienie z istniejących wierszy
+            if (!q.exec(QString("INSERT INTO %1 (rowid, %2) SELECT id, %3 FROM %4")
+                            .arg(table.name, names.join(", "), sourceValues.join(", "), table.source))) {
+                qWarning() << "[Wyszukiwanie] Nie można wypełnić" << table.name << ":" << q.lastError().text();
+                return false;
+            }
+        }
+        const QString insertNew = QString("INSERT INTO %1 (rowid, %2) VALUES (NEW.id, %3); ")
+                                      .arg(table.name, names.join(", "), newValues.join(", "));
+        const QString deleteOld = QString("DELETE FROM %1 WHERE rowid = OLD.id; ").arg(table.name);
+        const QList<QPair<QString, QString>> triggers = {
+            {"INSERT", insertNew},
+            {"UPDATE", deleteOld + insertNew},
+            {"DELETE", deleteOld},
+        };
+        for (const auto& trigger : triggers) {
+            const QString sql = QString("CREATE TRIGGER IF NOT EXISTS %1_%2 AFTER %3 ON %4 BEGIN %5END")
+                                    .arg(table.name, trigger.first.toLower(), trigger.first, table.source, trigger.second);
+            if (!q.exec(sql)) {
+                qWarning() << "[Wyszukiwanie] Nie można utworzyć triggera dla" << table.name << ":" << q.lastError().text();
+                return false;
+            }
+        }
+    }
+    m_fts = true;
+    return true;
+}
+
+QVector<int> SearchIndex::searchClients(const QSqlDatabase& connection, const QString& text, ClientSearchField field,
+                                        int limit, QSqlError* error) const {
+    QVector<int> ids;
+    const QString folded = fold(text);
+    if (folded.isEmpty()) return ids;
+    const QVector<SearchColumn> columns = columnsFor(field);
+
+    QString sql;
+    QVariantList bindValues;
+    if (m_postgres) {
+        QStringList matches;
+        QStringList ranks;
+        for (const SearchColumn& column : columns) {
+            const QString expression = foldSql(column.expression, true);
+            if (m_trigram) {
+                // word_similarity (<%) łapie też literówki; LIKE - dokładny fragment
+                matches << QString("%1 LIKE ? ESCAPE '\\' OR ? <% %1").arg(expression);
+                bindValues << likePattern(folded) << folded;
+                ranks << QString("word_similarity(?, %1)").arg(expression);
+            } else {
+                matches << QString("%1 LIKE ? ESCAPE '\\'").arg(expression);
+                bindValues << likePattern(folded);
+            }
+        }
+        if (m_trigram) {
+            for (int i = 0; i < columns.size(); ++i) bindValues << folded;
+        }
+        sql = QString("SELECT id FROM clients WHERE %1 ORDER BY %2name, id LIMIT ?")
+                  .arg(matches.join(" OR "),
+                       m_trigram ? QString("GREATEST(%1) DESC, ").arg(ranks.join(", ")) : QString());
+    } else if (m_fts && folded.size() >= kMinIndexedLength) {
+        QString match = ftsPhrase(folded);
+        if (columns.size() == 1) match = columns.first().name + " : " + match;
+        sql = "SELECT rowid FROM clients_search WHERE clients_search MATCH ? ORDER BY rank LIMIT ?";
+        bindValues << match;
+    } else {
+        // Krótka fraza albo brak FTS5 - LIKE (bez indeksu)
+        QStringList matches;
+        for (const SearchColumn& column : columns) {
+            matches << QString("%1 LIKE ? ESCAPE '\\'").arg(m_fts ? column.name : foldSql(column.expression, false));
+            bindValues << likePattern(folded);
+        }
+        sql = m_fts ? QString("SELECT rowid FROM clients_search WHERE %1 ORDER BY name LIMIT ?").arg(matches.join(" OR "))
+                    : QString("SELECT id FROM clients WHERE %1 ORDER BY name, id LIMIT ?").arg(matches.join(" OR "));
+    }
+    bindValues << qMax(1, limit);
+
+    QSqlQuery q(connection);
+    q.setForwardOnly(true);
+    q.prepare(sql);
+    for (const QVariant& value : bindValues) q.addBindValue(value);
+    if (!q.exec()) {
+        qWarning() << "[Wyszukiwanie] Błąd wyszukiwania klientów:" << q.lastError().text();
+        if (error) *error = q.lastError();
+        return ids;
+    }
+    while (q.next()) ids.append(q.value(0).toInt());
+    return ids;
+}
+
+QString SearchIndex::orderCondition(const QString& text, OrderSearchField field, QVariantList& bindValues,
+                                    bool includeArchive) const {
+    const QString folded = fold(text);
+    if (folded.isEmpty()) return QString();
+    if (field == OrderSearchField::ClientNumber) {
+        bindValues << likePattern(folded);
+        return "LOWER(COALESCE(CAST(c.client_number AS TEXT), '')) LIKE ? ESCAPE '\\'";
+    }
+    const bool byNumber = field == OrderSearchField::OrderNumber;
+    if (!m_postgres && m_fts && !(byNumber && includeArchive)) {
+        const QString table = byNumber ? "orders_search" : "clients_search";
+        const QString column = byNumber ? "order_number" : "name";
+        const QString idColumn = byNumber ? "o.id" : "o.client_id";
+        if (folded.size() >= kMinIndexedLength) {
+            bindValues << column + " : " + ftsPhrase(folded);
+            return QString("%1 IN (SELECT rowid FROM %2 WHERE %2 MATCH ?)").arg(idColumn, table);
+        }
+        bindValues << likePattern(folded);
+        return QString("%1 IN (SELECT rowid FROM %2 WHERE %3 LIKE ? ESCAPE '\\')").arg(idColumn, table, column);
+    }
+    // PostgreSQL: wyrażenie jak w indeksie trigramowym, więc LIKE korzysta z indeksu
+    bindValues << likePattern(folded);
+    return QString("%1 LIKE ? ESCAPE '\\'").arg(foldSql(byNumber ? "o.order_number" : "c.name", m_postgres));
+}
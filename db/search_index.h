@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+#include "models/order_list_row.h"
+
+// Pola wyszukiwania klientów (kolejność jak w ClientSelectDialog)
+enum class ClientSearchField {
+    All = 0,
+    Name = 1,
+    ShortName = 2,
+    City = 3,
+    Nip = 4,
+    ClientNumber = 5
+};
+
+/**
+ * @brief Indeksowane wyszukiwanie klientów i zamówień bez polskich znaków
+ *
+ * Tekst i fraza są sprowadzane do małych liter bez ogonków (fold), więc
+ * "lodz" znajduje "Łódź". Wyniki są identyfikatorami w kolejności trafności,
+ * z limitem.
+ *
+ * - PostgreSQL: rozszerzenie pg_trgm i indeksy GIN na wyrażeniach fold()
+ *   kolumn clients i orders; dopasowanie LIKE '%fraza%' lub podobieństwo
+ *   trigramów (literówki), ranking similarity(). Bez pg_trgm (brak uprawnień)
+ *   zostaje zwykłe LIKE.
+ * - SQLite: tabele FTS5 (tokenizer trigram) clients_search i orders_search,
+ *   rowid = id wiersza, utrzymywane triggerami. Ranking bm25 przy frazach od
+ *   3 znaków. Bez FTS5 - LIKE na tabelach źródłowych.
+ */
+class SearchIndex {
+public:
+    // Zakłada indeksy / tabele FTS i triggery (jeśli ich brak); false, gdy działa tylko LIKE
+    bool install(const QSqlDatabase& connection);
+    bool isIndexed() const { return m_postgres ? m_trigram : m_fts; }
+
+    // Id klientów pasujących do frazy, najtrafniejsze pierwsze
+    QVector<int> searchClients(const QSqlDatabase& connection, const QString& text, ClientSearchField field,
+                               int limit, QSqlError* error = nullptr) const;
+    // Warunek dla listy zamówień (aliasy o - orders, c - clients); pusty, gdy fraza pusta.
+    // includeArchive - numery zamówień bez orders_search (archiwum nie jest w indeksie).
+    QString orderCondition(const QString& text, OrderSearchField field, QVariantList& bindValues,
+                           bool includeArchive = false) const;
+
+    // Małe litery bez polskich znaków diakrytycznych
+    static QString fold(const QString& text);
+    // To samo przekształcenie jako wyrażenie SQL
+    static QString foldSql(const QString& expression, bool postgres);
+
+private:
+    bool installPostgres(const QSqlDatabase& connection);
+    bool installSqlite(const QSqlDatabase& connection);
+    static QString likePattern(const QString& folded);
+    static QString ftsPhrase(const QString& folded);
+
+    bool m_postgres = false;
+    bool m_trigram = false;
+    bool m_fts = false;
+};
@@ -0,0 +1,74 @@
+#include "sqlite_profile.h"
+#include "../utils/settings_manager.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+SqliteProfile SqliteProfile::fromSettings() {
+    SqliteProfile profile;
+    const SettingsManager& settings = SettingsManager::instance();
+    profile.journalMode = settings.getValue("sqlite/journal_mode", profile.journalMode).toString().toUpper();
+    profile.synchronous = settings.getValue("sqlite/synchronous", profile.synchronous).toString().toUpper();
+    profile.mmapSizeBytes = settings.getValue("sqlite/mmap_size", profile.mmapSizeBytes).toLongLong();
+    profile.cacheSizeKiB = settings.getValue("sqlite/cache_size_kib", profile.cacheSizeKiB).toInt();
+    profile.busyTimeoutMs = settings.getValue("sqlite/busy_timeout_ms", profile.busyTimeoutMs).toInt();
+    profile.maintenanceIntervalMs = settings.getValue("sqlite/maintenance_interval_ms", profile.maintenanceIntervalMs).toInt();
+
+    // Wartości trafiają do tekstu PRAGMA - akceptujemy tylko znane słowa kluczowe
+    static const QStringList journalModes = {"WAL", "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "OFF"};
+    static const QStringList synchronousModes = {"OFF", "NORMAL", "FULL", "EXTRA"};
+    if (!journalModes.contains(profile.journalMode)) {
+        qWarning() << "[SQLite] Nieznany journal_mode" << profile.journalMode << "- używam WAL";
+        profile.journalMode = "WAL";
+    }
+    if (!synchronousModes.contains(profile.synchronous)) {
+        qWarning() << "[SQLite] Nieznany tryb synchronous" << profile.synchronous << "- używam NORMAL";
+        profile.synchronous = "NORMAL";
+    }
+    return profile;
+}
+
+bool SqliteProfile::apply(QSqlDatabase& connection) const {
+    if (connection.driverName() != "QSQLITE" || !connection.isOpen()) return false;
+
+    // busy_timeout jako pierwszy - przełączenie na WAL samo potrzebuje blokady pliku
+    const QStringList pragmas = {
+        QString("PRAGMA busy_timeout = %1").arg(qMax(0, busyTimeoutMs)),
+        QString("PRAGMA journal_mode = %1").arg(journalMode),
+        QString("PRAGMA synchronous = %1").arg(synchronous),
+        QString("PRAGMA mmap_size = %1").arg(qMax<qint64>(0, mmapSizeBytes)),
+        // Wartość ujemna = rozmiar w KiB, niezależnie od rozmiaru strony
+        QString("PRAGMA cache_size = -%1").arg(qMax(0, cacheSizeKiB)),
+        "PRAGMA temp_store = MEMORY",
+    };
+    bool ok = true;
+    QSqlQuery q(connection);
+    for (const QString& pragma : pragmas) {
+        if (!q.exec(pragma)) {
+            qWarning() << "[SQLite]" << pragma << "nie powiodło się:" << q.lastError().text();
+            ok = false;
+        }
+    }
+    // journal_mode zwraca faktycznie ustawiony tryb (np. "memory" dla bazy w pamięci)
+    if (q.exec("PRAGMA journal_mode") && q.next()
+        && q.value(0).toString().compare(journalMode, Qt::CaseInsensitive) != 0) {
+        qWarning() << "[SQLite] journal_mode to" << q.value(0).toString() << "zamiast" << journalMode;
+    }
+    return ok;
+}
+
+bool SqliteProfile::runMaintenance(QSqlDatabase& connection) {
+    if (connection.driverName() != "QSQLITE" || !connection.isOpen()) return false;
+    QSqlQuery q(connection);
+    // PASSIVE nie czeka na czytelników ani piszących - przepisuje tyle, ile się da
+    if (!q.exec("PRAGMA wal_checkpoint(PASSIVE)")) {
+        qWarning() << "[SQLite] wal_checkpoint nie powiódł się:" << q.lastError().text();
+        return false;
+    }
+    if (!q.exec("PRAGMA optimize")) {
+        qWarning() << "[SQLite] PRAGMA optimize nie powiodło się:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
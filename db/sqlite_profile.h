@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+
+/**
+ * @brief Ustawienia wydajnościowe dla połączeń SQLite (tryb offline)
+ *
+ * Stosowane do każdego połączenia z plikiem bazy - głównego i z puli. WAL
+ * pozwala czytać równolegle z zapisem, busy_timeout sprawia, że zapis czeka
+ * na blokadę zamiast od razu zwracać "database is locked".
+ *
+ * Wartości domyślne można nadpisać w SettingsManager (grupa "sqlite/").
+ */
+struct SqliteProfile {
+    QString journalMode = "WAL";
+    QString synchronous = "NORMAL";            // w trybie WAL bezpieczne przy awarii aplikacji
+    qint64 mmapSizeBytes = 256LL * 1024 * 1024;
+    int cacheSizeKiB = 16 * 1024;
+    int busyTimeoutMs = 5000;
+    int maintenanceIntervalMs = 10 * 60 * 1000; // wal_checkpoint + optimize; 0 wyłącza
+
+    static SqliteProfile fromSettings();
+
+    // Ustawia PRAGMA na otwartym połączeniu; false, jeśli któraś się nie powiodła
+    bool apply(QSqlDatabase& connection) const;
+    // Okresowa konserwacja: checkpoint WAL (bez blokowania czytelników) i PRAGMA optimize
+    static bool runMaintenance(QSqlDatabase& connection);
+};
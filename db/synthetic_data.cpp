@@ -0,0 +1,353 @@
+#include "synthetic_data.h"
+#include "dbmanager.h"
+#include <QDate>
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include <QtMath>
+
+namespace {
+
+const QStringList kTrades = {"Piekarnia", "Masarnia", "Mleczarnia", "Hurtownia", "Drukarnia", "Apteka", "Browar",
+                             "Cukiernia", "Tłocznia", "Zakład Mięsny", "Przetwórnia Owoców", "Logistyka"};
+const QStringList kSurnames = {"Nowak", "Kowalski", "Wiśniewski", "Wójcik", "Kowalczyk", "Kamiński", "Lewandowski",
+                               "Zieliński", "Szymański", "Woźniak", "Dąbrowski", "Kozłowski", "Jankowski", "Mazur"};
+const QStringList kFirstNames = {"Anna", "Piotr", "Katarzyna", "Tomasz", "Magdalena", "Marcin", "Agnieszka", "Paweł"};
+const QStringList kLegalForms = {"Sp. z o.o.", "S.A.", "s.c.", "Sp. j.", ""};
+const QStringList kStreets = {"Polna", "Leśna", "Słoneczna", "Przemysłowa", "Kwiatowa", "Lipowa", "Fabryczna",
+                              "Ogrodowa", "Kolejowa", "Składowa"};
+// Miasto z kodem pocztowym
+const QVector<QPair<QString, QString>> kCities = {
+    {"Warszawa", "00-"}, {"Kraków", "30-"}, {"Łódź", "90-"}, {"Wrocław", "50-"}, {"Poznań", "60-"},
+    {"Gdańsk", "80-"}, {"Katowice", "40-"}, {"Lublin", "20-"}, {"Białystok", "15-"}, {"Rzeszów", "35-"},
+    {"Kielce", "25-"}, {"Opole", "45-"}};
+const QStringList kPaymentTerms = {"7 dni", "14 dni", "21 dni", "30 dni", "45 dni"};
+
+// Wartości jak w formularzu zamówienia, z wagami
+const QVector<QPair<QString, int>> kMaterials = {
+    {"Termiczny", 30}, {"Termotransferowy", 20}, {"Termiczny TOP", 12}, {"Termiczny RF20", 6},
+    {"Termotransferowy RF20", 4}, {"Folia PP", 14}, {"Folia PP RF20", 4}, {"PET Matt Silver", 3}};
+const QVector<QPair<QString, int>> kSizes = {
+    {"100x150", 18}, {"100x50", 14}, {"58x40", 12}, {"50x30", 12}, {"40x25", 10}, {"70x50", 8},
+    {"105x148", 6}, {"30x20", 6}, {"60x40", 8}, {"80x50", 6}};
+const QVector<QPair<QString, int>> kCores = {{"40", 50}, {"25", 25}, {"76", 25}};
+const QVector<QPair<QString, int>> kRollLengths = {{"500", 20}, {"1000", 45}, {"2000", 25}, {"3000", 10}};
+const QStringList kThousands = {"5", "10", "10", "20", "20", "50", "100"};
+const QStringList kRolls = {"4", "6", "10", "10", "20", "40"};
+const QList<int> kMaterialWidths = {50, 76, 100, 110, 150, 210};
+const QList<int> kMaterialLengths = {500, 1000, 2000};
+
+struct ClientInfo {
+    int id = -1;
+    QString shortName;
+    QString street;
+    QString postalCode;
+    QString city;
+    QString contactPerson;
+    QString phone;
+    QVector<QMap<QString, QVariant>> addresses; // dodatkowe adresy dostawy
+};
+
+class Generator {
+public:
+    explicit Generator(quint32 seed) : m_rng(seed) {}
+
+    int between(int lo, int hi) { return m_rng.bounded(lo, hi + 1); }
+    bool chance(double p) { return m_rng.generateDouble() < p; }
+    template <typename T>
+    const T& pick(const QList<T>& values) { return values.at(m_rng.bounded(static_cast<int>(values.size()))); }
+
+    QString weighted(const QVector<QPair<QString, int>>& values) {
+        int total = 0;
+        for (const auto& value : values) total += value.second;
+        int r = m_rng.bounded(total);
+        for (const auto& value : values) {
+            if (r < value.second) return value.first;
+            r -= value.second;
+        }
+        return values.last().first;
+    }
+
+    // Indeks z przewagą początku listy: ~5% klientów składa blisko połowę zamówień
+    int skewedIndex(int count) {
+        return qMin(count - 1, static_cast<int>(count * qPow(m_rng.generateDouble(), 4.0)));
+    }
+
+    // NIP z poprawną cyfrą kontrolną
+    QString nip() {
+        static const int weights[] = {6, 5, 7, 2, 3, 4, 5, 6, 7};
+        while (true) {
+            QString digits = QString::number(between(1, 9));
+            for (int i = 1; i < 9; ++i) digits += QString::number(between(0, 9));
+            int sum = 0;
+            for (int i = 0; i < 9; ++i) sum += digits.at(i).digitValue() * weights[i];
+            if (sum % 11 != 10) return digits + QString::number(sum % 11);
+        }
+    }
+
+    QString phone() { return QString("%1 %2 %3").arg(between(500, 799)).arg(between(100, 999)).arg(between(100, 999)); }
+    QString person() { return pick(kFirstNames) + " " + pick(kSurnames); }
+    QString street() { return QString("ul. %1 %2").arg(pick(kStreets)).arg(between(1, 120)); }
+
+    QPair<QString, QString> city() {
+        const auto& city = kCities.at(m_rng.bounded(static_cast<int>(kCities.size())));
+        return {city.first, city.second + QString::number(between(1, 999)).rightJustified(3, '0')};
+    }
+
+    // Dni robocze: sobota i niedziela przesunięte na poniedziałek
+    QDate workday(const QDate& from, int days) {
+        QDate date = from.addDays(between(0, qMax(0, days)));
+        while (date.dayOfWeek() > 5) date = date.addDays(1);
+        return date;
+    }
+
+    QMap<QString, QVariant> orderItem() {
+        QMap<QString, QVariant> item;
+        const QStringList size = weighted(kSizes).split('x');
+        item["width"] = size.value(0);
+        item["height"] = size.value(1);
+        item["material"] = weighted(kMaterials);
+        item["core"] = weighted(kCores);
+        item["roll_length"] = weighted(kRollLengths);
+        const bool thousands = chance(0.7);
+        item["quantity_type"] = thousands ? "tyś." : "rolek";
+        const QString quantity = thousands ? pick(kThousands) : pick(kRolls);
+        item["ordered_quantity"] = quantity;
+        // Jak formularz: tysiące przeliczone na rolki według nawoju
+        item["zam_rolki"] = thousands
+            ? QString::number(qCeil(quantity.toDouble() * 1000.0 / item.value("roll_length").toDouble()))
+            : quantity;
+        item["price"] = QString::number(thousands ? between(800, 4500) / 100.0 : between(1500, 9000) / 100.0, 'f', 2);
+        item["price_type"] = thousands ? "za 1 tyś" : "za 1 rolkę";
+        return item;
+    }
+
+    int itemCount() {
+        const double r = m_rng.generateDouble();
+        if (r < 0.45) return 1;
+        if (r < 0.70) return 2;
+        if (r < 0.85) return 3;
+        if (r < 0.97) return between(4, 6);
+        return between(7, 20);
+    }
+
+    // Starsze zamówienia są zrealizowane, bieżące rozłożone między etapy
+    Order::Status status(const QDate& deliveryDate, const QDate& today) {
+        if (deliveryDate < today.addDays(-14)) return chance(0.97) ? Order::Zrealizowane : Order::Gotowe;
+        if (deliveryDate < today) return chance(0.6) ? Order::Zrealizowane : Order::Gotowe;
+        const double r = m_rng.generateDouble();
+        if (r < 0.5) return Order::Przyjete;
+        return r < 0.85 ? Order::Produkcja : Order::Gotowe;
+    }
+
+private:
+    QRandomGenerator m_rng;
+};
+
+bool fail(DbManager& db, const QString& what, QString* error) {
+    const QString message = QString("%1: %2").arg(what, db.lastError().text());
+    qWarning() << "[SyntheticData]" << message;
+    if (error) *error = message;
+    return false;
+}
+
+void report(const SyntheticData::Progress& progress, const QString& stage, int done, int total) {
+    if (progress && (done % 100 == 0 || done == total)) progress(stage, done, total);
+}
+
+} // namespace
+
+SyntheticDataSpec SyntheticDataSpec::scaled(double factor) const {
+    SyntheticDataSpec spec = *this;
+    auto scale = [factor](int value) { return qMax(1, qRound(value * factor)); };
+    spec.clients = scale(clients);
+    spec.orders = scale(orders);
+    spec.suppliers = scale(suppliers);
+    spec.materialsOrders = scale(materialsOrders);
+    return spec;
+}
+
+bool SyntheticData::populate(DbManager& db, const SyntheticDataSpec& spec, const Progress& progress, QString* error) {
+    // Schemat SQLite z initializeTables nie ma kolumn zamówień zapisywanych niżej (order_date, notes, ...)
+    if (db.database().driverName() != QLatin1String("QPSQL")) {
+        const QString message = "Generator wymaga bazy PostgreSQL (DB_TYPE=QPSQL)";
+        qWarning() << "[SyntheticData]" << message;
+        if (error) *error = message;
+        return false;
+    }
+    Generator gen(spec.seed);
+    const QDate today = QDate::currentDate();
+    const QDate firstDay = today.addMonths(-qMax(1, spec.months));
+
+    // --- Dostawcy i katalog materiałów ---
+    for (int i = 1; i <= spec.suppliers; ++i) {
+        const auto city = gen.city();
+        QMap<QString, QVariant> supplier;
+        supplier["name"] = QString("Dostawca Materiałów %1 %2").arg(gen.pick(kSurnames)).arg(i);
+        supplier["street"] = gen.street();
+        supplier["city"] = city.first;
+        supplier["postal_code"] = city.second;
+        supplier["country"] = "Polska";
+        supplier["contact_person"] = gen.person();
+        supplier["phone"] = gen.phone();
+        supplier["email"] = QString("zamowienia%1@dostawca.example").arg(i);
+        if (!db.addSupplier(supplier)) return fail(db, "Nie udało się dodać dostawcy", error);
+        report(progress, "suppliers", i, spec.suppliers);
+    }
+    QVector<int> supplierIds;
+    for (const auto& supplier : db.getSuppliers()) supplierIds.append(supplier.value("id").toInt());
+
+    int materials = 0;
+    const int catalogSize = kMaterials.size() * kMaterialWidths.size();
+    for (const auto& material : kMaterials) {
+        for (int width : kMaterialWidths) {
+            QMap<QString, QVariant> data;
+            data["name"] = material.first;
+            data["width"] = width;
+            data["length"] = gen.pick(kMaterialLengths);
+            data["unit"] = "m";
+            if (!db.addMaterial(data)) return fail(db, "Nie udało się dodać materiału", error);
+            report(progress, "materials_catalog", ++materials, catalogSize);
+        }
+    }
+    const QVector<QMap<QString, QVariant>> catalog = db.getMaterialsCatalog();
+
+    // --- Klienci z adresami dostawy ---
+    QVector<ClientInfo> clients;
+    clients.reserve(spec.clients);
+    for (int i = 1; i <= spec.clients; ++i) {
+        const int number = db.getNextUniqueClientNumber();
+        if (number <= 0) return fail(db, "Nie udało się przydzielić numeru klienta", error);
+        const QString surname = gen.pick(kSurnames);
+        const QString trade = gen.pick(kTrades);
+        const auto city = gen.city();
+
+        ClientInfo client;
+        client.shortName = QString("%1 %2").arg(trade, surname);
+        client.street = gen.street();
+        client.city = city.first;
+        client.postalCode = city.second;
+        client.contactPerson = gen.person();
+        client.phone = gen.phone();
+
+        QMap<QString, QVariant> data;
+        data["client_number"] = QString::number(number).rightJustified(6, '0');
+        data["name"] = QString("%1 %2 %3").arg(trade, surname, gen.pick(kLegalForms)).trimmed();
+        data["short_name"] = client.shortName;
+        data["contact_person"] = client.contactPerson;
+        data["phone"] = client.phone;
+        data["email"] = QString("biuro%1@klient.example").arg(number);
+        data["street"] = client.street;
+        data["postal_code"] = client.postalCode;
+        data["city"] = client.city;
+        data["nip"] = gen.nip();
+        if (!db.addClient(data)) return fail(db, "Nie udało się dodać klienta", error);
+        client.id = db.findClientByNumber(data.value("client_number").toString());
+        if (client.id < 0) return fail(db, "Nie znaleziono dodanego klienta", error);
+
+        // Większość klientów ma tylko adres główny, część - oddziały lub magazyny
+        const int extraAddresses = gen.chance(0.6) ? 0 : (gen.chance(0.6) ? 1 : gen.between(2, 3));
+        for (int a = 0; a < extraAddresses; ++a) {
+            const auto addressCity = gen.city();
+            QMap<QString, QVariant> address;
+            address["client_id"] = client.id;
+            address["name"] = QString("Oddział %1").arg(a + 1);
+            address["company"] = client.shortName;
+            address["street"] = gen.street();
+            address["postal_code"] = addressCity.second;
+            address["city"] = addressCity.first;
+            address["contact_person"] = gen.person();
+            address["phone"] = gen.phone();
+            address["country"] = "Polska";
+            if (!db.addDeliveryAddress(address)) return fail(db, "Nie udało się dodać adresu dostawy", error);
+            client.addresses.append(address);
+        }
+        clients.append(client);
+        report(progress, "clients", i, spec.clients);
+    }
+    if (clients.isEmpty()) return true;
+
+    // --- Zamówienia z pozycjami ---
+    const int days = firstDay.daysTo(today);
+    for (int i = 1; i <= spec.orders; ++i) {
+        const ClientInfo& client = clients.at(gen.skewedIndex(clients.size()));
+        const QDate orderDate = gen.workday(firstDay, days);
+        const QDate deliveryDate = gen.workday(orderDate.addDays(5), 16);
+
+        QMap<QString, QVariant> order;
+        order["order_number"] = db.getNextOrderNumber(orderDate);
+        if (order.value("order_number").toString().isEmpty()) {
+            return fail(db, "Nie udało się przydzielić numeru zamówienia", error);
+        }
+        order["order_date"] = orderDate;
+        order["delivery_date"] = deliveryDate;
+        order["client_id"] = client.id;
+        order["notes"] = gen.chance(0.2) ? QString("Pakować po %1 rolek").arg(gen.between(2, 10)) : QString();
+        order["payment_term"] = gen.pick(kPaymentTerms);
+        order["status"] = static_cast<int>(gen.status(deliveryDate, today));
+        if (!client.addresses.isEmpty() && gen.chance(0.4)) {
+            const auto& address = client.addresses.at(gen.between(0, client.addresses.size() - 1));
+            order["delivery_company"] = address.value("company");
+            order["delivery_street"] = address.value("street");
+            order["delivery_postal_code"] = address.value("postal_code");
+            order["delivery_city"] = address.value("city");
+            order["delivery_contact_person"] = address.value("contact_person");
+            order["delivery_phone"] = address.value("phone");
+        } else {
+            order["delivery_company"] = client.shortName;
+            order["delivery_street"] = client.street;
+            order["delivery_postal_code"] = client.postalCode;
+            order["delivery_city"] = client.city;
+            order["delivery_contact_person"] = client.contactPerson;
+            order["delivery_phone"] = client.phone;
+        }
+
+        QVector<QMap<QString, QVariant>> items;
+        const int itemCount = gen.itemCount();
+        for (int n = 0; n < itemCount; ++n) items.append(gen.orderItem());
+        if (!db.addOrder(order, items)) {
+            return fail(db, QString("Nie udało się zapisać zamówienia %1").arg(order.value("order_number").toString()),
+                        error);
+        }
+        report(progress, "orders", i, spec.orders);
+    }
+
+    // --- Zamówienia materiałów ---
+    if (supplierIds.isEmpty() || catalog.isEmpty()) return true;
+    for (int i = 1; i <= spec.materialsOrders; ++i) {
+        const QDate orderDate = gen.workday(firstDay, days);
+        QMap<QString, QVariant> order;
+        order["order_number"] = db.getNextMaterialsOrderNumber();
+        if (order.value("order_number").toString().isEmpty()) {
+            return fail(db, "Nie udało się przydzielić numeru zamówienia materiałów", error);
+        }
+        order["order_date"] = orderDate;
+        order["delivery_date"] = gen.workday(orderDate.addDays(3), 10);
+        order["supplier_id"] = supplierIds.at(gen.between(0, supplierIds.size() - 1));
+        order["delivery_company"] = "Magazyn główny";
+        order["delivery_street"] = "ul. Przemysłowa 1";
+        order["delivery_postal_code"] = "00-001";
+        order["delivery_city"] = "Warszawa";
+        order["delivery_country"] = "Polska";
+        order["done"] = orderDate < today.addDays(-30) ? 1 : 0;
+
+        QVector<QMap<QString, QVariant>> items;
+        const int itemCount = gen.between(1, 4);
+        for (int n = 0; n < itemCount; ++n) {
+            const auto& material = catalog.at(gen.between(0, catalog.size() - 1));
+            QMap<QString, QVariant> item;
+            item["material_id"] = material.value("id");
+            item["material_name"] = material.value("name");
+            item["width"] = material.value("width");
+            item["length"] = material.value("length");
+            item["quantity"] = QString::number(gen.between(2, 40));
+            items.append(item);
+        }
+        if (!db.addMaterialsOrder(order, items)) {
+            return fail(db, "Nie udało się zapisać zamówienia materiałów", error);
+        }
+        report(progress, "materials_orders", i, spec.materialsOrders);
+    }
+    return true;
+}
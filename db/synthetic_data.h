@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+
+class DbManager;
+
+// Wielkość generowanego zbioru; scaled() mnoży liczby wierszy (np. 5 - pięciokrotny wolumen)
+struct SyntheticDataSpec {
+    quint32 seed = 1;
+    int clients = 1000;
+    int orders = 20000;
+    int suppliers = 15;
+    int materialsOrders = 600;
+    int months = 24; // zamówienia rozłożone na tyle miesięcy wstecz od dziś
+
+    SyntheticDataSpec scaled(double factor) const;
+};
+
+/**
+ * @brief Generator danych testowych do pomiarów wydajności (etykiety-bench)
+ *
+ * Wypełnia clients, delivery_addresses, orders, order_items, suppliers,
+ * materials_catalog, materials_orders i materials_order_items przez zwykłe
+ * API DbManager, więc dane przechodzą przez te same zapisy, numerację
+ * i triggery co w programie. Tylko PostgreSQL - schemat SQLite (initializeTables)
+ * nie ma części kolumn zamówień i pozycji; populate() na SQLite zwraca błąd.
+ *
+ * Rozkłady zbliżone do rzeczywistych:
+ * - kilka procent klientów składa większość zamówień,
+ * - zamówienia w dni robocze, dostawa po 5-21 dniach, starsze są zrealizowane,
+ * - zwykle 1-3 pozycje, rzadko kilkanaście; typowe wymiary, materiały i rdzenie
+ *   z formularza zamówienia.
+ *
+ * Ten sam seed daje te same dane (poza numerami nadanymi przez bazę).
+ */
+class SyntheticData {
+public:
+    // Etap ("clients", "orders", ...), wiersze zapisane dotąd i wszystkie wiersze etapu
+    using Progress = std::function<void(const QString& stage, int done, int total)>;
+
+    static bool populate(DbManager& db, const SyntheticDataSpec& spec, const Progress& progress = {},
+                         QString* error = nullptr);
+};
@@ -8,7 +8,9 @@
 #include "utils/session_manager.h"
 #include "utils/secure_config.h"
 #include "db/dbmanager.h"
+#include "utils/settings_manager.h"
 #include <QDebug>
+#include <QLoggingCategory>
 
 // Globalny wskaźnik na okno główne, aby uniknąć tworzenia wielu instancji
 MainWindow* g_mainWindow = nullptr;
@@ -28,6 +30,12 @@ int main(int argc, char *argv[])
     app.setQuitOnLastWindowClosed(false);
     app.setStyle("Fusion");
     
+    // Poziom logowania Debug (logging/level) włącza też diagnostykę z kategorii
+    // etykiety.* - np. pełne listy zamówień w podsumowaniu produkcji
+    if (SettingsManager::instance().getLogLevel() == SettingsManager::LogLevel::Debug) {
+        QLoggingCategory::setFilterRules("etykiety.*.debug=true");
+    }
+    
     try {
         // Initialize SecureUserManager
         SecureUserManager::instance().loadUsersFromFile();
@@ -115,6 +123,7 @@ void showMainWindow(const User &user, LoginDialog *loginDialog) {
         if (!g_mainWindow) {
             g_mainWindow = new MainWindow(nullptr);
             qDebug() << "[DEBUG] MainWindow utworzony";
+            DbManager::instance().startBackgroundMaintenance();
             QObject::connect(g_mainWindow, &MainWindow::logoutRequested, [loginDialog]() {
                 qDebug() << "[DEBUG] Logout requested";
                 // Destroy current session
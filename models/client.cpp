@@ -1,2 +1,8 @@
 #include "client.h"
-// Implementacja metod Client (jeśli potrzebne)
+#include <QRegularExpression>
+
+QString Client::cleanNip(const QString& nip) {
+    QString result = nip;
+    result.remove(QRegularExpression("[^0-9]"));
+    return result;
+}
@@ -5,7 +5,7 @@
 
 class Client {
 public:
-    int id;
+    int id = -1;
     QString clientNumber;
     QString name;
     QString shortName;
@@ -21,4 +21,7 @@ public:
     QString deliveryPostalCode;
     QString deliveryCity;
     QVector<DeliveryAddress> deliveryAddresses;
+
+    // NIP bez myślników, spacji i innych znaków - same cyfry
+    static QString cleanNip(const QString& nip);
 };
@@ -3,8 +3,8 @@
 
 class DeliveryAddress {
 public:
-    int id;
-    int clientId;
+    int id = -1;
+    int clientId = -1;
     QString name;
     QString company;
     QString street;
@@ -7,28 +7,30 @@
 
 class MaterialsOrderItem {
 public:
-    int id;
-    int orderId;
-    int materialId;
+    int id = -1;
+    int orderId = -1;
+    int materialId = -1;
     QString materialName;
     QString width;
     QString length;
     QString quantity;
+    double quantityValue = 0.0; // kolumna quantity_value; 0, gdy ilość niepoprawna
 };
 
 class MaterialsOrder {
 public:
-    int id;
+    int id = -1;
     QString orderNumber;
     QDate orderDate;
     QDate deliveryDate;
     QString notes;
-    int supplierId;
+    int supplierId = -1;
     QString deliveryCompany;
     QString deliveryStreet;
     QString deliveryPostalCode;
     QString deliveryCity;
     QString deliveryCountry;
+    bool done = false;
     QVector<MaterialsOrderItem> items;
     Supplier supplier;
 };
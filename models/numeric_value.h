@@ -0,0 +1,18 @@
+#pragma once
+#include <QString>
+#include <QVariant>
+#include <cmath>
+
+// Wartość liczbowa pola wpisywanego jako tekst (wymiary, ilości, ceny).
+// Akceptuje przecinek dziesiętny i spacje między cyframi; zwraca pusty
+// QVariant (NULL w bazie), gdy tekst nie jest skończoną, nieujemną liczbą.
+inline QVariant numericValue(const QString& text) {
+    QString normalized = text.trimmed();
+    if (normalized.isEmpty()) return QVariant();
+    normalized.remove(' ');
+    normalized.replace(',', '.');
+    bool ok = false;
+    const double value = normalized.toDouble(&ok);
+    if (!ok || !std::isfinite(value) || value < 0) return QVariant();
+    return value;
+}
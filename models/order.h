@@ -1,6 +1,7 @@
 #pragma once
 #include <QString>
 #include <QDate>
+#include <QRegularExpression>
 #include <QVector>
 #include "orderitem.h"
 #include "client.h"
@@ -13,11 +14,11 @@ public:
         Gotowe = 2,
         Zrealizowane = 3
     };
-    int id;
+    int id = -1;
     QString orderNumber;
     QDate orderDate;
     QDate deliveryDate;
-    int clientId;
+    int clientId = -1;
     QString notes;
     QString paymentTerm;
     QString deliveryCompany;
@@ -40,4 +41,10 @@ public:
         }
         return "Nieznany";
     }
+
+    // Numer w formacie ZAM-YYYY-NNN (numeracja powyżej 999 ma więcej cyfr)
+    static bool isValidOrderNumber(const QString& number) {
+        static const QRegularExpression re("^ZAM-\\d{4}-\\d{3,}$");
+        return re.match(number).hasMatch();
+    }
 };
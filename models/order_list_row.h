@@ -0,0 +1,52 @@
+#pragma once
+#include <QString>
+#include <QDate>
+#include "order.h"
+
+// Pole, po którym filtrowana jest lista zamówień (kolejność jak w wyszukiwarce widoku)
+enum class OrderSearchField {
+    OrderNumber = 0,
+    ClientNumber = 1,
+    ClientName = 2
+};
+
+// Wiersz listy zamówień: zamówienie z numerem/nazwą klienta i gotowymi
+// podsumowaniami pozycji - bez obiektów Client i OrderItem
+class OrderListRow {
+public:
+    int id = -1;
+    int clientId = -1;
+    Order::Status status = Order::Przyjete;
+    bool archived = false; // wiersz z orders_archive
+    QString orderNumber;
+    QDate orderDate;
+    QDate deliveryDate;
+    QString clientNumber;
+    QString clientName;
+    QString priceSummary;
+    QString productionSummary;
+    QString notes;
+    QString paymentTerm;
+    QString deliveryCompany;
+    QString deliveryStreet;
+    QString deliveryPostalCode;
+    QString deliveryCity;
+    QString deliveryContactPerson;
+    QString deliveryPhone;
+};
+
+// Pozycja w liście zamówień dla stronicowania keyset po (order_date DESC, id DESC).
+// Domyślnie skonstruowany kursor oznacza początek listy.
+class OrdersPageCursor {
+public:
+    QDate orderDate;
+    int id = -1;
+
+    bool atStart() const { return id < 0; }
+    static OrdersPageCursor after(const OrderListRow& row) {
+        OrdersPageCursor cursor;
+        cursor.orderDate = row.orderDate;
+        cursor.id = row.id;
+        return cursor;
+    }
+};
@@ -3,8 +3,8 @@
 
 class OrderItem {
 public:
-    int id;
-    int orderId;
+    int id = -1;
+    int orderId = -1;
     QString width;
     QString height;
     QString material;
@@ -15,4 +15,11 @@ public:
     QString price;
     QString priceType;
     QString zamRolki;
+    // Wartości liczbowe pól tekstowych (kolumny *_value); 0, gdy pole puste
+    // lub niepoprawne
+    double widthValue = 0.0;
+    double heightValue = 0.0;
+    double orderedQuantityValue = 0.0;
+    double rollLengthValue = 0.0;
+    double priceValue = 0.0;
 };
@@ -0,0 +1,19 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+
+// Grupa pozycji produkcji: ten sam materiał, wymiary i rdzeń
+struct ProductionGroup {
+    QString material;
+    QString width;
+    QString height;
+    QString dimensions;  // szerokość x wysokość
+    QString core;
+    double quantity = 0.0;
+    int orderCount = 0;
+    QStringList orderNumbers;
+    QString quantityType;    // typ miary (tyś., rolki)
+    double rollLength = 0.0; // długość/nawój rolki
+    double totalPrice = 0.0; // suma wartości zamówień
+    int rollCount = 0;      // ilość rolek
+};
@@ -3,7 +3,7 @@
 
 class Supplier {
 public:
-    int id;
+    int id = -1;
     QString name;
     QString street;
     QString city;
@@ -1,6 +1,5 @@
 #include "gusclient.h"
 #include <QUrl>
-#include <QMessageBox>
 #include <QRegularExpression>
 #include <QProcess>
 #include <QJsonDocument>
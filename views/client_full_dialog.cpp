@@ -1,5 +1,6 @@
 #include "client_full_dialog.h"
 #include "db/dbmanager.h"
+#include "models/client.h"
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QMessageBox>
@@ -176,6 +177,9 @@ QList<QMap<QString, QVariant>> ClientFullDialog::deliveryAddresses() const {
         addr["contact_person"] = addressesTable->item(row, 5) ? addressesTable->item(row, 5)->text() : "";
         addr["phone"] = addressesTable->item(row, 6) ? addressesTable->item(row, 6)->text() : "";
         addr["client_id"] = addressesTable->item(row, 7) ? addressesTable->item(row, 7)->text() : "";
+        // Id adresu z bazy (pusty dla nowych) - zapis aktualizuje tylko zmienione adresy
+        const QVariant addressId = addressesTable->item(row, 0) ? addressesTable->item(row, 0)->data(Qt::UserRole) : QVariant();
+        if (addressId.isValid()) addr["id"] = addressId;
         list.append(addr);
     }
     return list;
@@ -286,9 +290,7 @@ bool ClientFullDialog::validate() {
 
 // Utility: oczyszcza NIP z myślników, spacji i innych znaków, zostawia tylko cyfry
 QString ClientFullDialog::cleanNip(const QString &nip) {
-    QString result = nip;
-    result.remove(QRegularExpression("[^0-9]"));
-    return result;
+    return Client::cleanNip(nip);
 }
 
 void ClientFullDialog::validateAndAccept() {
@@ -327,7 +329,9 @@ void ClientFullDialog::validateAndAccept() {
             // WYMUSZAMY ZAPIS OCZYSZCZONEGO NIP
             client["nip"] = cleanNip;
             if (db.addClientWithAddresses(client, addresses)) {
-                db.markClientNumberUsed(client["client_number"].toString().rightJustified(6, '0').toInt());
+                if (!db.markClientNumberUsed(client["client_number"].toString().rightJustified(6, '0').toInt())) {
+                    qWarning() << "[ClientFullDialog] Nie zapisano numeru klienta jako użytego:" << db.lastError().text();
+                }
                 added = true;
                 emit clientAdded();
                 break;
@@ -381,7 +385,9 @@ void ClientFullDialog::setDeliveryAddresses(const QList<QMap<QString, QVariant>>
 void ClientFullDialog::addAddressToTable(const QMap<QString, QVariant> &address) {
     int row = addressesTable->rowCount();
     addressesTable->insertRow(row);
-    addressesTable->setItem(row, 0, new QTableWidgetItem(address.value("name").toString()));
+    QTableWidgetItem *nameItem = new QTableWidgetItem(address.value("name").toString());
+    if (address.contains("id")) nameItem->setData(Qt::UserRole, address.value("id"));
+    addressesTable->setItem(row, 0, nameItem);
     addressesTable->setItem(row, 1, new QTableWidgetItem(address.value("company").toString()));
     addressesTable->setItem(row, 2, new QTableWidgetItem(address.value("street").toString()));
     addressesTable->setItem(row, 3, new QTableWidgetItem(address.value("postal_code").toString()));
@@ -406,7 +412,10 @@ void ClientFullDialog::editSelectedAddressRow() {
     dlg.setAddressData(address);
     if (dlg.exec() == QDialog::Accepted) {
         QMap<QString, QVariant> edited = dlg.addressData();
-        addressesTable->setItem(row, 0, new QTableWidgetItem(edited.value("name").toString()));
+        const QVariant addressId = addressesTable->item(row, 0) ? addressesTable->item(row, 0)->data(Qt::UserRole) : QVariant();
+        QTableWidgetItem *nameItem = new QTableWidgetItem(edited.value("name").toString());
+        nameItem->setData(Qt::UserRole, addressId);
+        addressesTable->setItem(row, 0, nameItem);
         addressesTable->setItem(row, 1, new QTableWidgetItem(edited.value("company").toString()));
         addressesTable->setItem(row, 2, new QTableWidgetItem(edited.value("street").toString()));
         addressesTable->setItem(row, 3, new QTableWidgetItem(edited.value("postal_code").toString()));
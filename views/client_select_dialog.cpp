@@ -44,46 +44,26 @@ ClientSelectDialog::ClientSelectDialog(QWidget *parent) : QDialog(parent) {
 }
 
 void ClientSelectDialog::loadClients(const QString &filter, const QString &mode) {
-    auto clients = DbManager::instance().getClients();
-    QVector<QMap<QString, QVariant>> filtered;
-    if (!filter.isEmpty()) {
-        for (const auto &c : clients) {
-            bool match = false;
-            if (mode == "Wszystko") {
-                match = c["name"].toString().contains(filter, Qt::CaseInsensitive) ||
-                        c["short_name"].toString().contains(filter, Qt::CaseInsensitive) ||
-                        c["city"].toString().contains(filter, Qt::CaseInsensitive) ||
-                        c["nip"].toString().contains(filter, Qt::CaseInsensitive) ||
-                        c["client_number"].toString().contains(filter, Qt::CaseInsensitive);
-            } else if (mode == "Nazwa" && c["name"].toString().contains(filter, Qt::CaseInsensitive)) {
-                match = true;
-            } else if (mode == "Nazwa skrócona" && c["short_name"].toString().contains(filter, Qt::CaseInsensitive)) {
-                match = true;
-            } else if (mode == "Miasto" && c["city"].toString().contains(filter, Qt::CaseInsensitive)) {
-                match = true;
-            } else if (mode == "NIP" && c["nip"].toString().contains(filter, Qt::CaseInsensitive)) {
-                match = true;
-            } else if (mode == "Nr klienta" && c["client_number"].toString().contains(filter, Qt::CaseInsensitive)) {
-                match = true;
-            }
-            if (match) filtered.append(c);
-        }
-    } else {
-        filtered = clients;
-    }
-    table->setRowCount(filtered.size());
-    for (int row = 0; row < filtered.size(); ++row) {
-        table->setItem(row, 0, new QTableWidgetItem(QString::number(filtered[row]["id"].toInt())));
-        table->setItem(row, 1, new QTableWidgetItem(filtered[row]["client_number"].toString()));
-        table->setItem(row, 2, new QTableWidgetItem(filtered[row]["name"].toString()));
-        table->setItem(row, 3, new QTableWidgetItem(filtered[row]["short_name"].toString()));
-        table->setItem(row, 4, new QTableWidgetItem(filtered[row]["contact_person"].toString()));
-        table->setItem(row, 5, new QTableWidgetItem(filtered[row]["phone"].toString()));
-        table->setItem(row, 6, new QTableWidgetItem(filtered[row]["email"].toString()));
-        table->setItem(row, 7, new QTableWidgetItem(filtered[row]["street"].toString()));
-        table->setItem(row, 8, new QTableWidgetItem(filtered[row]["postal_code"].toString()));
-        table->setItem(row, 9, new QTableWidgetItem(filtered[row]["city"].toString()));
-        table->setItem(row, 10, new QTableWidgetItem(filtered[row]["nip"].toString()));
+    static const QStringList modes = {"Wszystko", "Nazwa", "Nazwa skrócona", "Miasto", "NIP", "Nr klienta"};
+    auto &dbm = DbManager::instance();
+    // Bez frazy - wszyscy klienci z cache; z frazą - wyszukiwanie w indeksie (bez polskich znaków, wg trafności)
+    const QVector<Client> clients = filter.trimmed().isEmpty()
+        ? dbm.fetchClients()
+        : dbm.searchClients(filter, static_cast<ClientSearchField>(qMax(0, modes.indexOf(mode))), SEARCH_LIMIT);
+    table->setRowCount(clients.size());
+    for (int row = 0; row < clients.size(); ++row) {
+        const Client &c = clients.at(row);
+        table->setItem(row, 0, new QTableWidgetItem(QString::number(c.id)));
+        table->setItem(row, 1, new QTableWidgetItem(c.clientNumber));
+        table->setItem(row, 2, new QTableWidgetItem(c.name));
+        table->setItem(row, 3, new QTableWidgetItem(c.shortName));
+        table->setItem(row, 4, new QTableWidgetItem(c.contactPerson));
+        table->setItem(row, 5, new QTableWidgetItem(c.phone));
+        table->setItem(row, 6, new QTableWidgetItem(c.email));
+        table->setItem(row, 7, new QTableWidgetItem(c.street));
+        table->setItem(row, 8, new QTableWidgetItem(c.postalCode));
+        table->setItem(row, 9, new QTableWidgetItem(c.city));
+        table->setItem(row, 10, new QTableWidgetItem(c.nip));
     }
 }
 
@@ -18,5 +18,6 @@ private:
     QTableWidget *table;
     QDialogButtonBox *buttonBox;
     QMap<QString, QVariant> selected;
+    static const int SEARCH_LIMIT = 500; // Najwięcej wyników wyszukiwania w tabeli
     void loadClients(const QString &filter = QString(), const QString &mode = QString("Wszystko"));
 };
@@ -1,5 +1,6 @@
 #include "clients_db_view.h"
 #include "db/dbmanager.h"
+#include "db/async_db.h"
 #include "views/client_dialog.h"
 #include "views/client_full_dialog.h"
 #include <QStandardItemModel>
@@ -31,8 +32,9 @@ void ClientsDbView::setupUI() {
     searchCombo->addItems({"Wszystko", "Nazwa", "Nazwa skrócona", "Miasto", "NIP", "Nr klienta"});
     searchCombo->setMaximumWidth(150);
     searchCombo->setToolTip("Wybierz pole do wyszukiwania");
-    connect(searchEdit, &QLineEdit::textChanged, this, &ClientsDbView::loadClients);
-    connect(searchCombo, &QComboBox::currentTextChanged, this, &ClientsDbView::loadClients);
+    // Wyszukiwanie filtruje już pobranych klientów - bez ponownego zapytania do bazy
+    connect(searchEdit, &QLineEdit::textChanged, this, &ClientsDbView::populateClients);
+    connect(searchCombo, &QComboBox::currentTextChanged, this, &ClientsDbView::populateClients);
     QLabel *searchLabel = new QLabel("Szukaj: ", this);
     QHBoxLayout *searchLayout = new QHBoxLayout;
     searchLayout->setContentsMargins(0, 0, 0, 0);
@@ -80,6 +82,9 @@ void ClientsDbView::setupUI() {
     setLayout(mainLayout);
     connect(btnEdit, &QPushButton::clicked, this, &ClientsDbView::editClient);
     connect(btnDelete, &QPushButton::clicked, this, &ClientsDbView::deleteClient);
+    // Wynik zapytania w tle wraca do wątku GUI przez watcher
+    loadWatcher = new QFutureWatcher<QVector<QMap<QString, QVariant>>>(this);
+    connect(loadWatcher, &QFutureWatcherBase::finished, this, &ClientsDbView::onClientsLoaded);
     if (selectionMode) {
         btnSelectToOrder = new QPushButton("Wstaw do zamówienia", this);
         btnSelectToOrder->setToolTip("Wstaw wybranego klienta do zamówienia");
@@ -129,8 +134,42 @@ void ClientsDbView::refreshClients() {
 
 void ClientsDbView::loadClients() {
     qDebug() << "[ClientsDbView::loadClients] Wywołano";
-    auto& db = DbManager::instance();
-    auto clients = db.getClients();
+    // Zapytanie już trwa - odśwież ponownie po jego zakończeniu
+    if (loadWatcher->isRunning()) {
+        reloadPending = true;
+        return;
+    }
+    setLoading(true);
+    loadWatcher->setFuture(DbManager::instance().async().getClients());
+}
+
+void ClientsDbView::onClientsLoaded() {
+    allClients = loadWatcher->result();
+    setLoading(false);
+    populateClients();
+    if (pendingSelectRow >= 0) {
+        tableView->selectRow(pendingSelectRow);
+        pendingSelectRow = -1;
+    }
+    if (reloadPending) {
+        reloadPending = false;
+        loadClients();
+    }
+}
+
+void ClientsDbView::setLoading(bool loading) {
+    tableView->setEnabled(!loading);
+    if (loading) {
+        setCursor(Qt::BusyCursor);
+        showStatus("Ładowanie klientów...", 0);
+    } else {
+        unsetCursor();
+        if (statusBar && statusBar->currentMessage() == "Ładowanie klientów...") statusBar->clearMessage();
+    }
+}
+
+void ClientsDbView::populateClients() {
+    const auto& clients = allClients;
     QString filter = searchEdit ? searchEdit->text().trimmed() : "";
     QString mode = searchCombo ? searchCombo->currentText() : "Wszystko";
     QList<QMap<QString, QVariant>> filtered;
@@ -294,11 +333,10 @@ void ClientsDbView::editClient() {
     dlg.setDeliveryAddresses(addresses);
     if (dlg.exec() == QDialog::Accepted) {
         if (db.updateClient(selectedClientId, dlg.clientData())) {
+            // Zaznaczenie wiersza po odświeżeniu listy w tle
+            pendingSelectRow = rowToSelect;
             loadClients();
             showStatus("Zaktualizowano dane klienta");
-            if (rowToSelect >= 0) {
-                tableView->selectRow(rowToSelect);
-            }
         } else {
             QMessageBox::warning(this, "Błąd", "Nie udało się zaktualizować klienta.");
         }
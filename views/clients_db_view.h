@@ -12,6 +12,7 @@
 #include <QKeyEvent>
 #include <QStatusBar>
 #include <QToolTip>
+#include <QFutureWatcher>
 
 class ClientsDbView : public QWidget {
     Q_OBJECT
@@ -43,6 +44,14 @@ private:
     QStatusBar *statusBar = nullptr;
     void setupUI();
     void loadClients();
+    void onClientsLoaded();
+    void populateClients();
+    void setLoading(bool loading);
+    // Klienci pobrani w tle; wyszukiwanie filtruje tę listę
+    QVector<QMap<QString, QVariant>> allClients;
+    QFutureWatcher<QVector<QMap<QString, QVariant>>> *loadWatcher = nullptr;
+    bool reloadPending = false;
+    int pendingSelectRow = -1;
     void saveTableState();
     void restoreTableState();
     void showStatus(const QString &msg, int timeoutMs = 2000);
@@ -1,6 +1,8 @@
 #include "dashboard_view.h"
 #include "order_card.h"
 #include "db/dbmanager.h"
+#include "db/async_db.h"
+#include "db/change_feed.h"
 #include "models/order.h"
 #include "models/client.h"
 #include "views/order_dialog.h"
@@ -17,6 +19,14 @@
 #include <QTimer>
 #include <QGroupBox>
 #include <QSqlQuery>
+#include <QFutureWatcher>
+#include <QSet>
+
+// Dane tablicy pobierane jednym zadaniem w tle
+struct DashboardData {
+    QVector<Order> orders; // bez zrealizowanych - dashboard ich nie pokazuje
+    QVector<QMap<QString, QVariant>> clients;
+};
 
 class DayBox : public QFrame {
 public:
@@ -48,15 +58,23 @@ protected:
         if (event->mimeData()->hasFormat("application/x-order-id")) {
             int orderId = event->mimeData()->data("application/x-order-id").toInt();
             QDate newDate = m_date;
-            auto& dbm = DbManager::instance();
-            if (!dbm.updateOrderDeliveryDate(orderId, newDate)) {
-                QMessageBox::critical(this, "Błąd", "Nie udało się zaktualizować daty zamówienia w bazie.");
-            }
-            // Odśwież dashboard
             QWidget* w = this;
             while (w && !w->inherits("DashboardView")) w = w->parentWidget();
-            if (w) w->update();
-            QMetaObject::invokeMethod(w, "refreshDashboard", Qt::QueuedConnection);
+            // Zapis w tle; DayBox zostanie usunięty przy odświeżeniu, więc
+            // wynik odbiera DashboardView
+            QWidget* owner = w ? w : this;
+            auto* watcher = new QFutureWatcher<bool>(owner);
+            QObject::connect(watcher, &QFutureWatcherBase::finished, owner, [owner, watcher]() {
+                if (!watcher->result()) {
+                    QMessageBox::critical(owner, "Błąd", "Nie udało się zaktualizować daty zamówienia w bazie.");
+                }
+                // Odśwież dashboard
+                if (owner->inherits("DashboardView")) {
+                    QMetaObject::invokeMethod(owner, "refreshDashboard", Qt::QueuedConnection);
+                }
+                watcher->deleteLater();
+            });
+            watcher->setFuture(DbManager::instance().async().updateOrderDeliveryDate(orderId, newDate));
             event->acceptProposedAction();
         }
     }
@@ -94,135 +112,134 @@ QWidget* createDashboardGrid(QWidget *parent) {
 }
 
 DashboardView::DashboardView(QWidget *parent) : QWidget(parent) {
+    m_loadWatcher = new QFutureWatcher<DashboardData>(this);
+    connect(m_loadWatcher, &QFutureWatcherBase::finished, this, &DashboardView::onDashboardLoaded);
     QVBoxLayout *layout = new QVBoxLayout(this);
-    QScrollArea *scroll = new QScrollArea;
-    scroll->setWidgetResizable(true);
-    QMap<QDate, DayBox*> dayBoxMap;
-    QWidget* grid = createDashboardGrid(nullptr, &dayBoxMap);
-    // DEBUG: wypisz wszystkie klucze dayBoxMap
-    qDebug() << "[DASHBOARD] Klucze dayBoxMap (dni na tablicy):";
-    QList<QDate> dayBoxDates = dayBoxMap.keys();
-    for (const QDate& d : dayBoxDates) {
-        qDebug() << "  " << d.toString("yyyy-MM-dd");
-    }
-    // Pobierz zamówienia i klientów
-    auto& dbm = DbManager::instance();
-    QVector<QMap<QString, QVariant>> orders = dbm.getOrders();
-    QVector<QMap<QString, QVariant>> clients = dbm.getClients();
-    QMap<int, QMap<QString, QVariant>> clientMap;
-    for (const auto& c : clients) clientMap[c["id"].toInt()] = c;
-    // DEBUG: wypisz daty deliveryDate wszystkich zamówień
-    qDebug() << "[DASHBOARD] Daty deliveryDate zamówień:";
-    for (const auto& o : orders) {
-        QDate d = o["delivery_date"].toDate();
-        qDebug() << "  ID:" << o["id"].toInt() << ", nr:" << o["order_number"].toString() << ", delivery:" << d.toString("yyyy-MM-dd");
-    }
-    // Dla każdego zamówienia utwórz OrderCard i wstaw do odpowiedniego DayBox
-    for (const auto& o : orders) {
-        Order order;
-        order.id = o["id"].toInt();
-        order.orderNumber = o["order_number"].toString();
-        order.orderDate = o["order_date"].toDate();
-        order.deliveryDate = o["delivery_date"].toDate();
-        order.clientId = o["client_id"].toInt();
-        order.notes = o["notes"].toString();
-        order.paymentTerm = o["payment_term"].toString();
-        order.status = o.contains("status") ? static_cast<Order::Status>(o["status"].toInt()) : Order::Przyjete;
-        
-        // Pomiń zamówienia ze statusem "Zrealizowane" - nie pokazuj ich na dashboard
-        if (order.status == Order::Zrealizowane) {
-            continue;
-        }
-        
-        if (clientMap.contains(order.clientId)) {
-            const auto& c = clientMap[order.clientId];
-            order.client.name = c["name"].toString();
-            order.client.shortName = c["short_name"].toString();
-        }
-        // DEBUG: sprawdź czy data jest w dayBoxMap
-        if (dayBoxMap.contains(order.deliveryDate)) {
-            qDebug() << "[DASHBOARD][MATCH] Zamówienie ID:" << order.id << ", nr:" << order.orderNumber << ", delivery:" << order.deliveryDate.toString("yyyy-MM-dd") << "-> DayBox OK";
-            OrderCard* card = new OrderCard(order, this);
-            // Połącz sygnał zmiany statusu
-            connect(card, &OrderCard::orderStatusChanged, this, &DashboardView::onOrderStatusChanged);
-            // Połącz sygnał dwukliku z podglądem zamówienia
-            connect(card, &OrderCard::orderDoubleClicked, this, &DashboardView::previewOrder);
-            dayBoxMap[order.deliveryDate]->addOrderCard(card);
-        } else {
-            // Wypisz różnicę z każdą datą DayBoxa
-            qDebug() << "[DASHBOARD][NOMATCH] Zamówienie ID:" << order.id << ", nr:" << order.orderNumber << ", delivery:" << order.deliveryDate.toString("yyyy-MM-dd") << "nie pasuje do żadnego DayBoxa!";
-            for (const QDate& d : dayBoxDates) {
-                int diff = d.daysTo(order.deliveryDate);
-                qDebug() << "    DayBox:" << d.toString("yyyy-MM-dd") << ", różnica dni:" << diff;
-            }
-        }
-    }
-    scroll->setWidget(grid);
-    layout->addWidget(scroll);
+    m_loadingLabel = new QLabel("Ładowanie zamówień...", this);
+    m_loadingLabel->setAlignment(Qt::AlignCenter);
+    m_loadingLabel->setStyleSheet("color: #6b7280; font-style: italic;");
+    m_loadingLabel->hide();
+    layout->addWidget(m_loadingLabel);
+    m_scroll = new QScrollArea;
+    m_scroll->setWidgetResizable(true);
+    // Pusta tablica do czasu pobrania zamówień w tle
+    m_scroll->setWidget(createDashboardGrid(nullptr));
+    layout->addWidget(m_scroll);
     setLayout(layout);
+    connect(&DbManager::instance().changeFeed(), &ChangeFeed::changed, this, &DashboardView::onRowsChanged);
+    refreshDashboard();
 }
 
 void DashboardView::refreshDashboard() {
-    // Usuń obecny widget i stwórz nowy
-    QLayout* oldLayout = layout();
-    if (oldLayout) {
-        QLayoutItem* item;
-        while ((item = oldLayout->takeAt(0)) != nullptr) {
-            delete item->widget();
-            delete item;
-        }
-        delete oldLayout;
+    // Zapytanie już trwa - odśwież ponownie po jego zakończeniu
+    if (m_loadWatcher->isRunning()) {
+        m_reloadPending = true;
+        return;
     }
+    m_loadingLabel->show();
+    m_loadWatcher->setFuture(DbManager::instance().async().run([](DbManager& dbm) {
+        DashboardData data;
+        data.orders = dbm.fetchOpenOrders();
+        data.clients = dbm.getClients();
+        return data;
+    }));
+}
+
+void DashboardView::onDashboardLoaded() {
+    const DashboardData data = m_loadWatcher->result();
+    m_dayBoxes.clear();
+    m_cards.clear();
+    m_cardClients.clear();
+    ++m_gridGeneration;
+    QWidget* grid = createDashboardGrid(nullptr, &m_dayBoxes);
     
-    // Odtwórz całą strukturę dashboard
-    QVBoxLayout *layout = new QVBoxLayout(this);
-    QScrollArea *scroll = new QScrollArea;
-    scroll->setWidgetResizable(true);
-    QMap<QDate, DayBox*> dayBoxMap;
-    QWidget* grid = createDashboardGrid(nullptr, &dayBoxMap);
-    
-    // Pobierz zamówienia i klientów
-    auto& dbm = DbManager::instance();
-    QVector<QMap<QString, QVariant>> orders = dbm.getOrders();
-    QVector<QMap<QString, QVariant>> clients = dbm.getClients();
     QMap<int, QMap<QString, QVariant>> clientMap;
-    for (const auto& c : clients) clientMap[c["id"].toInt()] = c;
+    for (const auto& c : data.clients) clientMap[c["id"].toInt()] = c;
     
     // Dla każdego zamówienia utwórz OrderCard i wstaw do odpowiedniego DayBox
-    for (const auto& o : orders) {
-        Order order;
-        order.id = o["id"].toInt();
-        order.orderNumber = o["order_number"].toString();
-        order.orderDate = o["order_date"].toDate();
-        order.deliveryDate = o["delivery_date"].toDate();
-        order.clientId = o["client_id"].toInt();
-        order.notes = o["notes"].toString();
-        order.paymentTerm = o["payment_term"].toString();
-        order.status = o.contains("status") ? static_cast<Order::Status>(o["status"].toInt()) : Order::Przyjete;
-        
-        // Pomiń zamówienia ze statusem "Zrealizowane" - nie pokazuj ich na dashboard
-        if (order.status == Order::Zrealizowane) {
-            continue;
-        }
-        
+    for (Order order : data.orders) {
         if (clientMap.contains(order.clientId)) {
             const auto& c = clientMap[order.clientId];
             order.client.name = c["name"].toString();
             order.client.shortName = c["short_name"].toString();
         }
-        
-        if (dayBoxMap.contains(order.deliveryDate)) {
-            OrderCard* card = new OrderCard(order, this);
-            // Połącz sygnał zmiany statusu
-            connect(card, &OrderCard::orderStatusChanged, this, &DashboardView::onOrderStatusChanged);
-            // Połącz sygnał dwukliku z podglądem zamówienia
-            connect(card, &OrderCard::orderDoubleClicked, this, &DashboardView::previewOrder);
-            dayBoxMap[order.deliveryDate]->addOrderCard(card);
-        }
+        addCard(order);
     }
-    scroll->setWidget(grid);
-    layout->addWidget(scroll);
-    setLayout(layout);
+    // Poprzednia tablica (razem z kartami) jest usuwana przez QScrollArea
+    m_scroll->setWidget(grid);
+    m_loadingLabel->hide();
+    
+    if (m_reloadPending) {
+        m_reloadPending = false;
+        refreshDashboard();
+    }
+}
+
+void DashboardView::addCard(const Order &order) {
+    // Pomiń zamówienia ze statusem "Zrealizowane" - nie pokazuj ich na dashboard
+    if (order.status == Order::Zrealizowane) return;
+    DayBox* box = m_dayBoxes.value(order.deliveryDate, nullptr);
+    if (!box) return;
+    OrderCard* card = new OrderCard(order, this);
+    // Połącz sygnał zmiany statusu
+    connect(card, &OrderCard::orderStatusChanged, this, &DashboardView::onOrderStatusChanged);
+    // Połącz sygnał dwukliku z podglądem zamówienia
+    connect(card, &OrderCard::orderDoubleClicked, this, &DashboardView::previewOrder);
+    box->addOrderCard(card);
+    m_cards.insert(order.id, card);
+    m_cardClients.insert(order.id, order.clientId);
+}
+
+void DashboardView::removeCard(int orderId) {
+    QPointer<OrderCard> card = m_cards.take(orderId);
+    m_cardClients.remove(orderId);
+    if (card) card->deleteLater();
+}
+
+void DashboardView::onRowsChanged(const QVector<RowChange> &changes) {
+    // Pełne odświeżenie w toku mogło nie uwzględnić tych zmian - powtórz je po zakończeniu
+    if (m_loadWatcher->isRunning()) {
+        m_reloadPending = true;
+        return;
+    }
+    const QSet<int> deleted = ChangeFeed::deletedOrderIds(changes);
+    for (int id : deleted) removeCard(id);
+
+    QSet<int> ids = ChangeFeed::changedOrderIds(changes);
+    ids.subtract(deleted);
+    // Zmieniona nazwa klienta na kartach jego zamówień
+    const QSet<int> clients = ChangeFeed::changedClientIds(changes);
+    for (auto it = m_cardClients.cbegin(); it != m_cardClients.cend(); ++it) {
+        if (clients.contains(it.value())) ids.insert(it.key());
+    }
+    if (ids.isEmpty()) return;
+    // Import lub archiwizacja zmienia tysiące zamówień - taniej odświeżyć całą tablicę
+    if (ids.size() > MAX_MERGED_CHANGES) {
+        refreshDashboard();
+        return;
+    }
+
+    const QVector<int> requested(ids.cbegin(), ids.cend());
+    const quint64 generation = m_gridGeneration;
+    auto* watcher = new QFutureWatcher<std::optional<QVector<Order>>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, requested]() {
+        watcher->deleteLater();
+        if (generation != m_gridGeneration) return;
+        const std::optional<QVector<Order>> orders = watcher->result();
+        // Bez wyniku karty zostają bez zmian - usunięcie ich wyglądałoby jak skasowane zamówienia
+        if (!orders) {
+            qWarning() << "[DashboardView] Nie pobrano zmienionych zamówień:" << DbManager::instance().lastError().text();
+            return;
+        }
+        replaceCards(requested, *orders);
+    });
+    watcher->setFuture(DbManager::instance().async().fetchOrdersByIds(requested));
+}
+
+void DashboardView::replaceCards(const QVector<int> &orderIds, const QVector<Order> &orders) {
+    for (int id : orderIds) removeCard(id);
+    // Zamówienia spoza czterech tygodni tablicy i zrealizowane pomija addCard
+    for (const Order &order : orders) addCard(order);
 }
 
 void DashboardView::onOrderStatusChanged(int orderId, Order::Status newStatus) {
@@ -242,27 +259,13 @@ void DashboardView::onOrderStatusChanged(int orderId, Order::Status newStatus) {
 
 void DashboardView::previewOrder(int orderId) {
     auto& db = DbManager::instance();
-    auto orders = db.getOrders();
-    QMap<QString, QVariant> order;
-    for (const auto& o : orders) {
-        if (o["id"].toInt() == orderId) {
-            order = o;
-            break;
-        }
-    }
+    const QMap<QString, QVariant> order = db.getOrderById(orderId);
     if (order.isEmpty()) {
         QMessageBox::warning(this, "Podgląd zamówienia", "Nie znaleziono zamówienia o podanym ID.");
         return;
     }
     int clientId = order["client_id"].toInt();
-    QVector<QMap<QString, QVariant>> clients = db.getClients();
-    QMap<QString, QVariant> client;
-    for (const auto &c : clients) {
-        if (c["id"].toInt() == clientId) {
-            client = c;
-            break;
-        }
-    }
+    QMap<QString, QVariant> client = db.getClientById(clientId);
     QDialog dlg(this);
     dlg.setWindowTitle("Podgląd zamówienia " + order["order_number"].toString());
     dlg.resize(900, 700);
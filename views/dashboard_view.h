@@ -1,7 +1,19 @@
 #pragma once
 #include <QWidget>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QVector>
 #include "models/order.h"
 
+class QLabel;
+class QScrollArea;
+class DayBox;
+class OrderCard;
+struct DashboardData;
+struct RowChange;
+
 class DashboardView : public QWidget {
     Q_OBJECT
 public:
@@ -13,6 +25,27 @@ public slots:
 
 signals:
     void orderStatusChanged(int orderId, Order::Status newStatus);
+
+private:
+    void onDashboardLoaded();
+    // Podmienia tylko karty zamówień, których dotyczą zmiany w bazie;
+    // przy więcej niż MAX_MERGED_CHANGES zamówieniach odświeża całą tablicę
+    void onRowsChanged(const QVector<RowChange> &changes);
+    static const int MAX_MERGED_CHANGES = 300;
+    void replaceCards(const QVector<int> &orderIds, const QVector<Order> &orders);
+    void addCard(const Order &order);
+    void removeCard(int orderId);
+
+    QScrollArea *m_scroll = nullptr;
+    QLabel *m_loadingLabel = nullptr;
+    QFutureWatcher<DashboardData> *m_loadWatcher = nullptr;
+    bool m_reloadPending = false;
+    // Stan bieżącej tablicy (przebudowywany w onDashboardLoaded)
+    QMap<QDate, DayBox*> m_dayBoxes;
+    QHash<int, QPointer<OrderCard>> m_cards;
+    QHash<int, int> m_cardClients; // id zamówienia -> id klienta
+    // Zwiększane przy przebudowie tablicy - starsze wyniki są odrzucane
+    quint64 m_gridGeneration = 0;
 };
 
 QWidget* createDashboardGrid(QWidget *parent = nullptr);
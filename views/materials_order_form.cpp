@@ -783,14 +783,7 @@ void MaterialsOrderForm::handleSaveOrder() {
         QComboBox *length = qobject_cast<QComboBox*>(materialsTable->cellWidget(i, 3));
         QComboBox *qty = qobject_cast<QComboBox*>(materialsTable->cellWidget(i, 4));
         QString matName = mat ? mat->currentText() : "";
-        int materialId = -1;
-        QVector<QMap<QString, QVariant>> mats = DbManager::instance().getMaterialsCatalog();
-        for (const auto &m : mats) {
-            if (m["name"].toString() == matName) {
-                materialId = m["id"].toInt();
-                break;
-            }
-        }
+        int materialId = DbManager::instance().findMaterialIdByName(matName);
         if (materialId > 0) {
             item["material_id"] = materialId;
         } else if (!matName.isEmpty()) {
@@ -801,13 +794,8 @@ void MaterialsOrderForm::handleSaveOrder() {
             matData["length"] = length ? length->currentText() : "";
             matData["unit"] = "mb";
             DbManager::instance().addMaterial(matData);
-            QVector<QMap<QString, QVariant>> mats2 = DbManager::instance().getMaterialsCatalog();
-            for (const auto &m2 : mats2) {
-                if (m2["name"].toString() == matName) {
-                    item["material_id"] = m2["id"].toInt();
-                    break;
-                }
-            }
+            int newMaterialId = DbManager::instance().findMaterialIdByName(matName);
+            if (newMaterialId > 0) item["material_id"] = newMaterialId;
         } else {
             item["material_id"] = QVariant(); // fallback, nie powinno się zdarzyć
         }
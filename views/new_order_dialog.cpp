@@ -264,41 +264,9 @@ private:
     QTableWidget *table;
 };
 
-// --- Generowanie numeru zamówienia (ciąg order_sequence) ---
-QString NewOrderDialog::generateOrderNumber(QSqlDatabase db) {
-    int currentYear = QDate::currentDate().year();
-    int lastNumber = 0;
-    int lastYear = 0;
-    // Pobierz ostatni numer i rok z bazy
-    QSqlQuery q(db);
-    if (!q.exec("SELECT last_number, year FROM order_sequence WHERE id=1 FOR UPDATE")) {
-        return "";
-    }
-    if (q.next()) {
-        lastNumber = q.value(0).toInt();
-        lastYear = q.value(1).toInt();
-    }
-    int nextNumber = 0;
-    if (lastYear != currentYear) {
-        // Nowy rok – reset numeracji
-        nextNumber = 1; // od nowego roku zawsze 00001
-    } else if (lastNumber == 0) {
-        // Pierwsze uruchomienie/migracja – start od 00601
-        nextNumber = 601;
-    } else {
-        nextNumber = lastNumber + 1;
-    }
-    // Zaktualizuj sekwencję
-    QSqlQuery q2(db);
-    q2.prepare("UPDATE order_sequence SET last_number=?, year=? WHERE id=1");
-    q2.addBindValue(nextNumber);
-    q2.addBindValue(currentYear);
-    if (!q2.exec()) return "";
-    // Format numeru zamówienia: YYYY/MM/XXXXX
-    QString year = QString::number(currentYear);
-    QString month = QString::number(QDate::currentDate().month()).rightJustified(2, '0');
-    QString num = QString("%1/%2/%3").arg(year).arg(month).arg(nextNumber, 5, 10, QChar('0'));
-    return num;
+// --- Generowanie numeru zamówienia (ciąg number_sequences) ---
+QString NewOrderDialog::generateOrderNumber() {
+    return DbManager::instance().getNextOrderNumber(QDate::currentDate());
 }
 
 // --- Walidacja formularza zamówienia ---
@@ -367,14 +335,13 @@ void NewOrderDialog::saveOrder() {
         QMessageBox::critical(this, "Błąd bazy", "Brak połączenia z bazą danych.");
         return;
     }
-    db.transaction();
-    // --- Generuj numer zamówienia ---
-    QString orderNumber = generateOrderNumber(db);
+    // --- Generuj numer zamówienia (przed transakcją) ---
+    QString orderNumber = generateOrderNumber();
     if (orderNumber.isEmpty()) {
-        db.rollback();
         QMessageBox::critical(this, "Błąd bazy", "Nie udało się wygenerować numeru zamówienia.");
         return;
     }
+    db.transaction();
     // --- Dodaj zamówienie ---
     QSqlQuery q(db);
     q.prepare("INSERT INTO orders (order_number, order_date, delivery_date, client_id, notes, payment_term, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone, status) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
@@ -400,27 +367,28 @@ void NewOrderDialog::saveOrder() {
     int orderId = q.lastInsertId().toInt();
     qDebug() << "[saveOrder] Dodano zamówienie, orderId:" << orderId;
     // --- Dodaj pozycje zamówienia ---
+    QVector<QMap<QString, QVariant>> items;
     for (const auto &p : prodFieldsList) {
-        QSqlQuery q2(db);
-        q2.prepare("INSERT INTO order_items (order_id, width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-        q2.addBindValue(orderId);
-        q2.addBindValue(static_cast<QLineEdit*>(p["Szerokość"])->text());
-        q2.addBindValue(static_cast<QLineEdit*>(p["Wysokość"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["Rodzaj materiału"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["zam. ilość"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["Typ ilości"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["nawój/długość"])->text());
+        QMap<QString, QVariant> item;
+        item["width"] = static_cast<QLineEdit*>(p["Szerokość"])->text();
+        item["height"] = static_cast<QLineEdit*>(p["Wysokość"])->text();
+        item["material"] = static_cast<QComboBox*>(p["Rodzaj materiału"])->currentText();
+        item["ordered_quantity"] = static_cast<QLineEdit*>(p["zam. ilość"])->text();
+        item["quantity_type"] = static_cast<QComboBox*>(p["Typ ilości"])->currentText();
+        item["roll_length"] = static_cast<QLineEdit*>(p["nawój/długość"])->text();
         QString core = static_cast<QComboBox*>(p["Rdzeń"])->currentText() == "inny" ? static_cast<QLineEdit*>(p["Rdzeń_inny"])->text() : static_cast<QComboBox*>(p["Rdzeń"])->currentText();
-        q2.addBindValue(core);
-        q2.addBindValue(static_cast<QLineEdit*>(p["Cena"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["CenaTyp"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["zam. rolki"])->text());
-        qDebug() << "[saveOrder] Dodaję pozycję zamówienia, orderId:" << orderId;
-        if (!q2.exec()) {
-            db.rollback();
-            QMessageBox::critical(this, "Błąd bazy", "Nie udało się dodać pozycji zamówienia: " + q2.lastError().text());
-            return;
-        }
+        item["core"] = core;
+        item["price"] = static_cast<QLineEdit*>(p["Cena"])->text();
+        item["price_type"] = static_cast<QComboBox*>(p["CenaTyp"])->currentText();
+        item["zam_rolki"] = static_cast<QLineEdit*>(p["zam. rolki"])->text();
+        items.append(item);
+    }
+    qDebug() << "[saveOrder] Dodaję pozycje zamówienia, orderId:" << orderId << "liczba:" << items.size();
+    // Ten sam zapis co DbManager::addOrder - razem z kolumnami liczbowymi *_value
+    if (!dbm.insertOrderItems(orderId, items)) {
+        db.rollback();
+        QMessageBox::critical(this, "Błąd bazy", "Nie udało się dodać pozycji zamówienia: " + dbm.lastError().text());
+        return;
     }
     db.commit();
     qDebug() << "[saveOrder] Zamówienie zapisane, orderNumber:" << orderNumber;
@@ -46,7 +46,7 @@ private:
     void saveOrder();
     bool isPolishHoliday(const QDate &date) const;
     void updateOrderRolls(QMap<QString, QWidget*> &prodFields);
-    QString generateOrderNumber(QSqlDatabase db);
+    QString generateOrderNumber();
     bool validateOrderForm(QString &errors);
     void fetchGusData(const QString& nip); // Nowa metoda do pobierania danych z GUS
 
@@ -478,8 +478,17 @@ void NewOrderView::saveOrder() {
         QMessageBox::warning(this, "Błąd danych", errors);
         return;
     }
-    db.transaction();
     QString orderNumber;
+    if (!(editMode && currentOrderId > 0)) {
+        // Numer pobierany przed transakcją - nie trzyma blokady ciągu do końca zapisu
+        orderNumber = generateOrderNumber();
+        qDebug() << "[DEBUG] Wygenerowano numer zamówienia:" << orderNumber;
+        if (orderNumber.isEmpty()) {
+            QMessageBox::critical(this, "Błąd bazy", "Nie udało się wygenerować numeru zamówienia.");
+            return;
+        }
+    }
+    db.transaction();
     int orderId = -1;
     // --- Pobierz client_id na podstawie client_number ---
     int clientId = -1;
@@ -518,26 +527,9 @@ void NewOrderView::saveOrder() {
             return;
         }
         orderId = currentOrderId;
-        // Usuń stare pozycje zamówienia
-        QSqlQuery qDel(db);
-        qDel.prepare("DELETE FROM order_items WHERE order_id = ?");
-        qDel.addBindValue(orderId);
-        if (!qDel.exec()) {
-            db.rollback();
-            qDebug() << "[ERROR] DELETE order_items failed:" << qDel.lastError().text();
-            QMessageBox::critical(this, "Błąd bazy", "Nie udało się usunąć pozycji zamówienia: " + qDel.lastError().text());
-            return;
-        }
         success = true;
     } else {
         // --- INSERT nowe/duplikowane zamówienie ---
-        orderNumber = generateOrderNumber(db);
-        qDebug() << "[DEBUG] Wygenerowano numer zamówienia:" << orderNumber;
-        if (orderNumber.isEmpty()) {
-            db.rollback();
-            QMessageBox::critical(this, "Błąd bazy", "Nie udało się wygenerować numeru zamówienia.");
-            return;
-        }
         QSqlQuery q(db);
         q.prepare("INSERT INTO orders (order_number, order_date, delivery_date, client_id, notes, payment_term, delivery_company, delivery_street, delivery_postal_code, delivery_city, delivery_contact_person, delivery_phone, status) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
         q.addBindValue(orderNumber);
@@ -563,28 +555,35 @@ void NewOrderView::saveOrder() {
         }
         success = true;
     }
-    // --- Dodaj pozycje zamówienia ---
+    // --- Dodaj pozycje zamówienia (jedno zapytanie na porcję pozycji) ---
+    QVector<QMap<QString, QVariant>> items;
+    items.reserve(prodFieldsList.size());
     for (const auto &p : prodFieldsList) {
-        QSqlQuery q2(db);
-        q2.prepare("INSERT INTO order_items (order_id, width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-        q2.addBindValue(orderId);
-        q2.addBindValue(static_cast<QLineEdit*>(p["Szerokość"])->text());
-        q2.addBindValue(static_cast<QLineEdit*>(p["Wysokość"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["Rodzaj materiału"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["zam. ilość"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["Typ ilości"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["nawój/długość"])->text());
-        QString core = static_cast<QComboBox*>(p["Rdzeń"])->currentText() == "inny" ? static_cast<QLineEdit*>(p["Rdzeń_inny"])->text() : static_cast<QComboBox*>(p["Rdzeń"])->currentText();
-        q2.addBindValue(core);
-        q2.addBindValue(static_cast<QLineEdit*>(p["Cena"])->text());
-        q2.addBindValue(static_cast<QComboBox*>(p["CenaTyp"])->currentText());
-        q2.addBindValue(static_cast<QLineEdit*>(p["zam. rolki"])->text());
-        if (!q2.exec()) {
-            db.rollback();
-            qDebug() << "[ERROR] INSERT order_items failed:" << q2.lastError().text();
-            QMessageBox::critical(this, "Błąd bazy", "Nie udało się dodać pozycji zamówienia: " + q2.lastError().text());
-            return;
-        }
+        QMap<QString, QVariant> item;
+        item["width"] = static_cast<QLineEdit*>(p["Szerokość"])->text();
+        item["height"] = static_cast<QLineEdit*>(p["Wysokość"])->text();
+        item["material"] = static_cast<QComboBox*>(p["Rodzaj materiału"])->currentText();
+        item["ordered_quantity"] = static_cast<QLineEdit*>(p["zam. ilość"])->text();
+        item["quantity_type"] = static_cast<QComboBox*>(p["Typ ilości"])->currentText();
+        item["roll_length"] = static_cast<QLineEdit*>(p["nawój/długość"])->text();
+        item["core"] = static_cast<QComboBox*>(p["Rdzeń"])->currentText() == "inny" ? static_cast<QLineEdit*>(p["Rdzeń_inny"])->text() : static_cast<QComboBox*>(p["Rdzeń"])->currentText();
+        item["price"] = static_cast<QLineEdit*>(p["Cena"])->text();
+        item["price_type"] = static_cast<QComboBox*>(p["CenaTyp"])->currentText();
+        item["zam_rolki"] = static_cast<QLineEdit*>(p["zam. rolki"])->text();
+        // Id pozycji wczytanej do edycji - zapis zmienia tylko ją, zamiast usuwać i wstawiać wszystkie
+        const QVariant itemId = p["block_widget"]->property("item_id");
+        if (editMode && currentOrderId > 0 && itemId.isValid()) item["id"] = itemId;
+        items.append(item);
+    }
+    // DbManager w wątku GUI używa tego samego połączenia, więc pozycje trafiają do otwartej transakcji
+    const bool itemsSaved = (editMode && currentOrderId > 0) ? DbManager::instance().syncOrderItems(orderId, items)
+                                                             : DbManager::instance().insertOrderItems(orderId, items);
+    if (!itemsSaved) {
+        db.rollback();
+        QString error = DbManager::instance().lastError().text();
+        qDebug() << "[ERROR] INSERT order_items failed:" << error;
+        QMessageBox::critical(this, "Błąd bazy", "Nie udało się dodać pozycji zamówienia: " + error);
+        return;
     }
     if (success) {
         if (!db.commit()) {
@@ -687,26 +686,11 @@ bool NewOrderView::validateOrderForm(QString &errors) {
     return errors.isEmpty();
 }
 
-QString NewOrderView::generateOrderNumber(QSqlDatabase db) {
-    QSqlQuery q(db);
-    // Pobierz ostatni numer
-    if (!q.exec("SELECT last_number FROM order_sequence WHERE id=1 FOR UPDATE")) {
-        qDebug() << "[ERROR] Nie można pobrać sekwencji zamówień:" << q.lastError().text();
-        return "";
-    }
-    int lastNumber = 0;
-    if (q.next())
-        lastNumber = q.value(0).toInt();
-    int nextNumber = (lastNumber < 750) ? 751 : lastNumber + 1;
-    // Format numeru zamówienia: ZAM-2025-0xx
-    QString year = QString::number(QDate::currentDate().year());
-    QString num = QString("ZAM-%1-%2").arg(year).arg(nextNumber, 3, 10, QChar('0'));
-    // Zaktualizuj sekwencję tylko jeśli numer zostanie użyty
-    QSqlQuery q2(db);
-    q2.prepare("UPDATE order_sequence SET last_number=? WHERE id=1");
-    q2.addBindValue(nextNumber);
-    if (!q2.exec()) {
-        qDebug() << "[ERROR] Nie można zaktualizować sekwencji zamówień:" << q2.lastError().text();
+QString NewOrderView::generateOrderNumber() {
+    // Numer z ciągu number_sequences (jedno zapytanie, bez blokowania innych stanowisk)
+    QString num = DbManager::instance().getNextOrderNumber(QDate::currentDate());
+    if (num.isEmpty()) {
+        qDebug() << "[ERROR] Nie można pobrać numeru zamówienia:" << DbManager::instance().lastError().text();
     }
     return num;
 }
@@ -1039,7 +1023,7 @@ void NewOrderView::loadOrderData(const QMap<QString, QVariant> &orderData, bool
         // --- Pobierz pozycje zamówienia i wypełnij bloki ---
         QVector<QMap<QString, QVariant>> items;
         QSqlQuery qItems(db); // Użyj tej samej otwartej bazy
-        qItems.prepare("SELECT width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki FROM order_items WHERE order_id = ?");
+        qItems.prepare("SELECT width, height, material, ordered_quantity, quantity_type, roll_length, core, price, price_type, zam_rolki, id FROM order_items WHERE order_id = ? ORDER BY id");
         qItems.addBindValue(orderData.value("id"));
         if (qItems.exec()) {
             while (qItems.next()) {
@@ -1054,6 +1038,7 @@ void NewOrderView::loadOrderData(const QMap<QString, QVariant> &orderData, bool
                 item["price"] = qItems.value(7);
                 item["price_type"] = qItems.value(8);
                 item["zam_rolki"] = qItems.value(9);
+                item["id"] = qItems.value(10);
                 items.append(item);
             }
         } else {
@@ -1071,6 +1056,7 @@ void NewOrderView::loadOrderData(const QMap<QString, QVariant> &orderData, bool
             addProductBlock(i+1);
             qDebug() << "[loadOrderData] addProductBlock(" << (i+1) << ")";
             auto& p = prodFieldsList.last();
+            p["block_widget"]->setProperty("item_id", items[i]["id"]);
             static_cast<QLineEdit*>(p["Szerokość"])->setText(items[i]["width"].toString());
             static_cast<QLineEdit*>(p["Wysokość"])->setText(items[i]["height"].toString());
             static_cast<QComboBox*>(p["Rodzaj materiału"])->setCurrentText(items[i]["material"].toString());
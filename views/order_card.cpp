@@ -1,5 +1,6 @@
 #include "order_card.h"
 #include "db/dbmanager.h"
+#include "db/async_db.h"
 #include "views/production_table_view.h"
 #include <QFont>
 #include <QDialog>
@@ -14,6 +15,7 @@
 #include <QHeaderView>
 #include <QStandardItemModel>
 #include <QTimer>
+#include <QFutureWatcher>
 
 static std::pair<QColor, QColor> getGradientForShippingDays(int workdaysLeft) {
     if (workdaysLeft < 0)
@@ -286,20 +288,26 @@ void OrderCard::updateOrderStatus(Order::Status newStatus) {
         qDebug() << "[OrderCard] Status bez zmian, nie aktualizuję.";
         return;
     }
+    // Przycisk zmienia się od razu, zapis do bazy idzie w tle;
+    // przy błędzie przywracamy poprzedni status
+    Order::Status previousStatus = order.status;
     order.status = newStatus;
-    // Aktualizacja w bazie
-    QSqlQuery q(DbManager::instance().database());
-    q.prepare("UPDATE orders SET status=? WHERE id=?");
-    q.addBindValue(static_cast<int>(newStatus));
-    q.addBindValue(order.id);
-    if (!q.exec()) {
-        qDebug() << "[OrderCard] Błąd SQL przy update statusu: " << q.lastError().text();
-        QMessageBox::warning(this, "Błąd bazy", "Nie udało się zaktualizować statusu zamówienia: " + q.lastError().text());
-        return;
-    }
-    qDebug() << "[OrderCard] Status zamówienia zaktualizowany w bazie.";
-    // Emituj sygnał o zmianie statusu
-    emit orderStatusChanged(order.id, newStatus);
+    auto* watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, previousStatus, newStatus]() {
+        watcher->deleteLater();
+        if (!watcher->result()) {
+            QString error = DbManager::instance().lastError().text();
+            qDebug() << "[OrderCard] Błąd SQL przy update statusu: " << error;
+            order.status = previousStatus;
+            updateStatusButtons();
+            QMessageBox::warning(this, "Błąd bazy", "Nie udało się zaktualizować statusu zamówienia: " + error);
+            return;
+        }
+        qDebug() << "[OrderCard] Status zamówienia zaktualizowany w bazie.";
+        // Emituj sygnał o zmianie statusu
+        emit orderStatusChanged(order.id, newStatus);
+    });
+    watcher->setFuture(DbManager::instance().async().updateOrderStatus(order.id, newStatus));
     // Przyciski są już aktualizowane przez updateStatusButtons() w onclick handlerach
 }
 
@@ -1,10 +1,12 @@
 #include "orders_db_view.h"
 #include "db/dbmanager.h"
+#include "db/change_feed.h"
+#include "db/order_archive.h"
 #include "views/order_dialog.h"
 #include "views/new_order_view.h"
 #include "views/print_dialog.h"
+#include "views/orders_table_model.h"
 #include "models/order.h"
-#include <QStandardItemModel>
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QItemSelectionModel>
@@ -44,7 +46,16 @@ void OrdersDbView::setupUI() {
     connect(searchTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &OrdersDbView::loadOrders);
     searchEdit = new QLineEdit(this);
     searchEdit->setPlaceholderText("Szukaj...");
-    connect(searchEdit, &QLineEdit::textChanged, this, &OrdersDbView::loadOrders);
+    // Wyszukiwanie idzie do bazy - zapytanie dopiero po przerwie w pisaniu
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(250);
+    connect(searchTimer, &QTimer::timeout, this, &OrdersDbView::loadOrders);
+    connect(searchEdit, &QLineEdit::textChanged, searchTimer, qOverload<>(&QTimer::start));
+    // Domyślnie tylko bieżące zamówienia; archiwum na żądanie
+    archiveCheck = new QCheckBox("Uwzględnij archiwum", this);
+    archiveCheck->setToolTip("Pokaż także zrealizowane zamówienia przeniesione do archiwum");
+    connect(archiveCheck, &QCheckBox::toggled, this, &OrdersDbView::loadOrders);
     // --- Nowy układ: wszystkie przyciski i pole szukania w jednym wierszu ---
     btnAdd = new QPushButton("Dodaj zamówienie", this);
     btnEdit = new QPushButton("Edytuj", this);
@@ -68,6 +79,11 @@ void OrdersDbView::setupUI() {
     btnLayout->addWidget(new QLabel("Szukaj: ", this));
     btnLayout->addWidget(searchTypeCombo);
     btnLayout->addWidget(searchEdit);
+    btnLayout->addWidget(archiveCheck);
+    loadingLabel = new QLabel("Ładowanie zamówień...", this);
+    loadingLabel->setStyleSheet("color: #6b7280; font-style: italic;");
+    loadingLabel->hide();
+    btnLayout->addWidget(loadingLabel);
     btnLayout->addStretch(1);
     tableView = new QTableView(this);
     mainLayout = new QVBoxLayout(this);
@@ -80,172 +96,30 @@ void OrdersDbView::setupUI() {
     connect(btnDuplicate, &QPushButton::clicked, this, &OrdersDbView::duplicateOrder);
     connect(btnPreview, &QPushButton::clicked, this, &OrdersDbView::previewOrder);
     connect(btnPrint, &QPushButton::clicked, this, &OrdersDbView::openPrintDialog);
-    // Dwuklik na wierszu tabeli otwiera podgląd zamówienia
-    connect(tableView, &QTableView::doubleClicked, this, [this](const QModelIndex &index) {
-        if (!index.isValid()) return;
-        int row = index.row();
-        QStandardItemModel *model = qobject_cast<QStandardItemModel*>(tableView->model());
-        if (!model) return;
-        QModelIndex idIndex = model->index(row, 0); // kolumna 0: order_number z id w UserRole+1
-        int orderId = idIndex.data(Qt::UserRole + 1).toInt();
-        if (orderIdToData.contains(orderId)) {
-            selectedOrderId = orderId;
-            previewOrder();
-        }
-    });
-}
-
-void OrdersDbView::loadOrders() {
-    try {
-        auto& db = DbManager::instance();
-        
-        // Check if database is available
-        if (!db.isOpen()) {
-            QMessageBox::warning(this, "Database Error", 
-                "Database connection is not available. Some features may not work.");
-            return;
-        }
-        
-        auto orders = db.getOrders();
-        QString filter = searchEdit ? searchEdit->text().trimmed() : "";
-        int searchType = searchTypeCombo ? searchTypeCombo->currentIndex() : 0;
-        QList<QMap<QString, QVariant>> filtered;
-        orderIdToData.clear();
-        QVector<QMap<QString, QVariant>> clients = db.getClients();
-        QMap<int, QString> clientIdToName;
-        QMap<int, QString> clientIdToNumber;
-        for (const auto &c : clients) {
-            clientIdToName[c["id"].toInt()] = c["name"].toString();
-            clientIdToNumber[c["id"].toInt()] = c["client_number"].toString();
-        }
-        
-        if (!filter.isEmpty()) {
-            for (const auto &o : orders) {
-                int cid = o["client_id"].toInt();
-                bool match = false;
-                
-                if (searchType == 0) { // Nr zamówienia
-                    match = o["order_number"].toString().contains(filter, Qt::CaseInsensitive);
-                } else if (searchType == 1) { // Nr klienta
-                    match = clientIdToNumber.value(cid).contains(filter, Qt::CaseInsensitive);
-                } else if (searchType == 2) { // Firma
-                    match = clientIdToName.value(cid).contains(filter, Qt::CaseInsensitive);
-                }
-                
-                if (match) {
-                    filtered.append(o);
-                }
-            }
-        } else {
-            filtered = orders;
-        }
-    // Nowy model: 9 kolumn: nr zamówienia, data zamówienia, data wysyłki, nr klienta, klient, cena, dane produkcji, uwagi, status
-    auto *model = new QStandardItemModel(filtered.size(), 9, this);
-    model->setHorizontalHeaderLabels({"Nr zamówienia", "Data zamówienia", "Data wysyłki", "Nr klienta", "Klient", "Cena", "Dane produkcji", "Uwagi", "Status"});
-    for (int row = 0; row < filtered.size(); ++row) {
-        int oid = filtered[row]["id"].toInt();
-        int cid = filtered[row]["client_id"].toInt();
-        // --- Numer zamówienia pogrubiony ---
-        QStandardItem *orderNumItem = new QStandardItem(filtered[row]["order_number"].toString());
-        QFont boldFont = orderNumItem->font();
-        boldFont.setBold(true);
-        orderNumItem->setFont(boldFont);
-        // --- DODAJ ID jako UserRole+1 ---
-        orderNumItem->setData(oid, Qt::UserRole + 1);
-        model->setItem(row, 0, orderNumItem);
-        // --- Data zamówienia ---
-        model->setItem(row, 1, new QStandardItem(filtered[row]["order_date"].toDate().toString("yyyy-MM-dd")));
-        // --- Data wysyłki ---
-        model->setItem(row, 2, new QStandardItem(filtered[row]["delivery_date"].toDate().toString("yyyy-MM-dd")));
-        // --- Nr klienta ---
-        model->setItem(row, 3, new QStandardItem(clientIdToNumber.value(cid)));
-        // --- Klient ---
-        model->setItem(row, 4, new QStandardItem(clientIdToName.value(cid)));
-        // --- Cena i szczegóły produkcji ---
-        QString prodDetails;
-        QSqlQuery q(db.database());
-        q.prepare("SELECT price, price_type, material, width, height, ordered_quantity, quantity_type FROM order_items WHERE order_id=?");
-        q.addBindValue(oid);
-        if (q.exec()) {
-            QStringList prodList;
-            QString priceCellValue;
-            priceCellValue = "";
-            while (q.next()) {
-                QString w = q.value(3).toString().trimmed();
-                QString h = q.value(4).toString().trimmed();
-                QString mat = q.value(2).toString().trimmed();
-                QString qty = q.value(5).toString().trimmed();
-                QString qtyType = q.value(6).toString();
-                QString priceType = q.value(1).toString();
-                QString price = q.value(0).toString();
-                bool ok = false;
-                int qtyInt = qty.toInt(&ok);
-                // Dodajemy tylko jeśli szerokość, wysokość, materiał i ilość są niepuste i ilość > 0
-                if (!w.isEmpty() && !h.isEmpty() && !mat.isEmpty() && ok && qtyInt > 0) {
-                    prodList << QString("%1 %2x%3 %4 %5").arg(mat).arg(w).arg(h).arg(qty).arg(qtyType);
-                        QString priceSuffix;
-                    QString pt = priceType.trimmed().toLower();
-                    if (pt.contains("rolk")) {
-                        priceSuffix = "zł/rolkę";
-                    } else {
-                        priceSuffix = "zł/tyś.";
-                    }
-                    if (!priceCellValue.isEmpty()) {
-                        priceCellValue += "\n";
-                    }
-                    priceCellValue += QString("%1 %2").arg(price, priceSuffix);
-                }
-            }
-            prodDetails = prodList.join("\n"); // każda pozycja w nowej linii
-            // Ustaw w kolumnie Cena tylko pierwszą cenę z sufiksem, jeśli istnieje
-            if (!priceCellValue.isEmpty()) {
-                model->setItem(row, 5, new QStandardItem(priceCellValue));
-            } else {
-                model->setItem(row, 5, new QStandardItem(""));
-            }
-        } else {
-            model->setItem(row, 5, new QStandardItem(""));
-        }
-        // --- Dane produkcji (agregacja) ---
-        model->setItem(row, 6, new QStandardItem(prodDetails));
-        // --- Uwagi ---
-        model->setItem(row, 7, new QStandardItem(filtered[row]["notes"].toString()));
-        
-        // --- Status zamówienia ---
-        int statusValue = filtered[row].contains("status") ? filtered[row]["status"].toInt() : 0;
-        Order::Status status = static_cast<Order::Status>(statusValue);
-        QString statusText = QString("%1 (%2)").arg(statusValue + 1).arg(Order::statusToString(status));
-        
-        QStandardItem *statusItem = new QStandardItem(statusText);
-        // Ustaw kolor tła w zależności od statusu
-        switch (status) {
-        case Order::Przyjete:
-            statusItem->setBackground(QColor("#fff3cd")); // żółte tło
-            statusItem->setForeground(QColor("#856404")); // ciemno-żółty tekst
-            break;
-        case Order::Produkcja:
-            statusItem->setBackground(QColor("#d1ecf1")); // niebieskie tło
-            statusItem->setForeground(QColor("#0c5460")); // ciemno-niebieski tekst
-            break;
-        case Order::Gotowe:
-            statusItem->setBackground(QColor("#d4edda")); // zielone tło
-            statusItem->setForeground(QColor("#155724")); // ciemno-zielony tekst
-            break;
-        case Order::Zrealizowane:
-            statusItem->setBackground(QColor("#e2e3e5")); // szare tło
-            statusItem->setForeground(QColor("#383d41")); // ciemno-szary tekst
-            break;
-        }
-        model->setItem(row, 8, statusItem);
-        
-        orderIdToData[oid] = filtered[row];
-    }
+    // Model doczytuje zamówienia stronami w tle; komórki formatuje dopiero przy wyświetlaniu
+    model = new OrdersTableModel(this);
+    connect(model, &OrdersTableModel::loadingChanged, this, &OrdersDbView::setLoading);
     tableView->setModel(model);
-    // Sortuj po kolumnie 0 (Nr zamówienia) rosnąco
-    tableView->setSortingEnabled(true);
-    tableView->sortByColumn(0, Qt::AscendingOrder);
-    // Kolumna 0 (Nr zamówienia) widoczna
+    // Kolejność z bazy (najnowsze pierwsze) - sortowanie w widoku dotyczyłoby
+    // tylko wczytanych stron
+    tableView->setSortingEnabled(false);
     connect(tableView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &OrdersDbView::onSelectionChanged);
+    // Reset modelu czyści zaznaczenie bez sygnału selectionChanged
+    connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+        onSelectionChanged(QItemSelection(), QItemSelection());
+    });
+    // Wysokość liczona tylko dla nowo wczytanych wierszy, szerokość kolumn - po pierwszej stronie
+    connect(model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; ++row) tableView->resizeRowToContents(row);
+        if (first == 0) tableView->resizeColumnsToContents();
+    });
+    // Wiersz podmieniony po zmianie w bazie może mieć inną liczbę pozycji
+    connect(model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+        if (!roles.isEmpty()) return;
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) tableView->resizeRowToContents(row);
+    });
+    // Zmiany z innych stanowisk nanoszone na wczytane wiersze bez przeładowania listy
+    connect(&DbManager::instance().changeFeed(), &ChangeFeed::changed, model, &OrdersTableModel::applyChanges);
     tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
     tableView->horizontalHeader()->setStretchLastSection(false);
     QFont headerFont = tableView->horizontalHeader()->font();
@@ -263,20 +137,37 @@ void OrdersDbView::loadOrders() {
         "QTableView::item:selected { background: #2563eb; color: #fff; } "
         "QTableView::item:focus { background: #2563eb; } "
     );
-    tableView->resizeColumnsToContents();
-    tableView->resizeRowsToContents();
     tableView->verticalHeader()->setVisible(false);
+    // Dwuklik na wierszu tabeli otwiera podgląd zamówienia
+    connect(tableView, &QTableView::doubleClicked, this, [this](const QModelIndex &index) {
+        if (!index.isValid()) return;
+        selectedOrderId = index.data(OrdersTableModel::OrderIdRole).toInt();
+        previewOrder();
+    });
+}
+
+void OrdersDbView::loadOrders() {
+    auto& db = DbManager::instance();
     
-    // Podświetlenie wyników wyszukiwania
-    highlightSearchResults(model, filter, searchType);
-    
-    } catch (const std::exception &e) {
-        QMessageBox::critical(this, "Database Error", 
-            QString("Error loading orders: %1").arg(e.what()));
-    } catch (...) {
-        QMessageBox::critical(this, "Database Error", 
-            "Unknown error occurred while loading orders");
+    // Check if database is available
+    if (!db.isOpen()) {
+        QMessageBox::warning(this, "Database Error", 
+            "Database connection is not available. Some features may not work.");
+        return;
     }
+    
+    // Wyszukiwanie filtruje po stronie bazy; model pobiera pierwszą stronę w tle,
+    // kolejne doczytuje przy przewijaniu (fetchMore)
+    QString filter = searchEdit ? searchEdit->text().trimmed() : "";
+    int searchType = searchTypeCombo ? searchTypeCombo->currentIndex() : 0;
+    model->reload(filter, static_cast<OrderSearchField>(searchType), archiveCheck && archiveCheck->isChecked());
+    // Wyniki wyszukiwania podświetlone do pierwszego kliknięcia w wiersz
+    model->setSearchHighlight(!filter.isEmpty());
+}
+
+void OrdersDbView::setLoading(bool loading) {
+    loadingLabel->setVisible(loading);
+    if (loading) setCursor(Qt::BusyCursor); else unsetCursor();
 }
 
 void OrdersDbView::refreshOrders() { 
@@ -288,14 +179,28 @@ void OrdersDbView::addOrder() {
 
 void OrdersDbView::editOrder() {
     if (selectedOrderId < 0) return;
-    if (!orderIdToData.contains(selectedOrderId)) return;
-    emit requestEditOrder(orderIdToData[selectedOrderId]);
+    QMap<QString, QVariant> order = model->orderData(selectedOrderId);
+    if (order.isEmpty()) return;
+    if (order.value("archived").toBool()) {
+        // Edytowane są tylko zamówienia bieżące - archiwalne najpierw wracają do orders
+        if (QMessageBox::question(this, "Zamówienie w archiwum",
+                                  "Zamówienie jest w archiwum. Przywrócić je do bieżących zamówień i edytować?") != QMessageBox::Yes) {
+            return;
+        }
+        if (!DbManager::instance().restoreArchivedOrder(selectedOrderId)) {
+            QMessageBox::warning(this, "Błąd", "Nie udało się przywrócić zamówienia z archiwum.");
+            return;
+        }
+        order["archived"] = false;
+    }
+    emit requestEditOrder(order);
 }
 
 void OrdersDbView::duplicateOrder() {
     if (selectedOrderId < 0) return;
-    if (!orderIdToData.contains(selectedOrderId)) return;
-    emit requestDuplicateOrder(orderIdToData[selectedOrderId]);
+    QMap<QString, QVariant> order = model->orderData(selectedOrderId);
+    if (order.isEmpty()) return;
+    emit requestDuplicateOrder(order);
 }
 
 void OrdersDbView::deleteOrder() {
@@ -308,36 +213,32 @@ void OrdersDbView::deleteOrder() {
 }
 void OrdersDbView::onSelectionChanged(const QItemSelection &selected, const QItemSelection &) {
     bool hasSel = !selected.indexes().isEmpty();
+    // Zamówienie z archiwum: tylko podgląd i edycja (po przywróceniu)
+    const bool archived = hasSel && model->orderData(selected.indexes().first().data(OrdersTableModel::OrderIdRole).toInt())
+                                        .value("archived").toBool();
     btnEdit->setEnabled(hasSel);
-    btnDelete->setEnabled(hasSel);
-    btnDuplicate->setEnabled(hasSel);
+    btnDelete->setEnabled(hasSel && !archived);
+    btnDuplicate->setEnabled(hasSel && !archived);
     btnPreview->setEnabled(hasSel);
-    btnPrint->setEnabled(hasSel);
+    btnPrint->setEnabled(hasSel && !archived);
     if (hasSel) {
-        // Pobierz ID z UserRole+1 z pierwszej kolumny
-        QModelIndex idx = selected.indexes().first();
-        selectedOrderId = idx.sibling(idx.row(), 0).data(Qt::UserRole + 1).toInt();
+        selectedOrderId = selected.indexes().first().data(OrdersTableModel::OrderIdRole).toInt();
+        // Kliknięcie w wiersz kończy podświetlenie wyników wyszukiwania
+        model->setSearchHighlight(false);
     } else {
         selectedOrderId = -1;
     }
 }
 
 void OrdersDbView::previewOrder() {
-    if (selectedOrderId < 0 || !orderIdToData.contains(selectedOrderId)) {
+    const QMap<QString, QVariant> order = selectedOrderId < 0 ? QMap<QString, QVariant>() : model->orderData(selectedOrderId);
+    if (order.isEmpty()) {
         QMessageBox::information(this, "Podgląd zamówienia", "Nie wybrano zamówienia.");
         return;
     }
-    const QMap<QString, QVariant> &order = orderIdToData[selectedOrderId];
     auto& db = DbManager::instance();
     int clientId = order["client_id"].toInt();
-    QVector<QMap<QString, QVariant>> clients = db.getClients();
-    QMap<QString, QVariant> client;
-    for (const auto &c : clients) {
-        if (c["id"].toInt() == clientId) {
-            client = c;
-            break;
-        }
-    }
+    QMap<QString, QVariant> client = db.getClientById(clientId);
     QDialog dlg(this);
     dlg.setWindowTitle("Podgląd zamówienia " + order["order_number"].toString());
     dlg.resize(900, 700);
@@ -372,7 +273,8 @@ void OrdersDbView::previewOrder() {
     QGroupBox *groupboxProduction = new QGroupBox("Dane produkcji");
     QVBoxLayout *productionLayout = new QVBoxLayout(groupboxProduction);
     QSqlQuery q(db.database());
-    q.prepare("SELECT material, width, height, ordered_quantity, quantity_type, roll_length, core, price, price_type FROM order_items WHERE order_id=?");
+    q.prepare(QString("SELECT material, width, height, ordered_quantity, quantity_type, roll_length, core, price, price_type FROM %1 WHERE order_id=?")
+                  .arg(order.value("archived").toBool() ? OrderArchive::ORDER_ITEMS : "order_items"));
     q.addBindValue(order["id"].toInt());
     bool anyRow = false;
     if (q.exec()) {
@@ -449,71 +351,3 @@ void OrdersDbView::openPrintDialog() {
     printDialog->exec();
     printDialog->deleteLater();
 }
-
-void OrdersDbView::highlightSearchResults(QStandardItemModel* model, const QString& filter, int searchType) {
-    if (filter.isEmpty() || !model) {
-        return;
-    }
-    
-    // Wyczyść poprzednią listę podświetlonych wierszy
-    highlightedRows.clear();
-    
-    // Znajdź wiersze, które odpowiadają kryteriom wyszukiwania
-    for (int row = 0; row < model->rowCount(); ++row) {
-        bool shouldHighlight = false;
-        
-        if (searchType == 0) { // Nr zamówienia
-            QString orderNumber = model->item(row, 0)->text();
-            if (orderNumber.contains(filter, Qt::CaseInsensitive)) {
-                shouldHighlight = true;
-            }
-        } else if (searchType == 1) { // Nr klienta
-            QString clientNumber = model->item(row, 3)->text();
-            if (clientNumber.contains(filter, Qt::CaseInsensitive)) {
-                shouldHighlight = true;
-            }
-        } else if (searchType == 2) { // Firma
-            QString clientName = model->item(row, 4)->text();
-            if (clientName.contains(filter, Qt::CaseInsensitive)) {
-                shouldHighlight = true;
-            }
-        }
-        
-        if (shouldHighlight) {
-            highlightedRows.append(row);
-            // Podświetl wszystkie komórki w wierszu na pomarańczowo
-            for (int col = 0; col < model->columnCount(); ++col) {
-                QModelIndex idx = model->index(row, col);
-                model->setData(idx, QColor("#fbbf24"), Qt::BackgroundRole);
-            }
-        }
-    }
-    
-    // Ustawienie obsługi czyszczenia podświetleń po kliknięciu w wiersz
-    if (!highlightedRows.isEmpty()) {
-        // Najpierw odłączamy poprzednie połączenie, jeśli istnieje
-        if (highlightConnection) {
-            disconnect(highlightConnection);
-        }
-        
-        // Teraz łączymy sygnał z nową lambdą
-        highlightConnection = connect(tableView->selectionModel(), &QItemSelectionModel::selectionChanged, 
-            [this, model](const QItemSelection &, const QItemSelection &) {
-                // Wyczyść wszystkie podświetlenia
-                for (int row : highlightedRows) {
-                    if (row < model->rowCount()) {
-                        for (int col = 0; col < model->columnCount(); ++col) {
-                            model->setData(model->index(row, col), QVariant(), Qt::BackgroundRole);
-                        }
-                    }
-                }
-                // Wyczyść listę podświetlonych wierszy
-                highlightedRows.clear();
-                
-                // Odłącz to połączenie
-                disconnect(highlightConnection);
-                highlightConnection = QMetaObject::Connection();
-            }
-        );
-    }
-}
@@ -8,10 +8,14 @@
 #include <QItemSelection>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QMap>
-#include <QStandardItemModel>
+#include <QLabel>
+#include <QTimer>
 #include "models/user.h"
 
+class OrdersTableModel;
+
 class OrdersDbView : public QWidget {
     Q_OBJECT
 public:
@@ -40,13 +44,14 @@ private:
     QHBoxLayout *btnLayout;
     QLineEdit *searchEdit;
     QComboBox *searchTypeCombo; // Dodano wskaźnik do QComboBox dla wyboru typu wyszukiwania
+    QCheckBox *archiveCheck = nullptr; // Wyszukiwanie także w archiwum zrealizowanych zamówień
     int selectedOrderId = -1;
-    QMap<int, QMap<QString, QVariant>> orderIdToData;
-    QList<int> highlightedRows; // Lista podświetlonych wierszy
-    QMetaObject::Connection highlightConnection; // Połączenie dla obsługi wyczyszczenia podświetleń
+    OrdersTableModel *model = nullptr;
+    QTimer *searchTimer = nullptr;
+    QLabel *loadingLabel = nullptr;
     void setupUI();
     void loadOrders();
-    void highlightSearchResults(QStandardItemModel* model, const QString& filter, int searchType); // Nowa metoda do podświetlania wyników
+    void setLoading(bool loading);
     User currentUser;
 
 signals:
@@ -0,0 +1,289 @@
+#include "orders_table_model.h"
+#include "db/dbmanager.h"
+#include "db/async_db.h"
+#include "db/change_feed.h"
+#include <QFutureWatcher>
+#include <QColor>
+#include <QFont>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+
+OrdersTableModel::OrdersTableModel(QObject *parent, int pageSize)
+    : QAbstractTableModel(parent), m_pageSize(qMax(1, pageSize)) {
+}
+
+int OrdersTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int OrdersTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant OrdersTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const OrderListRow &row = m_rows.at(index.row());
+    const int column = index.column();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (column) {
+        case ColOrderNumber: return row.orderNumber;
+        case ColOrderDate: return row.orderDate.toString("yyyy-MM-dd");
+        case ColDeliveryDate: return row.deliveryDate.toString("yyyy-MM-dd");
+        case ColClientNumber: return row.clientNumber;
+        case ColClientName: return row.clientName;
+        case ColPrice: return row.priceSummary; // każda pozycja w nowej linii
+        case ColProduction: return row.productionSummary;
+        case ColNotes: return row.notes;
+        case ColStatus: {
+            const QString status = QString("%1 (%2)").arg(static_cast<int>(row.status) + 1).arg(Order::statusToString(row.status));
+            return row.archived ? status + " - archiwum" : status;
+        }
+        }
+        break;
+    case Qt::FontRole:
+        // Numer zamówienia pogrubiony
+        if (column == ColOrderNumber) {
+            QFont boldFont;
+            boldFont.setBold(true);
+            return boldFont;
+        }
+        break;
+    case Qt::BackgroundRole:
+        if (m_searchHighlight) return QColor("#fbbf24");
+        if (column == ColStatus) {
+            switch (row.status) {
+            case Order::Przyjete: return QColor("#fff3cd");      // żółte tło
+            case Order::Produkcja: return QColor("#d1ecf1");     // niebieskie tło
+            case Order::Gotowe: return QColor("#d4edda");        // zielone tło
+            case Order::Zrealizowane: return QColor("#e2e3e5");  // szare tło
+            }
+        }
+        break;
+    case Qt::ForegroundRole:
+        if (column == ColStatus) {
+            switch (row.status) {
+            case Order::Przyjete: return QColor("#856404");      // ciemno-żółty tekst
+            case Order::Produkcja: return QColor("#0c5460");     // ciemno-niebieski tekst
+            case Order::Gotowe: return QColor("#155724");        // ciemno-zielony tekst
+            case Order::Zrealizowane: return QColor("#383d41");  // ciemno-szary tekst
+            }
+        }
+        break;
+    case OrderIdRole:
+        return row.id;
+    }
+    return QVariant();
+}
+
+QVariant OrdersTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"Nr zamówienia", "Data zamówienia", "Data wysyłki", "Nr klienta", "Klient", "Cena", "Dane produkcji", "Uwagi", "Status"};
+    return section >= 0 && section < headers.size() ? headers.at(section) : QVariant();
+}
+
+bool OrdersTableModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && !m_exhausted && !m_fetching;
+}
+
+void OrdersTableModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) return;
+    requestPage();
+}
+
+void OrdersTableModel::reload(const QString &filter, OrderSearchField field, bool includeArchive) {
+    beginResetModel();
+    m_rows.clear();
+    m_rows.squeeze();
+    m_rowById.clear();
+    m_cursor = OrdersPageCursor();
+    m_filter = filter.trimmed();
+    m_field = field;
+    m_includeArchive = includeArchive;
+    ++m_generation;
+    m_exhausted = false;
+    m_fetching = false;
+    endResetModel();
+    requestPage();
+}
+
+void OrdersTableModel::requestPage() {
+    auto &db = DbManager::instance();
+    if (!db.isOpen()) {
+        m_exhausted = true;
+        return;
+    }
+    const bool wasFetching = m_fetching;
+    m_fetching = true;
+    if (!wasFetching) emit loadingChanged(true);
+    const quint64 generation = m_generation;
+    auto *watcher = new QFutureWatcher<QVector<OrderListRow>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation]() {
+        watcher->deleteLater();
+        // Lista została przeładowana w trakcie zapytania - wynik jest nieaktualny
+        if (generation != m_generation) return;
+        appendPage(watcher->result());
+    });
+    watcher->setFuture(db.async().fetchOrdersPage(m_cursor, m_pageSize, m_filter, m_field, m_includeArchive));
+}
+
+void OrdersTableModel::appendPage(const QVector<OrderListRow> &page) {
+    m_fetching = false;
+    // Niepełna strona (także pusta po błędzie zapytania) kończy doczytywanie
+    m_exhausted = page.size() < m_pageSize;
+    if (!page.isEmpty()) {
+        m_cursor = OrdersPageCursor::after(page.last());
+        // Wiersz mógł już trafić do listy przez applyChanges w trakcie zapytania
+        QVector<OrderListRow> fresh;
+        fresh.reserve(page.size());
+        for (const OrderListRow &row : page) {
+            if (!m_rowById.contains(row.id)) fresh.append(row);
+        }
+        if (!fresh.isEmpty()) {
+            const int first = m_rows.size();
+            beginInsertRows(QModelIndex(), first, first + fresh.size() - 1);
+            m_rows += fresh;
+            for (int row = first; row < m_rows.size(); ++row) {
+                m_rowById.insert(m_rows.at(row).id, row);
+            }
+            endInsertRows();
+        }
+    }
+    emit loadingChanged(false);
+}
+
+void OrdersTableModel::applyChanges(const QVector<RowChange> &changes) {
+    const QSet<int> deleted = ChangeFeed::deletedOrderIds(changes);
+    QSet<int> ids = ChangeFeed::changedOrderIds(changes);
+    ids.subtract(deleted);
+    // Zmiana klienta zmienia numer i nazwę klienta w jego wczytanych zamówieniach
+    const QSet<int> clients = ChangeFeed::changedClientIds(changes);
+    if (!clients.isEmpty()) {
+        for (const OrderListRow &row : m_rows) {
+            if (clients.contains(row.clientId)) ids.insert(row.id);
+        }
+    }
+    // Import lub archiwizacja zmienia tysiące zamówień - taniej wczytać listę od nowa
+    if (deleted.size() + ids.size() > MAX_MERGED_CHANGES) {
+        reload(m_filter, m_field, m_includeArchive);
+        return;
+    }
+
+    QVector<int> positions;
+    for (int id : deleted) {
+        auto it = m_rowById.constFind(id);
+        if (it != m_rowById.constEnd()) positions.append(it.value());
+    }
+    removeRowsAt(positions);
+    if (ids.isEmpty() || !DbManager::isOpen()) return;
+
+    const QVector<int> requested(ids.cbegin(), ids.cend());
+    const quint64 generation = m_generation;
+    auto *watcher = new QFutureWatcher<std::optional<QVector<OrderListRow>>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, requested]() {
+        watcher->deleteLater();
+        if (generation != m_generation) return;
+        const std::optional<QVector<OrderListRow>> rows = watcher->result();
+        // Bez wyniku nie wiadomo, które wiersze zniknęły - lista zostaje bez zmian
+        if (!rows) {
+            qWarning() << "[OrdersTableModel] Nie pobrano zmienionych zamówień:" << DbManager::instance().lastError().text();
+            return;
+        }
+        mergeRows(requested, *rows);
+    });
+    watcher->setFuture(DbManager::instance().async().fetchOrderListRows(requested, m_filter, m_field, m_includeArchive));
+}
+
+void OrdersTableModel::mergeRows(const QVector<int> &requestedIds, const QVector<OrderListRow> &rows) {
+    QHash<int, const OrderListRow *> fetched;
+    for (const OrderListRow &row : rows) fetched.insert(row.id, &row);
+
+    // Podmiana w miejscu, a usunięcia i wstawienia zbiorczo - indeks wierszy przebudowywany raz
+    QVector<int> removed;
+    QVector<const OrderListRow *> inserted;
+    for (int id : requestedIds) {
+        auto loaded = m_rowById.constFind(id);
+        auto it = fetched.constFind(id);
+        if (loaded != m_rowById.constEnd()) {
+            const int position = loaded.value();
+            // Usunięte lub nie pasuje już do filtra
+            if (it == fetched.constEnd()) {
+                removed.append(position);
+                continue;
+            }
+            if (m_rows.at(position).orderDate == it.value()->orderDate) {
+                m_rows[position] = *it.value();
+                emit dataChanged(index(position, 0), index(position, ColumnCount - 1));
+                continue;
+            }
+            // Zmieniona data zamówienia - wiersz przenosi się w inne miejsce listy
+            removed.append(position);
+        }
+        if (it != fetched.constEnd()) inserted.append(it.value());
+    }
+    removeRowsAt(removed);
+
+    bool changed = false;
+    for (const OrderListRow *row : inserted) {
+        // Wiersze za ostatnim wczytanym i tak przyjdą z kolejną stroną
+        if (!m_exhausted && (m_rows.isEmpty() || !precedes(*row, m_rows.last()))) continue;
+        insertSorted(*row);
+        changed = true;
+    }
+    if (changed) rebuildRowIndex();
+}
+
+void OrdersTableModel::removeRowsAt(QVector<int> rows) {
+    if (rows.isEmpty()) return;
+    // Od końca - wcześniejsze pozycje nie przesuwają się
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    for (int row : rows) removeRowAt(row);
+    rebuildRowIndex();
+}
+
+void OrdersTableModel::removeRowAt(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.removeAt(row);
+    endRemoveRows();
+}
+
+void OrdersTableModel::insertSorted(const OrderListRow &row) {
+    auto it = std::lower_bound(m_rows.begin(), m_rows.end(), row, &OrdersTableModel::precedes);
+    const int position = static_cast<int>(it - m_rows.begin());
+    beginInsertRows(QModelIndex(), position, position);
+    m_rows.insert(position, row);
+    endInsertRows();
+}
+
+void OrdersTableModel::rebuildRowIndex() {
+    m_rowById.clear();
+    m_rowById.reserve(m_rows.size());
+    for (int row = 0; row < m_rows.size(); ++row) {
+        m_rowById.insert(m_rows.at(row).id, row);
+    }
+}
+
+bool OrdersTableModel::precedes(const OrderListRow &a, const OrderListRow &b) {
+    // Nieprawidłowa data jest mniejsza od każdej prawidłowej - brak daty na końcu listy
+    if (a.orderDate != b.orderDate) return a.orderDate > b.orderDate;
+    return a.id > b.id;
+}
+
+QMap<QString, QVariant> OrdersTableModel::orderData(int orderId) const {
+    auto it = m_rowById.constFind(orderId);
+    if (it == m_rowById.constEnd()) return QMap<QString, QVariant>();
+    return DbManager::toVariantMap(m_rows.at(it.value()));
+}
+
+void OrdersTableModel::setSearchHighlight(bool enabled) {
+    if (m_searchHighlight == enabled) return;
+    m_searchHighlight = enabled;
+    if (!m_rows.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_rows.size() - 1, ColumnCount - 1), {Qt::BackgroundRole});
+    }
+}
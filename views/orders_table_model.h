@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QMap>
+#include <QVariant>
+#include <QVector>
+#include "models/order_list_row.h"
+
+struct RowChange;
+
+/**
+ * @brief Model listy zamówień dla OrdersDbView
+ *
+ * Trzyma tylko wektor zwartych wierszy OrderListRow; tekst, czcionki i kolory
+ * komórek powstają dopiero w data(), gdy widok o nie poprosi. Zamówienia są
+ * doczytywane stronami (canFetchMore/fetchMore) w tle przez AsyncDb, z
+ * paginacją keyset po (order_date, id) - pierwsze wyświetlenie i zużycie
+ * pamięci nie zależą od liczby zamówień w bazie.
+ *
+ * Zmiany zgłoszone przez ChangeFeed są nanoszone na wczytane wiersze
+ * (applyChanges) bez przeładowania listy i utraty pozycji przewijania.
+ */
+class OrdersTableModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column {
+        ColOrderNumber = 0,
+        ColOrderDate,
+        ColDeliveryDate,
+        ColClientNumber,
+        ColClientName,
+        ColPrice,
+        ColProduction,
+        ColNotes,
+        ColStatus,
+        ColumnCount
+    };
+    // ID zamówienia (dostępne w każdej kolumnie)
+    static constexpr int OrderIdRole = Qt::UserRole + 1;
+    static constexpr int DEFAULT_PAGE_SIZE = 200;
+
+    explicit OrdersTableModel(QObject *parent = nullptr, int pageSize = DEFAULT_PAGE_SIZE);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // Czyści listę i pobiera pierwszą stronę (z filtrem wyszukiwania po stronie bazy);
+    // includeArchive - także zamówienia przeniesione do archiwum
+    void reload(const QString &filter = QString(), OrderSearchField field = OrderSearchField::OrderNumber,
+                bool includeArchive = false);
+    bool isLoading() const { return m_fetching; }
+
+    // Dane zamówienia w formacie QMap (DbManager::toVariantMap z podsumowaniami
+    // pozycji); pusta mapa, jeśli zamówienie nie jest wczytane
+    QMap<QString, QVariant> orderData(int orderId) const;
+
+    // Aktualizuje tylko zamówienia, których dotyczą zmiany: usunięte znikają od
+    // razu, pozostałe są pobierane ponownie (z bieżącym filtrem) i podmieniane
+    // lub wstawiane w kolejności listy. Przy dużej liczbie zmian (import,
+    // archiwizacja) lista jest wczytywana od nowa
+    void applyChanges(const QVector<RowChange> &changes);
+
+    // Podświetlenie wszystkich wierszy jako wyników wyszukiwania
+    void setSearchHighlight(bool enabled);
+
+signals:
+    void loadingChanged(bool loading);
+
+private:
+    void requestPage();
+    void appendPage(const QVector<OrderListRow> &page);
+    void mergeRows(const QVector<int> &requestedIds, const QVector<OrderListRow> &rows);
+    void removeRowAt(int row);
+    // Usuwa wiersze o podanych pozycjach i raz przebudowuje indeks
+    void removeRowsAt(QVector<int> rows);
+    void insertSorted(const OrderListRow &row);
+    void rebuildRowIndex();
+    // Kolejność listy: data zamówienia malejąco, potem id malejąco
+    static bool precedes(const OrderListRow &a, const OrderListRow &b);
+
+    // Więcej zmienionych zamówień naraz - reload() zamiast scalania
+    static const int MAX_MERGED_CHANGES = 300;
+
+    QVector<OrderListRow> m_rows;
+    QHash<int, int> m_rowById;
+    OrdersPageCursor m_cursor;
+    QString m_filter;
+    OrderSearchField m_field = OrderSearchField::OrderNumber;
+    bool m_includeArchive = false;
+    int m_pageSize;
+    // Zwiększane przy reload() - wyniki starszych zapytań są odrzucane
+    quint64 m_generation = 0;
+    bool m_fetching = false;
+    bool m_exhausted = true;
+    bool m_searchHighlight = false;
+};
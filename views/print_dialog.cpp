@@ -111,14 +111,7 @@ void PrintDialog::printConfirmation() {
         
         // Pobierz dane klienta
         int clientId = orderData["client_id"].toInt();
-        QMap<QString, QVariant> clientData;
-        auto clients = dbm.getClients();
-        for (const auto& c : clients) {
-            if (c["id"].toInt() == clientId) {
-                clientData = c;
-                break;
-            }
-        }
+        QMap<QString, QVariant> clientData = dbm.getClientById(clientId);
         
         // DEBUG: Sprawdź dostępne pola klienta
         qDebug() << "[PrintDialog] Dostępne pola klienta:";
@@ -183,14 +176,7 @@ void PrintDialog::printAndEmailConfirmation() {
         
         // Pobierz dane klienta
         int clientId = orderData["client_id"].toInt();
-        QMap<QString, QVariant> clientData;
-        auto clients = dbm.getClients();
-        for (const auto& c : clients) {
-            if (c["id"].toInt() == clientId) {
-                clientData = c;
-                break;
-            }
-        }
+        QMap<QString, QVariant> clientData = dbm.getClientById(clientId);
         
         // Pobierz pozycje zamówienia
         auto orderItems = dbm.getOrderItems(m_orderId);
@@ -301,14 +287,7 @@ void PrintDialog::printProduction() {
         
         // Pobierz dane klienta
         int clientId = orderData["client_id"].toInt();
-        QMap<QString, QVariant> clientData;
-        auto clients = dbm.getClients();
-        for (const auto& c : clients) {
-            if (c["id"].toInt() == clientId) {
-                clientData = c;
-                break;
-            }
-        }
+        QMap<QString, QVariant> clientData = dbm.getClientById(clientId);
         
         // Pobierz pozycje zamówienia
         auto orderItems = dbm.getOrderItems(m_orderId);
@@ -1,4 +1,6 @@
 #include "production_summary_view.h"
+#include "../db/async_db.h"
+#include "../db/change_feed.h"
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -13,6 +15,7 @@
 #include <QUrl>
 #include <QPdfDocument>
 #include <QPdfView>
+#include <QLoggingCategory>
 
 ProductionSummaryView::ProductionSummaryView(QWidget *parent) : QWidget(parent), 
     m_tableWidget(nullptr),
@@ -97,8 +100,12 @@ void ProductionSummaryView::setupUI() {
     m_groupByCombo->addItem("Wymiar -> Materiał -> Rdzeń");
     m_groupByCombo->addItem("Rdzeń -> Materiał -> Wymiar");
     
+    m_weekOnlyCheck = new QCheckBox("Tylko wybrany tydzień");
+    m_weekOnlyCheck->setToolTip("Tylko zamówienia z datą wysyłki w wybranym tygodniu");
+    
     groupByLayout->addWidget(groupByLabel);
     groupByLayout->addWidget(m_groupByCombo);
+    groupByLayout->addWidget(m_weekOnlyCheck);
     groupByLayout->addStretch();
     groupByLayout->addWidget(m_generateBtn);
     groupByLayout->addWidget(m_exportPdfBtn);
@@ -137,10 +144,17 @@ void ProductionSummaryView::setupConnections() {
     connect(m_prevYearBtn, &QPushButton::clicked, this, [this](){ yearChanged(-1); });
     connect(m_nextYearBtn, &QPushButton::clicked, this, [this](){ yearChanged(1); });
     connect(m_groupByCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ProductionSummaryView::refreshData);
+    connect(m_weekOnlyCheck, &QCheckBox::toggled, this, &ProductionSummaryView::refreshData);
+    
+    // Dane produkcji liczone w tle, wynik wraca do wątku GUI przez watcher
+    m_loadWatcher = new QFutureWatcher<QList<ProductionGroup>>(this);
+    connect(m_loadWatcher, &QFutureWatcherBase::finished, this, &ProductionSummaryView::onProductionDataLoaded);
+    m_generateBtnText = m_generateBtn->text();
     
     // Połączenie z sygnałem orderAdded z DbManager
     auto& dbManager = DbManager::instance();
     connect(&dbManager, &DbManager::orderAdded, this, &ProductionSummaryView::onOrderAdded);
+    connect(&dbManager.changeFeed(), &ChangeFeed::changed, this, &ProductionSummaryView::onRowsChanged);
 }
 
 QString ProductionSummaryView::getWeekLabel() const {
@@ -203,248 +217,93 @@ void ProductionSummaryView::generateReport() {
 }
 
 void ProductionSummaryView::refreshData() {
+    // Zapytanie już trwa - odśwież ponownie po jego zakończeniu
+    if (m_loadWatcher->isRunning()) {
+        m_reloadPending = true;
+        return;
+    }
     QDate startDate = getFirstDayOfWeek(m_currentYear, m_currentWeek);
     QDate endDate = getLastDayOfWeek(m_currentYear, m_currentWeek);
+    const bool weekOnly = m_weekOnlyCheck->isChecked();
     
-    QList<ProductionGroup> groups = getProductionData(startDate, endDate);
-    fillTable(groups);
+    setLoading(true);
+    m_loadWatcher->setFuture(DbManager::instance().async().run([startDate, endDate, weekOnly](DbManager&) {
+        return getProductionData(startDate, endDate, weekOnly);
+    }));
 }
 
-QList<ProductionGroup> ProductionSummaryView::getProductionData(const QDate &startDate, const QDate &endDate) {
-    QList<ProductionGroup> result;
-    QMap<QString, ProductionGroup> groupsMap;
-    
-    qDebug() << "=== Pobieranie danych produkcji ===";
-    qDebug() << "Zakres dat:" << startDate.toString("yyyy-MM-dd") << "do" << endDate.toString("yyyy-MM-dd");
-    
-    // Tworzymy zapytanie do bazy danych
-    DbManager& dbManager = DbManager::instance();
-    QSqlDatabase db = dbManager.getPooledConnection();
-    qDebug() << "Typ bazy danych:" << db.driverName();
-    qDebug() << "Nazwa bazy:" << db.databaseName();
+void ProductionSummaryView::onProductionDataLoaded() {
+    fillTable(m_loadWatcher->result());
+    setLoading(false);
+    if (m_reloadPending) {
+        m_reloadPending = false;
+        refreshData();
+    }
+}
+
+void ProductionSummaryView::setLoading(bool loading) {
+    m_generateBtn->setEnabled(!loading);
+    m_generateBtn->setText(loading ? "Ładowanie..." : m_generateBtnText);
+    m_tableWidget->setEnabled(!loading);
+    if (loading) setCursor(Qt::BusyCursor); else unsetCursor();
+}
+
+// Pełne listy zamówień i pozycji w logu przy każdym odświeżeniu - tylko na
+// żądanie: logging/level = Debug w ustawieniach albo
+// QT_LOGGING_RULES="etykiety.production.diagnostics.debug=true"
+Q_LOGGING_CATEGORY(lcProductionDiagnostics, "etykiety.production.diagnostics", QtInfoMsg)
+
+static void logProductionDiagnostics(const QSqlDatabase &db) {
+    qCDebug(lcProductionDiagnostics) << "Typ bazy danych:" << db.driverName();
+    qCDebug(lcProductionDiagnostics) << "Nazwa bazy:" << db.databaseName();
     
-    // Najpierw sprawdźmy wszystkie zamówienia w bazie
     QSqlQuery debugQuery(db);
     if (debugQuery.exec("SELECT o.id, o.order_number, o.status, o.created_at FROM orders o ORDER BY o.id")) {
-        qDebug() << "=== Wszystkie zamówienia w bazie ===";
+        qCDebug(lcProductionDiagnostics) << "=== Wszystkie zamówienia w bazie ===";
         while (debugQuery.next()) {
-            int id = debugQuery.value(0).toInt();
-            QString orderNumber = debugQuery.value(1).toString();
-            int status = debugQuery.value(2).toInt();
-            QString createdAt = debugQuery.value(3).toString();
-            qDebug() << "ID:" << id << "Numer:" << orderNumber << "Status:" << status << "Data:" << createdAt;
+            qCDebug(lcProductionDiagnostics) << "ID:" << debugQuery.value(0).toInt()
+                                             << "Numer:" << debugQuery.value(1).toString()
+                                             << "Status:" << debugQuery.value(2).toInt()
+                                             << "Data:" << debugQuery.value(3).toString();
         }
-        qDebug() << "=== Koniec listy wszystkich zamówień ===";
+        qCDebug(lcProductionDiagnostics) << "=== Koniec listy wszystkich zamówień ===";
     }
     
-    // Sprawdźmy też wszystkie pozycje zamówień
     QSqlQuery itemsQuery(db);
     if (itemsQuery.exec("SELECT oi.id, oi.order_id, o.order_number, oi.material, oi.width, oi.height, oi.core, oi.ordered_quantity FROM order_items oi JOIN orders o ON oi.order_id = o.id ORDER BY oi.order_id, oi.id")) {
-        qDebug() << "=== Wszystkie pozycje zamówień w bazie ===";
+        qCDebug(lcProductionDiagnostics) << "=== Wszystkie pozycje zamówień w bazie ===";
         while (itemsQuery.next()) {
-            int itemId = itemsQuery.value(0).toInt();
-            int orderId = itemsQuery.value(1).toInt();
-            QString orderNumber = itemsQuery.value(2).toString();
-            QString material = itemsQuery.value(3).toString();
-            QString width = itemsQuery.value(4).toString();
-            QString height = itemsQuery.value(5).toString();
-            QString core = itemsQuery.value(6).toString();
-            QString quantity = itemsQuery.value(7).toString();
-            
-            qDebug() << "Pozycja ID:" << itemId << "Zamówienie:" << orderNumber 
-                    << "Material:[" << material << "] Width:[" << width << "] Height:[" << height 
-                    << "] Core:[" << core << "] Qty:" << quantity;
+            qCDebug(lcProductionDiagnostics) << "Pozycja ID:" << itemsQuery.value(0).toInt()
+                                             << "Zamówienie:" << itemsQuery.value(2).toString()
+                                             << "Material:[" << itemsQuery.value(3).toString()
+                                             << "] Width:[" << itemsQuery.value(4).toString()
+                                             << "] Height:[" << itemsQuery.value(5).toString()
+                                             << "] Core:[" << itemsQuery.value(6).toString()
+                                             << "] Qty:" << itemsQuery.value(7).toString();
         }
-        qDebug() << "=== Koniec listy wszystkich pozycji ===";
+        qCDebug(lcProductionDiagnostics) << "=== Koniec listy wszystkich pozycji ===";
     }
-    
-    QSqlQuery q(db);
-    q.prepare("SELECT o.order_number, oi.material, oi.width, oi.height, oi.core, oi.ordered_quantity, oi.quantity_type, oi.roll_length, "
-              "oi.price, oi.price_type, o.status "
-              "FROM order_items oi "
-              "JOIN orders o ON oi.order_id = o.id "
-              "WHERE o.status IN (0, 1, 2)"); // Tylko zamówienia w procesie produkcji: Przyjęte (0), W produkcji (1), Gotowe (2)
-    
-    // Usunięto filtr dat - pokazujemy wszystkie aktywne zamówienia
-    
-    if (q.exec()) {
-        int rowCount = 0;
-        while (q.next()) {
-            rowCount++;
-            QString orderNumber = q.value(0).toString();
-            QString material = q.value(1).toString();
-            QString width = q.value(2).toString();
-            QString height = q.value(3).toString();
-            QString core = q.value(4).toString();
-            QString orderedQuantity = q.value(5).toString();
-            QString quantityType = q.value(6).toString();
-            QString rollLength = q.value(7).toString();
-            QString price = q.value(8).toString();
-            QString priceType = q.value(9).toString();
-            int status = q.value(10).toInt();
-            
-            qDebug() << "Przetwarzanie zamówienia:" << orderNumber << "Status:" << status;
-            
-            // Pomijamy rekordy bez materiału lub szerokości
-            if (material.trimmed().isEmpty() || width.trimmed().isEmpty()) {
-                qDebug() << "Pomijam zamówienie" << orderNumber << "- brak materiału lub szerokości";
-                qDebug() << "Material:" << material << "(puste:" << material.trimmed().isEmpty() << ")";
-                qDebug() << "Width:" << width << "(puste:" << width.trimmed().isEmpty() << ")";
-                qDebug() << "Height:" << height;
-                qDebug() << "Core:" << core;
-                continue;
-            }
-            
-            // Tworzymy klucz grupowania na podstawie wymiarów (szerokość x wysokość)
-            QString groupKey = QString("%1|%2x%3|%4").arg(material).arg(width).arg(height).arg(core);
-            
-            // Inicjalizacja grupy jeśli nie istnieje
-            if (!groupsMap.contains(groupKey)) {
-                ProductionGroup group;
-                group.material = material;
-                group.width = width;
-                group.height = height;
-                group.dimensions = QString("%1 x %2").arg(width).arg(height);
-                group.core = core;
-                group.quantity = 0.0;
-                group.orderCount = 0;
-                group.totalPrice = 0.0;
-                groupsMap[groupKey] = group;
-            }
-            
-            bool ok;
-            double quantity = orderedQuantity.toDouble(&ok);
-            if (!ok || quantity <= 0) continue;
-            
-            double actualQuantity = 0.0; // ilość w tysiącach
-            
-            if (quantityType.toLower().contains("tys")) {
-                // Już w tysiącach - nie trzeba przeliczać
-                actualQuantity = quantity;
-            } else if (quantityType.toLower().contains("rolki") || 
-                     quantityType.toLower().contains("rol")) {
-                // Dla rolek: ilość rolek × nawój/długość / 1000
-                double rollLengthValue = rollLength.toDouble(&ok);
-                if (ok && rollLengthValue > 0) {
-                    actualQuantity = (quantity * rollLengthValue / 1000.0);
-                    // Dodaj ilość rolek do odpowiedniej grupy średnic rdzenia
-                    groupsMap[groupKey].rollCount += static_cast<int>(quantity);
-                }
-            } else {
-                // Inne jednostki - zakładamy że trzeba podzielić przez 1000
-                actualQuantity = (quantity / 1000.0);
-            }
-            
-            // Dodaj ilość do grupy
-            if (actualQuantity > 0) {
-                groupsMap[groupKey].quantity += actualQuantity;
-            }
-
-            // Obliczanie wartości zamówienia
-            QString priceStr = price;
-            priceStr.replace(",", ".");
-            double priceValue = priceStr.toDouble(&ok);
-            
-            if (!ok || priceValue <= 0) {
-                qWarning() << "Nieprawidłowa cena:" << price << "dla zamówienia" << orderNumber;
-                continue;
-            }
-
-            QString measureType = quantityType.toLower();
-            QString pricingType = priceType.toLower();
-            double orderValue = 0.0;
-
-            // Pobierz długość nawoju/rolki jeśli jest dostępna
-            QString rollLengthStr = rollLength;
-            rollLengthStr.replace(",", ".");
-            double rollLengthValue = rollLengthStr.toDouble(&ok);
-            if (!ok) {
-                qWarning() << "Błąd konwersji długości nawoju:" << rollLength << "dla zamówienia" << orderNumber;
-                rollLengthValue = 0.0;
-            }
-
-            qDebug() << "\n=== Obliczanie wartości dla zamówienia" << orderNumber << "===";
-            qDebug() << "Material:" << material;
-            qDebug() << "Ilość:" << quantity << measureType;
-            qDebug() << "Cena:" << priceValue << pricingType;
-            qDebug() << "Długość nawoju:" << rollLengthValue;
-
-            if (pricingType.contains("rolk")) {
-                // Cena za rolkę - zawsze mnożymy przez ilość rolek
-                orderValue = quantity * priceValue;
-                qDebug() << "Cena za rolkę:" << quantity << "rolek *" << priceValue << "PLN =" << orderValue << "PLN";
-            }
-            else if (pricingType.contains("tys") || pricingType.contains("tyś") || 
-                    pricingType.contains("1000") || pricingType.contains("1 tys")) {
-                // Cena za tysiąc (różne warianty zapisu)
-                if (measureType.contains("tys") || measureType.contains("tyś")) {
-                    // Jeśli ilość w tysiącach, mnożymy bezpośrednio
-                    orderValue = quantity * priceValue;
-                    qDebug() << "Cena za tysiąc (ilość w tys):" << quantity << "tys. *" << priceValue << "PLN =" << orderValue << "PLN";
-                }
-                else if (measureType.contains("rolk") || measureType.contains("rol")) {
-                    if (rollLengthValue > 0) {
-                        // Jeśli ilość w rolkach, przeliczamy na tysiące:
-                        // ilość rolek × długość nawoju / 1000 × cena za tysiąc
-                        orderValue = (quantity * rollLengthValue / 1000.0) * priceValue;
-                        qDebug() << "Cena za tysiąc (ilość w rolkach):" << quantity << "rolek *" 
-                               << rollLengthValue << "mb /" << "1000 *" << priceValue << "PLN =" << orderValue << "PLN";
-                    } else {
-                        qWarning() << "Brak długości nawoju dla zamówienia w rolkach:" << orderNumber;
-                    }
-                }
-                else {
-                    // Zakładamy że to sztuki - przeliczamy na tysiące
-                    orderValue = (quantity / 1000.0) * priceValue;
-                    qDebug() << "Cena za tysiąc (ilość w szt):" << quantity << "szt. /" 
-                           << "1000 *" << priceValue << "PLN =" << orderValue << "PLN";
-                }
-            }
-            else if (pricingType.contains("szt")) {
-                // Cena za sztukę
-                orderValue = quantity * priceValue;
-                qDebug() << "Cena za sztukę:" << quantity << "szt. *" << priceValue << "PLN =" << orderValue << "PLN";
-            }
-            else {
-                qWarning() << "Nieznany typ ceny:" << pricingType << "dla zamówienia" << orderNumber;
-                continue;
-            }
+}
 
-            // Aktualizuj całkowitą wartość dla grupy tylko jeśli coś zostało policzone
-            if (orderValue > 0) {
-                // Dodaj wartość zamówienia do sumy dla grupy
-                groupsMap[groupKey].totalPrice += orderValue;
-                qDebug() << "Dodano wartość" << orderValue << "PLN do grupy" << groupKey 
-                        << "(suma:" << groupsMap[groupKey].totalPrice << "PLN)";
-            } else {
-                qWarning() << "Wartość 0 PLN dla zamówienia" << orderNumber 
-                          << "(material:" << material << "typ ceny:" << pricingType 
-                          << "typ miary:" << measureType << ")";
-            }
-            
-            // Aktualizacja licznika zamówień
-            if (!groupsMap[groupKey].orderNumbers.contains(orderNumber)) {
-                groupsMap[groupKey].orderCount++;
-                groupsMap[groupKey].orderNumbers.append(orderNumber);
-            }
-        }
-        qDebug() << "Pobrano" << rowCount << "pozycji zamówień z bazy danych";
-    } else {
-        qWarning() << "Błąd podczas pobierania danych produkcji:" << q.lastError().text();
-    }
-    
-    dbManager.returnPooledConnection(db);
-    
-    qDebug() << "Znaleziono" << groupsMap.size() << "grup produktów";
-    qDebug() << "=== Koniec pobierania danych produkcji ===";
+QList<ProductionGroup> ProductionSummaryView::getProductionData(const QDate &startDate, const QDate &endDate, bool weekOnly) {
+    qCDebug(lcProductionDiagnostics) << "Zakres dat:" << startDate.toString("yyyy-MM-dd") << "do" << endDate.toString("yyyy-MM-dd");
     
-    // Konwersja mapy na listę
-    QMapIterator<QString, ProductionGroup> it(groupsMap);
-    while (it.hasNext()) {
-        it.next();
-        result.append(it.value());
+    // Skany diagnostyczne tylko przy włączonej kategorii - normalnie jedno zapytanie
+    if (lcProductionDiagnostics().isDebugEnabled()) {
+        // Wywoływane w wątku roboczym AsyncDb - database() zwraca połączenie tego wątku
+        logProductionDiagnostics(DbManager::instance().database());
     }
     
+    // Normalizacja jednostek i grupowanie w bazie - wynik ma tyle wierszy, ile grup.
+    // Tylko zamówienia w procesie produkcji: Przyjęte (0), W produkcji (1), Gotowe (2).
+    // Domyślnie bez filtra dat - wszystkie aktywne zamówienia; wybrany tydzień
+    // czytamy z gotowego zestawienia tygodniowego.
+    const QVector<Order::Status> statuses = {Order::Przyjete, Order::Produkcja, Order::Gotowe};
+    QList<ProductionGroup> result = weekOnly
+        ? DbManager::instance().getProductionRollup(startDate, statuses)
+        : DbManager::instance().getProductionGroups(QDate(), QDate(), statuses);
+    
+    qCDebug(lcProductionDiagnostics) << "Znaleziono" << result.size() << "grup produktów";
     return result;
 }
 
@@ -702,3 +561,11 @@ void ProductionSummaryView::onOrderAdded()
     generateReport();
     qDebug() << "=== ProductionSummaryView odświeżone ===";
 }
+
+void ProductionSummaryView::onRowsChanged(const QVector<RowChange>& changes)
+{
+    // Raport jest agregatem tygodnia - przeliczamy go w całości, ale tylko
+    // gdy zmieniły się zamówienia lub ich pozycje
+    if (ChangeFeed::changedOrderIds(changes).isEmpty()) return;
+    refreshData();
+}
@@ -5,6 +5,7 @@
 #include <QDateEdit>
 #include <QPushButton>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -12,24 +13,12 @@
 #include <QMap>
 #include <QString>
 #include <QDate>
+#include <QFutureWatcher>
 #include "../db/dbmanager.h"
 #include "../models/orderitem.h"
+#include "../models/production_group.h"
 
-// Struktura do grupowania pozycji produkcji
-struct ProductionGroup {
-    QString material;
-    QString width;
-    QString height;
-    QString dimensions;  // szerokość x wysokość
-    QString core;
-    double quantity = 0.0;
-    int orderCount = 0;
-    QStringList orderNumbers;
-    QString quantityType;    // typ miary (tyś., rolki)
-    double rollLength = 0.0; // długość/nawój rolki
-    double totalPrice = 0.0; // suma wartości zamówień
-    int rollCount = 0;      // ilość rolek
-};
+struct RowChange;
 
 class ProductionSummaryView : public QWidget {
     Q_OBJECT
@@ -45,13 +34,18 @@ private slots:
     void weekChanged(int direction);
     void yearChanged(int direction);
     void onOrderAdded();  // Slot wywoływany po dodaniu nowego zamówienia
+    void onRowsChanged(const QVector<RowChange>& changes); // Zmiany zamówień w bazie (także z innych stanowisk)
     
 private:
     void setupUI();
     void setupConnections();
     void refreshData();
+    void onProductionDataLoaded();
+    void setLoading(bool loading);
     void fillTable(const QList<ProductionGroup> &groups);
-    QList<ProductionGroup> getProductionData(const QDate &startDate, const QDate &endDate);
+    // Wykonywane w wątku roboczym - nie może dotykać widżetów
+    // weekOnly - tylko zamówienia z datą wysyłki w tygodniu startDate (z production_rollup)
+    static QList<ProductionGroup> getProductionData(const QDate &startDate, const QDate &endDate, bool weekOnly);
     QString getWeekLabel() const;
     QDate getFirstDayOfWeek(int year, int week) const;
     QDate getLastDayOfWeek(int year, int week) const;
@@ -67,8 +61,12 @@ private:
     QPushButton *m_prevYearBtn;
     QPushButton *m_nextYearBtn;
     QComboBox *m_groupByCombo;
+    QCheckBox *m_weekOnlyCheck;
     
     // Data
     int m_currentWeek;
     int m_currentYear;
+    QFutureWatcher<QList<ProductionGroup>> *m_loadWatcher = nullptr;
+    bool m_reloadPending = false;
+    QString m_generateBtnText;
 };
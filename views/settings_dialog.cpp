@@ -31,6 +31,33 @@
 #include <QTabWidget>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include "db/async_db.h"
+
+namespace {
+// Długa operacja (import/eksport, przebudowa zestawienia) w wątku roboczym z oknem
+// postępu; finished(ok) po zakończeniu
+void runWithProgress(QWidget *parent, const QString &title, QFuture<bool> future,
+                     const std::function<void(bool)> &finished) {
+    auto *progress = new QProgressDialog(title, QString(), 0, 0, parent);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+    QObject::connect(&DbManager::instance(), &DbManager::transferProgress, progress,
+                     [progress, title](const QString &table, qint64 rows) {
+        progress->setLabelText(QString("%1\n%2: %3 wierszy").arg(title, table).arg(rows));
+    });
+    auto *watcher = new QFutureWatcher<bool>(progress);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, progress, [progress, watcher, finished]() {
+        const bool ok = watcher->result();
+        progress->close();
+        finished(ok);
+    });
+    watcher->setFuture(future);
+    progress->show();
+}
+}
 
 SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
     qDebug() << "[DEBUG] SettingsDialog konstruktor START";
@@ -60,6 +87,12 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
     notificationPortEdit = new QLineEdit(dbTab);
     testDbBtn = new QPushButton("Testuj połączenie", dbTab);
     QPushButton *testNotifyBtn = new QPushButton("Testuj serwer powiadomień", dbTab);
+    QPushButton *rebuildRollupBtn = new QPushButton("Przebuduj zestawienie produkcji", dbTab);
+    rebuildRollupBtn->setToolTip("Przelicza tygodniowe zestawienie produkcji od zera (np. po imporcie danych)");
+    QPushButton *exportDataBtn = new QPushButton("Eksportuj dane...", dbTab);
+    exportDataBtn->setToolTip("Zapisuje klientów, zamówienia i katalogi do plików CSV lub NDJSON w wybranym katalogu");
+    QPushButton *importDataBtn = new QPushButton("Importuj dane...", dbTab);
+    importDataBtn->setToolTip("Wczytuje pliki <tabela>.csv / <tabela>.ndjson z wybranego katalogu");
     clearDatabaseBtn = new QPushButton("Wyczyść wszystkie zamówienia", dbTab);
     clearDatabaseBtn->setStyleSheet("QPushButton { background-color: #dc3545; color: white; font-weight: bold; }");
     clearDatabaseBtn->setToolTip("UWAGA: Nieodwracalnie usuwa wszystkie zamówienia z bazy danych!");
@@ -75,6 +108,9 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
     dbLayout->addWidget(new QLabel("Port powiadomień:")); dbLayout->addWidget(notificationPortEdit);
     dbLayout->addWidget(testDbBtn);
     dbLayout->addWidget(testNotifyBtn);
+    dbLayout->addWidget(rebuildRollupBtn);
+    dbLayout->addWidget(exportDataBtn);
+    dbLayout->addWidget(importDataBtn);
     dbLayout->addWidget(new QLabel("Początkowy numer zamówienia:"));
     startOrderNumberEdit = new QLineEdit(dbTab);
     startOrderNumberEdit->setMaximumWidth(120);
@@ -191,6 +227,19 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
     connect(testDbBtn, &QPushButton::clicked, this, &SettingsDialog::testDbConnection);
     connect(testNotifyBtn, &QPushButton::clicked, this, &SettingsDialog::testNotificationServerConnection);
     connect(clearDatabaseBtn, &QPushButton::clicked, this, &SettingsDialog::clearDatabase);
+    connect(exportDataBtn, &QPushButton::clicked, this, &SettingsDialog::exportData);
+    connect(importDataBtn, &QPushButton::clicked, this, &SettingsDialog::importData);
+    connect(rebuildRollupBtn, &QPushButton::clicked, this, [this]() {
+        runWithProgress(this, "Przebudowa zestawienia produkcji", DbManager::instance().async().rebuildProductionRollup(),
+                        [this](bool ok) {
+            if (ok) {
+                QMessageBox::information(this, "Zestawienie produkcji", "Zestawienie produkcji zostało przebudowane.");
+            } else {
+                QMessageBox::warning(this, "Zestawienie produkcji",
+                                     "Nie udało się przebudować zestawienia:\n" + DbManager::instance().lastError().text());
+            }
+        });
+    });
     connect(saveBtn, &QPushButton::clicked, this, [this](){ saveSettings(false); });
     connect(okBtn, &QPushButton::clicked, this, [this](){ saveSettings(true); });
     connect(cancelBtn, &QPushButton::clicked, this, &SettingsDialog::reject);
@@ -223,11 +272,7 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
             QMessageBox::critical(this, "Błąd bazy", "Brak połączenia z bazą danych. Nie można zweryfikować numeru zamówienia.");
             return;
         }
-        QSqlQuery q(db);
-        int lastNumber = 0;
-        if (q.exec("SELECT last_number FROM order_sequence WHERE id=1")) {
-            if (q.next()) lastNumber = q.value(0).toInt();
-        }
+        int lastNumber = static_cast<int>(NumberingService::lastValue(db, NumberingService::ORDERS, QDate::currentDate().year()));
         int val = startOrderNumberEdit->text().toInt();
         if (val <= lastNumber) {
             QMessageBox::warning(this, "Nieprawidłowy numer", QString("Początkowy numer zamówienia nie może być mniejszy lub równy ostatniemu użytemu (%1).\nWprowadź większą wartość.").arg(lastNumber));
@@ -577,6 +622,48 @@ void SettingsDialog::clearDatabase() {
     }
 }
 
+void SettingsDialog::exportData() {
+    const QString directory = QFileDialog::getExistingDirectory(this, "Katalog eksportu danych");
+    if (directory.isEmpty()) return;
+    bool ok = false;
+    const QString format = QInputDialog::getItem(this, "Eksport danych", "Format plików:",
+                                                 {"CSV", "NDJSON"}, 0, false, &ok);
+    if (!ok) return;
+    const TransferFormat transferFormat = format == "NDJSON" ? TransferFormat::NdJson : TransferFormat::Csv;
+    runWithProgress(this, "Eksport danych", DbManager::instance().async().exportAll(directory, transferFormat),
+                    [this, directory](bool success) {
+        if (success) {
+            QMessageBox::information(this, "Eksport danych", "Dane zostały zapisane w katalogu:\n" + directory);
+        } else {
+            QMessageBox::warning(this, "Eksport danych",
+                                 "Eksport nie powiódł się:\n" + DbManager::instance().lastError().text());
+        }
+    });
+}
+
+void SettingsDialog::importData() {
+    const QString directory = QFileDialog::getExistingDirectory(this, "Katalog z plikami do importu");
+    if (directory.isEmpty()) return;
+    QMessageBox::StandardButton reply = QMessageBox::question(
+        this,
+        "Import danych",
+        "Wiersze z plików zastąpią wiersze o tych samych id w bazie danych.\n\n"
+        "Czy kontynuować?",
+        QMessageBox::Yes | QMessageBox::No,
+        QMessageBox::No
+    );
+    if (reply != QMessageBox::Yes) return;
+    runWithProgress(this, "Import danych", DbManager::instance().async().importAll(directory),
+                    [this](bool success) {
+        if (success) {
+            QMessageBox::information(this, "Import danych", "Import zakończony.");
+        } else {
+            QMessageBox::warning(this, "Import danych",
+                                 "Import nie powiódł się:\n" + DbManager::instance().lastError().text());
+        }
+    });
+}
+
 void SettingsDialog::checkOrdersCount() {
     DbManager& dbManager = DbManager::instance();
     int ordersCount = dbManager.getOrdersCount();
@@ -43,6 +43,8 @@ private slots:
     void removeUser();
     void testNotificationServerConnection();
     void clearDatabase();  // Slot do obsługi czyszczenia bazy danych
+    void exportData();  // Eksport tabel do katalogu (CSV/NDJSON)
+    void importData();  // Import tabel z katalogu
     void checkOrdersCount();  // Slot do sprawdzenia liczby zamówień
     void testSmtpConnection(); // Slot do testowania połączenia SMTP
     void chooseMaterialsOrderPdfDir(); // Slot do wyboru katalogu PDF zamówień materiałów